@@ -0,0 +1,381 @@
+/**
+ * @file PipelineBench.cpp
+ * @brief Headless throughput benchmark of the surface, blit and present pipeline
+ *
+ * Drives the wrapper the way a game does - colour fills, sprite blits,
+ * a stretched blit and a flip per frame - through the real DirectDraw
+ * objects, with the null renderer converting every presented frame.
+ * Prints frames per second, the per-stage times, and the hash of the
+ * final frame, which stays the same from run to run as long as the
+ * output does.
+ *
+ * Usage: ldc_bench [--frames N] [--width W] [--height H] [--bpp 8|16|32]
+ *                  [--sprites N] [--capture discard|hash|store] [--deferred]
+ *                  [--export NAME] [--static] [--no-skip]
+ *        ldc_bench --contention
+ *
+ * --export also publishes every frame to the shared-memory ring NAME,
+ * for measuring its cost or feeding ldc_frame_reader.
+ *
+ * --static draws the same scene every frame, like a menu or pause
+ * screen, and --no-skip presents frames even when nothing changed.
+ *
+ * --contention instead times the game, presenter and window threads'
+ * writes on the DeviceContext layout against the same fields packed on
+ * one cache line.
+ */
+
+#include "core/Common.h"
+#include "core/DeviceContext.h"
+#include "config/Config.h"
+#include "interfaces/DirectDrawImpl.h"
+#include "interfaces/SurfaceImpl.h"
+#include "renderer/NullRenderer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace ldc;
+using namespace ldc::interfaces;
+
+namespace {
+
+struct BenchOptions {
+    int frames = 600;
+    DWORD width = 640;
+    DWORD height = 480;
+    DWORD bpp = 16;
+    int sprites = 64;
+    std::string capture = "hash";
+    bool deferred = false;
+    bool staticScene = false;
+    bool skipUnchanged = true;
+    bool contention = false;
+    std::string exportName;
+};
+
+const DWORD kSpriteSize = 32;
+
+bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--deferred") {
+            options.deferred = true;
+            continue;
+        }
+        if (arg == "--static") {
+            options.staticScene = true;
+            continue;
+        }
+        if (arg == "--no-skip") {
+            options.skipUnchanged = false;
+            continue;
+        }
+        if (arg == "--contention") {
+            options.contention = true;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        if (arg == "--frames") {
+            options.frames = atoi(value);
+        } else if (arg == "--width") {
+            options.width = static_cast<DWORD>(atoi(value));
+        } else if (arg == "--height") {
+            options.height = static_cast<DWORD>(atoi(value));
+        } else if (arg == "--bpp") {
+            options.bpp = static_cast<DWORD>(atoi(value));
+        } else if (arg == "--sprites") {
+            options.sprites = atoi(value);
+        } else if (arg == "--capture") {
+            options.capture = value;
+        } else if (arg == "--export") {
+            options.exportName = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+    }
+
+    if (options.frames <= 0 || options.width < kSpriteSize || options.height < kSpriteSize ||
+        (options.bpp != 8 && options.bpp != 16 && options.bpp != 32)) {
+        fprintf(stderr, "Invalid options\n");
+        return false;
+    }
+    return true;
+}
+
+// The wrapper reads its settings from an INI file; point it at one that
+// selects the null renderer
+bool LoadBenchConfig(const BenchOptions& options) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "ldc_bench.ini";
+    {
+        std::ofstream ini(path);
+        ini << "[ddraw]\n"
+            << "renderer=null\n"
+            << "nullcapture=" << options.capture << "\n"
+            << "deferredblits=" << (options.deferred ? "true" : "false") << "\n"
+            << "skipunchanged=" << (options.skipUnchanged ? "true" : "false") << "\n";
+        if (!options.exportName.empty()) {
+            ini << "frameexport=true\n"
+                << "frameexportname=" << options.exportName << "\n";
+        }
+        if (!ini) {
+            return false;
+        }
+    }
+
+    bool loaded = config::ConfigManager::Instance().Load(path.string());
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return loaded;
+}
+
+DWORD PatternColor(DWORD bpp, DWORD x, DWORD y) {
+    DWORD v = (x * 7 + y * 13) & 0xFF;
+    switch (bpp) {
+        case 8:  return v;
+        case 16: return ((v >> 3) << 11) | ((x & 0x3F) << 5) | (y & 0x1F);
+        default: return 0xFF000000 | (v << 16) | ((x & 0xFF) << 8) | (y & 0xFF);
+    }
+}
+
+bool FillSprite(SurfaceImpl* sprite, DWORD bpp) {
+    DDSURFACEDESC2 desc = {};
+    desc.dwSize = sizeof(desc);
+    if (FAILED(sprite->Lock(nullptr, &desc, DDLOCK_WAIT | DDLOCK_WRITEONLY, nullptr))) {
+        return false;
+    }
+
+    auto* row = static_cast<uint8_t*>(desc.lpSurface);
+    for (DWORD y = 0; y < kSpriteSize; ++y, row += desc.lPitch) {
+        for (DWORD x = 0; x < kSpriteSize; ++x) {
+            DWORD color = PatternColor(bpp, x, y);
+            switch (bpp) {
+                case 8:  row[x] = static_cast<uint8_t>(color); break;
+                case 16: reinterpret_cast<uint16_t*>(row)[x] = static_cast<uint16_t>(color); break;
+                default: reinterpret_cast<uint32_t*>(row)[x] = color; break;
+            }
+        }
+    }
+    return SUCCEEDED(sprite->Unlock(nullptr));
+}
+
+double PerFrameMs(uint64_t micros, uint64_t frames) {
+    return frames ? micros / static_cast<double>(frames) / 1000.0 : 0.0;
+}
+
+// The async present path's hot fields: the game marks palette changes,
+// the presenter counts frames, and the window maps the mouse and
+// republishes the mapping now and then as WM_SIZE would
+double TimeThreadWrites(std::atomic<bool>& paletteChanged, DWORD& frameCount,
+                        Snapshot<InputMapping>& input) {
+    const int iterations = 2000000;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread presenter([&] {
+        volatile DWORD* frames = &frameCount;
+        for (int i = 0; i < iterations; ++i) {
+            *frames = *frames + 1;
+        }
+    });
+    std::thread window([&] {
+        for (int i = 0; i < iterations; ++i) {
+            if (i % 4096 == 0) {
+                InputMapping mapping;
+                mapping.gameWidth = 640 + (i & 0xFF);
+                input.Store(mapping);
+            }
+            volatile DWORD gameWidth = input.Load().gameWidth;
+            (void)gameWidth;
+        }
+    });
+    for (int i = 0; i < iterations; ++i) {
+        paletteChanged.store((i & 1) != 0, std::memory_order_relaxed);
+    }
+    presenter.join();
+    window.join();
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+           iterations;
+}
+
+int RunContentionBench() {
+    auto state = std::make_unique<DeviceContext>();
+
+    // The layout before the split: the same fields side by side
+    struct alignas(64) Packed {
+        std::atomic<bool> paletteChanged{false};
+        DWORD frameCount = 0;
+        Snapshot<InputMapping> input;
+    };
+    auto packed = std::make_unique<Packed>();
+
+    double splitNs = TimeThreadWrites(state->game.paletteChanged, state->present.frameCount, state->input);
+    double packedNs = TimeThreadWrites(packed->paletteChanged, packed->frameCount, packed->input);
+
+    printf("game/presenter/window writes: split %.2f ns/iter, packed %.2f ns/iter\n", splitNs, packedNs);
+    return 0;
+}
+
+} // namespace
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (options.contention) {
+        return RunContentionBench();
+    }
+    if (!LoadBenchConfig(options)) {
+        return 2;
+    }
+
+    auto* dd = new DirectDrawImpl();
+    dd->SetCooperativeLevel(nullptr, DDSCL_NORMAL);
+    if (FAILED(dd->SetDisplayMode(options.width, options.height, options.bpp, 0, 0))) {
+        fprintf(stderr, "SetDisplayMode failed\n");
+        return 1;
+    }
+
+    // Primary with one back buffer, and an offscreen sprite sheet
+    DDSURFACEDESC2 desc = {};
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DDSD_CAPS | DDSD_BACKBUFFERCOUNT;
+    desc.ddsCaps.dwCaps = DDSCAPS_PRIMARYSURFACE | DDSCAPS_FLIP | DDSCAPS_COMPLEX;
+    desc.dwBackBufferCount = 1;
+
+    LPDIRECTDRAWSURFACE7 primarySurface = nullptr;
+    if (FAILED(dd->CreateSurface(&desc, &primarySurface, nullptr))) {
+        fprintf(stderr, "Creating the primary surface failed\n");
+        return 1;
+    }
+
+    DDSCAPS2 backCaps = {};
+    backCaps.dwCaps = DDSCAPS_BACKBUFFER;
+    LPDIRECTDRAWSURFACE7 backSurface = nullptr;
+    if (FAILED(primarySurface->GetAttachedSurface(&backCaps, &backSurface))) {
+        fprintf(stderr, "No back buffer\n");
+        return 1;
+    }
+
+    desc = {};
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT;
+    desc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN;
+    desc.dwWidth = kSpriteSize;
+    desc.dwHeight = kSpriteSize;
+
+    LPDIRECTDRAWSURFACE7 spriteSurface = nullptr;
+    if (FAILED(dd->CreateSurface(&desc, &spriteSurface, nullptr)) ||
+        !FillSprite(static_cast<SurfaceImpl*>(spriteSurface), options.bpp)) {
+        fprintf(stderr, "Creating the sprite surface failed\n");
+        return 1;
+    }
+
+    LPDIRECTDRAWPALETTE palette = nullptr;
+    if (options.bpp == 8) {
+        PALETTEENTRY entries[256];
+        for (int i = 0; i < 256; ++i) {
+            entries[i] = { static_cast<BYTE>(i), static_cast<BYTE>(255 - i), static_cast<BYTE>(i * 3), 0 };
+        }
+        dd->CreatePalette(DDPCAPS_8BIT, entries, &palette, nullptr);
+        primarySurface->SetPalette(palette);
+    }
+
+    // Run the frames
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    DDBLTFX fx = {};
+    fx.dwSize = sizeof(fx);
+    for (int frame = 0; frame < options.frames; ++frame) {
+        int scene = options.staticScene ? 0 : frame;
+        fx.dwFillColor = PatternColor(options.bpp, scene, scene);
+        backSurface->Blt(nullptr, nullptr, nullptr, DDBLT_COLORFILL | DDBLT_WAIT, &fx);
+
+        for (int s = 0; s < options.sprites; ++s) {
+            DWORD x = (s * 97 + scene * 3) % (options.width - kSpriteSize);
+            DWORD y = (s * 61 + scene * 2) % (options.height - kSpriteSize);
+            backSurface->BltFast(x, y, spriteSurface, nullptr, DDBLTFAST_NOCOLORKEY | DDBLTFAST_WAIT);
+        }
+
+        // One stretched blit per frame exercises the scaler
+        RECT stretched = { 0, 0, static_cast<LONG>(options.width / 2), static_cast<LONG>(options.height / 2) };
+        backSurface->Blt(&stretched, spriteSurface, nullptr, DDBLT_WAIT, nullptr);
+
+        // No vertical blank to wait for: flip as fast as frames are drawn
+        primarySurface->Flip(nullptr, DDFLIP_WAIT | DDFLIP_NOVSYNC);
+    }
+
+    std::shared_ptr<DeviceContext> device = dd->GetDeviceContext();
+    device->presenter.Flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Read the renderer's results before tearing anything down
+    int result = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(device->renderMutex);
+        auto* null = dynamic_cast<renderer::NullRenderer*>(device->present.renderer.get());
+        if (!null) {
+            fprintf(stderr, "The null renderer is not active\n");
+            result = 1;
+        } else {
+            renderer::RendererTimings timings = null->GetTimings();
+            printf("%dx%d %ubpp, %d sprites, %s blits, capture %s\n",
+                   static_cast<int>(options.width), static_cast<int>(options.height),
+                   static_cast<unsigned>(options.bpp), options.sprites,
+                   options.deferred ? "deferred" : "immediate", options.capture.c_str());
+            printf("frames: %d drawn, %llu presented, %llu dropped\n", options.frames,
+                   static_cast<unsigned long long>(timings.frames),
+                   static_cast<unsigned long long>(device->presenter.GetDroppedCount()));
+            printf("time: %.3f s, %.1f frames/s\n", seconds, options.frames / seconds);
+            printf("per presented frame: convert %.3f ms, capture %.3f ms\n",
+                   PerFrameMs(timings.convertMicros, timings.frames),
+                   PerFrameMs(timings.presentMicros, timings.frames));
+            if (device->present.framesCompared > 0) {
+                printf("unchanged: %llu of %llu frames skipped (%.1f%%)\n",
+                       static_cast<unsigned long long>(device->present.framesSkipped),
+                       static_cast<unsigned long long>(device->present.framesCompared),
+                       100.0 * GetFrameSkipRatio(*device));
+            }
+            if (device->present.frameExport) {
+                printf("exported: %llu frames to %s\n",
+                       static_cast<unsigned long long>(device->present.frameExport->GetPublishedCount()),
+                       options.exportName.c_str());
+            }
+            if (null->GetCapture() == NullCapture::Hash) {
+                printf("last frame hash: %016llx\n",
+                       static_cast<unsigned long long>(null->GetFrameHash()));
+            }
+            if (timings.frames == 0) {
+                fprintf(stderr, "No frame was presented\n");
+                result = 1;
+            }
+        }
+    }
+
+    if (palette) {
+        palette->Release();
+    }
+    spriteSurface->Release();
+    backSurface->Release();
+    primarySurface->Release();
+    dd->Release();
+    return result;
+}
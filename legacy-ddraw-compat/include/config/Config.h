@@ -51,18 +51,57 @@ struct Config {
     // Rendering Settings
     // ========================================================================
 
-    /** Renderer selection: auto, d3d9, opengl, gdi */
+    /** Renderer selection: auto, d3d9, opengl, gdi, null */
     std::string renderer = "auto";
 
+    /** What the null renderer keeps of each frame: discard, hash, store */
+    std::string nullCapture = "hash";
+
+    /** How the GDI renderer reaches the window: auto, bitblt, setdibits, stretchdibits */
+    std::string gdiPresent = "auto";
+
     /** Enable vertical synchronization */
     bool vsync = true;
 
     /** Maximum frames per second (0 = unlimited, -1 = auto) */
     int maxFps = 0;
 
+    /** Present only the tiles of a frame that changed, and nothing for an unchanged frame */
+    bool skipUnchanged = true;
+
     /** Shader file path (empty = no shader) */
     std::string shader;
 
+    /** Record all blits to offscreen surfaces and run them on worker threads */
+    bool deferredBlits = false;
+
+    /** Worker threads for deferred blits (0 = auto) */
+    int blitThreads = 0;
+
+    /** Pixel count above which one blit is split across cores (0 = never, -1 = measure) */
+    int tileThreshold = -1;
+
+    /** Surface base address and pitch alignment in bytes (16-4096, 64 = cache line) */
+    int surfaceAlignment = 64;
+
+    /** Surfaces of at least this many KB get their own virtual memory pages (0 = never) */
+    int pagedSurfaceKb = 256;
+
+    /** Back very large surfaces with large pages when the OS grants the privilege */
+    bool largePages = false;
+
+    /** Video memory in MB reported to the game and enforced at surface creation */
+    int videoMemoryMb = 256;
+
+    /** Merge identical idle offscreen surfaces into shared copy-on-write storage */
+    bool dedupSurfaces = false;
+
+    /** Seconds without access after which offscreen surfaces are compressed (0 = never) */
+    int compressIdleSeconds = 0;
+
+    /** Surface memory in MB allowed before idle surfaces are compressed (0 = always compress) */
+    int compressBudgetMb = 256;
+
     // ========================================================================
     // Compatibility Settings
     // ========================================================================
@@ -105,6 +144,15 @@ struct Config {
     /** Show FPS counter */
     bool showFps = false;
 
+    /** Publish presented frames to a shared-memory ring for external tools */
+    bool frameExport = false;
+
+    /** Name of the frame ring section (consumers open Local\<name>) */
+    std::string frameExportName = "ldc_frames";
+
+    /** Frames the ring holds (2-16) */
+    int frameExportSlots = 3;
+
     // ========================================================================
     // Hotkey Settings (virtual key codes, 0 = disabled)
     // ========================================================================
@@ -127,6 +175,16 @@ struct Config {
         return StringToRendererType(renderer);
     }
 
+    /** Get null renderer capture mode from string setting */
+    NullCapture GetNullCapture() const {
+        return StringToNullCapture(nullCapture);
+    }
+
+    /** Get GDI present method from string setting */
+    GDIPresentMethod GetGDIPresentMethod() const {
+        return StringToGDIPresentMethod(gdiPresent);
+    }
+
     /** Get log level enum from string setting */
     LogLevel GetLogLevel() const {
         return StringToLogLevel(logLevel);
@@ -0,0 +1,130 @@
+/**
+ * @file BlitQueue.h
+ * @brief Deferred blit command queue for legacy-ddraw-compat
+ *
+ * Records blits instead of executing them on the game thread. Each
+ * command declares the surface regions it reads and writes; commands
+ * whose regions overlap run in submission order, everything else runs
+ * in parallel on a small pool of worker threads.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include "core/Fence.h"
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace ldc::core {
+
+// ============================================================================
+// Blit Access Description
+// ============================================================================
+
+/**
+ * @brief A surface region a queued command reads or writes
+ */
+struct BlitAccess {
+    /** Identity of the surface (compared only, never dereferenced) */
+    const void* resource = nullptr;
+
+    /** Fence signalled once all queued work touching the surface is done */
+    Fence* fence = nullptr;
+
+    /** Region touched */
+    RECT rect{};
+
+    /** Whether the region is written */
+    bool write = false;
+};
+
+/**
+ * @brief Queue statistics
+ */
+struct BlitQueueStats {
+    uint64_t submitted = 0;
+    uint64_t executed = 0;
+    uint64_t dependencies = 0;
+    uint64_t maxDepth = 0;
+};
+
+// ============================================================================
+// Blit Queue
+// ============================================================================
+
+/**
+ * @brief Dependency-tracking command queue executed by worker threads
+ *
+ * Every access enqueues a value on its surface's fence; values are
+ * signalled in submission order per surface, so waiting for a fence to
+ * go idle flushes exactly the work that touches that surface.
+ */
+class BlitQueue {
+public:
+    /**
+     * @brief Create the queue and start its workers
+     * @param workerCount Number of worker threads (0 = pick from CPU count)
+     */
+    explicit BlitQueue(uint32_t workerCount = 0);
+
+    /**
+     * @brief Drain outstanding work and stop the workers
+     */
+    ~BlitQueue();
+
+    BlitQueue(const BlitQueue&) = delete;
+    BlitQueue& operator=(const BlitQueue&) = delete;
+
+    /**
+     * @brief Record a command
+     * @param work Pixel work to run on a worker thread
+     * @param accesses Regions the work reads and writes
+     * @param count Number of entries in accesses
+     *
+     * Accesses to the same resource are merged. Returns without waiting.
+     */
+    void Submit(std::function<void()> work, const BlitAccess* accesses, size_t count);
+
+    /**
+     * @brief Block until every submitted command has executed
+     */
+    void Drain();
+
+    /** Number of worker threads */
+    uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    /** Snapshot of the queue statistics */
+    BlitQueueStats GetStats() const;
+
+private:
+    struct Command {
+        std::function<void()> work;
+        std::vector<BlitAccess> accesses;
+        std::vector<uint64_t> fenceValues;
+        std::vector<Command*> dependents;
+        uint32_t unresolved = 0;
+        uint32_t holds = 0;
+        bool done = false;
+    };
+
+    /** Commands touching one resource, oldest first, until their fence value is signalled */
+    using PendingList = std::deque<std::pair<uint64_t, Command*>>;
+
+    void WorkerProc();
+    void Retire(Command* cmd);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_idleCv;
+
+    std::vector<std::thread> m_workers;
+    std::deque<Command*> m_ready;
+    std::unordered_map<const void*, PendingList> m_pending;
+    size_t m_outstanding = 0;
+    bool m_stopping = false;
+
+    BlitQueueStats m_stats;
+};
+
+} // namespace ldc::core
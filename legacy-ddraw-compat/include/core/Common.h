@@ -31,8 +31,10 @@
 #include <mutex>
 #include <atomic>
 #include <array>
+#include <algorithm>
 #include <unordered_map>
 #include <functional>
+#include <type_traits>
 
 // Link required libraries
 #pragma comment(lib, "winmm.lib")
@@ -45,6 +47,11 @@ namespace ldc {
 
 #define LDC_UNUSED(x) (void)(x)
 
+// SSE2 is baseline on every x64 target and on the x86 targets we ship for
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define LDC_HAVE_SSE2 1
+#endif
+
 // ============================================================================
 // Log Level Enumeration
 // ============================================================================
@@ -85,7 +92,8 @@ enum class RendererType {
     Auto = 0,   // Auto-detect best available
     GDI = 1,    // GDI (always available)
     OpenGL = 2, // OpenGL
-    D3D9 = 3    // Direct3D 9
+    D3D9 = 3,   // Direct3D 9
+    Null = 4    // Presents into memory; headless benchmarking and tests
 };
 
 inline const char* RendererTypeToString(RendererType type) {
@@ -94,6 +102,7 @@ inline const char* RendererTypeToString(RendererType type) {
         case RendererType::GDI:    return "gdi";
         case RendererType::OpenGL: return "opengl";
         case RendererType::D3D9:   return "d3d9";
+        case RendererType::Null:   return "null";
         default: return "unknown";
     }
 }
@@ -103,9 +112,52 @@ inline RendererType StringToRendererType(const std::string& str) {
     if (str == "gdi" || str == "GDI") return RendererType::GDI;
     if (str == "opengl" || str == "OpenGL") return RendererType::OpenGL;
     if (str == "d3d9" || str == "D3D9" || str == "direct3d9") return RendererType::D3D9;
+    if (str == "null" || str == "Null") return RendererType::Null;
     return RendererType::Auto;  // Default
 }
 
+/**
+ * @brief What the null renderer keeps of each presented frame
+ */
+enum class NullCapture {
+    Discard = 0, // Convert and drop
+    Hash = 1,    // Hash every frame, for regression checks
+    Store = 2    // Keep the last frame readable
+};
+
+inline NullCapture StringToNullCapture(const std::string& str) {
+    if (str == "discard" || str == "Discard") return NullCapture::Discard;
+    if (str == "store" || str == "Store") return NullCapture::Store;
+    return NullCapture::Hash;  // Default
+}
+
+/**
+ * @brief How the GDI renderer copies a frame to the window
+ */
+enum class GDIPresentMethod {
+    Auto = 0,          // Time the others at startup and keep the fastest
+    BitBlt = 1,        // DIB section selected into a memory DC; BitBlt, StretchBlt when scaling
+    SetDIBits = 2,     // SetDIBitsToDevice from the frame buffer; StretchDIBits when scaling
+    StretchDIBits = 3  // StretchDIBits from the frame buffer, scaled or not
+};
+
+inline const char* GDIPresentMethodToString(GDIPresentMethod method) {
+    switch (method) {
+        case GDIPresentMethod::Auto:          return "auto";
+        case GDIPresentMethod::BitBlt:        return "bitblt";
+        case GDIPresentMethod::SetDIBits:     return "setdibits";
+        case GDIPresentMethod::StretchDIBits: return "stretchdibits";
+        default: return "unknown";
+    }
+}
+
+inline GDIPresentMethod StringToGDIPresentMethod(const std::string& str) {
+    if (str == "bitblt" || str == "BitBlt") return GDIPresentMethod::BitBlt;
+    if (str == "setdibits" || str == "SetDIBits") return GDIPresentMethod::SetDIBits;
+    if (str == "stretchdibits" || str == "StretchDIBits") return GDIPresentMethod::StretchDIBits;
+    return GDIPresentMethod::Auto;  // Default
+}
+
 // ============================================================================
 // NonCopyable Base Class
 // ============================================================================
@@ -118,6 +170,40 @@ protected:
     NonCopyable& operator=(const NonCopyable&) = delete;
 };
 
+// ============================================================================
+// Rectangle Helpers
+// ============================================================================
+
+/** Check whether a rectangle covers no pixels */
+inline bool RectIsEmpty(const RECT& r) {
+    return r.right <= r.left || r.bottom <= r.top;
+}
+
+/** Intersect two rectangles; returns false when they do not overlap */
+inline bool RectIntersect(RECT& out, const RECT& a, const RECT& b) {
+    RECT r = {
+        (std::max)(a.left, b.left),
+        (std::max)(a.top, b.top),
+        (std::min)(a.right, b.right),
+        (std::min)(a.bottom, b.bottom)
+    };
+    out = r;
+    return !RectIsEmpty(r);
+}
+
+/** Smallest rectangle containing both inputs (empty inputs are ignored) */
+inline RECT RectUnion(const RECT& a, const RECT& b) {
+    if (RectIsEmpty(a)) return b;
+    if (RectIsEmpty(b)) return a;
+    RECT r = {
+        (std::min)(a.left, b.left),
+        (std::min)(a.top, b.top),
+        (std::max)(a.right, b.right),
+        (std::max)(a.bottom, b.bottom)
+    };
+    return r;
+}
+
 // ============================================================================
 // Debug Logging
 // ============================================================================
@@ -133,64 +219,88 @@ inline void DebugLog(const char* fmt, ...) {
 }
 
 // ============================================================================
-// Global State - Single point of state for the entire wrapper
+// Cross-Thread Snapshots
 // ============================================================================
 
+/** Cache line size used to keep data written by different threads apart */
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * @brief Small value published by one thread and read by others without a lock
+ *
+ * A sequence counter guards the copy: writers make it odd while they
+ * store, readers retry when it was odd or changed under them. Reads never
+ * write shared memory, so a reader on another core costs the writer nothing.
+ */
+template <typename T>
+class Snapshot {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot needs a trivially copyable type");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "Snapshot size must be a multiple of 4");
+
+public:
+    Snapshot() { Store(T{}); }
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    /** Publish a new value; concurrent writers are serialised */
+    void Store(const T& value) {
+        uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+        while ((seq & 1) || !m_sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                              std::memory_order_relaxed)) {
+            seq = m_sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint32_t words[kWords];
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /** Read a consistent copy of the latest value */
+    T Load() const {
+        uint32_t words[kWords];
+        for (;;) {
+            uint32_t seq = m_sequence.load(std::memory_order_acquire);
+            if (seq & 1) {
+                continue;
+            }
+            for (size_t i = 0; i < kWords; ++i) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = sizeof(T) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> m_sequence{0};
+    std::atomic<uint32_t> m_words[kWords];
+};
+
+// ============================================================================
+// Global State - Process-wide wrapper state
+// ============================================================================
+
+/**
+ * @brief State shared by the whole module
+ *
+ * Everything tied to a window or display mode lives in the DeviceContext
+ * of the DirectDraw object that owns it.
+ */
 struct GlobalState {
     // Module handle
     HMODULE hModule = nullptr;
     bool initialized = false;
-
-    // Window state
-    HWND hWnd = nullptr;
-    WNDPROC originalWndProc = nullptr;
-    DWORD coopLevel = 0;
-
-    // Game's requested display mode
-    DWORD gameWidth = 640;
-    DWORD gameHeight = 480;
-    DWORD gameBpp = 8;
-    DWORD gameRefresh = 0;
-    bool displayModeSet = false;
-
-    // Actual render target size (window client area)
-    DWORD renderWidth = 640;
-    DWORD renderHeight = 480;
-
-    // Scaling for mouse coordinates
-    float scaleX = 1.0f;
-    float scaleY = 1.0f;
-    int offsetX = 0;
-    int offsetY = 0;
-
-    // GDI rendering resources
-    HDC hdcWindow = nullptr;
-    HDC hdcMem = nullptr;
-    HBITMAP hBitmap = nullptr;
-    HBITMAP hBitmapOld = nullptr;
-    void* bitmapBits = nullptr;
-    DWORD bitmapWidth = 0;
-    DWORD bitmapHeight = 0;
-
-    // Palette for 8-bit mode (as RGBQUAD for SetDIBitsToDevice)
-    RGBQUAD palette[256] = {};
-    uint32_t palette32[256] = {};  // As ARGB for conversion
-    bool paletteChanged = true;
-
-    // Primary surface pixel data
-    std::vector<uint8_t> primaryPixels;
-    DWORD primaryPitch = 0;
-
-    // Converted 32-bit buffer for rendering
-    std::vector<uint32_t> renderBuffer;
-
-    // Thread safety
-    std::recursive_mutex renderMutex;
-
-    // Statistics
-    DWORD frameCount = 0;
-    DWORD lastFpsTime = 0;
-    DWORD fps = 0;
 };
 
 // Global state instance
@@ -203,30 +313,6 @@ extern GlobalState g_state;
 bool InitializeWrapper();
 void ShutdownWrapper();
 
-// ============================================================================
-// Rendering
-// ============================================================================
-
-bool CreateRenderTarget(DWORD width, DWORD height, DWORD bpp);
-void DestroyRenderTarget();
-void PresentPrimaryToScreen();
-
-// ============================================================================
-// Window Management
-// ============================================================================
-
-void SubclassWindow(HWND hWnd);
-void UnsubclassWindow();
-LRESULT CALLBACK WrapperWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
-
-// ============================================================================
-// Mouse Coordinate Transformation
-// ============================================================================
-
-void UpdateScaling();
-POINT TransformMouseToGame(POINT pt);
-POINT TransformGameToScreen(POINT pt);
-
 // ============================================================================
 // Hooked Windows API Functions
 // ============================================================================
@@ -0,0 +1,315 @@
+/**
+ * @file DeviceContext.h
+ * @brief Per-device render state for legacy-ddraw-compat
+ *
+ * Each DirectDraw object owns one DeviceContext holding its window,
+ * display mode, palette, render target, mouse mapping, presenter and
+ * statistics. Surfaces keep a reference to their device's context, so
+ * two DirectDraw objects (a game and its video player, or devices in a
+ * test) never share a render target.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include "core/FrameExporter.h"
+#include "core/Presenter.h"
+#include "core/TileHasher.h"
+#include "renderer/IRenderer.h"
+
+namespace ldc {
+
+/**
+ * @brief Window-to-game coordinate mapping
+ *
+ * Computed on whichever thread changes the mode or window size and read
+ * by the window procedure for every mouse message.
+ */
+struct InputMapping {
+    // Game resolution the mapping clamps to
+    DWORD gameWidth = 640;
+    DWORD gameHeight = 480;
+
+    // Actual render target size (window client area)
+    DWORD renderWidth = 640;
+    DWORD renderHeight = 480;
+
+    // Scaling for mouse coordinates
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    int offsetX = 0;
+    int offsetY = 0;
+};
+
+/**
+ * @brief Window identity
+ *
+ * Set by SetCooperativeLevel, read by every thread.
+ */
+struct alignas(kCacheLineSize) WindowState {
+    HWND hWnd = nullptr;
+    DWORD coopLevel = 0;
+
+    // Window this device subclassed for mouse mapping, if any
+    HWND subclassedWnd = nullptr;
+    WNDPROC originalWndProc = nullptr;
+
+    // Set by the window procedure when the window lost its pixels or
+    // changed size and could not be redrawn; the next present then shows
+    // the whole frame instead of the tiles that changed
+    std::atomic<bool> repaintPending{false};
+};
+
+/**
+ * @brief Display mode and palette, written by the game thread
+ */
+struct alignas(kCacheLineSize) GameState {
+    // Game's requested display mode
+    DWORD width = 640;
+    DWORD height = 480;
+    DWORD bpp = 8;
+    DWORD refresh = 0;
+    bool displayModeSet = false;
+
+    // Set by the game when it changes the palette, cleared by the consumer
+    std::atomic<bool> paletteChanged{true};
+
+    // Changes to the primary's palette not yet on screen; the next present
+    // applies them all in one conversion
+    std::atomic<uint32_t> paletteChanges{0};
+
+    // Set when the game changes the gamma ramp, cleared by the next present
+    std::atomic<bool> gammaChanged{false};
+
+    // Default palette for 8-bit mode, used until the game attaches one
+    // (as RGBQUAD for SetDIBitsToDevice)
+    alignas(kCacheLineSize) RGBQUAD palette[256] = {};
+    uint32_t palette32[256] = {};  // As ARGB for conversion
+};
+
+/**
+ * @brief Presentation state, owned by whoever holds renderMutex
+ *
+ * That is the presenter thread for flipped frames and the game thread
+ * for synchronous presents; nothing here is touched without the mutex.
+ */
+struct alignas(kCacheLineSize) PresentState {
+    // Backend presenting to the window, and the game size it was set up for
+    std::unique_ptr<renderer::IRenderer> renderer;
+    DWORD bitmapWidth = 0;
+    DWORD bitmapHeight = 0;
+
+    // Window client size the renderer was last given. WM_SIZE only
+    // publishes the new size in the input mapping; the next present or
+    // repaint passes it on, so the window thread never waits for the mutex.
+    DWORD rendererWindowWidth = 0;
+    DWORD rendererWindowHeight = 0;
+
+    // Shared-memory ring every presented frame is also published to, if
+    // enabled; outlives render target changes
+    std::unique_ptr<core::FrameExporter> frameExport;
+
+    // Image presented to the window: the front buffer's own storage, or
+    // primaryPixels when overlays are composed over it
+    const uint8_t* presentPixels = nullptr;
+    DWORD primaryPitch = 0;
+    DWORD primaryBpp = 0;
+
+    // LUT of the palette attached to the primary; the device's default
+    // palette is used while none is attached
+    const uint32_t* paletteLut = nullptr;
+
+    // Palette the last 8-bit frame was presented with, to tell renderers
+    // when it changed
+    const uint32_t* presentedPalette = nullptr;
+
+    // Content hashes of the frame the window shows, per tile. With
+    // skipUnchanged, a full present compares against them and presents
+    // only the tiles that changed, or nothing; window is the client size
+    // the last compared frame was presented at.
+    bool skipUnchanged = false;
+    core::TileHasher tiles;
+    DWORD tilesWindowWidth = 0;
+    DWORD tilesWindowHeight = 0;
+
+    // Composition scratch for the primary (only used while overlays are shown)
+    std::vector<uint8_t> primaryPixels;
+
+    // Gamma ramp as set by the game and as one 8-bit table per channel;
+    // gammaActive is false while the ramp is the identity
+    DDGAMMARAMP gammaRamp = {};
+    bool gammaActive = false;
+    uint8_t gammaRed[256] = {};
+    uint8_t gammaGreen[256] = {};
+    uint8_t gammaBlue[256] = {};
+
+    // RGB565 expansion tables with the ramp applied, each entry already
+    // shifted into its place in the 32-bit pixel
+    uint32_t expandRed565[32] = {};
+    uint32_t expandGreen565[64] = {};
+    uint32_t expandBlue565[32] = {};
+
+    // 8-bit LUT with the ramp folded in, and the palette LUT it came from
+    uint32_t gammaPaletteLut[256] = {};
+    const uint32_t* gammaPaletteSource = nullptr;
+
+    // Statistics (fps and paletteChangesLastFrame may be read without the mutex)
+    DWORD frameCount = 0;
+    DWORD lastFpsTime = 0;
+    DWORD lastPresentTime = 0;
+    std::atomic<DWORD> fps{0};
+
+    // Palette changes per frame: those folded into the last present, and
+    // totals over the frames that applied any
+    std::atomic<DWORD> paletteChangesLastFrame{0};
+    uint64_t paletteChangesApplied = 0;
+    uint64_t paletteFrames = 0;
+    DWORD paletteChangesMax = 0;
+
+    // Window redraws served from the renderer's retained image
+    uint64_t repaints = 0;
+
+    // Full presents compared against the tile hashes, and those skipped
+    // because nothing had changed
+    uint64_t framesCompared = 0;
+    uint64_t framesSkipped = 0;
+};
+
+/**
+ * @brief Render state of one DirectDraw object
+ *
+ * Split into blocks that each start a cache line: each block is written
+ * by one thread (or under one lock), so the game, presenter and window
+ * threads never invalidate each other's lines. Data that crosses threads
+ * is handed over through atomics, the input snapshot, or renderMutex.
+ *
+ * Shared by the DirectDraw object and its surfaces; destroying the last
+ * reference stops the presenter, frees the render target and restores
+ * the window procedure.
+ */
+struct DeviceContext {
+    DeviceContext();
+    ~DeviceContext();
+    DeviceContext(const DeviceContext&) = delete;
+    DeviceContext& operator=(const DeviceContext&) = delete;
+
+    WindowState window;
+    GameState game;
+    PresentState present;
+
+    // Written on mode changes and WM_SIZE, read per mouse message
+    alignas(kCacheLineSize) Snapshot<InputMapping> input;
+
+    // Guards the present block; on its own line so waiters do not
+    // disturb the holder's data
+    alignas(kCacheLineSize) std::recursive_mutex renderMutex;
+
+    // Presents this device's flipped frames
+    core::Presenter presenter;
+};
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+bool CreateRenderTarget(DeviceContext& device, DWORD width, DWORD height, DWORD bpp,
+                        RendererType type = RendererType::Auto);
+void DestroyRenderTarget(DeviceContext& device);
+/**
+ * @brief Present the primary to the window (and the frame ring, if enabled)
+ * @param device Device to present
+ * @param pDirty Areas that changed since the previous present, or null
+ *               for the whole image
+ * @param dirtyCount Number of areas
+ */
+void PresentPrimaryToScreen(DeviceContext& device, const RECT* pDirty = nullptr, DWORD dirtyCount = 1);
+
+/**
+ * @brief Publish the device's presented frames to a shared-memory ring
+ * @param device Device whose frames to export
+ * @param name Section name (see core::FrameExporter::Open)
+ * @param slotCount Frames the ring holds
+ * @return false if the section could not be created
+ *
+ * Slots are sized for the current game resolution or 1920x1080, whichever
+ * is larger. Calling it again while exporting does nothing.
+ */
+bool EnableFrameExport(DeviceContext& device, const std::string& name, DWORD slotCount);
+
+/**
+ * @brief Skip presents of unchanged content
+ * @param device Device to configure
+ * @param enabled true to compare full presents tile by tile against the
+ *                last one and present only what changed
+ *
+ * A frame with no changed tile, the same palette and gamma ramp and the
+ * same window size is neither converted nor blitted. Presents that come
+ * with their own damage are passed through as they are.
+ */
+void SetFrameSkipping(DeviceContext& device, bool enabled);
+
+/**
+ * @brief Fraction of compared frames skipped because nothing changed
+ * @return framesSkipped / framesCompared, 0 before the first comparison
+ */
+double GetFrameSkipRatio(DeviceContext& device);
+
+/**
+ * @brief Redraw the window with the last presented frame
+ * @param device Device whose window needs repainting
+ *
+ * @return false if another thread was presenting and the window was not
+ *         redrawn; the present after it shows the whole frame instead
+ *
+ * For WM_PAINT, restores and resizes: the renderer draws its retained
+ * image at the window size published by UpdateScaling, so a paused game
+ * repaints without converting the primary. A renderer that keeps none
+ * presents the primary again. Never waits for a present in progress,
+ * which may itself be waiting on the window thread.
+ */
+bool RepaintWindow(DeviceContext& device);
+
+/**
+ * @brief Show queued palette and gamma changes if a virtual vertical blank has passed
+ * @param device Device whose primary palette or gamma ramp changed
+ * @param vblank true when called at a vertical blank the game waited for
+ *
+ * Palette and gamma changes only queue; this presents at most once per
+ * refresh period, so a fade that rewrites the palette many times between
+ * two frames converts the primary once. A change that has to wait is
+ * shown by the presenter thread at the end of the period if nothing else
+ * presents first.
+ */
+void FlushPaletteChanges(DeviceContext& device, bool vblank);
+
+// ============================================================================
+// Gamma
+// ============================================================================
+
+/**
+ * @brief Replace the device's gamma ramp
+ *
+ * Rebuilds the per-channel and RGB565 tables; conversion applies them as
+ * it expands pixels, so gamma never costs a pass of its own. The change
+ * is shown like a palette change.
+ */
+void SetGammaRamp(DeviceContext& device, const DDGAMMARAMP& ramp);
+void GetGammaRamp(DeviceContext& device, DDGAMMARAMP& ramp);
+
+// ============================================================================
+// Window Management
+// ============================================================================
+
+void SubclassWindow(DeviceContext& device, HWND hWnd);
+void UnsubclassWindow(DeviceContext& device);
+LRESULT CALLBACK WrapperWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+// ============================================================================
+// Mouse Coordinate Transformation
+// ============================================================================
+
+void UpdateScaling(DeviceContext& device);
+POINT TransformMouseToGame(const DeviceContext& device, POINT pt);
+POINT TransformGameToScreen(const DeviceContext& device, POINT pt);
+
+} // namespace ldc
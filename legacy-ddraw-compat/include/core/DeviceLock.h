@@ -0,0 +1,134 @@
+/**
+ * @file DeviceLock.h
+ * @brief Process-wide DirectDraw lock for legacy-ddraw-compat
+ *
+ * The lock behind AcquireDDThreadLock/ReleaseDDThreadLock. Games that
+ * pass DDSCL_MULTITHREADED also get it around every DirectDraw call that
+ * changes state or touches pixels; single-threaded games never take it.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include <condition_variable>
+
+namespace ldc::core {
+
+/**
+ * @brief Device lock statistics
+ */
+struct DeviceLockStats {
+    uint64_t contended = 0;      // Acquisitions that missed the fast path
+    uint64_t spinAcquired = 0;   // Of those, taken while spinning
+    uint64_t blocked = 0;        // Of those, taken after sleeping
+    uint32_t spinLimit = 0;      // Current adaptive spin count
+};
+
+/**
+ * @brief Recursive lock with an uncontended fast path and adaptive spinning
+ *
+ * Taking a free lock is one compare-exchange of the owner thread id.
+ * A contended caller spins for a while before sleeping; the spin count
+ * follows how long recent spins needed, so short holds never sleep and
+ * long holds stop wasting cycles.
+ */
+class DeviceLock {
+public:
+    /** Initial and bounding spin counts */
+    static constexpr uint32_t kInitialSpin = 1000;
+    static constexpr uint32_t kMinSpin = 50;
+    static constexpr uint32_t kMaxSpin = 20000;
+
+    static DeviceLock& Instance();
+
+    DeviceLock() = default;
+    DeviceLock(const DeviceLock&) = delete;
+    DeviceLock& operator=(const DeviceLock&) = delete;
+
+    /** Acquire the lock; a thread that holds it may acquire it again */
+    void Lock() {
+        DWORD self = GetCurrentThreadId();
+        if (m_owner.load(std::memory_order_relaxed) == self) {
+            ++m_recursion;
+            return;
+        }
+        DWORD expected = 0;
+        if (!m_owner.compare_exchange_strong(expected, self, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+            LockContended(self);
+        }
+        m_recursion = 1;
+    }
+
+    /** Try to acquire the lock without waiting */
+    bool TryLock();
+
+    /** Release one level of the lock */
+    void Unlock() {
+        if (--m_recursion > 0) {
+            return;
+        }
+        m_owner.store(0, std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_seq_cst) > 0) {
+            WakeWaiter();
+        }
+    }
+
+    /** Whether the calling thread holds the lock */
+    bool IsHeldByCurrentThread() const {
+        return m_owner.load(std::memory_order_relaxed) == GetCurrentThreadId();
+    }
+
+    /** Snapshot of the statistics */
+    DeviceLockStats GetStats() const;
+
+private:
+    void LockContended(DWORD self);
+    void WakeWaiter();
+
+    // Owning thread id (0 = free) and its nesting depth
+    std::atomic<DWORD> m_owner{0};
+    uint32_t m_recursion = 0;
+
+    // Spin count, adapted to recent hold times
+    std::atomic<uint32_t> m_spinLimit{kInitialSpin};
+
+    // Sleeping waiters
+    std::atomic<uint32_t> m_waiters{0};
+    std::mutex m_waitMutex;
+    std::condition_variable m_waitCv;
+
+    std::atomic<uint64_t> m_contended{0};
+    std::atomic<uint64_t> m_spinAcquired{0};
+    std::atomic<uint64_t> m_blocked{0};
+};
+
+/**
+ * @brief Scoped device lock that is only taken when enabled
+ *
+ * Constructed with the device's multithreaded flag, so single-threaded
+ * games pay one branch per call.
+ */
+class DeviceLockGuard {
+public:
+    explicit DeviceLockGuard(bool enabled)
+        : m_lock(enabled ? &DeviceLock::Instance() : nullptr) {
+        if (m_lock) {
+            m_lock->Lock();
+        }
+    }
+
+    ~DeviceLockGuard() {
+        if (m_lock) {
+            m_lock->Unlock();
+        }
+    }
+
+    DeviceLockGuard(const DeviceLockGuard&) = delete;
+    DeviceLockGuard& operator=(const DeviceLockGuard&) = delete;
+
+private:
+    DeviceLock* m_lock;
+};
+
+} // namespace ldc::core
@@ -0,0 +1,87 @@
+/**
+ * @file Fence.h
+ * @brief Completion fences for asynchronous surface work
+ *
+ * A fence hands out increasing values for queued work and records the
+ * highest value completed. Completing a value implies every earlier one
+ * is done, so superseded work simply signals a newer value.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include <chrono>
+#include <condition_variable>
+
+namespace ldc::core {
+
+/**
+ * @brief Time spent blocked on a fence
+ */
+struct FenceStats {
+    uint64_t waitCount = 0;
+    uint64_t totalWaitMicros = 0;
+    uint64_t maxWaitMicros = 0;
+};
+
+/**
+ * @brief Monotonic completion fence
+ */
+class Fence {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Reserve a value for new work
+     * @return Value to signal when the work completes
+     */
+    uint64_t Enqueue();
+
+    /**
+     * @brief Mark work up to and including value as complete
+     */
+    void Signal(uint64_t value);
+
+    /** Value of the most recently enqueued work */
+    uint64_t GetLastEnqueued() const { return m_enqueued.load(std::memory_order_acquire); }
+
+    /** Check whether work up to value has completed */
+    bool IsComplete(uint64_t value) const { return m_completed.load(std::memory_order_acquire) >= value; }
+
+    /** Check whether all enqueued work has completed */
+    bool IsIdle() const { return IsComplete(GetLastEnqueued()); }
+
+    /**
+     * @brief Block until value completes
+     *
+     * Time spent blocked is added to the fence statistics.
+     */
+    void Wait(uint64_t value);
+
+    /**
+     * @brief Block until all enqueued work completes
+     */
+    void WaitIdle() { Wait(GetLastEnqueued()); }
+
+    /**
+     * @brief Account for a wait measured outside the fence
+     * @param start Time the caller started waiting
+     */
+    void RecordWait(Clock::time_point start);
+
+    /** Snapshot of the wait statistics */
+    FenceStats GetStats() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    std::atomic<uint64_t> m_enqueued{0};
+    std::atomic<uint64_t> m_completed{0};
+
+    std::atomic<uint64_t> m_waitCount{0};
+    std::atomic<uint64_t> m_totalWaitMicros{0};
+    std::atomic<uint64_t> m_maxWaitMicros{0};
+};
+
+} // namespace ldc::core
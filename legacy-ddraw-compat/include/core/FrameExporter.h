@@ -0,0 +1,79 @@
+/**
+ * @file FrameExporter.h
+ * @brief Publishes presented frames into a shared-memory ring
+ *
+ * A present-stage sink for capture, streaming and analysis tools: every
+ * frame the device presents is converted to 32-bit XRGB straight into a
+ * slot of a named shared-memory section (see core/FrameRing.h), where
+ * other processes read it in place. Publishing never waits for a reader;
+ * a reader that falls behind loses frames, never the game.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include "core/FrameRing.h"
+#include "renderer/IRenderer.h"
+
+namespace ldc::core {
+
+/** Slot capacity used when the game's frames are smaller */
+constexpr uint32_t kFrameExportMinWidth = 1920;
+constexpr uint32_t kFrameExportMinHeight = 1080;
+
+/**
+ * @brief Writer side of a frame ring
+ *
+ * Used under the device renderMutex, like the renderer it follows.
+ */
+class FrameExporter : public NonCopyable {
+public:
+    FrameExporter() = default;
+    ~FrameExporter();
+
+    /**
+     * @brief Create the shared section
+     * @param name Section name; consumers open "Local\<name>"
+     * @param slotCount Frames the ring holds (at least 2)
+     * @param maxWidth Widest frame a slot holds
+     * @param maxHeight Tallest frame a slot holds
+     * @return false if the section could not be created or another
+     *         writer already owns the name
+     */
+    bool Open(const std::string& name, uint32_t slotCount, uint32_t maxWidth, uint32_t maxHeight);
+
+    /** Remove the section; consumers that still map it keep their view */
+    void Close();
+
+    bool IsOpen() const { return m_header != nullptr; }
+
+    /**
+     * @brief Publish a presented frame
+     * @param frame Frame as handed to the renderer
+     * @param rects Areas that changed since the previous frame, or null
+     *              for the whole frame
+     * @param count Number of rects
+     *
+     * Only the changed areas are converted; the rest of the slot is copied
+     * from the previous frame, and the areas are recorded as the frame's
+     * damage. Frames larger than the slots are skipped.
+     */
+    void Publish(const renderer::PresentFrame& frame, const RECT* rects = nullptr, uint32_t count = 0);
+
+    /** Frames written to the ring */
+    uint64_t GetPublishedCount() const { return m_published; }
+
+    /** Frames too large for a slot */
+    uint64_t GetSkippedCount() const { return m_skipped; }
+
+private:
+    HANDLE m_mapping = nullptr;
+    uint8_t* m_view = nullptr;
+    FrameRingHeader* m_header = nullptr;
+
+    uint64_t m_sequence = 0;
+    uint64_t m_published = 0;
+    uint64_t m_skipped = 0;
+};
+
+} // namespace ldc::core
@@ -0,0 +1,107 @@
+/**
+ * @file FrameRing.h
+ * @brief Layout of the shared-memory frame ring
+ *
+ * The wrapper publishes every presented frame as 32-bit XRGB into a named
+ * shared-memory section. External tools map the section read-only and
+ * read frames in place. This header only needs the standard library, so
+ * consumers can include it on its own.
+ *
+ * Layout: FrameRingHeader, then slotCount FrameRingSlot headers, then
+ * the pixels of each slot at its pixelOffset.
+ *
+ * The writer never waits for readers. Frame n goes to slot
+ * (n - 1) % slotCount. The writer zeroes the slot's sequence while it
+ * rewrites the slot and stores n once the slot is complete. A reader
+ * loads the sequence, uses the pixels, then loads the sequence again. If
+ * the two loads differ, the writer lapped the reader and the frame must
+ * be thrown away.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ldc::core {
+
+/** 'LDCF' */
+constexpr uint32_t kFrameRingMagic = 0x4643444C;
+constexpr uint32_t kFrameRingVersion = 1;
+
+/** Damage rectangles a slot can describe */
+constexpr uint32_t kFrameRingMaxDamageRects = 16;
+
+/** Pixel format of every slot: 32-bit, bytes B, G, R, unused */
+constexpr uint32_t kFrameRingFormatXRGB8888 = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the ring's atomics must be usable across processes");
+
+struct FrameRingRect {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+/**
+ * @brief One frame in the ring
+ */
+struct alignas(64) FrameRingSlot {
+    /** Frame held by the slot, 0 while empty or being rewritten */
+    std::atomic<uint64_t> sequence;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;         // Bytes per row
+    uint32_t damageCount;   // Areas that changed since the previous frame
+
+    /** Performance-counter ticks (see timerFrequency) */
+    uint64_t captureTime;   // Frame reached the present stage
+    uint64_t publishTime;   // Slot complete
+
+    /** Offset of the pixels from the start of the section */
+    uint64_t pixelOffset;
+
+    FrameRingRect damage[kFrameRingMaxDamageRects];
+};
+
+/**
+ * @brief Start of the section
+ */
+struct alignas(64) FrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t slotCount;
+
+    /** Largest frame a slot holds; bigger frames are not published */
+    uint32_t maxWidth;
+    uint32_t maxHeight;
+
+    /** Bytes of the whole section */
+    uint64_t sectionSize;
+
+    /** Performance-counter ticks per second */
+    uint64_t timerFrequency;
+
+    /** Newest complete frame, 0 before the first */
+    std::atomic<uint64_t> latestSequence;
+};
+
+/** Slot headers follow the ring header */
+inline FrameRingSlot* GetFrameRingSlots(FrameRingHeader* header) {
+    return reinterpret_cast<FrameRingSlot*>(header + 1);
+}
+
+inline const FrameRingSlot* GetFrameRingSlots(const FrameRingHeader* header) {
+    return reinterpret_cast<const FrameRingSlot*>(header + 1);
+}
+
+/** Slot frame sequence is (or was) published in */
+inline uint32_t GetFrameRingSlotIndex(const FrameRingHeader* header, uint64_t sequence) {
+    return static_cast<uint32_t>((sequence - 1) % header->slotCount);
+}
+
+} // namespace ldc::core
@@ -0,0 +1,49 @@
+/**
+ * @file Hash.h
+ * @brief Fast non-cryptographic hashing of pixel data for legacy-ddraw-compat
+ *
+ * Used to find identical surface contents. Equal hashes are always
+ * confirmed with a byte comparison before anything is merged.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc::core {
+
+/**
+ * @brief Hash a block of memory
+ * @param data Bytes to hash
+ * @param size Number of bytes
+ * @param seed Starting value, to chain hashes of several blocks
+ * @return 64-bit hash
+ *
+ * Processes eight bytes per multiply, so hashing runs at close to
+ * memory bandwidth on large surfaces.
+ */
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0) {
+    const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (size * kMul);
+
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t v;
+        memcpy(&v, bytes + i * 8, 8);
+        h = (h ^ (v * kMul)) * kMul;
+        h ^= h >> 29;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, bytes + words * 8, size - words * 8);
+    h = (h ^ (tail * kMul)) * kMul;
+
+    // Final avalanche so nearby inputs spread across the whole range
+    h ^= h >> 32;
+    h *= kMul;
+    h ^= h >> 29;
+    return h;
+}
+
+} // namespace ldc::core
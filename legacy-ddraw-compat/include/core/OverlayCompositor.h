@@ -0,0 +1,80 @@
+/**
+ * @file OverlayCompositor.h
+ * @brief Software overlay composition for legacy-ddraw-compat
+ *
+ * Emulates hardware overlays by compositing overlay surface pixels
+ * onto the presented primary image, honouring source and destination
+ * colour keys and overlay stretching.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc::core {
+
+// ============================================================================
+// Overlay Blend Parameters
+// ============================================================================
+
+/**
+ * @brief Description of one overlay placement on a destination image
+ *
+ * Source and destination must share the same pixel format; the overlay
+ * is stretched from srcRect to dstRect with nearest-neighbour sampling.
+ */
+struct OverlayBlendParams {
+    /** Overlay surface pixels */
+    const uint8_t* srcPixels = nullptr;
+    uint32_t srcPitch = 0;
+
+    /** Visible part of the overlay surface */
+    RECT srcRect{};
+
+    /** Image the overlay is composited onto */
+    uint8_t* dstPixels = nullptr;
+    uint32_t dstPitch = 0;
+
+    /** Placement of the overlay on the destination */
+    RECT dstRect{};
+
+    /** Pixels the destination colour key is tested against (defaults to dstPixels) */
+    const uint8_t* keyPixels = nullptr;
+    uint32_t keyPitch = 0;
+
+    /** Bytes per pixel (1, 2, 3 or 4) */
+    uint32_t bytesPerPixel = 0;
+
+    /** Overlay pixels equal to srcKey are transparent */
+    bool useSrcKey = false;
+    uint32_t srcKey = 0;
+
+    /** Overlay is only shown where the destination equals destKey */
+    bool useDestKey = false;
+    uint32_t destKey = 0;
+};
+
+// ============================================================================
+// Composition
+// ============================================================================
+
+/**
+ * @brief Composite an overlay onto the destination image
+ * @param params Overlay placement and colour keys
+ * @param clip Destination region to recompose
+ *
+ * Only pixels inside both clip and params.dstRect are written, so an
+ * overlay update touches just its dirty area instead of the full frame.
+ */
+void CompositeOverlay(const OverlayBlendParams& params, const RECT& clip);
+
+/**
+ * @brief Map a rectangle in overlay surface space to destination space
+ * @param rect Rectangle on the overlay surface
+ * @param srcRect Visible part of the overlay surface
+ * @param dstRect Placement of the overlay on the destination
+ * @return Destination rectangle covering every pixel rect maps onto
+ */
+RECT MapOverlayRect(const RECT& rect, const RECT& srcRect, const RECT& dstRect);
+
+} // namespace ldc::core
@@ -0,0 +1,152 @@
+/**
+ * @file Presenter.h
+ * @brief Asynchronous frame presentation for flip chains
+ *
+ * Flip hands the new front buffer to a presenter thread instead of
+ * converting and blitting it on the game thread. The presenter reads the
+ * front buffer's storage directly; Flip only waits when the storage it is
+ * about to hand back to the game is still being read.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include "core/Fence.h"
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace ldc {
+struct DeviceContext;
+}
+
+namespace ldc::core {
+
+/**
+ * @brief Presenter thread of one device
+ *
+ * Holds at most one pending frame: a newer submission replaces a frame
+ * the thread has not started yet, so a fast game never queues behind
+ * a slow window blit.
+ */
+class Presenter {
+public:
+    /**
+     * @brief Create a presenter for a device
+     * @param device Device whose window the frames are presented to
+     *
+     * The thread starts on the first submission.
+     */
+    explicit Presenter(DeviceContext& device);
+    ~Presenter();
+    Presenter(const Presenter&) = delete;
+    Presenter& operator=(const Presenter&) = delete;
+
+    /**
+     * @brief Queue a frame for presentation
+     * @param pixels Front buffer storage (must stay alive until released)
+     * @param pitch Bytes per row
+     * @param fence Fence signalled once the frame is shown or superseded
+     * @param fenceValue Value to signal on fence
+     *
+     * Starts the presenter thread on first use.
+     */
+    void Submit(const uint8_t* pixels, DWORD pitch, Fence* fence, uint64_t fenceValue);
+
+    /**
+     * @brief Check whether the presenter is reading a buffer right now
+     */
+    bool IsPresenting(const uint8_t* pixels);
+
+    /**
+     * @brief Make sure the presenter no longer reads a buffer
+     * @param pixels Storage about to be handed back for drawing
+     *
+     * A pending frame using the storage is dropped; a frame being
+     * presented from it is waited for.
+     */
+    void Release(const uint8_t* pixels);
+
+    /**
+     * @brief Show queued palette and gamma changes after a delay
+     * @param delayMs Milliseconds until the end of the current refresh period
+     *
+     * The thread calls FlushPaletteChanges when the delay has passed, so
+     * a change made while presents are throttled is shown even if the game
+     * never presents again. An earlier pending flush is kept. Starts the
+     * presenter thread on first use.
+     */
+    void ScheduleFlush(DWORD delayMs);
+
+    /**
+     * @brief Drop frames superseded by a synchronous present
+     * @return true if a frame was dropped before the window showed it;
+     *         the synchronous present must then cover the whole image
+     *
+     * Never blocks; a frame already being presented is skipped if it has
+     * not reached the window yet.
+     */
+    bool Discard();
+
+    /**
+     * @brief Drop any pending frame and wait for the current one
+     */
+    void WaitIdle();
+
+    /**
+     * @brief Wait until the pending and current frames have been presented
+     *
+     * Unlike WaitIdle nothing is dropped, so the last frame submitted is
+     * the one on screen afterwards.
+     */
+    void Flush();
+
+    /**
+     * @brief Stop the presenter thread
+     *
+     * Must not be called with the device's renderMutex held.
+     */
+    void Stop();
+
+    /** Frames presented by the thread */
+    uint64_t GetPresentedCount() const { return m_presented.load(); }
+
+    /** Frames replaced before the thread picked them up */
+    uint64_t GetDroppedCount() const { return m_dropped.load(); }
+
+private:
+    /** A frame queued for, or being read by, the presenter thread */
+    struct Frame {
+        const uint8_t* pixels = nullptr;
+        DWORD pitch = 0;
+        Fence* fence = nullptr;
+        uint64_t fenceValue = 0;
+    };
+
+    void ThreadProc();
+    void StartThread();
+    void DropPending();
+    static void Complete(const Frame& frame);
+
+    DeviceContext& m_device;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    Frame m_pending;
+    Frame m_inFlight;
+    bool m_inFlightStale = false;
+
+    // A frame was dropped and nothing has shown the whole image since
+    bool m_windowBehind = false;
+    bool m_stopping = false;
+
+    // Queued palette or gamma changes to show at m_flushDeadline
+    bool m_flushScheduled = false;
+    std::chrono::steady_clock::time_point m_flushDeadline;
+
+    std::atomic<uint64_t> m_presented{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+} // namespace ldc::core
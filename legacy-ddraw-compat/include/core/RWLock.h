@@ -0,0 +1,109 @@
+/**
+ * @file RWLock.h
+ * @brief Reader/writer lock for surface pixel storage
+ *
+ * One atomic word holds the reader count and writer bit, so uncontended
+ * acquisition is a single compare-exchange. Unlike std::shared_mutex the
+ * lock has no owning thread: a deferred blit may take it on a worker
+ * and release it there, and it never needs the OS unless it has to wait.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc::core {
+
+/**
+ * @brief Writer-preferring reader/writer spin lock with backoff
+ *
+ * Meant for sections that last about as long as one blit; waiters spin
+ * briefly, then yield their time slice, then sleep.
+ */
+class RWLock {
+public:
+    RWLock() = default;
+    RWLock(const RWLock&) = delete;
+    RWLock& operator=(const RWLock&) = delete;
+
+    /** Acquire shared (read) access */
+    void LockShared() {
+        if (!TryLockShared()) {
+            LockSharedSlow();
+        }
+    }
+
+    /** Try to acquire shared access without waiting */
+    bool TryLockShared() {
+        uint32_t state = m_state.load(std::memory_order_relaxed);
+        return !(state & (kWriter | kWriterWaiting)) &&
+               m_state.compare_exchange_weak(state, state + 1,
+                                             std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    /** Release shared access */
+    void UnlockShared() { m_state.fetch_sub(1, std::memory_order_release); }
+
+    /** Acquire exclusive (write) access */
+    void Lock() {
+        if (!TryLock()) {
+            LockSlow();
+        }
+    }
+
+    /** Try to acquire exclusive access without waiting */
+    bool TryLock() {
+        uint32_t state = m_state.load(std::memory_order_relaxed);
+        return (state & ~kWriterWaiting) == 0 &&
+               m_state.compare_exchange_strong(state, kWriter,
+                                               std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    /** Release exclusive access */
+    void Unlock() { m_state.fetch_and(~kWriter, std::memory_order_release); }
+
+    /** Times a caller had to wait, for contention statistics */
+    uint64_t GetContendedCount() const { return m_contended.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t kWriter = 0x80000000u;
+    static constexpr uint32_t kWriterWaiting = 0x40000000u;
+
+    void LockSharedSlow();
+    void LockSlow();
+
+    std::atomic<uint32_t> m_state{0};
+    std::atomic<uint64_t> m_contended{0};
+};
+
+/**
+ * @brief Scoped shared access
+ */
+class SharedLockGuard {
+public:
+    explicit SharedLockGuard(RWLock& lock) : m_lock(lock) { m_lock.LockShared(); }
+    ~SharedLockGuard() { m_lock.UnlockShared(); }
+
+    SharedLockGuard(const SharedLockGuard&) = delete;
+    SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+
+private:
+    RWLock& m_lock;
+};
+
+/**
+ * @brief Scoped exclusive access
+ */
+class ExclusiveLockGuard {
+public:
+    explicit ExclusiveLockGuard(RWLock& lock) : m_lock(lock) { m_lock.Lock(); }
+    ~ExclusiveLockGuard() { m_lock.Unlock(); }
+
+    ExclusiveLockGuard(const ExclusiveLockGuard&) = delete;
+    ExclusiveLockGuard& operator=(const ExclusiveLockGuard&) = delete;
+
+private:
+    RWLock& m_lock;
+};
+
+} // namespace ldc::core
@@ -0,0 +1,302 @@
+/**
+ * @file SurfaceAllocator.h
+ * @brief Pooled surface pixel memory for legacy-ddraw-compat
+ *
+ * Surface storage comes from size classes with aligned base addresses.
+ * Small sprite surfaces are carved from contiguous arena chunks so they
+ * sit together in memory, and freed blocks are kept per size class for
+ * the next surface of similar size.
+ *
+ * Surfaces above a size threshold are backed by their own virtual
+ * memory pages instead: the OS supplies zero pages on first touch, the
+ * pages can be pinned with PageLock, and very large buffers can use
+ * large pages.
+ *
+ * Surfaces the game draws on with GDI move into a DIB section that
+ * keeps its memory DC, so GetDC hands out the surface memory itself.
+ *
+ * Blocks can be shared copy-on-write between surfaces with identical
+ * contents; the first write through either owner gives it a private copy.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc::core {
+
+class SurfaceAllocator;
+
+// ============================================================================
+// Surface Memory
+// ============================================================================
+
+/**
+ * @brief Owner of one block of surface pixel memory
+ *
+ * Move-only; the block returns to its allocator when the owner is
+ * destroyed or assigned over. Swapping two owners only exchanges
+ * pointers, which is how flip chains rotate storage. A block shared
+ * with SurfaceAllocator::Share is freed with its last owner.
+ */
+class SurfaceMemory {
+public:
+    SurfaceMemory() = default;
+    ~SurfaceMemory() { Reset(); }
+
+    SurfaceMemory(SurfaceMemory&& other) noexcept { swap(other); }
+    SurfaceMemory& operator=(SurfaceMemory&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            swap(other);
+        }
+        return *this;
+    }
+
+    SurfaceMemory(const SurfaceMemory&) = delete;
+    SurfaceMemory& operator=(const SurfaceMemory&) = delete;
+
+    uint8_t* data() { return m_data; }
+    const uint8_t* data() const { return m_data; }
+
+    /** Bytes requested for the surface */
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /** Release the block back to the allocator */
+    void Reset();
+
+    /** Whether the block has its own pages (and so can be pinned) */
+    bool IsPageBacked() const { return m_kind != Kind::Pooled; }
+
+    /** Whether the block's pages are currently pinned */
+    bool IsPinned() const { return m_pinned; }
+
+    /** Memory DC drawing into the block, if it is a DIB section */
+    HDC GetDC() const { return m_dc; }
+
+    /** Whether another owner shares the block */
+    bool IsShared() const { return m_refs && m_refs->load(std::memory_order_acquire) > 1; }
+
+    void swap(SurfaceMemory& other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_sizeClass, other.m_sizeClass);
+        std::swap(m_kind, other.m_kind);
+        std::swap(m_reserved, other.m_reserved);
+        std::swap(m_pinned, other.m_pinned);
+        std::swap(m_bitmap, other.m_bitmap);
+        std::swap(m_dc, other.m_dc);
+        std::swap(m_oldBitmap, other.m_oldBitmap);
+        std::swap(m_refs, other.m_refs);
+    }
+
+private:
+    friend class SurfaceAllocator;
+
+    enum class Kind : uint8_t {
+        Pooled,      // Size-class block from the pool or arena
+        Pages,       // Reserved and committed virtual memory
+        LargePages,  // Committed large pages (never paged out)
+        Dib          // DIB section selected into its own memory DC
+    };
+
+    uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    uint32_t m_sizeClass = 0;
+    Kind m_kind = Kind::Pooled;
+    size_t m_reserved = 0;
+    bool m_pinned = false;
+
+    // DIB section storage
+    HBITMAP m_bitmap = nullptr;
+    HDC m_dc = nullptr;
+    HGDIOBJ m_oldBitmap = nullptr;
+
+    // Owner count once the block has been shared
+    std::atomic<uint32_t>* m_refs = nullptr;
+};
+
+inline void swap(SurfaceMemory& a, SurfaceMemory& b) noexcept { a.swap(b); }
+
+// ============================================================================
+// Surface Allocator
+// ============================================================================
+
+/**
+ * @brief Allocator statistics
+ */
+struct SurfaceAllocatorStats {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t poolHits = 0;
+    uint64_t arenaAllocations = 0;
+    uint64_t bytesInUse = 0;
+    uint64_t peakBytesInUse = 0;
+    uint64_t bytesCached = 0;
+    uint64_t arenaBytes = 0;
+    uint64_t pageAllocations = 0;
+    uint64_t largePageAllocations = 0;
+    uint64_t reservationsReused = 0;
+    uint64_t bytesPinned = 0;
+    uint64_t dibConversions = 0;
+    uint64_t bytesShared = 0;
+    uint64_t copiesOnWrite = 0;
+};
+
+/**
+ * @brief Size-class allocator for surface pixel memory
+ */
+class SurfaceAllocator {
+public:
+    /** Blocks up to this size come from the sprite arena */
+    static constexpr size_t kArenaMaxBlock = 16 * 1024;
+
+    /** Size of each arena chunk */
+    static constexpr size_t kArenaChunkSize = 1024 * 1024;
+
+    /** Freed large blocks kept for reuse, in bytes, before memory is returned */
+    static constexpr size_t kMaxCachedBytes = 64 * 1024 * 1024;
+
+    /** Decommitted address space kept for reuse by page-backed surfaces */
+    static constexpr size_t kMaxCachedReservation = 128 * 1024 * 1024;
+
+    /** Allocation granularity of reserved address space */
+    static constexpr size_t kReservationGranularity = 64 * 1024;
+
+    static SurfaceAllocator& Instance();
+
+    SurfaceAllocator(const SurfaceAllocator&) = delete;
+    SurfaceAllocator& operator=(const SurfaceAllocator&) = delete;
+
+    /**
+     * @brief Set base address and pitch alignment
+     * @param alignment Power of two from 16 to 4096 (64 = one cache line)
+     *
+     * Cached blocks are released, so this is meant for startup.
+     */
+    void SetAlignment(uint32_t alignment);
+
+    /** Current base address and pitch alignment */
+    uint32_t GetAlignment() const { return m_alignment; }
+
+    /**
+     * @brief Configure page-backed storage
+     * @param thresholdBytes Surfaces of at least this size get their own
+     *                       pages (0 = always use the pool)
+     * @param largePages Use large pages for surfaces of at least one
+     *                   large page, where the OS grants the privilege
+     */
+    void SetPageBacking(size_t thresholdBytes, bool largePages);
+
+    /**
+     * @brief Pad a row to the allocator's alignment
+     * @param rowBytes Bytes of pixel data per row
+     * @param bytesPerPixel Pixel size; the pitch is kept a whole number
+     *                      of pixels so a DIB section can describe it
+     * @return Pitch to use for the surface
+     *
+     * Rows narrower than the alignment keep 4-byte padding so small
+     * sprites do not multiply in size.
+     */
+    DWORD AlignPitch(DWORD rowBytes, DWORD bytesPerPixel = 1) const;
+
+    /**
+     * @brief Allocate zeroed surface memory
+     * @param size Bytes required
+     * @return Owner of the block, empty if size is 0 or memory ran out
+     */
+    SurfaceMemory Allocate(size_t size);
+
+    /**
+     * @brief Move a block into a DIB section with its own memory DC
+     * @param memory Block to convert; its contents are preserved
+     * @param pitch Row pitch of the surface (a whole number of pixels)
+     * @param height Rows in the surface
+     * @param pixelFormat Surface pixel format
+     * @return false if GDI could not create the section
+     *
+     * Conversion is one-way; the block stays a DIB section until freed.
+     */
+    bool ConvertToDib(SurfaceMemory& memory, DWORD pitch, DWORD height,
+                      const DDPIXELFORMAT& pixelFormat);
+
+    /**
+     * @brief Create another owner of a block
+     * @param memory Block to share
+     * @return New owner referring to the same memory
+     *
+     * Owners must call MakeUnique before writing.
+     */
+    SurfaceMemory Share(SurfaceMemory& memory);
+
+    /**
+     * @brief Give an owner a private copy of a shared block
+     * @return false if memory for the copy ran out
+     */
+    bool MakeUnique(SurfaceMemory& memory);
+
+    /**
+     * @brief Pin a page-backed block in physical memory
+     * @return false if the block is not page-backed or the OS refused
+     */
+    bool Pin(SurfaceMemory& memory);
+
+    /**
+     * @brief Allow a pinned block to be paged out again
+     */
+    void Unpin(SurfaceMemory& memory);
+
+    /**
+     * @brief Return every cached free block and reservation to the system
+     */
+    void Trim();
+
+    /** Snapshot of the allocator statistics */
+    SurfaceAllocatorStats GetStats() const;
+
+    /** Write the statistics to the debug log */
+    void LogStats() const;
+
+    /** Size class a request falls into */
+    static uint32_t SizeClassOf(size_t size);
+
+    /** Bytes reserved for a size class */
+    static size_t SizeOfClass(uint32_t sizeClass);
+
+private:
+    friend class SurfaceMemory;
+
+    SurfaceAllocator() = default;
+
+    void Free(SurfaceMemory& memory);
+    uint8_t* CarveFromArena(size_t blockSize);
+    void ReleaseCached();
+
+    bool AllocatePages(SurfaceMemory& memory, size_t size);
+    void FreePages(SurfaceMemory& memory);
+    void FreeDib(SurfaceMemory& memory);
+    static size_t BlockBytes(const SurfaceMemory& memory);
+    bool EnableLargePages();
+
+    mutable std::mutex m_mutex;
+    uint32_t m_alignment = 64;
+
+    // Free blocks per size class
+    std::unordered_map<uint32_t, std::vector<uint8_t*>> m_freeLists;
+
+    // Arena chunks and the bump offset into the newest one
+    std::vector<uint8_t*> m_arenaChunks;
+    size_t m_arenaOffset = kArenaChunkSize;
+
+    // Page-backed storage settings and decommitted reservations by size
+    size_t m_pageThreshold = 0;
+    bool m_largePages = false;
+    size_t m_largePageSize = 0;
+    std::unordered_map<size_t, std::vector<uint8_t*>> m_reservations;
+    size_t m_reservedCached = 0;
+
+    SurfaceAllocatorStats m_stats;
+};
+
+} // namespace ldc::core
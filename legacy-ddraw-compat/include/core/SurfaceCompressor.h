@@ -0,0 +1,145 @@
+/**
+ * @file SurfaceCompressor.h
+ * @brief Background compression of idle surfaces for legacy-ddraw-compat
+ *
+ * Offscreen surfaces the game has not touched for a while are packed
+ * with a small LZ-style codec and their pixel memory is released. The
+ * next Lock, Blt or GetDC unpacks them again; the time that takes is
+ * recorded in a latency histogram.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include <condition_variable>
+#include <thread>
+
+namespace ldc::core {
+
+// ============================================================================
+// Pixel Codec
+// ============================================================================
+
+/**
+ * @brief Compress a block of pixel data
+ * @param data Bytes to compress
+ * @param size Number of bytes
+ * @param packed Receives the compressed stream
+ * @return false if the data does not shrink by at least an eighth
+ *
+ * Byte-oriented LZ77 with a 64KB window. Runs of equal pixels encode as
+ * overlapping matches, so fills and transparent borders pack tightly.
+ */
+bool CompressPixels(const uint8_t* data, size_t size, std::vector<uint8_t>& packed);
+
+/**
+ * @brief Expand a stream produced by CompressPixels
+ * @param packed Compressed stream
+ * @param packedSize Bytes in the stream
+ * @param data Destination for exactly size bytes
+ * @param size Size of the original data
+ * @return false if the stream is corrupt
+ */
+bool DecompressPixels(const uint8_t* packed, size_t packedSize, uint8_t* data, size_t size);
+
+// ============================================================================
+// Surface Compressor
+// ============================================================================
+
+/** Buckets in the decompression latency histogram */
+constexpr uint32_t kStallBuckets = 12;
+
+/**
+ * @brief Compressor statistics
+ *
+ * Bucket 0 counts stalls under 64us; bucket i counts stalls from 2^(i+5)
+ * up to 2^(i+6) microseconds, and the last bucket everything longer.
+ */
+struct SurfaceCompressorStats {
+    uint64_t compressions = 0;
+    uint64_t incompressible = 0;
+    uint64_t decompressions = 0;
+    uint64_t bytesUnpacked = 0;   // Original size of surfaces held compressed
+    uint64_t bytesPacked = 0;     // Memory those surfaces use now
+    uint64_t totalStallMicros = 0;
+    uint64_t maxStallMicros = 0;
+    uint64_t stallHistogram[kStallBuckets] = {};
+};
+
+/**
+ * @brief Worker that periodically compresses idle surfaces
+ *
+ * The compressor does not know about surfaces itself; its owner supplies
+ * a scan function that is called on the worker thread about once a
+ * second and compresses whatever it finds idle, checking IsOverBudget
+ * between surfaces.
+ */
+class SurfaceCompressor {
+public:
+    /** Called on the worker thread to compress idle surfaces */
+    using ScanFn = std::function<void(SurfaceCompressor&)>;
+
+    /** Time between scans */
+    static constexpr uint32_t kScanIntervalMs = 1000;
+
+    /**
+     * @brief Start the worker
+     * @param idleMs Time without access after which a surface is compressed
+     * @param budgetBytes Surface memory allowed before compressing
+     *                    (0 = compress every idle surface)
+     * @param scan Scan function
+     */
+    SurfaceCompressor(uint32_t idleMs, uint64_t budgetBytes, ScanFn scan);
+
+    /**
+     * @brief Stop the worker, waiting for a running scan to finish
+     */
+    ~SurfaceCompressor();
+
+    SurfaceCompressor(const SurfaceCompressor&) = delete;
+    SurfaceCompressor& operator=(const SurfaceCompressor&) = delete;
+
+    /** Time without access after which a surface is compressed */
+    uint32_t GetIdleMs() const { return m_idleMs; }
+
+    /** Whether surface memory in use exceeds the budget */
+    bool IsOverBudget() const;
+
+    /** Record a surface packed from original to packed bytes */
+    void RecordCompression(size_t original, size_t packed);
+
+    /** Record a surface that was not worth packing */
+    void RecordIncompressible();
+
+    /** Record a surface unpacked on access, and how long the game waited */
+    void RecordDecompression(size_t original, size_t packed, uint64_t micros);
+
+    /** Record a packed surface destroyed without being unpacked */
+    void RecordRelease(size_t original, size_t packed);
+
+    /** Snapshot of the statistics */
+    SurfaceCompressorStats GetStats() const;
+
+    /** Write the statistics and latency histogram to the debug log */
+    void LogStats() const;
+
+    /** Histogram bucket for a stall */
+    static uint32_t StallBucketOf(uint64_t micros);
+
+private:
+    void WorkerProc();
+
+    uint32_t m_idleMs;
+    uint64_t m_budgetBytes;
+    ScanFn m_scan;
+
+    std::mutex m_mutex;
+    std::condition_variable m_stopCv;
+    bool m_stopping = false;
+    std::thread m_worker;
+
+    mutable std::mutex m_statsMutex;
+    SurfaceCompressorStats m_stats;
+};
+
+} // namespace ldc::core
@@ -0,0 +1,130 @@
+/**
+ * @file TileExecutor.h
+ * @brief Row-band parallel execution of large blits for legacy-ddraw-compat
+ *
+ * Splits one large pixel operation into horizontal bands and runs them
+ * on a worker pool, with the calling thread taking bands as well.
+ * Operations below a size threshold run inline with no thread handoff.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace ldc::core {
+
+/**
+ * @brief Tile executor statistics
+ */
+struct TileExecutorStats {
+    uint64_t inlineRuns = 0;
+    uint64_t parallelRuns = 0;
+    uint64_t bands = 0;
+};
+
+/**
+ * @brief Worker pool that runs row bands of a single operation
+ *
+ * Run() may be called from several threads at once, including from
+ * deferred blit workers; every caller makes progress on its own bands,
+ * so nested use cannot deadlock.
+ */
+class TileExecutor {
+public:
+    /** Band callback: process rows [begin, end) */
+    using BandFn = std::function<void(uint32_t begin, uint32_t end)>;
+
+    /** Split threshold used while the crossover is being measured */
+    static constexpr uint64_t kDefaultThreshold = 1024 * 256;
+
+    /**
+     * @brief Create the executor and start its workers
+     * @param workerCount Number of worker threads (0 = pick from CPU count)
+     * @param thresholdPixels Smallest operation split into bands
+     *                        (0 = never split, -1 = measure on this machine)
+     *
+     * Measuring runs on threads of its own, never on the workers blits
+     * use; until it finishes, operations are split from kDefaultThreshold
+     * pixels.
+     */
+    TileExecutor(uint32_t workerCount, int thresholdPixels);
+
+    /**
+     * @brief Stop the measurement, if still running, and the workers
+     */
+    ~TileExecutor();
+
+    TileExecutor(const TileExecutor&) = delete;
+    TileExecutor& operator=(const TileExecutor&) = delete;
+
+    /**
+     * @brief Check whether an operation is large enough to split
+     * @param pixels Number of pixels the operation touches
+     */
+    bool ShouldSplit(uint64_t pixels) const {
+        uint64_t threshold = m_threshold.load(std::memory_order_relaxed);
+        return !m_workers.empty() && threshold != 0 && pixels >= threshold;
+    }
+
+    /**
+     * @brief Run band over rows, split across the workers if large enough
+     * @param rows Number of rows in the operation
+     * @param pixels Number of pixels the operation touches
+     * @param band Callback run once per band; bands never overlap
+     *
+     * Returns once every band has run.
+     */
+    void Run(uint32_t rows, uint64_t pixels, const BandFn& band);
+
+    /** Pixel count at which operations are split (0 = never) */
+    uint64_t GetThreshold() const { return m_threshold.load(std::memory_order_relaxed); }
+
+    /** Number of worker threads */
+    uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    /** Snapshot of the executor statistics */
+    TileExecutorStats GetStats() const;
+
+private:
+    struct Job {
+        const BandFn* band = nullptr;
+        uint32_t rows = 0;
+        uint32_t bandRows = 0;
+        uint32_t bandCount = 0;
+        uint32_t next = 0;
+        uint32_t finished = 0;
+    };
+
+    void WorkerProc();
+    bool RunOneBand(std::unique_lock<std::mutex>& lock, Job& job);
+    void RunParallel(uint32_t rows, const BandFn& band, bool countBands = true);
+
+    // Times inline and split fills of growing size, the split ones on a
+    // temporary executor with as many workers; the first size where
+    // splitting wins clearly becomes the threshold. Returns the current
+    // threshold unchanged if the executor stops first.
+    uint64_t MeasureCrossover();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+
+    std::vector<std::thread> m_workers;
+    std::deque<Job*> m_jobs;
+    bool m_stopping = false;
+
+    std::atomic<uint64_t> m_threshold{0};
+
+    // Measures the crossover without holding up the first large blit
+    std::thread m_calibrator;
+    std::atomic<bool> m_stopCalibration{false};
+
+    std::atomic<uint64_t> m_inlineRuns{0};
+    std::atomic<uint64_t> m_parallelRuns{0};
+    std::atomic<uint64_t> m_bands{0};
+};
+
+} // namespace ldc::core
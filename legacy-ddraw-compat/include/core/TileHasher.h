@@ -0,0 +1,76 @@
+/**
+ * @file TileHasher.h
+ * @brief Detection of the parts of a frame that changed since the last present
+ *
+ * Games often flip at full rate while the screen stands still (menus,
+ * pause, loading). Hashing the primary in tiles at present time tells
+ * which tiles differ from what the window already shows, so an unchanged
+ * frame is not converted or blitted at all, and a changed one only where
+ * it changed.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc::core {
+
+/**
+ * @brief Per-tile content hashes of the last compared frame
+ *
+ * Not thread-safe; the device uses it under its renderMutex.
+ */
+class TileHasher : public NonCopyable {
+public:
+    /** Tile size in pixels */
+    static constexpr uint32_t kTileWidth = 64;
+    static constexpr uint32_t kTileHeight = 32;
+
+    TileHasher() = default;
+
+    /** Forget every tile; the next Compare reports the whole frame */
+    void Reset();
+
+    /**
+     * @brief Forget the tiles under some areas
+     * @param rects Areas shown without a comparison, e.g. by a partial present
+     * @param count Number of rects
+     */
+    void Invalidate(const RECT* rects, uint32_t count);
+
+    /**
+     * @brief Hash a frame and report the tiles that changed
+     * @param pixels Frame pixels, rows pitch bytes apart
+     * @param pitch Bytes per row
+     * @param width Frame width in pixels
+     * @param height Frame height in pixels
+     * @param bpp Bits per pixel (8, 16, 24 or 32)
+     * @param changed Receives up to maxRects rects covering the changed tiles
+     * @param maxRects Most rects to report (at least 1)
+     * @return Number of rects written, 0 if no tile changed
+     *
+     * Changed tiles are merged into runs along each tile row, and runs of
+     * the same span in consecutive rows into one rect. If that still takes
+     * more than maxRects, their bounds are reported instead. A frame of a
+     * new size or depth is reported whole.
+     */
+    uint32_t Compare(const uint8_t* pixels, uint32_t pitch, uint32_t width, uint32_t height,
+                     uint32_t bpp, RECT* changed, uint32_t maxRects);
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_bpp = 0;
+    uint32_t m_tilesX = 0;
+    uint32_t m_tilesY = 0;
+
+    // One hash per tile, row by row; a tile without a valid hash always
+    // counts as changed
+    std::vector<uint64_t> m_hashes;
+    std::vector<uint8_t> m_valid;
+
+    // Rects built by Compare, kept to avoid an allocation per frame
+    std::vector<RECT> m_runs;
+};
+
+} // namespace ldc::core
@@ -0,0 +1,92 @@
+/**
+ * @file VideoMemory.h
+ * @brief Emulated video memory accounting for legacy-ddraw-compat
+ *
+ * All surfaces live in system memory, but games size their caches from
+ * the video memory DirectDraw reports and expect creation to fail once
+ * it is used up. The tracker charges each surface to a class, reports
+ * free space against a configured budget, and refuses surfaces that
+ * must be in video memory once the budget is spent.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc::core {
+
+/**
+ * @brief Where a surface's memory is charged
+ */
+enum class SurfaceClass : uint8_t {
+    Primary,
+    BackBuffer,
+    Offscreen,
+    Overlay,
+    SystemMemory,   // Not charged against the budget
+    Count
+};
+
+constexpr size_t kSurfaceClassCount = static_cast<size_t>(SurfaceClass::Count);
+
+/**
+ * @brief Video memory statistics, indexed by SurfaceClass
+ */
+struct VideoMemoryStats {
+    uint64_t budget = 0;
+    uint64_t bytes[kSurfaceClassCount] = {};
+    uint64_t peakBytes[kSurfaceClassCount] = {};
+    uint64_t surfaces[kSurfaceClassCount] = {};
+    uint64_t failedAllocations = 0;
+};
+
+/**
+ * @brief Per-class byte counts checked against a video memory budget
+ */
+class VideoMemoryTracker {
+public:
+    /**
+     * @param budgetBytes Video memory reported to the game
+     */
+    explicit VideoMemoryTracker(uint64_t budgetBytes);
+
+    VideoMemoryTracker(const VideoMemoryTracker&) = delete;
+    VideoMemoryTracker& operator=(const VideoMemoryTracker&) = delete;
+
+    /**
+     * @brief Charge a surface
+     * @return false if a video memory class would exceed the budget
+     *
+     * System memory is always granted; it is counted for statistics only.
+     */
+    bool Reserve(SurfaceClass surfaceClass, uint64_t bytes);
+
+    /** Return a surface's charge */
+    void Release(SurfaceClass surfaceClass, uint64_t bytes);
+
+    /** Video memory reported as installed */
+    uint64_t GetTotal() const { return m_budget; }
+
+    /** Video memory not charged to any surface */
+    uint64_t GetFree() const;
+
+    /** Snapshot of the statistics */
+    VideoMemoryStats GetStats() const;
+
+    /** Write the statistics to the debug log */
+    void LogStats() const;
+
+    /** Class a surface with these caps is charged to, before any fallback */
+    static SurfaceClass ClassOf(const DDSCAPS2& caps);
+
+    /** Display name of a class */
+    static const char* NameOf(SurfaceClass surfaceClass);
+
+private:
+    mutable std::mutex m_mutex;
+    uint64_t m_budget;
+    uint64_t m_used = 0;
+    VideoMemoryStats m_stats;
+};
+
+} // namespace ldc::core
@@ -9,6 +9,17 @@
 
 #include "core/Common.h"
 
+namespace ldc {
+struct DeviceContext;
+}
+
+namespace ldc::core {
+class BlitQueue;
+class SurfaceCompressor;
+class TileExecutor;
+class VideoMemoryTracker;
+}
+
 namespace ldc::interfaces {
 
 // Forward declarations
@@ -160,12 +171,54 @@ public:
     /** Get the window handle */
     HWND GetHWnd() const { return m_hWnd; }
 
+    /** Whether the game set DDSCL_MULTITHREADED, so calls take the device lock */
+    bool IsMultithreaded() const { return m_multithreaded.load(std::memory_order_relaxed); }
+
+    /** Get the render state shared by this object and its surfaces */
+    const std::shared_ptr<DeviceContext>& GetDeviceContext() const { return m_device; }
+
     /** Get primary surface */
     SurfaceImpl* GetPrimarySurface() const { return m_primarySurface; }
 
     /** Set primary surface */
     void SetPrimarySurface(SurfaceImpl* pSurface) { m_primarySurface = pSurface; }
 
+    /** Get the deferred blit queue, starting its workers on first use */
+    core::BlitQueue& GetBlitQueue();
+
+    /** Get the executor for large single blits, starting its workers on first use */
+    core::TileExecutor& GetTileExecutor();
+
+    /** Get the emulated video memory accounting for this device */
+    core::VideoMemoryTracker& GetVideoMemory() { return *m_videoMemory; }
+
+    /** Track a surface created on this object */
+    void RegisterSurface(SurfaceImpl* surface);
+
+    /** Stop tracking a destroyed surface */
+    void UnregisterSurface(SurfaceImpl* surface);
+
+    /** Run a deduplication pass if enabled and new surfaces have settled (compressor thread) */
+    void MaybeDeduplicateSurfaces();
+
+    /**
+     * @brief Merge identical idle offscreen surfaces into shared storage
+     * @return Number of surfaces that now share another's storage
+     */
+    size_t DeduplicateSurfaces();
+
+    /** Get the idle surface compressor, or nullptr if it and deduplication are disabled */
+    core::SurfaceCompressor* GetSurfaceCompressor() const { return m_surfaceCompressor.get(); }
+
+    /**
+     * @brief Compress idle offscreen surfaces, longest idle first
+     * @return Number of surfaces compressed
+     *
+     * Runs on the compressor thread and stops once surface memory is
+     * back under the budget.
+     */
+    size_t CompressIdleSurfaces(core::SurfaceCompressor& compressor);
+
 private:
     std::atomic<ULONG> m_refCount{1};
     int m_interfaceVersion = 7;
@@ -174,6 +227,7 @@ private:
     // Window and display state
     HWND m_hWnd = nullptr;
     DWORD m_coopFlags = 0;
+    std::atomic<bool> m_multithreaded{false};
 
     // Display mode
     DWORD m_displayWidth = 0;
@@ -185,6 +239,30 @@ private:
     // Primary surface reference
     SurfaceImpl* m_primarySurface = nullptr;
 
+    // Render target, palette and window state of this device
+    std::shared_ptr<DeviceContext> m_device;
+
+    // Deferred blit queue (created on first deferred blit)
+    std::unique_ptr<core::BlitQueue> m_blitQueue;
+    std::once_flag m_blitQueueOnce;
+
+    // Row-band executor for large blits (created on first blit)
+    std::unique_ptr<core::TileExecutor> m_tileExecutor;
+    std::once_flag m_tileExecutorOnce;
+
+    // Video memory charged by surfaces against the configured budget
+    std::unique_ptr<core::VideoMemoryTracker> m_videoMemory;
+
+    // Surfaces created on this object, for deduplication passes
+    std::mutex m_surfacesMutex;
+    std::vector<SurfaceImpl*> m_surfaces;
+    std::atomic<uint32_t> m_surfacesCreatedSinceDedup{0};
+    ULONGLONG m_lastDedupTick = 0;
+
+    // Background thread compressing idle surfaces and running
+    // deduplication passes (null when both are disabled)
+    std::unique_ptr<core::SurfaceCompressor> m_surfaceCompressor;
+
     // Helper methods
     void FillCaps(LPDDCAPS pCaps);
     void FillDeviceIdentifier(LPDDDEVICEIDENTIFIER2 pDDDI);
@@ -0,0 +1,53 @@
+/**
+ * @file GammaControlImpl.h
+ * @brief IDirectDrawGammaControl interface implementation
+ *
+ * Obtained from the primary surface with QueryInterface. The ramp is
+ * device-wide and applied while the primary is converted for display.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc {
+struct DeviceContext;
+}
+
+namespace ldc::interfaces {
+
+/**
+ * @brief IDirectDrawGammaControl implementation
+ *
+ * A tear-off of the primary surface: reference counting and QueryInterface
+ * go to the surface, which owns this object.
+ */
+class GammaControlImpl : public IDirectDrawGammaControl {
+public:
+    /**
+     * @param owner Surface the interface was queried from
+     * @param device Render state the ramp applies to
+     */
+    GammaControlImpl(IUnknown& owner, std::shared_ptr<DeviceContext> device);
+
+    // ========================================================================
+    // IUnknown Methods
+    // ========================================================================
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObj) override;
+    ULONG STDMETHODCALLTYPE AddRef() override;
+    ULONG STDMETHODCALLTYPE Release() override;
+
+    // ========================================================================
+    // IDirectDrawGammaControl Methods
+    // ========================================================================
+
+    HRESULT STDMETHODCALLTYPE GetGammaRamp(DWORD dwFlags, LPDDGAMMARAMP lpRampData) override;
+    HRESULT STDMETHODCALLTYPE SetGammaRamp(DWORD dwFlags, LPDDGAMMARAMP lpRampData) override;
+
+private:
+    IUnknown& m_owner;
+    std::shared_ptr<DeviceContext> m_device;
+};
+
+} // namespace ldc::interfaces
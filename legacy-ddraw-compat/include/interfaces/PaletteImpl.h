@@ -0,0 +1,108 @@
+/**
+ * @file PaletteImpl.h
+ * @brief IDirectDrawPalette interface implementation
+ *
+ * Keeps the palette's entries together with the tables the renderer reads:
+ * a 32-bit LUT for converting 8-bit pixels and an RGBQUAD colour table for
+ * GDI. SetEntries rewrites only the slots whose colour actually changed.
+ */
+
+#pragma once
+
+#include "core/Common.h"
+
+namespace ldc {
+struct DeviceContext;
+}
+
+namespace ldc::interfaces {
+
+/**
+ * @brief IDirectDrawPalette implementation
+ */
+class PaletteImpl : public IDirectDrawPalette {
+public:
+    /**
+     * @param device Render state of the creating DirectDraw object
+     * @param caps DDPCAPS_* flags; exactly one of the 1/2/4/8BIT sizes
+     * @param entries Initial colours, GetEntryCountForCaps(caps) of them
+     */
+    PaletteImpl(std::shared_ptr<DeviceContext> device, DWORD caps, const PALETTEENTRY* entries);
+    virtual ~PaletteImpl();
+
+    /** Number of entries a palette created with these caps has, 0 if invalid */
+    static DWORD GetEntryCountForCaps(DWORD caps);
+
+    // ========================================================================
+    // IUnknown Methods
+    // ========================================================================
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObj) override;
+    ULONG STDMETHODCALLTYPE AddRef() override;
+    ULONG STDMETHODCALLTYPE Release() override;
+
+    // ========================================================================
+    // IDirectDrawPalette Methods
+    // ========================================================================
+
+    HRESULT STDMETHODCALLTYPE GetCaps(LPDWORD lpdwCaps) override;
+
+    HRESULT STDMETHODCALLTYPE GetEntries(
+        DWORD dwFlags,
+        DWORD dwBase,
+        DWORD dwNumEntries,
+        LPPALETTEENTRY lpEntries) override;
+
+    HRESULT STDMETHODCALLTYPE Initialize(
+        LPDIRECTDRAW lpDD,
+        DWORD dwFlags,
+        LPPALETTEENTRY lpDDColorTable) override;
+
+    HRESULT STDMETHODCALLTYPE SetEntries(
+        DWORD dwFlags,
+        DWORD dwStartingEntry,
+        DWORD dwCount,
+        LPPALETTEENTRY lpEntries) override;
+
+    // ========================================================================
+    // Internal Methods
+    // ========================================================================
+
+    /**
+     * @brief 32-bit ARGB colour of each entry
+     *
+     * Read by the renderer under the device renderMutex, which SetEntries
+     * holds while it writes.
+     */
+    const uint32_t* GetLut() const { return m_lut; }
+
+    /** Entries as an RGBQUAD table for SetDIBColorTable */
+    const RGBQUAD* GetColorTable() const { return m_colorTable; }
+
+    /** Bumped by every SetEntries that changes at least one colour */
+    uint32_t GetVersion() const { return m_version.load(std::memory_order_acquire); }
+
+    DWORD GetEntryCount() const { return m_entryCount; }
+
+private:
+    // Rewrite the derived tables for one entry
+    void UpdateSlot(DWORD index);
+
+    std::atomic<ULONG> m_refCount{1};
+
+    // Render state of the device that created us
+    std::shared_ptr<DeviceContext> m_device;
+
+    DWORD m_caps = 0;
+    DWORD m_entryCount = 0;
+
+    PALETTEENTRY m_entries[256] = {};
+
+    // Derived from m_entries slot by slot; unused slots stay black
+    alignas(kCacheLineSize) uint32_t m_lut[256] = {};
+    RGBQUAD m_colorTable[256] = {};
+
+    std::atomic<uint32_t> m_version{0};
+};
+
+} // namespace ldc::interfaces
@@ -8,6 +8,18 @@
 #pragma once
 
 #include "core/Common.h"
+#include "core/Fence.h"
+#include "core/RWLock.h"
+#include "core/SurfaceAllocator.h"
+#include "core/VideoMemory.h"
+
+namespace ldc {
+struct DeviceContext;
+}
+
+namespace ldc::core {
+class SurfaceCompressor;
+}
 
 namespace ldc::interfaces {
 
@@ -15,6 +27,7 @@ namespace ldc::interfaces {
 class DirectDrawImpl;
 class PaletteImpl;
 class ClipperImpl;
+class GammaControlImpl;
 
 /**
  * @brief GUID hash functor for unordered_map
@@ -48,8 +61,10 @@ public:
      * @brief Construct a surface
      * @param parent Parent DirectDraw object
      * @param desc Surface description
+     * @param shareFrom Surface whose storage is shared copy-on-write
+     *                  instead of allocating new pixels (DuplicateSurface)
      */
-    SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc);
+    SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc, SurfaceImpl* shareFrom = nullptr);
     virtual ~SurfaceImpl();
 
     // ========================================================================
@@ -133,12 +148,27 @@ public:
     /** Check if this is a back buffer */
     bool IsBackBuffer() const { return (m_caps.dwCaps & DDSCAPS_BACKBUFFER) != 0; }
 
+    /** Check if this is an overlay surface */
+    bool IsOverlay() const { return (m_caps.dwCaps & DDSCAPS_OVERLAY) != 0; }
+
+    /** Check if the game holds a Lock on the surface */
+    bool IsLocked() const { return m_lockState.load() != kUnlocked; }
+
+    /** Check if this overlay is currently shown */
+    bool IsOverlayVisible() const { return m_overlayVisible; }
+
+    /** Count overlays currently shown on this surface */
+    DWORD GetVisibleOverlayCount() const;
+
     /** Set back buffer in chain */
     void SetBackBuffer(SurfaceImpl* pBack) { m_backBuffer = pBack; }
 
     /** Get back buffer in chain */
     SurfaceImpl* GetBackBuffer() const { return m_backBuffer; }
 
+    /** Get the surface attached after this one in its flip chain (wraps to the front) */
+    SurfaceImpl* GetNextInFlipChain() const { return m_backBuffer ? m_backBuffer : m_flipFront; }
+
     /** Get width */
     DWORD GetWidth() const { return m_width; }
 
@@ -151,8 +181,73 @@ public:
     /** Get pitch (bytes per row) */
     DWORD GetPitch() const { return m_pitch; }
 
-    /** Notify that surface content changed (triggers rendering for primary) */
-    void NotifyContentChanged();
+    /**
+     * @brief Notify that surface content changed
+     * @param pRect Changed region, or nullptr for the whole surface
+     *
+     * Triggers rendering for the primary, and recomposes the covered
+     * destination region for a visible overlay.
+     */
+    void NotifyContentChanged(const RECT* pRect = nullptr);
+
+    /**
+     * @brief Check that every surface in the chain got its memory
+     *
+     * False when the device's video memory budget refused the surface or
+     * one of its back buffers; the surface has no storage and must be
+     * released.
+     */
+    bool FitsInVideoMemory() const;
+
+    /** Forget the parent once the DirectDraw object is destroyed */
+    void DetachParent() { m_parent = nullptr; }
+
+    /**
+     * @brief Check whether the surface can share storage with identical ones
+     * @param now Current GetTickCount64 value
+     * @param idleMs Time without writes after which contents count as loaded
+     *
+     * Only idle offscreen surfaces qualify; anything that is part of a
+     * flip chain, shown as an overlay, locked or pinned is skipped.
+     */
+    bool IsDedupCandidate(ULONGLONG now, ULONGLONG idleMs) const;
+
+    /** Hash of the surface storage, cached until the next write */
+    uint64_t GetContentHash();
+
+    /** Check whether another surface has the same layout and bytes */
+    bool HasSameContents(SurfaceImpl& other);
+
+    /** Check whether two surfaces already use the same storage */
+    bool SharesStorageWith(const SurfaceImpl& other) const { return m_pixels.data() == other.m_pixels.data(); }
+
+    /**
+     * @brief Replace this surface's storage with a copy-on-write share of source's
+     * @return false if either surface was locked or written since it was hashed
+     */
+    bool ShareStorageWith(SurfaceImpl& source);
+
+    /**
+     * @brief Unpack compressed storage and record an access
+     * @return DDERR_OUTOFMEMORY if memory for the pixels ran out
+     *
+     * Called before anything reads or writes the pixels.
+     */
+    HRESULT PrepareAccess();
+
+    /** GetTickCount64 value of the last Lock, Blt or GetDC touching the surface */
+    ULONGLONG GetLastAccessTick() const { return m_lastAccessTick.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Compress the storage if the surface is still idle
+     * @param compressor Compressor recording the result
+     * @param now Current GetTickCount64 value
+     * @return true if the pixel memory was released
+     *
+     * Runs on the compressor thread. Only offscreen surfaces that are not
+     * locked, pinned, shared, drawn with GDI or used by queued blits qualify.
+     */
+    bool CompressIfIdle(core::SurfaceCompressor& compressor, ULONGLONG now);
 
 private:
     std::atomic<ULONG> m_refCount{1};
@@ -160,6 +255,10 @@ private:
     // Parent DirectDraw object
     DirectDrawImpl* m_parent;
 
+    // Render state of the device that created us; outlives the parent
+    // while the game still holds the surface
+    std::shared_ptr<DeviceContext> m_device;
+
     // Surface properties
     DWORD m_width = 0;
     DWORD m_height = 0;
@@ -170,19 +269,47 @@ private:
     DWORD m_flags = 0;
 
     // Pixel data storage
-    std::vector<uint8_t> m_pixels;
+    core::SurfaceMemory m_pixels;
 
-    // Attached surfaces
+    // Attached surfaces (each flip chain member owns the next one)
     SurfaceImpl* m_backBuffer = nullptr;
 
+    // Front buffer of the flip chain this back buffer belongs to (not owned)
+    SurfaceImpl* m_flipFront = nullptr;
+
     // Associated objects
     PaletteImpl* m_palette = nullptr;
     ClipperImpl* m_clipper = nullptr;
 
-    // Lock state
-    bool m_locked = false;
+    // Gamma control tear-off of the primary, created on first query
+    std::unique_ptr<GammaControlImpl> m_gammaControl;
+
+    // Completion fences: presentation of flips (on the front) and pending blits
+    core::Fence m_flipFence;
+    core::Fence m_bltFence;
+
+    // Lock state machine; the transient states keep a racing Lock or
+    // Unlock from seeing a half-written m_lockedRect. GetDC locks the
+    // surface too, as in DirectDraw, until ReleaseDC.
+    enum LockState : uint32_t {
+        kUnlocked,
+        kLocking,
+        kLockedRead,
+        kLockedWrite,
+        kUnlocking,
+        kLockedDC
+    };
+    std::atomic<uint32_t> m_lockState{kUnlocked};
     RECT m_lockedRect{};
-    std::mutex m_lockMutex;
+
+    // Blits between their lock state check and being queued or done,
+    // with this surface as destination or source; Lock waits for them
+    std::atomic<uint32_t> m_bltsStarting{0};
+
+    // Guards the storage while the library touches it: blits read sources
+    // shared and write destinations exclusively, and anything replacing
+    // m_pixels is exclusive. Taken before the device renderMutex, never after.
+    core::RWLock m_pixelLock;
 
     // Color keys
     DDCOLORKEY m_srcColorKey{};
@@ -190,24 +317,113 @@ private:
     bool m_hasSrcColorKey = false;
     bool m_hasDestColorKey = false;
 
-    // GDI interop
+    // Overlay color keys
+    DDCOLORKEY m_srcOverlayKey{};
+    DDCOLORKEY m_destOverlayKey{};
+    bool m_hasSrcOverlayKey = false;
+    bool m_hasDestOverlayKey = false;
+
+    // Overlay state (when this surface is an overlay)
+    SurfaceImpl* m_overlayDest = nullptr;
+    RECT m_overlaySrcRect{};
+    RECT m_overlayDestRect{};
+    bool m_overlayVisible = false;
+    bool m_overlayUseSrcKey = false;
+    bool m_overlayUseDestKey = false;
+    DWORD m_overlaySrcKey = 0;
+    DWORD m_overlayDestKey = 0;
+    std::vector<RECT> m_overlayDirtyRects;
+
+    // Overlays shown on this surface, front to back (when this is the primary)
+    std::vector<SurfaceImpl*> m_overlays;
+
+    // DC handed out by GetDC (owned by the DIB-backed storage)
     HDC m_hDC = nullptr;
-    HBITMAP m_hBitmap = nullptr;
-    HBITMAP m_hBitmapOld = nullptr;
 
     // Private data storage (using GuidHash defined at top of file)
     std::unordered_map<GUID, std::vector<uint8_t>, GuidHash, GuidEqual> m_privateData;
 
     // Uniqueness value
-    DWORD m_uniquenessValue = 0;
+    std::atomic<DWORD> m_uniquenessValue{0};
 
     // Priority and LOD
     DWORD m_priority = 0;
     DWORD m_lod = 0;
 
+    // PageLock nesting count (kept on the front of a flip chain)
+    DWORD m_pageLockCount = 0;
+
+    // Write tracking for copy-on-write and deduplication; the counters
+    // are read by the deduplication pass on the compressor thread, the
+    // cached hash is only used there
+    std::atomic<uint64_t> m_writeCount{0};
+    std::atomic<ULONGLONG> m_lastWriteTick{0};
+    uint64_t m_contentHash = 0;
+    uint64_t m_hashedWriteCount = UINT64_MAX;
+
+    // Idle compression; the storage mutex keeps the compressor thread
+    // away from pixels the game is about to use
+    std::mutex m_storageMutex;
+    std::atomic<ULONGLONG> m_lastAccessTick{0};
+    std::vector<uint8_t> m_packedPixels;
+    size_t m_unpackedSize = 0;
+
+    // Video memory charge (m_memoryCharged is false if the budget refused it)
+    core::SurfaceClass m_memoryClass = core::SurfaceClass::Offscreen;
+    uint64_t m_memoryCharge = 0;
+    bool m_memoryCharged = false;
+
     // Helper methods
     void InitializePixelFormat();
     void AllocatePixelData();
+
+    // Charges the surface to the device, falling back to system memory
+    // where DirectDraw would
+    bool ChargeVideoMemory();
+
+    // Moves the storage into a DIB section on first GetDC
+    bool EnsureDibStorage();
+
+    // Flip chain helpers
+    void CreateFlipChain(const DDSURFACEDESC2& desc);
+    void RotateFlipChain(SurfaceImpl* pTarget);
+    const uint8_t* GetFlipHandBack(SurfaceImpl* pTarget) const;
+
+    // Whether calls must take the device lock (DDSCL_MULTITHREADED)
+    bool UsesDeviceLock() const;
+
+    // Waits for pending blits, or returns DDERR_WASSTILLDRAWING if doNotWait
+    HRESULT WaitForBlts(bool doNotWait);
+
+    // Wait out blits that passed their lock state check before our Lock
+    void WaitForStartingBlts() const;
+
+    // A blit with rectangles clipped and colour keys resolved
+    struct BltOp {
+        SurfaceImpl* src = nullptr;
+        RECT dstRect{};
+        POINT srcOrigin{};
+        bool colorFill = false;
+        DWORD fillColor = 0;
+        bool useColorKey = false;
+        DWORD colorKey = 0;
+    };
+
+    // Blit execution, inline or through the device's deferred queue;
+    // large blits are split into row bands by the device's tile executor
+    bool ShouldDeferBlt(DWORD dwFlags) const;
+    void QueueBlt(const BltOp& op);
+
+    // Gives the surface private storage before any write and records it
+    HRESULT PrepareWrite();
+    void ExecuteBlt(const BltOp& op);
+    void ExecuteBltRows(const BltOp& op, uint32_t rowBegin, uint32_t rowEnd);
+
+    // Overlay helpers
+    void DetachOverlay();
+    RECT GetOverlayDestRegion(const RECT* pSrcRect) const;
+    void RefreshOverlayRegion(const RECT& region);
+    void ComposeOverlays(const RECT& region);
 };
 
 } // namespace ldc::interfaces
@@ -15,6 +15,27 @@ namespace ldc::renderer {
 // Renderer Capabilities
 // ============================================================================
 
+/**
+ * @brief Source pixel formats, as bits of RendererCaps::nativeFormats
+ */
+enum SourceFormat : uint32_t {
+    kSourcePalette8 = 1u << 0,   // 8-bit indices into a 256-colour palette
+    kSourceRGB565 = 1u << 1,     // 16-bit 5-6-5
+    kSourceRGB888 = 1u << 2,     // 24-bit B, G, R
+    kSourceXRGB8888 = 1u << 3,   // 32-bit B, G, R, unused
+};
+
+/** Format bit of a primary with the given depth, 0 if there is none */
+inline uint32_t SourceFormatForBpp(uint32_t bpp) {
+    switch (bpp) {
+        case 8:  return kSourcePalette8;
+        case 16: return kSourceRGB565;
+        case 24: return kSourceRGB888;
+        case 32: return kSourceXRGB8888;
+        default: return 0;
+    }
+}
+
 /**
  * @brief Renderer capability information
  */
@@ -36,6 +57,77 @@ struct RendererCaps {
 
     /** Renderer version string */
     std::string version;
+
+    /**
+     * Source formats the backend presents without converting them on the
+     * CPU (SourceFormat bits). Only frames whose colour tables the format
+     * can express go that way: 565 and XRGB while the gamma ramp is the
+     * identity, 8-bit always (the palette carries the ramp). Every other
+     * frame is converted to XRGB first.
+     */
+    uint32_t nativeFormats = 0;
+
+    /** A palette change is applied without touching the source pixels */
+    bool supportsPaletteUpload = false;
+
+    /** Damage rects PresentPartial handles one by one; more are merged into their bounds */
+    uint32_t maxDamageRects = 1;
+
+    bool AcceptsNative(uint32_t bpp) const {
+        return (nativeFormats & SourceFormatForBpp(bpp)) != 0;
+    }
+};
+
+// ============================================================================
+// Frames
+// ============================================================================
+
+/**
+ * @brief One frame of the primary surface, ready for a renderer
+ *
+ * The colour tables already carry the palette and the gamma ramp, so a
+ * backend converts every format in a single pass, or uploads the source
+ * and the tables and converts on the GPU.
+ */
+struct PresentFrame {
+    /** Source pixels, rows pitch bytes apart */
+    const uint8_t* pixels = nullptr;
+    uint32_t pitch = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bpp = 0;
+
+    /** 8bpp: 256 ARGB colours */
+    const uint32_t* palette = nullptr;
+
+    /**
+     * 8bpp: the palette differs from the previous frame's, so every pixel
+     * may show a new colour even where the indices did not change
+     */
+    bool paletteChanged = false;
+
+    /** 16bpp: RGB565 expansion tables (32, 64, 32 entries), each component shifted into place */
+    const uint32_t* expandRed565 = nullptr;
+    const uint32_t* expandGreen565 = nullptr;
+    const uint32_t* expandBlue565 = nullptr;
+
+    /** 24/32bpp: per-channel gamma tables, null while the ramp is the identity */
+    const uint8_t* gammaRed = nullptr;
+    const uint8_t* gammaGreen = nullptr;
+    const uint8_t* gammaBlue = nullptr;
+};
+
+/** Damage rects the built-in backends take per frame */
+constexpr uint32_t kMaxDamageRects = 16;
+
+/**
+ * @brief Time a renderer spent on the frames it presented
+ */
+struct RendererTimings {
+    uint64_t frames = 0;          // Frames presented
+    uint64_t convertMicros = 0;   // Converting source pixels to the backend format
+    uint64_t scaleMicros = 0;     // Scaling to the window size
+    uint64_t presentMicros = 0;   // Handing the image to the display
 };
 
 // ============================================================================
@@ -82,32 +174,37 @@ public:
     // ========================================================================
 
     /**
-     * @brief Present surface data to the display
-     * @param pixels Pointer to pixel data
-     * @param pitch Bytes per row
-     * @param width Surface width
-     * @param height Surface height
-     * @param bpp Bits per pixel
+     * @brief Present a whole frame to the display
+     * @param frame Source pixels and colour tables
+     */
+    virtual void Present(const PresentFrame& frame) = 0;
+
+    /**
+     * @brief Present the parts of a frame that changed
+     * @param frame Source pixels and colour tables
+     * @param rects Areas whose pixels changed since the previous frame
+     * @param count Number of rects
      *
-     * Copies the surface data to the GPU and presents it to the screen.
-     * For 8-bit surfaces, uses the current palette for conversion.
+     * The rest of the window keeps the previous frame. A changed palette
+     * still recolours the whole frame. The default presents everything.
      */
-    virtual void Present(
-        const void* pixels,
-        uint32_t pitch,
-        uint32_t width,
-        uint32_t height,
-        uint32_t bpp
-    ) = 0;
+    virtual void PresentPartial(const PresentFrame& frame, const RECT* rects, uint32_t count) {
+        LDC_UNUSED(rects);
+        LDC_UNUSED(count);
+        Present(frame);
+    }
 
     /**
-     * @brief Set the palette for 8-bit rendering
-     * @param palette256 Array of 256 32-bit XRGB colors
+     * @brief Show the last presented frame again
+     * @return false if the backend keeps no image it can show; the
+     *         caller then presents the frame anew
      *
-     * Updates the color lookup table used for converting 8-bit
-     * palettized surfaces to 32-bit for display.
+     * Serves WM_PAINT, restores and resizes: the retained image is drawn
+     * again at the current window size, without converting anything.
      */
-    virtual void SetPalette(const uint32_t* palette256) = 0;
+    virtual bool Repaint() {
+        return false;
+    }
 
     // ========================================================================
     // Configuration
@@ -123,6 +220,9 @@ public:
      * @brief Handle window resize
      * @param width New window width
      * @param height New window height
+     *
+     * Called under the device renderMutex before the first present or
+     * repaint after the window changed size, not from WM_SIZE itself.
      */
     virtual void OnResize(uint32_t width, uint32_t height) = 0;
 
@@ -149,8 +249,39 @@ public:
      * Static check that can be called before construction.
      */
     virtual bool IsAvailable() const = 0;
+
+    /**
+     * @brief Get the time spent per stage since initialization
+     * @return Accumulated convert, scale and present times
+     */
+    virtual RendererTimings GetTimings() const = 0;
 };
 
+// ============================================================================
+// Backends
+// ============================================================================
+
+/**
+ * @brief Create the GDI renderer (always available)
+ * @param method How frames reach the window; Auto times each method
+ *               the first time the renderer is initialized for a window
+ *               and depth
+ */
+std::unique_ptr<IRenderer> CreateGDIRenderer(GDIPresentMethod method = GDIPresentMethod::Auto);
+
+/**
+ * @brief Present method Auto resolves to for a window and depth
+ * @param hWnd Window presented to
+ * @param bpp Game colour depth
+ * @param measure Times each method and returns the fastest; only called
+ *                for a window and depth not seen before
+ *
+ * Timing paints several black frames, so it is done once per process for
+ * each window and depth, not every time a primary surface is created.
+ */
+GDIPresentMethod SelectGDIPresentMethod(HWND hWnd, uint32_t bpp,
+                                        const std::function<GDIPresentMethod()>& measure);
+
 // ============================================================================
 // Renderer Factory
 // ============================================================================
@@ -162,7 +293,7 @@ class RendererFactory {
 public:
     /**
      * @brief Create a renderer of the specified type
-     * @param type Renderer type to create
+     * @param type Renderer type to create; Auto picks the best available
      * @return Unique pointer to renderer, or nullptr if failed
      */
     static std::unique_ptr<IRenderer> Create(RendererType type);
@@ -171,7 +302,8 @@ public:
      * @brief Create the best available renderer
      * @return Unique pointer to renderer, or nullptr if all failed
      *
-     * Tries renderers in order: D3D9 > OpenGL > GDI
+     * Tries renderers in order: D3D9 > OpenGL > GDI. The null renderer
+     * is never picked automatically.
      */
     static std::unique_ptr<IRenderer> CreateBestAvailable();
 
@@ -0,0 +1,85 @@
+/**
+ * @file NullRenderer.h
+ * @brief Headless rendering backend
+ *
+ * Presents into memory instead of a window: every frame is converted to
+ * 32-bit XRGB exactly as a display backend would, then hashed, kept or
+ * dropped. Nothing waits for a display, so the surface, blit and convert
+ * pipeline runs at full speed for benchmarks and regression tests.
+ */
+
+#pragma once
+
+#include "renderer/IRenderer.h"
+
+namespace ldc::renderer {
+
+/**
+ * @brief Renderer that presents into memory
+ *
+ * Needs no window; Initialize accepts a null HWND. Like the other
+ * backends it is only used under the device renderMutex, and the
+ * accessors below are read under that mutex or once presenting is idle.
+ */
+class NullRenderer : public IRenderer {
+public:
+    explicit NullRenderer(NullCapture capture = NullCapture::Hash);
+    ~NullRenderer() override;
+
+    bool Initialize(HWND hWnd, uint32_t width, uint32_t height, uint32_t bpp) override;
+    void Shutdown() override;
+    bool IsInitialized() const override { return m_initialized; }
+    void Present(const PresentFrame& frame) override;
+    void PresentPartial(const PresentFrame& frame, const RECT* rects, uint32_t count) override;
+    bool Repaint() override;
+    void SetVSync(bool enabled) override;
+    RendererType GetType() const override { return RendererType::Null; }
+    RendererCaps GetCaps() const override;
+    bool IsAvailable() const override { return true; }
+    RendererTimings GetTimings() const override { return m_timings; }
+    void OnResize(uint32_t width, uint32_t height) override;
+
+    // ========================================================================
+    // Captured Frames
+    // ========================================================================
+
+    NullCapture GetCapture() const { return m_capture; }
+
+    /** Hash of the last presented image (Hash mode), 0 before the first */
+    uint64_t GetFrameHash() const { return m_frameHash; }
+
+    /**
+     * @brief Hashes of every presented image, chained in order (Hash mode)
+     *
+     * Two runs that present the same frames produce the same value.
+     */
+    uint64_t GetSequenceHash() const { return m_sequenceHash; }
+
+    /** Last presented image, width * height XRGB pixels (Store mode), else null */
+    const uint32_t* GetFrame() const;
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+private:
+    NullCapture m_capture;
+
+    // Convert the areas (already clipped) into the image and capture it
+    void PresentAreas(const PresentFrame& frame, const RECT* areas, uint32_t count);
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+
+    // Image the frames are converted into; areas a present does not
+    // touch keep the previous frame, as a window would
+    std::vector<uint32_t> m_image;
+
+    uint64_t m_frameHash = 0;
+    uint64_t m_sequenceHash = 0;
+
+    bool m_initialized = false;
+
+    RendererTimings m_timings;
+};
+
+} // namespace ldc::renderer
@@ -0,0 +1,38 @@
+/**
+ * @file PixelConvert.h
+ * @brief Conversion of presented frames to 32-bit XRGB
+ *
+ * The software conversion shared by backends that present a 32-bit
+ * image; one pass per pixel with the palette and gamma tables applied.
+ * Backends also use it for frames in formats they cannot take natively.
+ */
+
+#pragma once
+
+#include "renderer/IRenderer.h"
+
+namespace ldc::renderer {
+
+/**
+ * @brief Convert part of a frame to 32-bit XRGB
+ * @param frame Source pixels and colour tables
+ * @param area Area to convert, inside the frame
+ * @param dst Destination image, same size as the frame
+ * @param dstStride Destination pixels per row
+ */
+void ConvertFrame(const PresentFrame& frame, const RECT& area, uint32_t* dst, uint32_t dstStride);
+
+/**
+ * @brief Clip damage rects to an image
+ * @param bounds Image area
+ * @param rects Damage as passed to PresentPartial
+ * @param count Number of rects
+ * @param maxRects Most rects to return (at least 1)
+ * @param out Receives up to maxRects rects
+ * @return Number of rects written; empty ones are dropped, and if more
+ *         than maxRects remain they are merged into their bounds
+ */
+uint32_t ClipDamageRects(const RECT& bounds, const RECT* rects, uint32_t count,
+                         uint32_t maxRects, RECT* out);
+
+} // namespace ldc::renderer
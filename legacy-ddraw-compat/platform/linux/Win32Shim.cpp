@@ -0,0 +1,779 @@
+/**
+ * @file Win32Shim.cpp
+ * @brief POSIX implementation of the Win32 subset used by the portable build
+ *
+ * Timing, threads and virtual memory map onto their POSIX equivalents so
+ * the allocator, presenter and logger behave as on Windows. There is no
+ * display: window queries report a 640x480 client area and window DCs do
+ * not exist, which leaves presentation to the null renderer. Memory DCs
+ * and DIB sections live in process memory, so surfaces still take GDI
+ * drawing (SetPixel) and report its bounds as on Windows. Named
+ * file mappings are POSIX shared memory objects, so a section the wrapper
+ * creates can be opened from another process by the same name.
+ */
+
+#include <windows.h>
+#include <mmsystem.h>
+#include <ddraw.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cerrno>
+#include <mutex>
+#include <string>
+#include <strings.h>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// An emulated DIB section; its handle is the object's address
+struct DibSection {
+    std::vector<uint8_t> bits;
+    LONG width = 0;
+    LONG height = 0;
+    LONG pitch = 0;
+    WORD bpp = 0;
+    bool topDown = false;
+    DWORD masks[3] = { 0x00FF0000, 0x0000FF00, 0x000000FF };
+    RGBQUAD colors[256] = {};
+};
+
+// An emulated memory DC, with the bounds GDI accumulates for SetBoundsRect
+struct MemoryDC {
+    HBITMAP bitmap = nullptr;
+    int savedStates = 0;
+    bool boundsEnabled = false;
+    bool boundsSet = false;
+    RECT bounds = {};
+};
+
+std::mutex g_gdiMutex;
+std::unordered_map<HBITMAP, std::unique_ptr<DibSection>> g_dibSections;
+std::unordered_map<HDC, std::unique_ptr<MemoryDC>> g_memoryDCs;
+
+// Callers hold g_gdiMutex
+MemoryDC* FindMemoryDC(HDC hdc) {
+    auto it = g_memoryDCs.find(hdc);
+    return it != g_memoryDCs.end() ? it->second.get() : nullptr;
+}
+
+DibSection* FindSelectedDib(HDC hdc) {
+    MemoryDC* dc = FindMemoryDC(hdc);
+    if (!dc || !dc->bitmap) {
+        return nullptr;
+    }
+    auto it = g_dibSections.find(dc->bitmap);
+    return it != g_dibSections.end() ? it->second.get() : nullptr;
+}
+
+void AccumulateBounds(MemoryDC& dc, const RECT& rect) {
+    if (!dc.boundsSet) {
+        dc.bounds = rect;
+        dc.boundsSet = true;
+        return;
+    }
+    dc.bounds.left = std::min(dc.bounds.left, rect.left);
+    dc.bounds.top = std::min(dc.bounds.top, rect.top);
+    dc.bounds.right = std::max(dc.bounds.right, rect.right);
+    dc.bounds.bottom = std::max(dc.bounds.bottom, rect.bottom);
+}
+
+// Scales an 8-bit channel into the bits of a colour mask
+uint32_t PackChannel(BYTE value, DWORD mask) {
+    if (!mask) {
+        return 0;
+    }
+    int shift = 0;
+    while (!((mask >> shift) & 1)) {
+        ++shift;
+    }
+    uint32_t maxValue = mask >> shift;
+    return ((value * maxValue + 127) / 255) << shift;
+}
+
+int64_t MillisecondsSinceStart() {
+    static const Clock::time_point start = Clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+// Size of each region VirtualAlloc reserved, for MEM_RELEASE
+std::mutex g_regionMutex;
+std::unordered_map<void*, size_t> g_regions;
+
+thread_local DWORD g_lastError = ERROR_SUCCESS;
+
+// A named file mapping: the shared memory object and whether this handle
+// created it. As on Windows the name goes away with the creator's handle;
+// views and handles opened before then stay valid.
+struct SharedSection {
+    int fd = -1;
+    size_t size = 0;
+    std::string name;
+    bool owner = false;
+};
+
+std::mutex g_sectionMutex;
+std::unordered_map<HANDLE, SharedSection*> g_sections;
+std::unordered_map<const void*, size_t> g_views;
+
+// "Local\\frames" and "Global\\frames" both become "/frames"
+std::string SharedMemoryName(LPCSTR name) {
+    std::string result = name;
+    size_t slash = result.find('\\');
+    if (slash != std::string::npos) {
+        result = result.substr(slash + 1);
+    }
+    for (char& c : result) {
+        if (c == '/' || c == '\\') {
+            c = '_';
+        }
+    }
+    return "/" + result;
+}
+
+HANDLE AddSection(int fd, size_t size, const std::string& name, bool owner) {
+    auto* section = new SharedSection{fd, size, name, owner};
+    HANDLE handle = reinterpret_cast<HANDLE>(section);
+    std::lock_guard<std::mutex> lock(g_sectionMutex);
+    g_sections[handle] = section;
+    return handle;
+}
+
+} // namespace
+
+// ============================================================================
+// Interface IDs
+// ============================================================================
+
+const IID IID_IUnknown = {0x00000000, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IDirectDraw = {0x6C14DB80, 0xA733, 0x11CE, {0xA5, 0x21, 0x00, 0x20, 0xAF, 0x0B, 0xE5, 0x60}};
+const IID IID_IDirectDraw2 = {0xB3A6F3E0, 0x2B43, 0x11CF, {0xA2, 0xDE, 0x00, 0xAA, 0x00, 0xB9, 0x33, 0x56}};
+const IID IID_IDirectDraw4 = {0x9C59509A, 0x39BD, 0x11D1, {0x8C, 0x4A, 0x00, 0xC0, 0x4F, 0xD9, 0x30, 0xC5}};
+const IID IID_IDirectDraw7 = {0x15E65EC0, 0x3B9C, 0x11D2, {0xB9, 0x2F, 0x00, 0x60, 0x97, 0x97, 0xEA, 0x5B}};
+const IID IID_IDirectDrawSurface = {0x6C14DB81, 0xA733, 0x11CE, {0xA5, 0x21, 0x00, 0x20, 0xAF, 0x0B, 0xE5, 0x60}};
+const IID IID_IDirectDrawSurface2 = {0x57805885, 0x6EEC, 0x11CF, {0x94, 0x41, 0xA8, 0x23, 0x03, 0xC1, 0x0E, 0x27}};
+const IID IID_IDirectDrawSurface3 = {0xDA044E00, 0x69B2, 0x11D0, {0xA1, 0xD5, 0x00, 0xAA, 0x00, 0xB8, 0xDF, 0xBB}};
+const IID IID_IDirectDrawSurface4 = {0x0B2B8630, 0xAD35, 0x11D0, {0x8E, 0xA6, 0x00, 0x60, 0x97, 0x97, 0xEA, 0x5B}};
+const IID IID_IDirectDrawSurface7 = {0x06675A80, 0x3B9B, 0x11D2, {0xB9, 0x2F, 0x00, 0x60, 0x97, 0x97, 0xEA, 0x5B}};
+const IID IID_IDirectDrawPalette = {0x6C14DB84, 0xA733, 0x11CE, {0xA5, 0x21, 0x00, 0x20, 0xAF, 0x0B, 0xE5, 0x60}};
+const IID IID_IDirectDrawClipper = {0x6C14DB85, 0xA733, 0x11CE, {0xA5, 0x21, 0x00, 0x20, 0xAF, 0x0B, 0xE5, 0x60}};
+const IID IID_IDirectDrawGammaControl = {0x69C11C3E, 0xB46B, 0x11D1, {0xAD, 0x7A, 0x00, 0xC0, 0x4F, 0xC2, 0x9B, 0x4E}};
+const IID IID_IDirectDrawColorControl = {0x4B9F0EE0, 0x0D7E, 0x11D0, {0x9B, 0x06, 0x00, 0xA0, 0xC9, 0x03, 0xA3, 0xB8}};
+
+// ============================================================================
+// Timing and Threads
+// ============================================================================
+
+DWORD GetTickCount() {
+    return static_cast<DWORD>(MillisecondsSinceStart());
+}
+
+ULONGLONG GetTickCount64() {
+    return static_cast<ULONGLONG>(MillisecondsSinceStart());
+}
+
+DWORD timeGetTime() {
+    return GetTickCount();
+}
+
+UINT timeBeginPeriod(UINT) {
+    return 0;
+}
+
+UINT timeEndPeriod(UINT) {
+    return 0;
+}
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* counter) {
+    counter->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+    return TRUE;
+}
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency) {
+    frequency->QuadPart = 1000000000;
+    return TRUE;
+}
+
+void GetLocalTime(SYSTEMTIME* time) {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    std::tm local = {};
+    localtime_r(&seconds, &local);
+
+    time->wYear = static_cast<WORD>(local.tm_year + 1900);
+    time->wMonth = static_cast<WORD>(local.tm_mon + 1);
+    time->wDayOfWeek = static_cast<WORD>(local.tm_wday);
+    time->wDay = static_cast<WORD>(local.tm_mday);
+    time->wHour = static_cast<WORD>(local.tm_hour);
+    time->wMinute = static_cast<WORD>(local.tm_min);
+    time->wSecond = static_cast<WORD>(local.tm_sec);
+    time->wMilliseconds = static_cast<WORD>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+}
+
+void Sleep(DWORD milliseconds) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+BOOL SwitchToThread() {
+    std::this_thread::yield();
+    return TRUE;
+}
+
+void YieldProcessor() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+DWORD GetCurrentThreadId() {
+    static std::atomic<DWORD> nextId{1};
+    thread_local DWORD id = nextId++;
+    return id;
+}
+
+HANDLE GetCurrentThread() {
+    return reinterpret_cast<HANDLE>(static_cast<LONG_PTR>(-2));
+}
+
+HANDLE GetCurrentProcess() {
+    return reinterpret_cast<HANDLE>(static_cast<LONG_PTR>(-1));
+}
+
+BOOL SetThreadPriority(HANDLE, int) {
+    return TRUE;
+}
+
+// ============================================================================
+// Process and Diagnostics
+// ============================================================================
+
+DWORD GetLastError() {
+    return g_lastError;
+}
+
+BOOL CloseHandle(HANDLE handle) {
+    SharedSection* section = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_sectionMutex);
+        auto it = g_sections.find(handle);
+        if (it != g_sections.end()) {
+            section = it->second;
+            g_sections.erase(it);
+        }
+    }
+
+    if (section) {
+        close(section->fd);
+        if (section->owner) {
+            shm_unlink(section->name.c_str());
+        }
+        delete section;
+    }
+    return TRUE;
+}
+
+void OutputDebugStringA(LPCSTR) {
+    // No debugger to receive it, as on Windows when none is attached
+}
+
+DWORD GetModuleFileNameA(HMODULE, LPSTR fileName, DWORD size) {
+    if (!fileName || size == 0) {
+        return 0;
+    }
+    ssize_t length = readlink("/proc/self/exe", fileName, size - 1);
+    if (length < 0) {
+        fileName[0] = '\0';
+        return 0;
+    }
+    fileName[length] = '\0';
+    return static_cast<DWORD>(length);
+}
+
+BOOL DisableThreadLibraryCalls(HMODULE) {
+    return TRUE;
+}
+
+int lstrcmpiA(LPCSTR a, LPCSTR b) {
+    return strcasecmp(a, b);
+}
+
+// ============================================================================
+// Memory
+// ============================================================================
+
+LPVOID VirtualAlloc(LPVOID address, SIZE_T size, DWORD type, DWORD protect) {
+    if (type & MEM_LARGE_PAGES) {
+        return nullptr;
+    }
+
+    int prot = (protect == PAGE_NOACCESS) ? PROT_NONE : (PROT_READ | PROT_WRITE);
+
+    if (address) {
+        // Commit within a region reserved earlier
+        if (!(type & MEM_COMMIT) || mprotect(address, size, prot) != 0) {
+            return nullptr;
+        }
+        return address;
+    }
+
+    if (!(type & MEM_COMMIT)) {
+        prot = PROT_NONE;
+    }
+    void* base = mmap(nullptr, size, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(g_regionMutex);
+    g_regions[base] = size;
+    return base;
+}
+
+BOOL VirtualFree(LPVOID address, SIZE_T size, DWORD type) {
+    if (type & MEM_DECOMMIT) {
+        // Give the pages back but keep the range reserved
+        madvise(address, size, MADV_DONTNEED);
+        return mprotect(address, size, PROT_NONE) == 0;
+    }
+
+    size_t regionSize = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_regionMutex);
+        auto it = g_regions.find(address);
+        if (it == g_regions.end()) {
+            return FALSE;
+        }
+        regionSize = it->second;
+        g_regions.erase(it);
+    }
+    return munmap(address, regionSize) == 0;
+}
+
+BOOL VirtualLock(LPVOID address, SIZE_T size) {
+    return mlock(address, size) == 0;
+}
+
+BOOL VirtualUnlock(LPVOID address, SIZE_T size) {
+    return munlock(address, size) == 0;
+}
+
+HANDLE CreateFileMappingA(HANDLE file, SECURITY_ATTRIBUTES*, DWORD protect,
+                          DWORD sizeHigh, DWORD sizeLow, LPCSTR name) {
+    // Only named sections backed by memory (not by a file) are needed
+    size_t size = (static_cast<size_t>(sizeHigh) << 32) | sizeLow;
+    if (file != INVALID_HANDLE_VALUE || !name || size == 0 || protect != PAGE_READWRITE) {
+        g_lastError = ERROR_INVALID_PARAMETER;
+        return nullptr;
+    }
+
+    std::string shmName = SharedMemoryName(name);
+    int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            shm_unlink(shmName.c_str());
+            g_lastError = ERROR_INVALID_PARAMETER;
+            return nullptr;
+        }
+        g_lastError = ERROR_SUCCESS;
+        return AddSection(fd, size, shmName, true);
+    }
+    if (errno != EEXIST) {
+        g_lastError = ERROR_INVALID_PARAMETER;
+        return nullptr;
+    }
+
+    // Windows hands back the existing section and reports that it existed
+    fd = shm_open(shmName.c_str(), O_RDWR, 0);
+    struct stat info = {};
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        g_lastError = ERROR_FILE_NOT_FOUND;
+        return nullptr;
+    }
+    g_lastError = ERROR_ALREADY_EXISTS;
+    return AddSection(fd, static_cast<size_t>(info.st_size), shmName, false);
+}
+
+HANDLE OpenFileMappingA(DWORD access, BOOL, LPCSTR name) {
+    if (!name) {
+        g_lastError = ERROR_INVALID_PARAMETER;
+        return nullptr;
+    }
+
+    std::string shmName = SharedMemoryName(name);
+    int fd = shm_open(shmName.c_str(), (access & FILE_MAP_WRITE) ? O_RDWR : O_RDONLY, 0);
+    struct stat info = {};
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        g_lastError = ERROR_FILE_NOT_FOUND;
+        return nullptr;
+    }
+    g_lastError = ERROR_SUCCESS;
+    return AddSection(fd, static_cast<size_t>(info.st_size), shmName, false);
+}
+
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size) {
+    std::lock_guard<std::mutex> lock(g_sectionMutex);
+    auto it = g_sections.find(mapping);
+    if (it == g_sections.end() || offsetHigh != 0 || offsetLow != 0) {
+        g_lastError = ERROR_INVALID_PARAMETER;
+        return nullptr;
+    }
+
+    // A size of 0 maps the whole section
+    SharedSection* section = it->second;
+    if (size == 0 || size > section->size) {
+        size = section->size;
+    }
+
+    int prot = (access & FILE_MAP_WRITE) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* view = mmap(nullptr, size, prot, MAP_SHARED, section->fd, 0);
+    if (view == MAP_FAILED) {
+        g_lastError = ERROR_INVALID_PARAMETER;
+        return nullptr;
+    }
+    g_views[view] = size;
+    return view;
+}
+
+BOOL UnmapViewOfFile(LPCVOID address) {
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_sectionMutex);
+        auto it = g_views.find(address);
+        if (it == g_views.end()) {
+            return FALSE;
+        }
+        size = it->second;
+        g_views.erase(it);
+    }
+    return munmap(const_cast<void*>(address), size) == 0;
+}
+
+SIZE_T GetLargePageMinimum() {
+    return 0;
+}
+
+BOOL GetProcessWorkingSetSize(HANDLE, SIZE_T*, SIZE_T*) {
+    return FALSE;
+}
+
+BOOL SetProcessWorkingSetSize(HANDLE, SIZE_T, SIZE_T) {
+    return FALSE;
+}
+
+BOOL OpenProcessToken(HANDLE, DWORD, HANDLE*) {
+    return FALSE;
+}
+
+BOOL LookupPrivilegeValueA(LPCSTR, LPCSTR, LUID*) {
+    return FALSE;
+}
+
+BOOL AdjustTokenPrivileges(HANDLE, BOOL, TOKEN_PRIVILEGES*, DWORD, TOKEN_PRIVILEGES*, DWORD*) {
+    return FALSE;
+}
+
+// ============================================================================
+// Windows
+// ============================================================================
+
+BOOL GetClientRect(HWND, LPRECT rect) {
+    rect->left = 0;
+    rect->top = 0;
+    rect->right = 640;
+    rect->bottom = 480;
+    return TRUE;
+}
+
+BOOL AdjustWindowRect(LPRECT, DWORD, BOOL) {
+    return TRUE;
+}
+
+BOOL SetWindowPos(HWND, HWND, int, int, int, int, UINT) {
+    return TRUE;
+}
+
+LONG GetWindowLong(HWND, int) {
+    return 0;
+}
+
+LONG_PTR SetWindowLongPtrA(HWND, int, LONG_PTR) {
+    return 0;
+}
+
+LRESULT CallWindowProcA(WNDPROC, HWND, UINT, WPARAM, LPARAM) {
+    return 0;
+}
+
+LRESULT DefWindowProcA(HWND, UINT, WPARAM, LPARAM) {
+    return 0;
+}
+
+BOOL InvalidateRect(HWND, const RECT*, BOOL) {
+    return TRUE;
+}
+
+BOOL ValidateRect(HWND, const RECT*) {
+    return TRUE;
+}
+
+HANDLE GetPropA(HWND, LPCSTR) {
+    return nullptr;
+}
+
+BOOL SetPropA(HWND, LPCSTR, HANDLE) {
+    return TRUE;
+}
+
+HANDLE RemovePropA(HWND, LPCSTR) {
+    return nullptr;
+}
+
+int GetSystemMetrics(int index) {
+    return index == SM_CXSCREEN ? 640 : 480;
+}
+
+// ============================================================================
+// GDI
+// ============================================================================
+
+HDC GetDC(HWND) {
+    return nullptr;
+}
+
+int ReleaseDC(HWND, HDC) {
+    return 1;
+}
+
+HDC CreateCompatibleDC(HDC) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    auto dc = std::make_unique<MemoryDC>();
+    HDC handle = reinterpret_cast<HDC>(dc.get());
+    g_memoryDCs[handle] = std::move(dc);
+    return handle;
+}
+
+BOOL DeleteDC(HDC hdc) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    return g_memoryDCs.erase(hdc) ? TRUE : FALSE;
+}
+
+int SaveDC(HDC hdc) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    MemoryDC* dc = FindMemoryDC(hdc);
+    return dc ? ++dc->savedStates : 0;
+}
+
+BOOL RestoreDC(HDC hdc, int) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    MemoryDC* dc = FindMemoryDC(hdc);
+    if (!dc || dc->savedStates == 0) {
+        return FALSE;
+    }
+    --dc->savedStates;
+    return TRUE;
+}
+
+int GetDeviceCaps(HDC, int index) {
+    return index == BITSPIXEL ? 32 : 0;
+}
+
+HBITMAP CreateDIBSection(HDC, const BITMAPINFO* info, UINT, void** bits, HANDLE, DWORD) {
+    if (bits) {
+        *bits = nullptr;
+    }
+
+    const BITMAPINFOHEADER& header = info->bmiHeader;
+    if (header.biWidth <= 0 || header.biHeight == 0 ||
+        (header.biBitCount != 8 && header.biBitCount != 16 && header.biBitCount != 32)) {
+        return nullptr;
+    }
+
+    auto bitmap = std::make_unique<DibSection>();
+    bitmap->width = header.biWidth;
+    bitmap->height = header.biHeight < 0 ? -header.biHeight : header.biHeight;
+    bitmap->topDown = header.biHeight < 0;
+    bitmap->bpp = header.biBitCount;
+    bitmap->pitch = ((header.biWidth * header.biBitCount + 31) / 32) * 4;
+    bitmap->bits.assign(static_cast<size_t>(bitmap->pitch) * bitmap->height, 0);
+    if (header.biCompression == BI_BITFIELDS) {
+        memcpy(bitmap->masks, info->bmiColors, sizeof(bitmap->masks));
+    } else if (header.biBitCount == 16) {
+        bitmap->masks[0] = 0x7C00;
+        bitmap->masks[1] = 0x03E0;
+        bitmap->masks[2] = 0x001F;
+    }
+
+    if (bits) {
+        *bits = bitmap->bits.data();
+    }
+
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    HBITMAP handle = reinterpret_cast<HBITMAP>(bitmap.get());
+    g_dibSections[handle] = std::move(bitmap);
+    return handle;
+}
+
+HGDIOBJ SelectObject(HDC hdc, HGDIOBJ object) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    MemoryDC* dc = FindMemoryDC(hdc);
+    if (!dc) {
+        return nullptr;
+    }
+
+    // Selecting nullptr restores the DC's empty default bitmap
+    HGDIOBJ previous = dc->bitmap;
+    HBITMAP bitmap = static_cast<HBITMAP>(object);
+    if (bitmap && !g_dibSections.count(bitmap)) {
+        return nullptr;
+    }
+    dc->bitmap = bitmap;
+    return previous;
+}
+
+BOOL DeleteObject(HGDIOBJ object) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    g_dibSections.erase(static_cast<HBITMAP>(object));
+    return TRUE;
+}
+
+UINT SetDIBColorTable(HDC hdc, UINT start, UINT count, const RGBQUAD* colors) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    DibSection* bitmap = FindSelectedDib(hdc);
+    if (!bitmap || bitmap->bpp != 8 || start >= 256) {
+        return 0;
+    }
+    count = std::min<UINT>(count, 256 - start);
+    std::copy(colors, colors + count, bitmap->colors + start);
+    return count;
+}
+
+BOOL BitBlt(HDC, int, int, int, int, HDC, int, int, DWORD) {
+    return FALSE;
+}
+
+BOOL StretchBlt(HDC, int, int, int, int, HDC, int, int, int, int, DWORD) {
+    return FALSE;
+}
+
+int SetDIBitsToDevice(HDC, int, int, DWORD, DWORD, int, int, UINT, UINT, const void*,
+                      const BITMAPINFO*, UINT) {
+    return 0;
+}
+
+int StretchDIBits(HDC, int, int, int, int, int, int, int, int, const void*,
+                  const BITMAPINFO*, UINT, DWORD) {
+    return 0;
+}
+
+int SetStretchBltMode(HDC, int) {
+    return 0;
+}
+
+BOOL SetBrushOrgEx(HDC, int, int, LPPOINT) {
+    return TRUE;
+}
+
+UINT SetBoundsRect(HDC hdc, const RECT* rect, UINT flags) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    MemoryDC* dc = FindMemoryDC(hdc);
+    if (!dc) {
+        return 0;
+    }
+
+    UINT previous = (dc->boundsEnabled ? DCB_ENABLE : DCB_DISABLE) |
+                    (dc->boundsSet ? DCB_SET : DCB_RESET);
+    if (flags & DCB_RESET) {
+        dc->boundsSet = false;
+    }
+    if ((flags & DCB_ACCUMULATE) && rect) {
+        AccumulateBounds(*dc, *rect);
+    }
+    if (flags & DCB_ENABLE) {
+        dc->boundsEnabled = true;
+    } else if (flags & DCB_DISABLE) {
+        dc->boundsEnabled = false;
+    }
+    return previous;
+}
+
+UINT GetBoundsRect(HDC hdc, LPRECT rect, UINT flags) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    MemoryDC* dc = FindMemoryDC(hdc);
+    if (!dc) {
+        return 0;
+    }
+
+    *rect = dc->boundsSet ? dc->bounds : RECT{};
+    UINT state = dc->boundsSet ? DCB_SET : DCB_RESET;
+    if (flags & DCB_RESET) {
+        dc->boundsSet = false;
+    }
+    return state;
+}
+
+COLORREF SetPixel(HDC hdc, int x, int y, COLORREF color) {
+    std::lock_guard<std::mutex> lock(g_gdiMutex);
+    MemoryDC* dc = FindMemoryDC(hdc);
+    DibSection* bitmap = FindSelectedDib(hdc);
+    if (!bitmap || x < 0 || y < 0 || x >= bitmap->width || y >= bitmap->height) {
+        return CLR_INVALID;
+    }
+
+    uint8_t* row = bitmap->bits.data() +
+                   static_cast<size_t>(bitmap->topDown ? y : bitmap->height - 1 - y) * bitmap->pitch;
+    if (bitmap->bpp == 8) {
+        // Nearest colour of the DIB's table, as GDI picks it
+        int best = 0;
+        int bestDistance = INT32_MAX;
+        for (int i = 0; i < 256; ++i) {
+            int dr = bitmap->colors[i].rgbRed - GetRValue(color);
+            int dg = bitmap->colors[i].rgbGreen - GetGValue(color);
+            int db = bitmap->colors[i].rgbBlue - GetBValue(color);
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        row[x] = static_cast<uint8_t>(best);
+    } else {
+        uint32_t pixel = PackChannel(GetRValue(color), bitmap->masks[0]) |
+                         PackChannel(GetGValue(color), bitmap->masks[1]) |
+                         PackChannel(GetBValue(color), bitmap->masks[2]);
+        if (bitmap->bpp == 16) {
+            reinterpret_cast<uint16_t*>(row)[x] = static_cast<uint16_t>(pixel);
+        } else {
+            reinterpret_cast<uint32_t*>(row)[x] = pixel;
+        }
+    }
+
+    if (dc->boundsEnabled) {
+        AccumulateBounds(*dc, RECT{ x, y, x + 1, y + 1 });
+    }
+    return color;
+}
+
+BOOL GdiFlush() {
+    return TRUE;
+}
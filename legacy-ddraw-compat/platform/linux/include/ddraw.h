@@ -0,0 +1,664 @@
+/**
+ * @file ddraw.h
+ * @brief DirectDraw declaration shim for the portable (CMake) build
+ *
+ * The DirectDraw 7 interfaces, structures and constants the wrapper
+ * implements. Interface IDs are defined in platform/linux/Win32Shim.cpp.
+ */
+
+#pragma once
+
+#include <windows.h>
+
+// ============================================================================
+// Status Codes
+// ============================================================================
+
+#define _FACDD 0x876
+#define MAKE_DDHRESULT(code) MAKE_HRESULT(1, _FACDD, code)
+#define DD_OK S_OK
+#define DD_FALSE S_FALSE
+#define DDERR_ALREADYINITIALIZED MAKE_DDHRESULT(5)
+#define DDERR_CANNOTATTACHSURFACE MAKE_DDHRESULT(10)
+#define DDERR_CANNOTDETACHSURFACE MAKE_DDHRESULT(20)
+#define DDERR_EXCEPTION MAKE_DDHRESULT(55)
+#define DDERR_GENERIC E_FAIL
+#define DDERR_INVALIDCAPS MAKE_DDHRESULT(100)
+#define DDERR_INVALIDMODE MAKE_DDHRESULT(125)
+#define DDERR_INVALIDOBJECT MAKE_DDHRESULT(130)
+#define DDERR_INVALIDPARAMS E_INVALIDARG
+#define DDERR_INVALIDPIXELFORMAT MAKE_DDHRESULT(145)
+#define DDERR_INVALIDRECT MAKE_DDHRESULT(150)
+#define DDERR_NOCOLORKEY MAKE_DDHRESULT(215)
+#define DDERR_NOOVERLAYHW MAKE_DDHRESULT(280)
+#define DDERR_NOTFOUND MAKE_DDHRESULT(255)
+#define DDERR_OUTOFMEMORY E_OUTOFMEMORY
+#define DDERR_OUTOFVIDEOMEMORY MAKE_DDHRESULT(380)
+#define DDERR_SURFACEBUSY MAKE_DDHRESULT(430)
+#define DDERR_SURFACELOST MAKE_DDHRESULT(450)
+#define DDERR_UNSUPPORTED E_NOTIMPL
+#define DDERR_WASSTILLDRAWING MAKE_DDHRESULT(540)
+#define DDERR_NOTFLIPPABLE MAKE_DDHRESULT(582)
+#define DDERR_NOTLOCKED MAKE_DDHRESULT(584)
+#define DDERR_NOTAOVERLAYSURFACE MAKE_DDHRESULT(580)
+#define DDERR_OVERLAYNOTVISIBLE MAKE_DDHRESULT(577)
+#define DDERR_NOOVERLAYDEST MAKE_DDHRESULT(578)
+#define DDERR_INVALIDPOSITION MAKE_DDHRESULT(579)
+#define DDERR_NOPALETTEATTACHED MAKE_DDHRESULT(572)
+#define DDERR_NOCLIPPERATTACHED MAKE_DDHRESULT(568)
+#define DDERR_DCALREADYCREATED MAKE_DDHRESULT(620)
+#define DDERR_NODC MAKE_DDHRESULT(586)
+#define DDERR_MOREDATA MAKE_DDHRESULT(690)
+#define DDERR_SURFACEALREADYATTACHED MAKE_DDHRESULT(410)
+#define DDERR_SURFACENOTATTACHED MAKE_DDHRESULT(600)
+#define DDERR_CANTLOCKSURFACE MAKE_DDHRESULT(573)
+#define DDERR_CANTPAGELOCK MAKE_DDHRESULT(640)
+#define DDERR_CANTPAGEUNLOCK MAKE_DDHRESULT(660)
+#define DDERR_NOTPAGELOCKED MAKE_DDHRESULT(680)
+#define DDERR_CANTDUPLICATE MAKE_DDHRESULT(581)
+#define DDERR_NOEXCLUSIVEMODE MAKE_DDHRESULT(225)
+#define DDERR_INVALIDSURFACETYPE MAKE_DDHRESULT(592)
+#define DDERR_NOTPALETTIZED MAKE_DDHRESULT(589)
+#define DDERR_NOGAMMARAMP MAKE_DDHRESULT(1001)
+#define DDERR_NODIRECTDRAWHW MAKE_DDHRESULT(561)
+#define DDENUMRET_CANCEL 0
+#define DDENUMRET_OK 1
+
+// ============================================================================
+// Surface Description Flags
+// ============================================================================
+
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PITCH 0x8
+#define DDSD_BACKBUFFERCOUNT 0x20
+#define DDSD_ZBUFFERBITDEPTH 0x40
+#define DDSD_ALPHABITDEPTH 0x80
+#define DDSD_LPSURFACE 0x800
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_CKDESTOVERLAY 0x2000
+#define DDSD_CKDESTBLT 0x4000
+#define DDSD_CKSRCOVERLAY 0x8000
+#define DDSD_CKSRCBLT 0x10000
+#define DDSD_REFRESHRATE 0x40000
+
+// ============================================================================
+// Surface Caps
+// ============================================================================
+
+#define DDSCAPS_ALPHA 0x2
+#define DDSCAPS_BACKBUFFER 0x4
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_FLIP 0x10
+#define DDSCAPS_FRONTBUFFER 0x20
+#define DDSCAPS_OFFSCREENPLAIN 0x40
+#define DDSCAPS_OVERLAY 0x80
+#define DDSCAPS_PALETTE 0x100
+#define DDSCAPS_PRIMARYSURFACE 0x200
+#define DDSCAPS_SYSTEMMEMORY 0x800
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_3DDEVICE 0x2000
+#define DDSCAPS_VIDEOMEMORY 0x4000
+#define DDSCAPS_VISIBLE 0x8000
+#define DDSCAPS_WRITEONLY 0x10000
+#define DDSCAPS_ZBUFFER 0x20000
+#define DDSCAPS_OWNDC 0x40000
+#define DDSCAPS_MIPMAP 0x400000
+#define DDSCAPS_LOCALVIDMEM 0x10000000
+#define DDSCAPS_NONLOCALVIDMEM 0x20000000
+
+// ============================================================================
+// Pixel Format Flags
+// ============================================================================
+
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_PALETTEINDEXED8 0x20
+#define DDPF_RGB 0x40
+
+// ============================================================================
+// Blt Flags
+// ============================================================================
+
+#define DDBLT_ALPHADEST 0x1
+#define DDBLT_ASYNC 0x200
+#define DDBLT_COLORFILL 0x400
+#define DDBLT_DDFX 0x800
+#define DDBLT_KEYDEST 0x2000
+#define DDBLT_KEYDESTOVERRIDE 0x4000
+#define DDBLT_KEYSRC 0x8000
+#define DDBLT_KEYSRCOVERRIDE 0x10000
+#define DDBLT_ROP 0x20000
+#define DDBLT_WAIT 0x1000000
+#define DDBLT_DEPTHFILL 0x2000000
+#define DDBLT_DONOTWAIT 0x8000000
+#define DDBLTFAST_NOCOLORKEY 0x0
+#define DDBLTFAST_SRCCOLORKEY 0x1
+#define DDBLTFAST_DESTCOLORKEY 0x2
+#define DDBLTFAST_WAIT 0x10
+#define DDBLTFAST_DONOTWAIT 0x20
+
+// ============================================================================
+// Flip Flags
+// ============================================================================
+
+#define DDFLIP_WAIT 0x1
+#define DDFLIP_EVEN 0x2
+#define DDFLIP_ODD 0x4
+#define DDFLIP_NOVSYNC 0x8
+#define DDFLIP_DONOTWAIT 0x20
+
+// ============================================================================
+// Lock Flags
+// ============================================================================
+
+#define DDLOCK_SURFACEMEMORYPTR 0x0
+#define DDLOCK_WAIT 0x1
+#define DDLOCK_EVENT 0x2
+#define DDLOCK_READONLY 0x10
+#define DDLOCK_WRITEONLY 0x20
+#define DDLOCK_NOSYSLOCK 0x800
+#define DDLOCK_DONOTWAIT 0x4000
+
+// ============================================================================
+// Status Flags
+// ============================================================================
+
+#define DDGBS_CANBLT 0x1
+#define DDGBS_ISBLTDONE 0x2
+#define DDGFS_CANFLIP 0x1
+#define DDGFS_ISFLIPDONE 0x2
+
+// ============================================================================
+// Color Key Flags
+// ============================================================================
+
+#define DDCKEY_COLORSPACE 0x1
+#define DDCKEY_DESTBLT 0x2
+#define DDCKEY_DESTOVERLAY 0x4
+#define DDCKEY_SRCBLT 0x8
+#define DDCKEY_SRCOVERLAY 0x10
+
+// ============================================================================
+// Overlay Flags
+// ============================================================================
+
+#define DDOVER_ALPHADEST 0x1
+#define DDOVER_HIDE 0x200
+#define DDOVER_KEYDEST 0x400
+#define DDOVER_KEYDESTOVERRIDE 0x800
+#define DDOVER_KEYSRC 0x1000
+#define DDOVER_KEYSRCOVERRIDE 0x2000
+#define DDOVER_SHOW 0x4000
+#define DDOVER_ADDDIRTYRECT 0x8000
+#define DDOVER_REFRESHDIRTYRECTS 0x10000
+#define DDOVER_REFRESHALL 0x20000
+#define DDOVER_DDFX 0x80000
+#define DDOVERZ_SENDTOFRONT 0x0
+#define DDOVERZ_SENDTOBACK 0x1
+#define DDOVERZ_MOVEFORWARD 0x2
+#define DDOVERZ_MOVEBACKWARD 0x3
+#define DDOVERZ_INSERTINFRONTOF 0x4
+#define DDOVERZ_INSERTINBACKOF 0x5
+#define DDENUMOVERLAYZ_BACKTOFRONT 0x0
+#define DDENUMOVERLAYZ_FRONTTOBACK 0x1
+
+// ============================================================================
+// Cooperative Level Flags
+// ============================================================================
+
+#define DDSCL_FULLSCREEN 0x1
+#define DDSCL_ALLOWREBOOT 0x2
+#define DDSCL_NOWINDOWCHANGES 0x4
+#define DDSCL_NORMAL 0x8
+#define DDSCL_EXCLUSIVE 0x10
+#define DDSCL_ALLOWMODEX 0x40
+#define DDSCL_SETFOCUSWINDOW 0x80
+#define DDSCL_SETDEVICEWINDOW 0x100
+#define DDSCL_CREATEDEVICEWINDOW 0x200
+#define DDSCL_MULTITHREADED 0x400
+#define DDSCL_FPUSETUP 0x800
+#define DDSCL_FPUPRESERVE 0x1000
+#define DDWAITVB_BLOCKBEGIN 0x1
+#define DDWAITVB_BLOCKBEGINEVENT 0x2
+#define DDWAITVB_BLOCKEND 0x4
+
+// ============================================================================
+// Driver Caps
+// ============================================================================
+
+#define DDCAPS_3D 0x1
+#define DDCAPS_BLT 0x40
+#define DDCAPS_BLTQUEUE 0x80
+#define DDCAPS_BLTFOURCC 0x100
+#define DDCAPS_BLTSTRETCH 0x200
+#define DDCAPS_GDI 0x400
+#define DDCAPS_OVERLAY 0x800
+#define DDCAPS_OVERLAYCANTCLIP 0x1000
+#define DDCAPS_OVERLAYFOURCC 0x2000
+#define DDCAPS_OVERLAYSTRETCH 0x4000
+#define DDCAPS_PALETTE 0x8000
+#define DDCAPS_COLORKEY 0x400000
+#define DDCAPS_BLTCOLORFILL 0x4000000
+#define DDCAPS2_NOPAGELOCKREQUIRED 0x40000
+#define DDCAPS2_CANRENDERWINDOWED 0x80000
+#define DDCAPS2_PRIMARYGAMMA 0x20000
+#define DDCAPS2_FLIPNOVSYNC 0x8000000
+#define DDCKEYCAPS_DESTOVERLAY 0x100
+#define DDCKEYCAPS_SRCOVERLAY 0x10000
+#define DDCKEYCAPS_SRCBLT 0x200
+#define DDCKEYCAPS_DESTBLT 0x2
+#define DDFXCAPS_OVERLAYSHRINKX 0x80000
+#define DDFXCAPS_OVERLAYSHRINKY 0x100000
+#define DDFXCAPS_OVERLAYSTRETCHX 0x200000
+#define DDFXCAPS_OVERLAYSTRETCHY 0x400000
+
+// ============================================================================
+// Palette Caps
+// ============================================================================
+
+#define DDPCAPS_4BIT 0x1
+#define DDPCAPS_8BITENTRIES 0x2
+#define DDPCAPS_8BIT 0x4
+#define DDPCAPS_INITIALIZE 0x8
+#define DDPCAPS_PRIMARYSURFACE 0x10
+#define DDPCAPS_ALLOW256 0x40
+#define DDPCAPS_1BIT 0x100
+#define DDPCAPS_2BIT 0x200
+#define DDPCAPS_ALPHA 0x400
+#define DDSGR_CALIBRATE 0x1
+#define DDSDM_STANDARDVGAMODE 0x1
+#define DDEDM_REFRESHRATES 0x1
+
+// ============================================================================
+// Structures
+// ============================================================================
+
+struct IDirectDraw;
+struct IDirectDraw2;
+struct IDirectDraw4;
+struct IDirectDraw7;
+struct IDirectDrawSurface;
+struct IDirectDrawSurface7;
+struct IDirectDrawPalette;
+struct IDirectDrawClipper;
+struct IDirectDrawGammaControl;
+
+typedef IDirectDraw* LPDIRECTDRAW;
+typedef IDirectDraw7* LPDIRECTDRAW7;
+typedef IDirectDrawSurface* LPDIRECTDRAWSURFACE;
+typedef IDirectDrawSurface7* LPDIRECTDRAWSURFACE7;
+typedef IDirectDrawPalette* LPDIRECTDRAWPALETTE;
+typedef IDirectDrawClipper* LPDIRECTDRAWCLIPPER;
+typedef IDirectDrawGammaControl* LPDIRECTDRAWGAMMACONTROL;
+
+typedef struct _DDCOLORKEY {
+    DWORD dwColorSpaceLowValue;
+    DWORD dwColorSpaceHighValue;
+} DDCOLORKEY, *LPDDCOLORKEY;
+
+typedef struct _DDSCAPS {
+    DWORD dwCaps;
+} DDSCAPS, *LPDDSCAPS;
+
+typedef struct _DDSCAPS2 {
+    DWORD dwCaps;
+    DWORD dwCaps2;
+    DWORD dwCaps3;
+    union {
+        DWORD dwCaps4;
+        DWORD dwVolumeDepth;
+    };
+} DDSCAPS2, *LPDDSCAPS2;
+
+typedef struct _DDPIXELFORMAT {
+    DWORD dwSize;
+    DWORD dwFlags;
+    DWORD dwFourCC;
+    union {
+        DWORD dwRGBBitCount;
+        DWORD dwYUVBitCount;
+    };
+    union {
+        DWORD dwRBitMask;
+        DWORD dwYBitMask;
+    };
+    union {
+        DWORD dwGBitMask;
+        DWORD dwUBitMask;
+    };
+    union {
+        DWORD dwBBitMask;
+        DWORD dwVBitMask;
+    };
+    union {
+        DWORD dwRGBAlphaBitMask;
+        DWORD dwYUVAlphaBitMask;
+    };
+} DDPIXELFORMAT, *LPDDPIXELFORMAT;
+
+typedef struct _DDSURFACEDESC2 {
+    DWORD dwSize;
+    DWORD dwFlags;
+    DWORD dwHeight;
+    DWORD dwWidth;
+    union {
+        LONG lPitch;
+        DWORD dwLinearSize;
+    };
+    union {
+        DWORD dwBackBufferCount;
+        DWORD dwDepth;
+    };
+    union {
+        DWORD dwMipMapCount;
+        DWORD dwRefreshRate;
+        DWORD dwSrcVBHandle;
+    };
+    DWORD dwAlphaBitDepth;
+    DWORD dwReserved;
+    LPVOID lpSurface;
+    union {
+        DDCOLORKEY ddckCKDestOverlay;
+        DWORD dwEmptyFaceColor;
+    };
+    DDCOLORKEY ddckCKDestBlt;
+    DDCOLORKEY ddckCKSrcOverlay;
+    DDCOLORKEY ddckCKSrcBlt;
+    union {
+        DDPIXELFORMAT ddpfPixelFormat;
+        DWORD dwFVF;
+    };
+    DDSCAPS2 ddsCaps;
+    DWORD dwTextureStage;
+} DDSURFACEDESC2, *LPDDSURFACEDESC2;
+
+typedef struct _DDSURFACEDESC {
+    DWORD dwSize;
+    DWORD dwFlags;
+    DWORD dwHeight;
+    DWORD dwWidth;
+    union {
+        LONG lPitch;
+        DWORD dwLinearSize;
+    };
+    DWORD dwBackBufferCount;
+    union {
+        DWORD dwMipMapCount;
+        DWORD dwZBufferBitDepth;
+        DWORD dwRefreshRate;
+    };
+    DWORD dwAlphaBitDepth;
+    DWORD dwReserved;
+    LPVOID lpSurface;
+    DDCOLORKEY ddckCKDestOverlay;
+    DDCOLORKEY ddckCKDestBlt;
+    DDCOLORKEY ddckCKSrcOverlay;
+    DDCOLORKEY ddckCKSrcBlt;
+    DDPIXELFORMAT ddpfPixelFormat;
+    DDSCAPS ddsCaps;
+} DDSURFACEDESC, *LPDDSURFACEDESC;
+
+typedef struct _DDBLTFX {
+    DWORD dwSize;
+    DWORD dwDDFX;
+    DWORD dwROP;
+    DWORD dwDDROP;
+    DWORD dwRotationAngle;
+    DWORD dwZBufferOpCode;
+    DWORD dwZBufferLow;
+    DWORD dwZBufferHigh;
+    DWORD dwZBufferBaseDest;
+    DWORD dwZDestConstBitDepth;
+    DWORD dwZDestConst;
+    DWORD dwZSrcConstBitDepth;
+    DWORD dwZSrcConst;
+    DWORD dwAlphaEdgeBlendBitDepth;
+    DWORD dwAlphaEdgeBlend;
+    DWORD dwReserved;
+    DWORD dwAlphaDestConstBitDepth;
+    DWORD dwAlphaDestConst;
+    DWORD dwAlphaSrcConstBitDepth;
+    DWORD dwAlphaSrcConst;
+    union {
+        DWORD dwFillColor;
+        DWORD dwFillDepth;
+        DWORD dwFillPixel;
+    };
+    DDCOLORKEY ddckDestColorkey;
+    DDCOLORKEY ddckSrcColorkey;
+} DDBLTFX, *LPDDBLTFX;
+
+typedef struct _DDBLTBATCH {
+    LPRECT lprDest;
+    LPDIRECTDRAWSURFACE lpDDSSrc;
+    LPRECT lprSrc;
+    DWORD dwFlags;
+    LPDDBLTFX lpDDBltFx;
+} DDBLTBATCH, *LPDDBLTBATCH;
+
+typedef struct _DDOVERLAYFX {
+    DWORD dwSize;
+    DWORD dwAlphaEdgeBlendBitDepth;
+    DWORD dwAlphaEdgeBlend;
+    DWORD dwReserved;
+    DWORD dwAlphaDestConstBitDepth;
+    DWORD dwAlphaDestConst;
+    DWORD dwAlphaSrcConstBitDepth;
+    DWORD dwAlphaSrcConst;
+    DDCOLORKEY dckDestColorkey;
+    DDCOLORKEY dckSrcColorkey;
+    DWORD dwDDFX;
+    DWORD dwFlags;
+} DDOVERLAYFX, *LPDDOVERLAYFX;
+
+typedef struct _DDCAPS_DX7 {
+    DWORD dwSize;
+    DWORD dwCaps;
+    DWORD dwCaps2;
+    DWORD dwCKeyCaps;
+    DWORD dwFXCaps;
+    DWORD dwFXAlphaCaps;
+    DWORD dwPalCaps;
+    DWORD dwSVCaps;
+    DWORD dwAlphaBltConstBitDepths;
+    DWORD dwAlphaBltPixelBitDepths;
+    DWORD dwAlphaBltSurfaceBitDepths;
+    DWORD dwAlphaOverlayConstBitDepths;
+    DWORD dwAlphaOverlayPixelBitDepths;
+    DWORD dwAlphaOverlaySurfaceBitDepths;
+    DWORD dwZBufferBitDepths;
+    DWORD dwVidMemTotal;
+    DWORD dwVidMemFree;
+    DWORD dwMaxVisibleOverlays;
+    DWORD dwCurrVisibleOverlays;
+    DWORD dwNumFourCCCodes;
+    DWORD dwAlignBoundarySrc;
+    DWORD dwAlignSizeSrc;
+    DWORD dwAlignBoundaryDest;
+    DWORD dwAlignSizeDest;
+    DWORD dwAlignStrideAlign;
+    DWORD dwRops[8];
+    DDSCAPS ddsOldCaps;
+    DWORD dwMinOverlayStretch;
+    DWORD dwMaxOverlayStretch;
+    DWORD dwMinLiveVideoStretch;
+    DWORD dwMaxLiveVideoStretch;
+    DWORD dwMinHwCodecStretch;
+    DWORD dwMaxHwCodecStretch;
+    DWORD dwReserved1;
+    DWORD dwReserved2;
+    DWORD dwReserved3;
+    DWORD dwSVBCaps;
+    DWORD dwSVBCKeyCaps;
+    DWORD dwSVBFXCaps;
+    DWORD dwSVBRops[8];
+    DWORD dwVSBCaps;
+    DWORD dwVSBCKeyCaps;
+    DWORD dwVSBFXCaps;
+    DWORD dwVSBRops[8];
+    DWORD dwSSBCaps;
+    DWORD dwSSBCKeyCaps;
+    DWORD dwSSBFXCaps;
+    DWORD dwSSBRops[8];
+    DWORD dwMaxVideoPorts;
+    DWORD dwCurrVideoPorts;
+    DWORD dwSVBCaps2;
+    DWORD dwNLVBCaps;
+    DWORD dwNLVBCaps2;
+    DWORD dwNLVBCKeyCaps;
+    DWORD dwNLVBFXCaps;
+    DWORD dwNLVBRops[8];
+    DDSCAPS2 ddsCaps;
+} DDCAPS, *LPDDCAPS;
+
+typedef struct tagDDDEVICEIDENTIFIER2 {
+    char szDriver[512];
+    char szDescription[512];
+    LARGE_INTEGER liDriverVersion;
+    DWORD dwVendorId;
+    DWORD dwDeviceId;
+    DWORD dwSubSysId;
+    DWORD dwRevision;
+    GUID guidDeviceIdentifier;
+    DWORD dwWHQLLevel;
+} DDDEVICEIDENTIFIER2, *LPDDDEVICEIDENTIFIER2;
+
+typedef struct _DDGAMMARAMP {
+    WORD red[256];
+    WORD green[256];
+    WORD blue[256];
+} DDGAMMARAMP, *LPDDGAMMARAMP;
+
+typedef HRESULT (WINAPI* LPDDENUMSURFACESCALLBACK7)(LPDIRECTDRAWSURFACE7, LPDDSURFACEDESC2, LPVOID);
+typedef HRESULT (WINAPI* LPDDENUMMODESCALLBACK2)(LPDDSURFACEDESC2, LPVOID);
+typedef BOOL (WINAPI* LPDDENUMCALLBACKA)(GUID*, LPSTR, LPSTR, LPVOID);
+typedef BOOL (WINAPI* LPDDENUMCALLBACKW)(GUID*, LPWSTR, LPWSTR, LPVOID);
+typedef BOOL (WINAPI* LPDDENUMCALLBACKEXA)(GUID*, LPSTR, LPSTR, LPVOID, HMONITOR);
+typedef BOOL (WINAPI* LPDDENUMCALLBACKEXW)(GUID*, LPWSTR, LPWSTR, LPVOID, HMONITOR);
+typedef struct _RGNDATA {
+    char dummy;
+} RGNDATA, *LPRGNDATA;
+
+// ============================================================================
+// Interfaces
+// ============================================================================
+
+extern const IID IID_IDirectDraw;
+extern const IID IID_IDirectDraw2;
+extern const IID IID_IDirectDraw4;
+extern const IID IID_IDirectDraw7;
+extern const IID IID_IDirectDrawSurface;
+extern const IID IID_IDirectDrawSurface2;
+extern const IID IID_IDirectDrawSurface3;
+extern const IID IID_IDirectDrawSurface4;
+extern const IID IID_IDirectDrawSurface7;
+extern const IID IID_IDirectDrawPalette;
+extern const IID IID_IDirectDrawClipper;
+extern const IID IID_IDirectDrawGammaControl;
+extern const IID IID_IDirectDrawColorControl;
+
+struct IDirectDraw : IUnknown {};
+
+struct IDirectDraw7 : IUnknown {
+    STDMETHOD(Compact)() PURE;
+    STDMETHOD(CreateClipper)(DWORD, LPDIRECTDRAWCLIPPER*, IUnknown*) PURE;
+    STDMETHOD(CreatePalette)(DWORD, LPPALETTEENTRY, LPDIRECTDRAWPALETTE*, IUnknown*) PURE;
+    STDMETHOD(CreateSurface)(LPDDSURFACEDESC2, LPDIRECTDRAWSURFACE7*, IUnknown*) PURE;
+    STDMETHOD(DuplicateSurface)(LPDIRECTDRAWSURFACE7, LPDIRECTDRAWSURFACE7*) PURE;
+    STDMETHOD(EnumDisplayModes)(DWORD, LPDDSURFACEDESC2, LPVOID, LPDDENUMMODESCALLBACK2) PURE;
+    STDMETHOD(EnumSurfaces)(DWORD, LPDDSURFACEDESC2, LPVOID, LPDDENUMSURFACESCALLBACK7) PURE;
+    STDMETHOD(FlipToGDISurface)() PURE;
+    STDMETHOD(GetCaps)(LPDDCAPS, LPDDCAPS) PURE;
+    STDMETHOD(GetDisplayMode)(LPDDSURFACEDESC2) PURE;
+    STDMETHOD(GetFourCCCodes)(LPDWORD, LPDWORD) PURE;
+    STDMETHOD(GetGDISurface)(LPDIRECTDRAWSURFACE7*) PURE;
+    STDMETHOD(GetMonitorFrequency)(LPDWORD) PURE;
+    STDMETHOD(GetScanLine)(LPDWORD) PURE;
+    STDMETHOD(GetVerticalBlankStatus)(LPBOOL) PURE;
+    STDMETHOD(Initialize)(GUID*) PURE;
+    STDMETHOD(RestoreDisplayMode)() PURE;
+    STDMETHOD(SetCooperativeLevel)(HWND, DWORD) PURE;
+    STDMETHOD(SetDisplayMode)(DWORD, DWORD, DWORD, DWORD, DWORD) PURE;
+    STDMETHOD(WaitForVerticalBlank)(DWORD, HANDLE) PURE;
+    STDMETHOD(GetAvailableVidMem)(LPDDSCAPS2, LPDWORD, LPDWORD) PURE;
+    STDMETHOD(GetSurfaceFromDC)(HDC, LPDIRECTDRAWSURFACE7*) PURE;
+    STDMETHOD(RestoreAllSurfaces)() PURE;
+    STDMETHOD(TestCooperativeLevel)() PURE;
+    STDMETHOD(GetDeviceIdentifier)(LPDDDEVICEIDENTIFIER2, DWORD) PURE;
+    STDMETHOD(StartModeTest)(LPSIZE, DWORD, DWORD) PURE;
+    STDMETHOD(EvaluateMode)(DWORD, DWORD*) PURE;
+};
+
+struct IDirectDrawSurface : IUnknown {};
+
+struct IDirectDrawSurface7 : IUnknown {
+    STDMETHOD(AddAttachedSurface)(LPDIRECTDRAWSURFACE7) PURE;
+    STDMETHOD(AddOverlayDirtyRect)(LPRECT) PURE;
+    STDMETHOD(Blt)(LPRECT, LPDIRECTDRAWSURFACE7, LPRECT, DWORD, LPDDBLTFX) PURE;
+    STDMETHOD(BltBatch)(LPDDBLTBATCH, DWORD, DWORD) PURE;
+    STDMETHOD(BltFast)(DWORD, DWORD, LPDIRECTDRAWSURFACE7, LPRECT, DWORD) PURE;
+    STDMETHOD(DeleteAttachedSurface)(DWORD, LPDIRECTDRAWSURFACE7) PURE;
+    STDMETHOD(EnumAttachedSurfaces)(LPVOID, LPDDENUMSURFACESCALLBACK7) PURE;
+    STDMETHOD(EnumOverlayZOrders)(DWORD, LPVOID, LPDDENUMSURFACESCALLBACK7) PURE;
+    STDMETHOD(Flip)(LPDIRECTDRAWSURFACE7, DWORD) PURE;
+    STDMETHOD(GetAttachedSurface)(LPDDSCAPS2, LPDIRECTDRAWSURFACE7*) PURE;
+    STDMETHOD(GetBltStatus)(DWORD) PURE;
+    STDMETHOD(GetCaps)(LPDDSCAPS2) PURE;
+    STDMETHOD(GetClipper)(LPDIRECTDRAWCLIPPER*) PURE;
+    STDMETHOD(GetColorKey)(DWORD, LPDDCOLORKEY) PURE;
+    STDMETHOD(GetDC)(HDC*) PURE;
+    STDMETHOD(GetFlipStatus)(DWORD) PURE;
+    STDMETHOD(GetOverlayPosition)(LPLONG, LPLONG) PURE;
+    STDMETHOD(GetPalette)(LPDIRECTDRAWPALETTE*) PURE;
+    STDMETHOD(GetPixelFormat)(LPDDPIXELFORMAT) PURE;
+    STDMETHOD(GetSurfaceDesc)(LPDDSURFACEDESC2) PURE;
+    STDMETHOD(Initialize)(LPDIRECTDRAW, LPDDSURFACEDESC2) PURE;
+    STDMETHOD(IsLost)() PURE;
+    STDMETHOD(Lock)(LPRECT, LPDDSURFACEDESC2, DWORD, HANDLE) PURE;
+    STDMETHOD(ReleaseDC)(HDC) PURE;
+    STDMETHOD(Restore)() PURE;
+    STDMETHOD(SetClipper)(LPDIRECTDRAWCLIPPER) PURE;
+    STDMETHOD(SetColorKey)(DWORD, LPDDCOLORKEY) PURE;
+    STDMETHOD(SetOverlayPosition)(LONG, LONG) PURE;
+    STDMETHOD(SetPalette)(LPDIRECTDRAWPALETTE) PURE;
+    STDMETHOD(Unlock)(LPRECT) PURE;
+    STDMETHOD(UpdateOverlay)(LPRECT, LPDIRECTDRAWSURFACE7, LPRECT, DWORD, LPDDOVERLAYFX) PURE;
+    STDMETHOD(UpdateOverlayDisplay)(DWORD) PURE;
+    STDMETHOD(UpdateOverlayZOrder)(DWORD, LPDIRECTDRAWSURFACE7) PURE;
+    STDMETHOD(GetDDInterface)(LPVOID*) PURE;
+    STDMETHOD(PageLock)(DWORD) PURE;
+    STDMETHOD(PageUnlock)(DWORD) PURE;
+    STDMETHOD(SetSurfaceDesc)(LPDDSURFACEDESC2, DWORD) PURE;
+    STDMETHOD(SetPrivateData)(REFGUID, LPVOID, DWORD, DWORD) PURE;
+    STDMETHOD(GetPrivateData)(REFGUID, LPVOID, LPDWORD) PURE;
+    STDMETHOD(FreePrivateData)(REFGUID) PURE;
+    STDMETHOD(GetUniquenessValue)(LPDWORD) PURE;
+    STDMETHOD(ChangeUniquenessValue)() PURE;
+    STDMETHOD(SetPriority)(DWORD) PURE;
+    STDMETHOD(GetPriority)(LPDWORD) PURE;
+    STDMETHOD(SetLOD)(DWORD) PURE;
+    STDMETHOD(GetLOD)(LPDWORD) PURE;
+};
+
+struct IDirectDrawPalette : IUnknown {
+    STDMETHOD(GetCaps)(LPDWORD) PURE;
+    STDMETHOD(GetEntries)(DWORD, DWORD, DWORD, LPPALETTEENTRY) PURE;
+    STDMETHOD(Initialize)(LPDIRECTDRAW, DWORD, LPPALETTEENTRY) PURE;
+    STDMETHOD(SetEntries)(DWORD, DWORD, DWORD, LPPALETTEENTRY) PURE;
+};
+
+struct IDirectDrawClipper : IUnknown {
+    STDMETHOD(GetClipList)(LPRECT, LPRGNDATA, LPDWORD) PURE;
+    STDMETHOD(GetHWnd)(HWND*) PURE;
+    STDMETHOD(Initialize)(LPDIRECTDRAW, DWORD) PURE;
+    STDMETHOD(IsClipListChanged)(BOOL*) PURE;
+    STDMETHOD(SetClipList)(LPRGNDATA, DWORD) PURE;
+    STDMETHOD(SetHWnd)(DWORD, HWND) PURE;
+};
+
+struct IDirectDrawGammaControl : IUnknown {
+    STDMETHOD(GetGammaRamp)(DWORD, LPDDGAMMARAMP) PURE;
+    STDMETHOD(SetGammaRamp)(DWORD, LPDDGAMMARAMP) PURE;
+};
@@ -0,0 +1,16 @@
+/**
+ * @file mmsystem.h
+ * @brief Multimedia timer shim for the portable (CMake) build
+ */
+
+#pragma once
+
+#include <windows.h>
+
+extern "C" {
+
+UINT timeBeginPeriod(UINT period);
+UINT timeEndPeriod(UINT period);
+DWORD timeGetTime();
+
+} // extern "C"
@@ -0,0 +1,549 @@
+/**
+ * @file windows.h
+ * @brief Win32 type shim for the portable (CMake) build
+ *
+ * Declares just the subset of the Win32 API the wrapper's sources use, so
+ * the pixel, blit, config and logging code compiles with GCC/Clang on
+ * Linux. Integer types keep their Win32 widths (DWORD and LONG are 32-bit
+ * even on LP64). Functions are implemented in platform/linux/Win32Shim.cpp:
+ * timing, threading and memory map onto POSIX, window and GDI calls are
+ * inert stubs that report failure where the caller checks.
+ *
+ * Never used by the Windows build.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// Calling Conventions and Keywords
+// ============================================================================
+
+#define WINAPI
+#define CALLBACK
+#define APIENTRY
+#define STDMETHODCALLTYPE
+#define PASCAL
+#define FAR
+#define NEAR
+#define CONST const
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFF
+
+// ============================================================================
+// Basic Types
+// ============================================================================
+
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int32_t HRESULT;
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef uint16_t WORD;
+typedef unsigned int UINT;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef int64_t LONG64;
+typedef uint64_t DWORD64;
+
+typedef intptr_t INT_PTR;
+typedef uintptr_t UINT_PTR;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR;
+typedef ULONG_PTR DWORD_PTR;
+typedef ULONG_PTR SIZE_T;
+
+typedef LONG_PTR LRESULT;
+typedef UINT_PTR WPARAM;
+typedef LONG_PTR LPARAM;
+
+typedef void* PVOID;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+typedef BYTE* LPBYTE;
+typedef WORD* LPWORD;
+typedef DWORD* LPDWORD;
+typedef LONG* LPLONG;
+typedef BOOL* LPBOOL;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef wchar_t* LPWSTR;
+typedef const wchar_t* LPCWSTR;
+
+// ============================================================================
+// Handles
+// ============================================================================
+
+#define LDC_DECLARE_HANDLE(name) struct name##__; typedef struct name##__* name
+
+typedef void* HANDLE;
+typedef void* HGDIOBJ;
+LDC_DECLARE_HANDLE(HWND);
+LDC_DECLARE_HANDLE(HDC);
+LDC_DECLARE_HANDLE(HBITMAP);
+LDC_DECLARE_HANDLE(HINSTANCE);
+LDC_DECLARE_HANDLE(HMONITOR);
+LDC_DECLARE_HANDLE(HRGN);
+LDC_DECLARE_HANDLE(HPALETTE);
+typedef HINSTANCE HMODULE;
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(LONG_PTR)-1)
+
+typedef LRESULT (CALLBACK* WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+
+// ============================================================================
+// Structures
+// ============================================================================
+
+typedef struct tagRECT {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT, *PRECT, *LPRECT;
+typedef const RECT* LPCRECT;
+
+typedef struct tagPOINT {
+    LONG x;
+    LONG y;
+} POINT, *LPPOINT;
+
+typedef struct tagSIZE {
+    LONG cx;
+    LONG cy;
+} SIZE, *LPSIZE;
+
+typedef union _LARGE_INTEGER {
+    struct {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct _SYSTEMTIME {
+    WORD wYear;
+    WORD wMonth;
+    WORD wDayOfWeek;
+    WORD wDay;
+    WORD wHour;
+    WORD wMinute;
+    WORD wSecond;
+    WORD wMilliseconds;
+} SYSTEMTIME;
+
+typedef DWORD COLORREF;
+
+typedef struct tagRGBQUAD {
+    BYTE rgbBlue;
+    BYTE rgbGreen;
+    BYTE rgbRed;
+    BYTE rgbReserved;
+} RGBQUAD;
+
+typedef struct tagPALETTEENTRY {
+    BYTE peRed;
+    BYTE peGreen;
+    BYTE peBlue;
+    BYTE peFlags;
+} PALETTEENTRY, *LPPALETTEENTRY;
+
+typedef struct tagBITMAPINFOHEADER {
+    DWORD biSize;
+    LONG biWidth;
+    LONG biHeight;
+    WORD biPlanes;
+    WORD biBitCount;
+    DWORD biCompression;
+    DWORD biSizeImage;
+    LONG biXPelsPerMeter;
+    LONG biYPelsPerMeter;
+    DWORD biClrUsed;
+    DWORD biClrImportant;
+} BITMAPINFOHEADER;
+
+typedef struct tagBITMAPINFO {
+    BITMAPINFOHEADER bmiHeader;
+    RGBQUAD bmiColors[1];
+} BITMAPINFO;
+
+typedef struct tagBITMAP {
+    LONG bmType;
+    LONG bmWidth;
+    LONG bmHeight;
+    LONG bmWidthBytes;
+    WORD bmPlanes;
+    WORD bmBitsPixel;
+    LPVOID bmBits;
+} BITMAP;
+
+typedef struct tagPAINTSTRUCT {
+    HDC hdc;
+    BOOL fErase;
+    RECT rcPaint;
+    BOOL fRestore;
+    BOOL fIncUpdate;
+    BYTE rgbReserved[32];
+} PAINTSTRUCT;
+
+typedef struct _MEMORYSTATUSEX {
+    DWORD dwLength;
+    DWORD dwMemoryLoad;
+    ULONGLONG ullTotalPhys;
+    ULONGLONG ullAvailPhys;
+    ULONGLONG ullTotalPageFile;
+    ULONGLONG ullAvailPageFile;
+    ULONGLONG ullTotalVirtual;
+    ULONGLONG ullAvailVirtual;
+    ULONGLONG ullAvailExtendedVirtual;
+} MEMORYSTATUSEX;
+
+typedef struct _SYSTEM_INFO {
+    DWORD dwOemId;
+    DWORD dwPageSize;
+    LPVOID lpMinimumApplicationAddress;
+    LPVOID lpMaximumApplicationAddress;
+    DWORD_PTR dwActiveProcessorMask;
+    DWORD dwNumberOfProcessors;
+    DWORD dwProcessorType;
+    DWORD dwAllocationGranularity;
+    WORD wProcessorLevel;
+    WORD wProcessorRevision;
+} SYSTEM_INFO;
+
+typedef struct _SECURITY_ATTRIBUTES {
+    DWORD nLength;
+    LPVOID lpSecurityDescriptor;
+    BOOL bInheritHandle;
+} SECURITY_ATTRIBUTES;
+
+typedef struct _LUID {
+    DWORD LowPart;
+    LONG HighPart;
+} LUID;
+
+typedef struct _LUID_AND_ATTRIBUTES {
+    LUID Luid;
+    DWORD Attributes;
+} LUID_AND_ATTRIBUTES;
+
+typedef struct _TOKEN_PRIVILEGES {
+    DWORD PrivilegeCount;
+    LUID_AND_ATTRIBUTES Privileges[1];
+} TOKEN_PRIVILEGES;
+
+// ============================================================================
+// GUIDs and COM
+// ============================================================================
+
+typedef struct _GUID {
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+} GUID, IID, CLSID;
+typedef GUID* LPGUID;
+typedef const GUID& REFGUID;
+typedef const IID& REFIID;
+typedef const CLSID& REFCLSID;
+
+inline bool operator==(const GUID& a, const GUID& b) { return memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool operator!=(const GUID& a, const GUID& b) { return !(a == b); }
+
+#define IsEqualGUID(a, b) ((a) == (b))
+#define IsEqualIID(a, b) ((a) == (b))
+
+#define DECLARE_INTERFACE_(iface, base) struct iface : public base
+#define STDMETHOD(method) virtual HRESULT STDMETHODCALLTYPE method
+#define STDMETHOD_(type, method) virtual type STDMETHODCALLTYPE method
+#define PURE = 0
+#define THIS_
+#define THIS void
+
+struct IUnknown {
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObj) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+};
+typedef IUnknown* LPUNKNOWN;
+
+extern const IID IID_IUnknown;
+
+// ============================================================================
+// Status Codes
+// ============================================================================
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define CLASS_E_NOAGGREGATION ((HRESULT)0x80040110L)
+#define CLASS_E_CLASSNOTAVAILABLE ((HRESULT)0x80040111L)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define MAKE_HRESULT(sev, fac, code) \
+    ((HRESULT)(((uint32_t)(sev) << 31) | ((uint32_t)(fac) << 16) | ((uint32_t)(code))))
+
+#define ERROR_SUCCESS 0L
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_INVALID_PARAMETER 87L
+#define ERROR_ALREADY_EXISTS 183L
+#define ERROR_WORKING_SET_QUOTA 1453L
+
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258L
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+// DllMain reasons
+#define DLL_PROCESS_DETACH 0
+#define DLL_PROCESS_ATTACH 1
+#define DLL_THREAD_ATTACH 2
+#define DLL_THREAD_DETACH 3
+
+// Window messages
+#define WM_MOVE 0x0003
+#define WM_SIZE 0x0005
+#define WM_ACTIVATE 0x0006
+#define WM_PAINT 0x000F
+#define WM_ERASEBKGND 0x0014
+#define WM_SHOWWINDOW 0x0018
+#define WM_ACTIVATEAPP 0x001C
+#define WM_WINDOWPOSCHANGED 0x0047
+#define WM_DISPLAYCHANGE 0x007E
+#define WM_SYSCOMMAND 0x0112
+#define WM_MOUSEMOVE 0x0200
+#define WM_LBUTTONDOWN 0x0201
+#define WM_LBUTTONUP 0x0202
+#define WM_RBUTTONDOWN 0x0204
+#define WM_RBUTTONUP 0x0205
+#define WM_MBUTTONDOWN 0x0207
+#define WM_MBUTTONUP 0x0208
+
+#define SIZE_RESTORED 0
+#define SIZE_MINIMIZED 1
+#define SIZE_MAXIMIZED 2
+#define SC_RESTORE 0xF120
+
+// Window management
+#define GWLP_WNDPROC (-4)
+#define GWL_STYLE (-16)
+#define SWP_NOSIZE 0x0001
+#define SWP_NOMOVE 0x0002
+#define SWP_NOZORDER 0x0004
+#define RDW_INVALIDATE 0x0001
+#define RDW_ERASE 0x0004
+#define RDW_UPDATENOW 0x0100
+#define SM_CXSCREEN 0
+#define SM_CYSCREEN 1
+#define MONITOR_DEFAULTTOPRIMARY 1
+#define MONITOR_DEFAULTTONEAREST 2
+
+// GDI
+#define BITSPIXEL 12
+#define VREFRESH 116
+#define COLORONCOLOR 3
+#define HALFTONE 4
+#define SRCCOPY 0x00CC0020
+#define BI_RGB 0L
+#define BI_BITFIELDS 3L
+#define DIB_RGB_COLORS 0
+#define DIB_PAL_COLORS 1
+#define DCB_RESET 0x0001
+#define DCB_ACCUMULATE 0x0002
+#define DCB_SET (DCB_RESET | DCB_ACCUMULATE)
+#define DCB_ENABLE 0x0004
+#define DCB_DISABLE 0x0008
+#define RGB(r, g, b) ((COLORREF)(((BYTE)(r)) | ((WORD)((BYTE)(g)) << 8) | (((DWORD)(BYTE)(b)) << 16)))
+#define GetRValue(rgb) ((BYTE)(rgb))
+#define GetGValue(rgb) ((BYTE)(((WORD)(rgb)) >> 8))
+#define GetBValue(rgb) ((BYTE)((rgb) >> 16))
+#define CLR_INVALID 0xFFFFFFFF
+
+// Memory
+#define MEM_COMMIT 0x1000
+#define MEM_RESERVE 0x2000
+#define MEM_DECOMMIT 0x4000
+#define MEM_RELEASE 0x8000
+#define MEM_RESET 0x80000
+#define MEM_LARGE_PAGES 0x20000000
+#define PAGE_NOACCESS 0x01
+#define PAGE_READONLY 0x02
+#define PAGE_READWRITE 0x04
+#define FILE_MAP_WRITE 0x0002
+#define FILE_MAP_READ 0x0004
+#define FILE_MAP_ALL_ACCESS 0xF001F
+
+// Threads and privileges
+#define THREAD_PRIORITY_ABOVE_NORMAL 1
+#define THREAD_PRIORITY_HIGHEST 2
+#define TOKEN_ADJUST_PRIVILEGES 0x0020
+#define TOKEN_QUERY 0x0008
+#define SE_PRIVILEGE_ENABLED 0x00000002L
+#define SE_LOCK_MEMORY_NAME "SeLockMemoryPrivilege"
+
+// ============================================================================
+// Macros
+// ============================================================================
+
+#define LOWORD(l) ((WORD)(((DWORD_PTR)(l)) & 0xffff))
+#define HIWORD(l) ((WORD)((((DWORD_PTR)(l)) >> 16) & 0xffff))
+#define MAKELPARAM(l, h) ((LPARAM)(DWORD)(LOWORD(l) | ((DWORD)LOWORD(h) << 16)))
+
+#define ZeroMemory(dst, size) memset((dst), 0, (size))
+#define CopyMemory(dst, src, size) memcpy((dst), (src), (size))
+
+// ============================================================================
+// Functions (platform/linux/Win32Shim.cpp)
+// ============================================================================
+
+extern "C" {
+
+// Timing and threads
+DWORD GetTickCount();
+ULONGLONG GetTickCount64();
+BOOL QueryPerformanceCounter(LARGE_INTEGER* counter);
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+void GetLocalTime(SYSTEMTIME* time);
+void Sleep(DWORD milliseconds);
+BOOL SwitchToThread();
+void YieldProcessor();
+DWORD GetCurrentThreadId();
+HANDLE GetCurrentThread();
+HANDLE GetCurrentProcess();
+BOOL SetThreadPriority(HANDLE thread, int priority);
+
+// Process and diagnostics
+DWORD GetLastError();
+BOOL CloseHandle(HANDLE handle);
+void OutputDebugStringA(LPCSTR text);
+DWORD GetModuleFileNameA(HMODULE module, LPSTR fileName, DWORD size);
+BOOL DisableThreadLibraryCalls(HMODULE module);
+int WideCharToMultiByte(UINT codePage, DWORD flags, LPCWSTR wide, int wideCount,
+                        LPSTR narrow, int narrowSize, LPCSTR defaultChar, BOOL* usedDefault);
+int lstrcmpiA(LPCSTR a, LPCSTR b);
+
+// Memory
+LPVOID VirtualAlloc(LPVOID address, SIZE_T size, DWORD type, DWORD protect);
+BOOL VirtualFree(LPVOID address, SIZE_T size, DWORD type);
+BOOL VirtualLock(LPVOID address, SIZE_T size);
+BOOL VirtualUnlock(LPVOID address, SIZE_T size);
+SIZE_T GetLargePageMinimum();
+void GetSystemInfo(SYSTEM_INFO* info);
+BOOL GlobalMemoryStatusEx(MEMORYSTATUSEX* status);
+BOOL GetProcessWorkingSetSize(HANDLE process, SIZE_T* minimum, SIZE_T* maximum);
+BOOL SetProcessWorkingSetSize(HANDLE process, SIZE_T minimum, SIZE_T maximum);
+BOOL OpenProcessToken(HANDLE process, DWORD access, HANDLE* token);
+BOOL LookupPrivilegeValueA(LPCSTR system, LPCSTR name, LUID* luid);
+BOOL AdjustTokenPrivileges(HANDLE token, BOOL disableAll, TOKEN_PRIVILEGES* newState,
+                           DWORD length, TOKEN_PRIVILEGES* previous, DWORD* returnLength);
+HANDLE CreateFileMappingA(HANDLE file, SECURITY_ATTRIBUTES* attributes, DWORD protect,
+                          DWORD sizeHigh, DWORD sizeLow, LPCSTR name);
+HANDLE OpenFileMappingA(DWORD access, BOOL inherit, LPCSTR name);
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size);
+BOOL UnmapViewOfFile(LPCVOID address);
+
+// Events
+HANDLE CreateEventA(SECURITY_ATTRIBUTES* attributes, BOOL manualReset, BOOL initialState, LPCSTR name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+
+// Windows
+BOOL GetClientRect(HWND hWnd, LPRECT rect);
+BOOL IsWindow(HWND hWnd);
+BOOL IsIconic(HWND hWnd);
+BOOL AdjustWindowRect(LPRECT rect, DWORD style, BOOL menu);
+BOOL SetWindowPos(HWND hWnd, HWND after, int x, int y, int cx, int cy, UINT flags);
+LONG GetWindowLong(HWND hWnd, int index);
+LONG_PTR SetWindowLongPtrA(HWND hWnd, int index, LONG_PTR value);
+LRESULT CallWindowProcA(WNDPROC proc, HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+LRESULT DefWindowProcA(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+HANDLE GetPropA(HWND hWnd, LPCSTR name);
+BOOL SetPropA(HWND hWnd, LPCSTR name, HANDLE value);
+HANDLE RemovePropA(HWND hWnd, LPCSTR name);
+BOOL InvalidateRect(HWND hWnd, const RECT* rect, BOOL erase);
+BOOL ValidateRect(HWND hWnd, const RECT* rect);
+BOOL RedrawWindow(HWND hWnd, const RECT* rect, HRGN region, UINT flags);
+HDC BeginPaint(HWND hWnd, PAINTSTRUCT* paint);
+BOOL EndPaint(HWND hWnd, const PAINTSTRUCT* paint);
+int GetSystemMetrics(int index);
+HMONITOR MonitorFromPoint(POINT pt, DWORD flags);
+HMONITOR MonitorFromWindow(HWND hWnd, DWORD flags);
+
+// GDI
+HDC GetDC(HWND hWnd);
+int ReleaseDC(HWND hWnd, HDC hdc);
+HDC CreateCompatibleDC(HDC hdc);
+BOOL DeleteDC(HDC hdc);
+int SaveDC(HDC hdc);
+BOOL RestoreDC(HDC hdc, int saved);
+int GetDeviceCaps(HDC hdc, int index);
+HBITMAP CreateDIBSection(HDC hdc, const BITMAPINFO* info, UINT usage, void** bits,
+                         HANDLE section, DWORD offset);
+HGDIOBJ SelectObject(HDC hdc, HGDIOBJ object);
+BOOL DeleteObject(HGDIOBJ object);
+int GetObjectA(HANDLE object, int size, LPVOID buffer);
+UINT SetDIBColorTable(HDC hdc, UINT start, UINT count, const RGBQUAD* colors);
+BOOL BitBlt(HDC dst, int x, int y, int cx, int cy, HDC src, int srcX, int srcY, DWORD rop);
+BOOL StretchBlt(HDC dst, int x, int y, int cx, int cy, HDC src, int srcX, int srcY,
+                int srcCx, int srcCy, DWORD rop);
+int SetStretchBltMode(HDC hdc, int mode);
+BOOL SetBrushOrgEx(HDC hdc, int x, int y, LPPOINT previous);
+int SetDIBitsToDevice(HDC hdc, int x, int y, DWORD cx, DWORD cy, int srcX, int srcY,
+                      UINT startScan, UINT scanLines, const void* bits, const BITMAPINFO* info, UINT usage);
+int StretchDIBits(HDC hdc, int x, int y, int cx, int cy, int srcX, int srcY, int srcCx, int srcCy,
+                  const void* bits, const BITMAPINFO* info, UINT usage, DWORD rop);
+UINT SetBoundsRect(HDC hdc, const RECT* rect, UINT flags);
+UINT GetBoundsRect(HDC hdc, LPRECT rect, UINT flags);
+COLORREF SetPixel(HDC hdc, int x, int y, COLORREF color);
+BOOL GdiFlush();
+
+} // extern "C"
+
+#define GetObject GetObjectA
+
+// ============================================================================
+// CRT Extensions
+// ============================================================================
+
+inline int strcpy_s(char* dst, size_t size, const char* src) {
+    if (!dst || size == 0) {
+        return 1;
+    }
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+    return 0;
+}
+
+template <size_t N>
+inline int strcpy_s(char (&dst)[N], const char* src) {
+    return strcpy_s(dst, N, src);
+}
+
+inline void* _aligned_malloc(size_t size, size_t alignment) {
+    // aligned_alloc wants the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+inline void _aligned_free(void* ptr) {
+    std::free(ptr);
+}
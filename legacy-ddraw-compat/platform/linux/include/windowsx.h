@@ -0,0 +1,11 @@
+/**
+ * @file windowsx.h
+ * @brief Message-cracker shim for the portable (CMake) build
+ */
+
+#pragma once
+
+#include <windows.h>
+
+#define GET_X_LPARAM(lp) ((int)(short)LOWORD(lp))
+#define GET_Y_LPARAM(lp) ((int)(short)HIWORD(lp))
@@ -226,9 +226,22 @@ void ConfigManager::LoadSection(const IniParser& parser, const std::string& sect
 
     // Rendering settings
     m_config.renderer = parser.GetString(section, "renderer", m_config.renderer);
+    m_config.nullCapture = parser.GetString(section, "nullcapture", m_config.nullCapture);
+    m_config.gdiPresent = parser.GetString(section, "gdipresent", m_config.gdiPresent);
     m_config.vsync = parser.GetBool(section, "vsync", m_config.vsync);
     m_config.maxFps = parser.GetInt(section, "maxfps", m_config.maxFps);
+    m_config.skipUnchanged = parser.GetBool(section, "skipunchanged", m_config.skipUnchanged);
     m_config.shader = parser.GetString(section, "shader", m_config.shader);
+    m_config.deferredBlits = parser.GetBool(section, "deferredblits", m_config.deferredBlits);
+    m_config.blitThreads = parseNonNegativeInt("blitthreads", m_config.blitThreads);
+    m_config.tileThreshold = parser.GetInt(section, "tilethreshold", m_config.tileThreshold);
+    m_config.surfaceAlignment = parseNonNegativeInt("surfacealign", m_config.surfaceAlignment);
+    m_config.pagedSurfaceKb = parseNonNegativeInt("pagedsurfacekb", m_config.pagedSurfaceKb);
+    m_config.largePages = parser.GetBool(section, "largepages", m_config.largePages);
+    m_config.videoMemoryMb = parseNonNegativeInt("vidmemmb", m_config.videoMemoryMb);
+    m_config.dedupSurfaces = parser.GetBool(section, "dedupsurfaces", m_config.dedupSurfaces);
+    m_config.compressIdleSeconds = parseNonNegativeInt("compressidle", m_config.compressIdleSeconds);
+    m_config.compressBudgetMb = parseNonNegativeInt("compressbudgetmb", m_config.compressBudgetMb);
 
     // Compatibility settings
     m_config.maxGameTicks = parser.GetInt(section, "maxgameticks", m_config.maxGameTicks);
@@ -245,6 +258,9 @@ void ConfigManager::LoadSection(const IniParser& parser, const std::string& sect
     m_config.logLevel = parser.GetString(section, "loglevel", m_config.logLevel);
     m_config.crashDumps = parser.GetBool(section, "crashdumps", m_config.crashDumps);
     m_config.showFps = parser.GetBool(section, "showfps", m_config.showFps);
+    m_config.frameExport = parser.GetBool(section, "frameexport", m_config.frameExport);
+    m_config.frameExportName = parser.GetString(section, "frameexportname", m_config.frameExportName);
+    m_config.frameExportSlots = parseNonNegativeInt("frameexportslots", m_config.frameExportSlots);
 
     // Hotkeys
     m_config.hotkeyFullscreen = static_cast<uint32_t>(parseNonNegativeInt("hotkey_fullscreen", static_cast<int>(m_config.hotkeyFullscreen)));
@@ -269,6 +285,39 @@ void ConfigManager::Validate() {
     if (m_config.maxFps > 1000) m_config.maxFps = 1000;
     if (m_config.maxFps < -1) m_config.maxFps = -1;
 
+    // Clamp blit worker count
+    if (m_config.blitThreads > 16) m_config.blitThreads = 16;
+
+    // Clamp tile split threshold
+    if (m_config.tileThreshold < -1) m_config.tileThreshold = -1;
+
+    // Surface alignment must be a power of two
+    if (m_config.surfaceAlignment < 16) m_config.surfaceAlignment = 16;
+    if (m_config.surfaceAlignment > 4096) m_config.surfaceAlignment = 4096;
+    if (m_config.surfaceAlignment & (m_config.surfaceAlignment - 1)) {
+        LOG_WARN("Invalid surfacealign %d, using 64", m_config.surfaceAlignment);
+        m_config.surfaceAlignment = 64;
+    }
+
+    // Reported video memory must fit the DWORD fields of DDCAPS
+    if (m_config.videoMemoryMb < 8) m_config.videoMemoryMb = 8;
+    if (m_config.videoMemoryMb > 4095) m_config.videoMemoryMb = 4095;
+
+    // Clamp idle compression settings (the budget must fit a 32-bit address space)
+    if (m_config.compressIdleSeconds > 3600) m_config.compressIdleSeconds = 3600;
+    if (m_config.compressBudgetMb > 4096) m_config.compressBudgetMb = 4096;
+
+    // Clamp frame ring size
+    if (m_config.frameExportSlots < 2) m_config.frameExportSlots = 2;
+    if (m_config.frameExportSlots > 16) m_config.frameExportSlots = 16;
+
+    // The ring name becomes part of a kernel object name
+    if (m_config.frameExportName.empty() ||
+        m_config.frameExportName.find_first_of("\\/") != std::string::npos) {
+        LOG_WARN("Invalid frameexportname '%s', using 'ldc_frames'", m_config.frameExportName.c_str());
+        m_config.frameExportName = "ldc_frames";
+    }
+
     // Clamp game ticks
     if (m_config.maxGameTicks > 1000) m_config.maxGameTicks = 1000;
     if (m_config.maxGameTicks < 0) m_config.maxGameTicks = 0;
@@ -279,10 +328,30 @@ void ConfigManager::Validate() {
                    [](unsigned char c) { return std::tolower(c); });
 
     if (renderer != "auto" && renderer != "gdi" &&
-        renderer != "opengl" && renderer != "d3d9" && renderer != "direct3d9") {
+        renderer != "opengl" && renderer != "d3d9" && renderer != "direct3d9" &&
+        renderer != "null") {
         LOG_WARN("Invalid renderer '%s', using 'auto'", m_config.renderer.c_str());
         m_config.renderer = "auto";
     }
+
+    std::string nullCapture = m_config.nullCapture;
+    std::transform(nullCapture.begin(), nullCapture.end(), nullCapture.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    if (nullCapture != "discard" && nullCapture != "hash" && nullCapture != "store") {
+        LOG_WARN("Invalid nullcapture '%s', using 'hash'", m_config.nullCapture.c_str());
+        m_config.nullCapture = "hash";
+    }
+
+    std::string gdiPresent = m_config.gdiPresent;
+    std::transform(gdiPresent.begin(), gdiPresent.end(), gdiPresent.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    if (gdiPresent != "auto" && gdiPresent != "bitblt" &&
+        gdiPresent != "setdibits" && gdiPresent != "stretchdibits") {
+        LOG_WARN("Invalid gdipresent '%s', using 'auto'", m_config.gdiPresent.c_str());
+        m_config.gdiPresent = "auto";
+    }
 }
 
 std::string ConfigManager::GetExecutableName() {
@@ -0,0 +1,196 @@
+/**
+ * @file BlitQueue.cpp
+ * @brief Deferred blit command queue implementation
+ */
+
+#include "core/BlitQueue.h"
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// BlitQueue Implementation
+// ============================================================================
+
+BlitQueue::BlitQueue(uint32_t workerCount) {
+    if (workerCount == 0) {
+        // Leave a core for the game thread; more than four rarely pays off
+        // for blits that are mostly memory bound
+        uint32_t cpus = std::thread::hardware_concurrency();
+        workerCount = std::clamp<uint32_t>(cpus > 1 ? cpus - 1 : 1, 1, 4);
+    }
+
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&BlitQueue::WorkerProc, this);
+    }
+
+    DebugLog("BlitQueue started with %u workers", workerCount);
+}
+
+BlitQueue::~BlitQueue() {
+    Drain();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+
+    DebugLog("BlitQueue stopped: %llu submitted, %llu executed, %llu dependencies, max depth %llu",
+             static_cast<unsigned long long>(m_stats.submitted),
+             static_cast<unsigned long long>(m_stats.executed),
+             static_cast<unsigned long long>(m_stats.dependencies),
+             static_cast<unsigned long long>(m_stats.maxDepth));
+}
+
+void BlitQueue::Submit(std::function<void()> work, const BlitAccess* accesses, size_t count) {
+    Command* cmd = new Command();
+    cmd->work = std::move(work);
+
+    // One access per resource keeps fence bookkeeping simple
+    for (size_t i = 0; i < count; ++i) {
+        const BlitAccess& access = accesses[i];
+        auto it = std::find_if(cmd->accesses.begin(), cmd->accesses.end(),
+                               [&](const BlitAccess& a) { return a.resource == access.resource; });
+        if (it == cmd->accesses.end()) {
+            cmd->accesses.push_back(access);
+        } else {
+            it->rect = RectUnion(it->rect, access.rect);
+            it->write = it->write || access.write;
+        }
+    }
+
+    bool ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const BlitAccess& access : cmd->accesses) {
+            PendingList& pending = m_pending[access.resource];
+
+            // Overlapping work on the same surface runs in order, unless
+            // both commands only read
+            for (auto& entry : pending) {
+                Command* prior = entry.second;
+                if (prior->done) {
+                    continue;
+                }
+                for (const BlitAccess& priorAccess : prior->accesses) {
+                    RECT overlap;
+                    if (priorAccess.resource == access.resource &&
+                        (priorAccess.write || access.write) &&
+                        RectIntersect(overlap, priorAccess.rect, access.rect)) {
+                        if (std::find(prior->dependents.begin(), prior->dependents.end(), cmd) ==
+                            prior->dependents.end()) {
+                            prior->dependents.push_back(cmd);
+                            ++cmd->unresolved;
+                            ++m_stats.dependencies;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            uint64_t value = access.fence ? access.fence->Enqueue() : 0;
+            cmd->fenceValues.push_back(value);
+            pending.emplace_back(value, cmd);
+            ++cmd->holds;
+        }
+
+        ++m_outstanding;
+        ++m_stats.submitted;
+        m_stats.maxDepth = std::max<uint64_t>(m_stats.maxDepth, m_outstanding);
+
+        ready = (cmd->unresolved == 0);
+        if (ready) {
+            m_ready.push_back(cmd);
+        }
+    }
+
+    if (ready) {
+        m_workCv.notify_one();
+    }
+}
+
+void BlitQueue::Drain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCv.wait(lock, [&] { return m_outstanding == 0; });
+}
+
+BlitQueueStats BlitQueue::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void BlitQueue::WorkerProc() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        m_workCv.wait(lock, [&] { return m_stopping || !m_ready.empty(); });
+        if (m_ready.empty()) {
+            break;
+        }
+
+        Command* cmd = m_ready.front();
+        m_ready.pop_front();
+        lock.unlock();
+
+        cmd->work();
+
+        lock.lock();
+        Retire(cmd);
+    }
+}
+
+void BlitQueue::Retire(Command* cmd) {
+    // Caller holds m_mutex
+    cmd->done = true;
+    ++m_stats.executed;
+
+    size_t released = 0;
+    for (Command* dependent : cmd->dependents) {
+        if (--dependent->unresolved == 0) {
+            m_ready.push_back(dependent);
+            ++released;
+        }
+    }
+    if (released == 1) {
+        m_workCv.notify_one();
+    } else if (released > 1) {
+        m_workCv.notify_all();
+    }
+
+    // Signal each surface's fence up to its oldest unfinished command
+    for (const BlitAccess& access : cmd->accesses) {
+        auto it = m_pending.find(access.resource);
+        PendingList& pending = it->second;
+
+        uint64_t signalValue = 0;
+        while (!pending.empty() && pending.front().second->done) {
+            Command* finished = pending.front().second;
+            signalValue = pending.front().first;
+            pending.pop_front();
+            if (--finished->holds == 0 && finished != cmd) {
+                delete finished;
+            }
+        }
+
+        if (signalValue && access.fence) {
+            access.fence->Signal(signalValue);
+        }
+        if (pending.empty()) {
+            m_pending.erase(it);
+        }
+    }
+
+    if (cmd->holds == 0) {
+        delete cmd;
+    }
+
+    if (--m_outstanding == 0) {
+        m_idleCv.notify_all();
+    }
+}
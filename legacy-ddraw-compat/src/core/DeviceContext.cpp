@@ -0,0 +1,555 @@
+/**
+ * @file DeviceContext.cpp
+ * @brief Per-device rendering and window management
+ */
+
+#include "core/DeviceContext.h"
+
+using namespace ldc;
+
+namespace {
+
+// Window property naming the device that subclassed the window
+const char* const kDeviceProperty = "ldc.DeviceContext";
+
+// Refresh rate assumed when the game never set one
+const DWORD kDefaultRefreshHz = 60;
+
+// Derive the per-channel and RGB565 tables from present.gammaRamp
+void BuildGammaTables(PresentState& present) {
+    present.gammaActive = false;
+    for (int i = 0; i < 256; ++i) {
+        present.gammaRed[i] = static_cast<uint8_t>(present.gammaRamp.red[i] >> 8);
+        present.gammaGreen[i] = static_cast<uint8_t>(present.gammaRamp.green[i] >> 8);
+        present.gammaBlue[i] = static_cast<uint8_t>(present.gammaRamp.blue[i] >> 8);
+        if (present.gammaRed[i] != i || present.gammaGreen[i] != i || present.gammaBlue[i] != i) {
+            present.gammaActive = true;
+        }
+    }
+
+    // Components widen by shifting, as the conversion always has
+    for (uint32_t i = 0; i < 32; ++i) {
+        present.expandRed565[i] = static_cast<uint32_t>(present.gammaRed[i << 3]) << 16;
+        present.expandBlue565[i] = present.gammaBlue[i << 3];
+    }
+    for (uint32_t i = 0; i < 64; ++i) {
+        present.expandGreen565[i] = static_cast<uint32_t>(present.gammaGreen[i << 2]) << 8;
+    }
+
+    present.gammaPaletteSource = nullptr;
+}
+
+// Pass the window size UpdateScaling published on to the renderer;
+// called under renderMutex before it draws
+void ApplyWindowSize(DeviceContext& device, renderer::IRenderer& target) {
+    InputMapping mapping = device.input.Load();
+    if (mapping.renderWidth == device.present.rendererWindowWidth &&
+        mapping.renderHeight == device.present.rendererWindowHeight) {
+        return;
+    }
+    device.present.rendererWindowWidth = mapping.renderWidth;
+    device.present.rendererWindowHeight = mapping.renderHeight;
+    target.OnResize(mapping.renderWidth, mapping.renderHeight);
+}
+
+} // namespace
+
+// ============================================================================
+// DeviceContext Implementation
+// ============================================================================
+
+DeviceContext::DeviceContext()
+    : presenter(*this)
+{
+    for (int i = 0; i < 256; ++i) {
+        WORD level = static_cast<WORD>(i * 257);
+        present.gammaRamp.red[i] = level;
+        present.gammaRamp.green[i] = level;
+        present.gammaRamp.blue[i] = level;
+    }
+    BuildGammaTables(present);
+}
+
+DeviceContext::~DeviceContext() {
+    presenter.Stop();
+
+    if (present.framesCompared > 0) {
+        DebugLog("Unchanged frames: %llu of %llu skipped (%.1f%%)",
+                 static_cast<unsigned long long>(present.framesSkipped),
+                 static_cast<unsigned long long>(present.framesCompared),
+                 100.0 * present.framesSkipped / present.framesCompared);
+    }
+
+    if (present.paletteFrames > 0) {
+        DebugLog("Palette changes: %llu applied in %llu frames (%.1f per frame, max %u)",
+                 static_cast<unsigned long long>(present.paletteChangesApplied),
+                 static_cast<unsigned long long>(present.paletteFrames),
+                 static_cast<double>(present.paletteChangesApplied) / present.paletteFrames,
+                 present.paletteChangesMax);
+    }
+
+    UnsubclassWindow(*this);
+    DestroyRenderTarget(*this);
+}
+
+// ============================================================================
+// Rendering Implementation
+// ============================================================================
+
+bool ldc::CreateRenderTarget(DeviceContext& device, DWORD width, DWORD height, DWORD bpp,
+                             RendererType type) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    DebugLog("CreateRenderTarget: %ux%u %ubpp", width, height, bpp);
+
+    // Clean up existing resources
+    DestroyRenderTarget(device);
+
+    // Store dimensions
+    device.game.width = width;
+    device.game.height = height;
+    device.game.bpp = bpp;
+    device.present.bitmapWidth = width;
+    device.present.bitmapHeight = height;
+    device.present.primaryBpp = bpp;
+
+    // Calculate pitch (align to 4 bytes)
+    device.present.primaryPitch = ((width * (bpp / 8) + 3) / 4) * 4;
+
+    // Allocate primary pixel buffer
+    device.present.primaryPixels.resize(device.present.primaryPitch * height);
+    std::memset(device.present.primaryPixels.data(), 0, device.present.primaryPixels.size());
+
+    // Set up the backend presenting to the window; the null renderer
+    // presents into memory and needs none
+    if (device.window.hWnd || type == RendererType::Null) {
+        device.present.renderer = renderer::RendererFactory::Create(type);
+        if (!device.present.renderer && type != RendererType::Auto) {
+            device.present.renderer = renderer::RendererFactory::CreateBestAvailable();
+        }
+        if (!device.present.renderer ||
+            !device.present.renderer->Initialize(device.window.hWnd, width, height, bpp)) {
+            DebugLog("Failed to initialize renderer");
+            device.present.renderer.reset();
+            return false;
+        }
+    }
+
+    // Initialize palette to grayscale
+    for (int i = 0; i < 256; ++i) {
+        device.game.palette[i].rgbRed = static_cast<BYTE>(i);
+        device.game.palette[i].rgbGreen = static_cast<BYTE>(i);
+        device.game.palette[i].rgbBlue = static_cast<BYTE>(i);
+        device.game.palette[i].rgbReserved = 0;
+        device.game.palette32[i] = 0xFF000000 | (i << 16) | (i << 8) | i;
+    }
+    device.present.gammaPaletteSource = nullptr;
+    device.present.presentedPalette = nullptr;
+
+    // The new renderer shows nothing yet
+    device.present.tiles.Reset();
+
+    // Update scaling; the renderer was set up at the current window size
+    UpdateScaling(device);
+    InputMapping mapping = device.input.Load();
+    device.present.rendererWindowWidth = mapping.renderWidth;
+    device.present.rendererWindowHeight = mapping.renderHeight;
+
+    DebugLog("Render target created successfully");
+    return true;
+}
+
+void ldc::DestroyRenderTarget(DeviceContext& device) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    if (device.present.renderer) {
+        device.present.renderer->Shutdown();
+        device.present.renderer.reset();
+    }
+
+    device.present.presentPixels = nullptr;
+    device.present.primaryPixels.clear();
+}
+
+void ldc::PresentPrimaryToScreen(DeviceContext& device, const RECT* pDirty, DWORD dirtyCount) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    renderer::IRenderer* target = device.present.renderer.get();
+    if (target && !target->IsInitialized()) {
+        target = nullptr;
+    }
+    if (!target && !device.present.frameExport) {
+        return;
+    }
+
+    if (!device.present.presentPixels) {
+        return;
+    }
+
+    DWORD bpp = device.present.primaryBpp;
+
+    // Every palette change queued since the last present lands in this
+    // frame. A changed palette recolours the whole image, which the frame
+    // tells the renderer; a new ramp does so for every depth.
+    uint32_t paletteChanges = device.game.paletteChanges.exchange(0);
+    device.game.paletteChanged = false;
+    bool gammaChanged = device.game.gammaChanged.exchange(false);
+    if (gammaChanged && bpp != 8) {
+        pDirty = nullptr;
+    }
+
+    // A window that lost its pixels matches no tile hash and no damage
+    if (device.window.repaintPending.exchange(false)) {
+        device.present.tiles.Reset();
+        pDirty = nullptr;
+    }
+
+    renderer::PresentFrame frame;
+    frame.pixels = device.present.presentPixels;
+    frame.pitch = device.present.primaryPitch;
+    frame.width = device.present.bitmapWidth;
+    frame.height = device.present.bitmapHeight;
+    frame.bpp = bpp;
+    frame.expandRed565 = device.present.expandRed565;
+    frame.expandGreen565 = device.present.expandGreen565;
+    frame.expandBlue565 = device.present.expandBlue565;
+
+    if (bpp == 8) {
+        const uint32_t* lut = device.present.paletteLut ? device.present.paletteLut
+                                                        : device.game.palette32;
+        frame.paletteChanged = paletteChanges > 0 || gammaChanged ||
+                               lut != device.present.presentedPalette;
+        device.present.presentedPalette = lut;
+
+        // Gamma is folded into a copy of the LUT, redone only when the
+        // palette or the ramp changed
+        if (device.present.gammaActive) {
+            if (paletteChanges > 0 || gammaChanged || device.present.gammaPaletteSource != lut) {
+                for (int i = 0; i < 256; ++i) {
+                    uint32_t color = lut[i];
+                    device.present.gammaPaletteLut[i] = 0xFF000000 |
+                        (device.present.gammaRed[(color >> 16) & 0xFF] << 16) |
+                        (device.present.gammaGreen[(color >> 8) & 0xFF] << 8) |
+                        device.present.gammaBlue[color & 0xFF];
+                }
+                device.present.gammaPaletteSource = lut;
+            }
+            lut = device.present.gammaPaletteLut;
+        }
+        frame.palette = lut;
+    }
+
+    if (device.present.gammaActive) {
+        frame.gammaRed = device.present.gammaRed;
+        frame.gammaGreen = device.present.gammaGreen;
+        frame.gammaBlue = device.present.gammaBlue;
+    }
+
+    // A full present shows only the tiles whose content changed, unless
+    // new colours or a new window size call for everything. Damage from
+    // the caller is presented as it is; its tiles are compared afresh
+    // next time.
+    bool skip = false;
+    RECT changed[renderer::kMaxDamageRects];
+    if (device.present.skipUnchanged && pDirty) {
+        device.present.tiles.Invalidate(pDirty, dirtyCount);
+    } else if (device.present.skipUnchanged) {
+        InputMapping mapping = device.input.Load();
+        bool windowChanged = mapping.renderWidth != device.present.tilesWindowWidth ||
+                             mapping.renderHeight != device.present.tilesWindowHeight;
+        device.present.tilesWindowWidth = mapping.renderWidth;
+        device.present.tilesWindowHeight = mapping.renderHeight;
+
+        uint32_t changedCount = device.present.tiles.Compare(frame.pixels, frame.pitch, frame.width,
+                                                             frame.height, bpp, changed,
+                                                             renderer::kMaxDamageRects);
+        device.present.framesCompared++;
+
+        RECT full = { 0, 0, static_cast<LONG>(frame.width), static_cast<LONG>(frame.height) };
+        bool everything = frame.paletteChanged || gammaChanged || windowChanged ||
+                          (changedCount == 1 && memcmp(&changed[0], &full, sizeof(RECT)) == 0);
+        if (!everything && changedCount == 0) {
+            skip = true;
+            device.present.framesSkipped++;
+        } else if (!everything) {
+            pDirty = changed;
+            dirtyCount = changedCount;
+        }
+    }
+
+    if (target && !skip) {
+        ApplyWindowSize(device, *target);
+        if (pDirty) {
+            target->PresentPartial(frame, pDirty, dirtyCount);
+        } else {
+            target->Present(frame);
+        }
+    }
+    if (device.present.frameExport && !skip) {
+        device.present.frameExport->Publish(frame, pDirty, pDirty ? dirtyCount : 0);
+    }
+
+    // Update palette and FPS counters
+    device.present.paletteChangesLastFrame = paletteChanges;
+    if (paletteChanges > 0) {
+        device.present.paletteChangesApplied += paletteChanges;
+        device.present.paletteFrames++;
+        device.present.paletteChangesMax = std::max<DWORD>(device.present.paletteChangesMax, paletteChanges);
+    }
+
+    device.present.frameCount++;
+    DWORD now = GetTickCount();
+    device.present.lastPresentTime = now;
+    if (now - device.present.lastFpsTime >= 1000) {
+        device.present.fps = device.present.frameCount;
+        device.present.frameCount = 0;
+        device.present.lastFpsTime = now;
+    }
+}
+
+bool ldc::EnableFrameExport(DeviceContext& device, const std::string& name, DWORD slotCount) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    if (device.present.frameExport) {
+        return true;
+    }
+
+    auto exporter = std::make_unique<core::FrameExporter>();
+    if (!exporter->Open(name, slotCount,
+                        (std::max)(device.game.width, static_cast<DWORD>(core::kFrameExportMinWidth)),
+                        (std::max)(device.game.height, static_cast<DWORD>(core::kFrameExportMinHeight)))) {
+        return false;
+    }
+    device.present.frameExport = std::move(exporter);
+    return true;
+}
+
+void ldc::SetFrameSkipping(DeviceContext& device, bool enabled) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    device.present.skipUnchanged = enabled;
+    device.present.tiles.Reset();
+}
+
+double ldc::GetFrameSkipRatio(DeviceContext& device) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    if (device.present.framesCompared == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(device.present.framesSkipped) / device.present.framesCompared;
+}
+
+bool ldc::RepaintWindow(DeviceContext& device) {
+    // Called from the window procedure; never wait for a present, which
+    // may itself be waiting on this thread
+    std::unique_lock<std::recursive_mutex> lock(device.renderMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        device.window.repaintPending = true;
+        return false;
+    }
+
+    // Nothing presented yet; the first present draws the whole window
+    renderer::IRenderer* target = device.present.renderer.get();
+    if (!target || !target->IsInitialized()) {
+        return true;
+    }
+
+    ApplyWindowSize(device, *target);
+    if (target->Repaint()) {
+        // The window shows the last presented frame again, which is what
+        // the tile hashes describe
+        device.window.repaintPending = false;
+        device.present.repaints++;
+    } else {
+        // The window lost what it showed, so nothing counts as unchanged
+        device.present.tiles.Reset();
+        PresentPrimaryToScreen(device);
+    }
+    return true;
+}
+
+void ldc::FlushPaletteChanges(DeviceContext& device, bool vblank) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    if (device.game.paletteChanges.load() == 0 && !device.game.gammaChanged.load()) {
+        return;
+    }
+
+    // Between vertical blanks changes keep queuing; the game's next
+    // present, Flip or WaitForVerticalBlank shows them, or else the
+    // presenter thread once the period is over
+    if (!vblank) {
+        DWORD refresh = device.game.refresh ? device.game.refresh : kDefaultRefreshHz;
+        DWORD period = 1000 / refresh;
+        DWORD elapsed = GetTickCount() - device.present.lastPresentTime;
+        if (elapsed < period) {
+            device.presenter.ScheduleFlush(period - elapsed);
+            return;
+        }
+    }
+
+    PresentPrimaryToScreen(device);
+}
+
+// ============================================================================
+// Gamma Implementation
+// ============================================================================
+
+void ldc::SetGammaRamp(DeviceContext& device, const DDGAMMARAMP& ramp) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+
+    if (memcmp(&device.present.gammaRamp, &ramp, sizeof(ramp)) == 0) {
+        return;
+    }
+    device.present.gammaRamp = ramp;
+    BuildGammaTables(device.present);
+
+    device.game.gammaChanged = true;
+    FlushPaletteChanges(device, false);
+}
+
+void ldc::GetGammaRamp(DeviceContext& device, DDGAMMARAMP& ramp) {
+    std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+    ramp = device.present.gammaRamp;
+}
+
+// ============================================================================
+// Window Management
+// ============================================================================
+
+void ldc::UpdateScaling(DeviceContext& device) {
+    // Built locally and published whole, so the window procedure never
+    // sees a half-updated mapping
+    InputMapping mapping;
+    mapping.gameWidth = device.game.width;
+    mapping.gameHeight = device.game.height;
+
+    if (device.window.hWnd) {
+        RECT clientRect;
+        GetClientRect(device.window.hWnd, &clientRect);
+        int windowWidth = clientRect.right - clientRect.left;
+        int windowHeight = clientRect.bottom - clientRect.top;
+
+        if (windowWidth <= 0) windowWidth = 1;
+        if (windowHeight <= 0) windowHeight = 1;
+
+        mapping.renderWidth = windowWidth;
+        mapping.renderHeight = windowHeight;
+
+        mapping.scaleX = static_cast<float>(mapping.gameWidth) / windowWidth;
+        mapping.scaleY = static_cast<float>(mapping.gameHeight) / windowHeight;
+    }
+
+    device.input.Store(mapping);
+}
+
+POINT ldc::TransformMouseToGame(const DeviceContext& device, POINT pt) {
+    InputMapping mapping = device.input.Load();
+
+    POINT result;
+    result.x = static_cast<LONG>((pt.x - mapping.offsetX) * mapping.scaleX);
+    result.y = static_cast<LONG>((pt.y - mapping.offsetY) * mapping.scaleY);
+
+    // Clamp to game bounds
+    if (result.x < 0) result.x = 0;
+    if (result.y < 0) result.y = 0;
+    if (result.x >= (LONG)mapping.gameWidth) result.x = mapping.gameWidth - 1;
+    if (result.y >= (LONG)mapping.gameHeight) result.y = mapping.gameHeight - 1;
+
+    return result;
+}
+
+POINT ldc::TransformGameToScreen(const DeviceContext& device, POINT pt) {
+    InputMapping mapping = device.input.Load();
+
+    POINT result;
+    result.x = static_cast<LONG>(pt.x / mapping.scaleX) + mapping.offsetX;
+    result.y = static_cast<LONG>(pt.y / mapping.scaleY) + mapping.offsetY;
+    return result;
+}
+
+LRESULT CALLBACK ldc::WrapperWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    // Stays valid until the device unsubclasses the window
+    DeviceContext* device = static_cast<DeviceContext*>(GetPropA(hWnd, kDeviceProperty));
+    if (!device) {
+        return DefWindowProcA(hWnd, msg, wParam, lParam);
+    }
+
+    switch (msg) {
+        case WM_SIZE:
+            // The renderer picks the new size up from the mapping when it
+            // next draws, so a present in progress is not waited for
+            UpdateScaling(*device);
+
+            // Restored or resized: show the last frame at the new size
+            // rather than waiting for the game to draw one. If a present
+            // holds the renderer, the one after it shows the whole frame.
+            if (wParam != SIZE_MINIMIZED && LOWORD(lParam) > 0 && HIWORD(lParam) > 0) {
+                RepaintWindow(*device);
+            }
+            break;
+
+        case WM_PAINT:
+        {
+            // The game's handler runs first; the frame then covers whatever
+            // it drew, and the update region is validated so WM_PAINT stops.
+            // While a present holds the renderer it is validated all the
+            // same: invalidating again would spin this thread on WM_PAINT,
+            // and RepaintWindow has the next present show the whole frame.
+            LRESULT result = device->window.originalWndProc
+                ? CallWindowProcA(device->window.originalWndProc, hWnd, msg, wParam, lParam)
+                : DefWindowProcA(hWnd, msg, wParam, lParam);
+            RepaintWindow(*device);
+            ValidateRect(hWnd, nullptr);
+            return result;
+        }
+
+        case WM_MOUSEMOVE:
+        case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
+        case WM_MBUTTONDOWN:
+        case WM_MBUTTONUP:
+        {
+            // Transform mouse coordinates
+            POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+            pt = TransformMouseToGame(*device, pt);
+            lParam = MAKELPARAM(pt.x, pt.y);
+            break;
+        }
+    }
+
+    if (device->window.originalWndProc) {
+        return CallWindowProcA(device->window.originalWndProc, hWnd, msg, wParam, lParam);
+    }
+    return DefWindowProcA(hWnd, msg, wParam, lParam);
+}
+
+void ldc::SubclassWindow(DeviceContext& device, HWND hWnd) {
+    if (device.window.originalWndProc) {
+        return;  // Already subclassed
+    }
+
+    // A second DirectDraw object on the same window (video playback)
+    // leaves mouse mapping to the device that got there first
+    if (GetPropA(hWnd, kDeviceProperty)) {
+        return;
+    }
+
+    SetPropA(hWnd, kDeviceProperty, &device);
+    device.window.originalWndProc = (WNDPROC)SetWindowLongPtrA(hWnd, GWLP_WNDPROC, (LONG_PTR)WrapperWndProc);
+    device.window.subclassedWnd = hWnd;
+    DebugLog("Window subclassed: %p", hWnd);
+}
+
+void ldc::UnsubclassWindow(DeviceContext& device) {
+    if (device.window.originalWndProc && device.window.subclassedWnd) {
+        SetWindowLongPtrA(device.window.subclassedWnd, GWLP_WNDPROC, (LONG_PTR)device.window.originalWndProc);
+        RemovePropA(device.window.subclassedWnd, kDeviceProperty);
+        device.window.originalWndProc = nullptr;
+        device.window.subclassedWnd = nullptr;
+        DebugLog("Window unsubclassed");
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file DeviceLock.cpp
+ * @brief Process-wide DirectDraw lock implementation
+ */
+
+#include "core/DeviceLock.h"
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// DeviceLock Implementation
+// ============================================================================
+
+DeviceLock& DeviceLock::Instance() {
+    // Never destroyed: games may still call ReleaseDDThreadLock while
+    // the process is shutting down
+    static DeviceLock* instance = new DeviceLock();
+    return *instance;
+}
+
+bool DeviceLock::TryLock() {
+    DWORD self = GetCurrentThreadId();
+    if (m_owner.load(std::memory_order_relaxed) == self) {
+        ++m_recursion;
+        return true;
+    }
+    DWORD expected = 0;
+    if (!m_owner.compare_exchange_strong(expected, self, std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+        return false;
+    }
+    m_recursion = 1;
+    return true;
+}
+
+void DeviceLock::LockContended(DWORD self) {
+    m_contended.fetch_add(1, std::memory_order_relaxed);
+
+    // Spin while the holder is likely to release soon
+    uint32_t limit = m_spinLimit.load(std::memory_order_relaxed);
+    for (uint32_t spins = 0; spins < limit; ++spins) {
+        DWORD expected = 0;
+        if (m_owner.load(std::memory_order_relaxed) == 0 &&
+            m_owner.compare_exchange_weak(expected, self, std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+            // Aim for twice what this acquisition needed, smoothed
+            int32_t target = static_cast<int32_t>(std::max(spins * 2, kMinSpin));
+            int32_t adjusted = static_cast<int32_t>(limit) + (target - static_cast<int32_t>(limit)) / 8;
+            m_spinLimit.store(std::clamp<uint32_t>(static_cast<uint32_t>(adjusted), kMinSpin, kMaxSpin),
+                              std::memory_order_relaxed);
+            m_spinAcquired.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        YieldProcessor();
+    }
+
+    // The holder kept it for the whole spin; spin less next time
+    m_spinLimit.store(std::max(limit - limit / 8, kMinSpin), std::memory_order_relaxed);
+    m_blocked.fetch_add(1, std::memory_order_relaxed);
+
+    // Registering as a waiter before the final check means an Unlock that
+    // misses the waiter count has already freed the lock for us
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waitCv.wait(lock, [&] {
+            DWORD expected = 0;
+            return m_owner.compare_exchange_strong(expected, self, std::memory_order_seq_cst);
+        });
+    }
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void DeviceLock::WakeWaiter() {
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+    m_waitCv.notify_one();
+}
+
+DeviceLockStats DeviceLock::GetStats() const {
+    DeviceLockStats stats;
+    stats.contended = m_contended.load(std::memory_order_relaxed);
+    stats.spinAcquired = m_spinAcquired.load(std::memory_order_relaxed);
+    stats.blocked = m_blocked.load(std::memory_order_relaxed);
+    stats.spinLimit = m_spinLimit.load(std::memory_order_relaxed);
+    return stats;
+}
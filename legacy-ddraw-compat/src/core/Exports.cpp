@@ -7,6 +7,7 @@
  */
 
 #include "core/Common.h"
+#include "core/DeviceLock.h"
 #include "interfaces/DirectDrawImpl.h"
 
 using namespace ldc;
@@ -205,6 +206,49 @@ extern "C" HRESULT WINAPI DirectDrawEnumerateExW(
     return DD_OK;
 }
 
+// ============================================================================
+// DirectDraw Thread Lock
+// ============================================================================
+
+// The same recursive lock DDSCL_MULTITHREADED devices take around their
+// calls, so a game can hold it across several of them
+
+extern "C" void WINAPI AcquireDDThreadLock() {
+    core::DeviceLock::Instance().Lock();
+}
+
+extern "C" void WINAPI ReleaseDDThreadLock() {
+    core::DeviceLock& lock = core::DeviceLock::Instance();
+    if (!lock.IsHeldByCurrentThread()) {
+        DebugLog("ReleaseDDThreadLock: lock not held by this thread");
+        return;
+    }
+    lock.Unlock();
+}
+
+// Used by the 16-bit thunks to lock a surface under the thread lock. The
+// driver-level surface structures they pass are not emulated, so these only
+// take and release the lock and hand back no pixel pointer.
+
+extern "C" HRESULT WINAPI DDInternalLock(LPVOID lpSurfaceLocal, LPVOID* lplpBits) {
+    LDC_UNUSED(lpSurfaceLocal);
+    core::DeviceLock::Instance().Lock();
+    if (lplpBits) {
+        *lplpBits = nullptr;
+    }
+    return DD_OK;
+}
+
+extern "C" HRESULT WINAPI DDInternalUnlock(LPVOID lpSurfaceLocal) {
+    LDC_UNUSED(lpSurfaceLocal);
+    core::DeviceLock& lock = core::DeviceLock::Instance();
+    if (!lock.IsHeldByCurrentThread()) {
+        return DDERR_NOTLOCKED;
+    }
+    lock.Unlock();
+    return DD_OK;
+}
+
 // ============================================================================
 // COM Entry Points (Stubs)
 // ============================================================================
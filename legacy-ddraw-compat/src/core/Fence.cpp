@@ -0,0 +1,63 @@
+/**
+ * @file Fence.cpp
+ * @brief Completion fence implementation
+ */
+
+#include "core/Fence.h"
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// Fence Implementation
+// ============================================================================
+
+uint64_t Fence::Enqueue() {
+    return m_enqueued.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+void Fence::Signal(uint64_t value) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (value <= m_completed.load(std::memory_order_relaxed)) {
+            return;
+        }
+        m_completed.store(value, std::memory_order_release);
+    }
+    m_cv.notify_all();
+}
+
+void Fence::Wait(uint64_t value) {
+    // Completed work costs one atomic load and is not counted as a wait
+    if (IsComplete(value)) {
+        return;
+    }
+
+    Clock::time_point start = Clock::now();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return IsComplete(value); });
+    }
+    RecordWait(start);
+}
+
+void Fence::RecordWait(Clock::time_point start) {
+    uint64_t micros = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+
+    ++m_waitCount;
+    m_totalWaitMicros += micros;
+
+    uint64_t prevMax = m_maxWaitMicros.load(std::memory_order_relaxed);
+    while (micros > prevMax &&
+           !m_maxWaitMicros.compare_exchange_weak(prevMax, micros, std::memory_order_relaxed)) {
+    }
+}
+
+FenceStats Fence::GetStats() const {
+    FenceStats stats;
+    stats.waitCount = m_waitCount.load();
+    stats.totalWaitMicros = m_totalWaitMicros.load();
+    stats.maxWaitMicros = m_maxWaitMicros.load();
+    return stats;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file FrameExporter.cpp
+ * @brief Publishes presented frames into a shared-memory ring
+ */
+
+#include "core/FrameExporter.h"
+#include "renderer/PixelConvert.h"
+#include <new>
+
+using namespace ldc;
+using namespace ldc::core;
+
+namespace {
+
+// Slot pixels start on their own pages
+const uint64_t kSectionPageSize = 4096;
+
+uint64_t AlignToPage(uint64_t size) {
+    return (size + kSectionPageSize - 1) & ~(kSectionPageSize - 1);
+}
+
+uint64_t QueryTicks() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return static_cast<uint64_t>(now.QuadPart);
+}
+
+// Copy everything of the previous frame outside the area about to be converted
+void CopyOutside(const uint8_t* src, uint8_t* dst, uint32_t pitch, uint32_t height, const RECT& area) {
+    size_t left = static_cast<size_t>(area.left) * sizeof(uint32_t);
+    size_t right = static_cast<size_t>(area.right) * sizeof(uint32_t);
+
+    std::memcpy(dst, src, static_cast<size_t>(area.top) * pitch);
+    for (LONG y = area.top; y < area.bottom; ++y) {
+        size_t row = static_cast<size_t>(y) * pitch;
+        std::memcpy(dst + row, src + row, left);
+        std::memcpy(dst + row + right, src + row + right, pitch - right);
+    }
+    size_t below = static_cast<size_t>(area.bottom) * pitch;
+    std::memcpy(dst + below, src + below, (height - area.bottom) * static_cast<size_t>(pitch));
+}
+
+} // namespace
+
+// ============================================================================
+// FrameExporter Implementation
+// ============================================================================
+
+FrameExporter::~FrameExporter() {
+    Close();
+}
+
+bool FrameExporter::Open(const std::string& name, uint32_t slotCount, uint32_t maxWidth, uint32_t maxHeight) {
+    Close();
+
+    slotCount = (std::max)(slotCount, 2u);
+    uint64_t slotBytes = AlignToPage(static_cast<uint64_t>(maxWidth) * maxHeight * sizeof(uint32_t));
+    uint64_t pixelStart = AlignToPage(sizeof(FrameRingHeader) + slotCount * sizeof(FrameRingSlot));
+    uint64_t sectionSize = pixelStart + slotBytes * slotCount;
+
+    std::string sectionName = "Local\\" + name;
+    m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                   static_cast<DWORD>(sectionSize >> 32),
+                                   static_cast<DWORD>(sectionSize), sectionName.c_str());
+    if (!m_mapping) {
+        DebugLog("FrameExporter: cannot create %s (error %u)", sectionName.c_str(), GetLastError());
+        return false;
+    }
+
+    // Two writers on one ring would corrupt each other's frames
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        DebugLog("FrameExporter: %s is already in use", sectionName.c_str());
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+
+    m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+                                                 static_cast<SIZE_T>(sectionSize)));
+    if (!m_view) {
+        DebugLog("FrameExporter: cannot map %s", sectionName.c_str());
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+
+    auto* header = new (m_view) FrameRingHeader{};
+    header->version = kFrameRingVersion;
+    header->format = kFrameRingFormatXRGB8888;
+    header->slotCount = slotCount;
+    header->maxWidth = maxWidth;
+    header->maxHeight = maxHeight;
+    header->sectionSize = sectionSize;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    header->timerFrequency = static_cast<uint64_t>(frequency.QuadPart);
+
+    FrameRingSlot* slots = GetFrameRingSlots(header);
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        new (&slots[i]) FrameRingSlot{};
+        slots[i].pixelOffset = pixelStart + slotBytes * i;
+    }
+
+    // The magic goes in last: a consumer that sees it sees the whole layout
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kFrameRingMagic;
+
+    m_header = header;
+    m_sequence = 0;
+    m_published = 0;
+    m_skipped = 0;
+
+    DebugLog("FrameExporter: %s, %u slots of %ux%u (%llu KB)", sectionName.c_str(), slotCount,
+             maxWidth, maxHeight, static_cast<unsigned long long>(sectionSize / 1024));
+    return true;
+}
+
+void FrameExporter::Close() {
+    if (m_header) {
+        DebugLog("FrameExporter: %llu frames published, %llu skipped",
+                 static_cast<unsigned long long>(m_published),
+                 static_cast<unsigned long long>(m_skipped));
+    }
+
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    m_header = nullptr;
+}
+
+void FrameExporter::Publish(const renderer::PresentFrame& frame, const RECT* rects, uint32_t count) {
+    if (!m_header || !frame.pixels || frame.width == 0 || frame.height == 0) {
+        return;
+    }
+    if (frame.width > m_header->maxWidth || frame.height > m_header->maxHeight) {
+        m_skipped++;
+        return;
+    }
+
+    uint64_t captureTime = QueryTicks();
+
+    // A new palette recolours every pixel
+    RECT full = { 0, 0, static_cast<LONG>(frame.width), static_cast<LONG>(frame.height) };
+    RECT areas[kFrameRingMaxDamageRects];
+    uint32_t areaCount = 1;
+    areas[0] = full;
+    if (rects && !frame.paletteChanged) {
+        areaCount = renderer::ClipDamageRects(full, rects, count, kFrameRingMaxDamageRects, areas);
+        if (areaCount == 0) {
+            return;
+        }
+    }
+
+    FrameRingSlot* slots = GetFrameRingSlots(m_header);
+    uint64_t sequence = m_sequence + 1;
+    FrameRingSlot& slot = slots[GetFrameRingSlotIndex(m_header, sequence)];
+    uint32_t pitch = frame.width * sizeof(uint32_t);
+
+    // A partial frame builds on the previous one; readers never write, so
+    // that slot is intact as long as it holds the same size of frame
+    const FrameRingSlot* previous = nullptr;
+    if (std::memcmp(&areas[0], &full, sizeof(RECT)) != 0 && m_sequence > 0) {
+        previous = &slots[GetFrameRingSlotIndex(m_header, m_sequence)];
+        if (previous->width != frame.width || previous->height != frame.height) {
+            previous = nullptr;
+        }
+    }
+    if (!previous) {
+        areas[0] = full;
+        areaCount = 1;
+    }
+
+    // Readers that see the cleared sequence, or see it change after they
+    // read the pixels, discard what they read
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* pixels = m_view + slot.pixelOffset;
+    if (previous && areaCount == 1) {
+        CopyOutside(m_view + previous->pixelOffset, pixels, pitch, frame.height, areas[0]);
+    } else if (previous) {
+        std::memcpy(pixels, m_view + previous->pixelOffset, static_cast<size_t>(pitch) * frame.height);
+    }
+    for (uint32_t i = 0; i < areaCount; ++i) {
+        renderer::ConvertFrame(frame, areas[i], reinterpret_cast<uint32_t*>(pixels), frame.width);
+        slot.damage[i] = { areas[i].left, areas[i].top, areas[i].right, areas[i].bottom };
+    }
+
+    slot.width = frame.width;
+    slot.height = frame.height;
+    slot.pitch = pitch;
+    slot.damageCount = areaCount;
+    slot.captureTime = captureTime;
+    slot.publishTime = QueryTicks();
+
+    slot.sequence.store(sequence, std::memory_order_release);
+    m_header->latestSequence.store(sequence, std::memory_order_release);
+
+    m_sequence = sequence;
+    m_published++;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file Presenter.cpp
+ * @brief Asynchronous frame presentation implementation
+ */
+
+#include "core/Presenter.h"
+#include "core/DeviceContext.h"
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// Presenter Implementation
+// ============================================================================
+
+Presenter::Presenter(DeviceContext& device)
+    : m_device(device)
+{
+}
+
+Presenter::~Presenter() {
+    // The device is going away; the primary surface normally stops the
+    // thread earlier
+    Stop();
+}
+
+void Presenter::Submit(const uint8_t* pixels, DWORD pitch, Fence* fence, uint64_t fenceValue) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    StartThread();
+    DropPending();
+    m_pending.pixels = pixels;
+    m_pending.pitch = pitch;
+    m_pending.fence = fence;
+    m_pending.fenceValue = fenceValue;
+    m_cv.notify_all();
+}
+
+void Presenter::ScheduleFlush(DWORD delayMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+    if (m_flushScheduled && m_flushDeadline <= deadline) {
+        return;
+    }
+
+    StartThread();
+    m_flushScheduled = true;
+    m_flushDeadline = deadline;
+    m_cv.notify_all();
+}
+
+bool Presenter::IsPresenting(const uint8_t* pixels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inFlight.pixels == pixels;
+}
+
+void Presenter::Release(const uint8_t* pixels) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_pending.pixels == pixels) {
+        DropPending();
+    }
+    m_cv.wait(lock, [&] { return m_inFlight.pixels != pixels; });
+}
+
+bool Presenter::Discard() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    DropPending();
+    if (m_inFlight.pixels) {
+        m_inFlightStale = true;
+        m_windowBehind = true;
+    }
+
+    bool behind = m_windowBehind;
+    m_windowBehind = false;
+    return behind;
+}
+
+void Presenter::WaitIdle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    DropPending();
+    m_cv.wait(lock, [&] { return m_inFlight.pixels == nullptr; });
+}
+
+void Presenter::Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [&] {
+        return !m_thread.joinable() || (m_pending.pixels == nullptr && m_inFlight.pixels == nullptr);
+    });
+}
+
+void Presenter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            return;
+        }
+        m_stopping = true;
+        m_flushScheduled = false;
+        DropPending();
+        m_cv.notify_all();
+    }
+
+    m_thread.join();
+    DebugLog("Presenter stopped: %llu presented, %llu dropped",
+             static_cast<unsigned long long>(m_presented.load()),
+             static_cast<unsigned long long>(m_dropped.load()));
+}
+
+void Presenter::StartThread() {
+    // Caller holds m_mutex
+    if (!m_thread.joinable()) {
+        m_stopping = false;
+        m_thread = std::thread(&Presenter::ThreadProc, this);
+    }
+}
+
+void Presenter::DropPending() {
+    // Caller holds m_mutex; a superseded frame counts as done for its fence
+    if (m_pending.pixels) {
+        Complete(m_pending);
+        m_pending = Frame{};
+        m_windowBehind = true;
+        ++m_dropped;
+    }
+}
+
+void Presenter::Complete(const Frame& frame) {
+    if (frame.fence) {
+        frame.fence->Signal(frame.fenceValue);
+    }
+}
+
+void Presenter::ThreadProc() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        auto ready = [&] { return m_stopping || m_pending.pixels != nullptr; };
+        bool flushDue = false;
+        if (m_flushScheduled) {
+            flushDue = !m_cv.wait_until(lock, m_flushDeadline, ready);
+        } else {
+            m_cv.wait(lock, ready);
+        }
+        if (m_stopping) {
+            break;
+        }
+
+        // No frame came by the end of the refresh period; show the
+        // queued palette or gamma changes as the vertical blank would
+        if (flushDue) {
+            m_flushScheduled = false;
+            lock.unlock();
+            FlushPaletteChanges(m_device, true);
+            lock.lock();
+            continue;
+        }
+
+        m_inFlight = m_pending;
+        m_pending = Frame{};
+        // This frame is presented whole and is the newest; drops before
+        // it no longer matter
+        m_windowBehind = false;
+        lock.unlock();
+
+        {
+            std::lock_guard<std::recursive_mutex> render(m_device.renderMutex);
+
+            // A synchronous present may have overtaken this frame
+            bool stale;
+            {
+                std::lock_guard<std::mutex> check(m_mutex);
+                stale = m_inFlightStale;
+            }
+
+            if (!stale) {
+                m_device.present.presentPixels = m_inFlight.pixels;
+                m_device.present.primaryPitch = m_inFlight.pitch;
+                PresentPrimaryToScreen(m_device);
+                ++m_presented;
+            }
+        }
+
+        lock.lock();
+        Complete(m_inFlight);
+        m_inFlight = Frame{};
+        m_inFlightStale = false;
+        m_cv.notify_all();
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * @file RWLock.cpp
+ * @brief Reader/writer lock slow paths
+ */
+
+#include "core/RWLock.h"
+
+using namespace ldc;
+using namespace ldc::core;
+
+namespace {
+
+// Spins first (the holder is usually mid-blit on another core), then
+// gives up the time slice, then sleeps for holders that were preempted
+class Backoff {
+public:
+    void Pause() {
+        if (m_count < 64) {
+            YieldProcessor();
+        } else if (m_count < 256) {
+            SwitchToThread();
+        } else {
+            Sleep(1);
+        }
+        ++m_count;
+    }
+
+private:
+    uint32_t m_count = 0;
+};
+
+} // namespace
+
+// ============================================================================
+// RWLock Implementation
+// ============================================================================
+
+void RWLock::LockSharedSlow() {
+    m_contended.fetch_add(1, std::memory_order_relaxed);
+
+    for (Backoff backoff;; backoff.Pause()) {
+        if (TryLockShared()) {
+            return;
+        }
+    }
+}
+
+void RWLock::LockSlow() {
+    m_contended.fetch_add(1, std::memory_order_relaxed);
+
+    for (Backoff backoff;; backoff.Pause()) {
+        uint32_t state = m_state.load(std::memory_order_relaxed);
+        if ((state & ~kWriterWaiting) == 0) {
+            // Taking the lock clears the waiting bit; other waiting
+            // writers set it again on their next pass
+            if (m_state.compare_exchange_weak(state, kWriter,
+                                              std::memory_order_acquire, std::memory_order_relaxed)) {
+                return;
+            }
+            continue;
+        }
+
+        // Hold off new readers so a steady stream of them cannot starve us
+        if (!(state & kWriterWaiting)) {
+            m_state.fetch_or(kWriterWaiting, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,600 @@
+/**
+ * @file SurfaceAllocator.cpp
+ * @brief Pooled surface pixel memory implementation
+ */
+
+#include "core/SurfaceAllocator.h"
+#include <malloc.h>
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// SurfaceMemory Implementation
+// ============================================================================
+
+void SurfaceMemory::Reset() {
+    if (m_data) {
+        SurfaceAllocator::Instance().Free(*this);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_sizeClass = 0;
+    m_kind = Kind::Pooled;
+    m_reserved = 0;
+    m_pinned = false;
+    m_bitmap = nullptr;
+    m_dc = nullptr;
+    m_oldBitmap = nullptr;
+    m_refs = nullptr;
+}
+
+// ============================================================================
+// SurfaceAllocator Implementation
+// ============================================================================
+
+SurfaceAllocator& SurfaceAllocator::Instance() {
+    // Never destroyed: surfaces leaked by the game may still free into it
+    // during process teardown
+    static SurfaceAllocator* instance = new SurfaceAllocator();
+    return *instance;
+}
+
+uint32_t SurfaceAllocator::SizeClassOf(size_t size) {
+    if (size <= 64) {
+        return 0;
+    }
+
+    // Four classes per power of two keeps rounding waste under 25%
+    uint32_t log2 = 0;
+    for (size_t v = size - 1; v > 1; v >>= 1) {
+        ++log2;
+    }
+    size_t step = (static_cast<size_t>(1) << log2) / 4;
+    size_t steps = (size + step - 1) / step;
+    return (log2 - 6) * 4 + static_cast<uint32_t>(steps - 4);
+}
+
+size_t SurfaceAllocator::SizeOfClass(uint32_t sizeClass) {
+    if (sizeClass == 0) {
+        return 64;
+    }
+    uint32_t log2 = 6 + (sizeClass - 1) / 4;
+    size_t steps = (sizeClass - 1) % 4 + 5;
+    return steps * ((static_cast<size_t>(1) << log2) / 4);
+}
+
+void SurfaceAllocator::SetAlignment(uint32_t alignment) {
+    alignment = std::clamp<uint32_t>(alignment, 16, 4096);
+    if (alignment & (alignment - 1)) {
+        DebugLog("SurfaceAllocator: alignment %u is not a power of two, using 64", alignment);
+        alignment = 64;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (alignment == m_alignment) {
+        return;
+    }
+
+    // Cached blocks and the arena tail were laid out for the old alignment
+    ReleaseCached();
+    m_freeLists.clear();
+    m_arenaOffset = kArenaChunkSize;
+    m_alignment = alignment;
+}
+
+void SurfaceAllocator::SetPageBacking(size_t thresholdBytes, bool largePages) {
+    bool useLargePages = largePages && EnableLargePages();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pageThreshold = thresholdBytes;
+    m_largePages = useLargePages;
+}
+
+bool SurfaceAllocator::EnableLargePages() {
+    size_t largePageSize = GetLargePageMinimum();
+    if (largePageSize == 0) {
+        return false;
+    }
+
+    // Large pages need SeLockMemoryPrivilege, which must already be
+    // granted to the account; we can only switch it on for the process
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES privileges{};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+    bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+                   AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                   GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+
+    if (!enabled) {
+        DebugLog("SurfaceAllocator: large pages unavailable (SeLockMemoryPrivilege not held)");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_largePageSize = largePageSize;
+    return true;
+}
+
+DWORD SurfaceAllocator::AlignPitch(DWORD rowBytes, DWORD bytesPerPixel) const {
+    DWORD alignment = rowBytes >= m_alignment ? m_alignment : 4;
+    DWORD pitch = (rowBytes + alignment - 1) & ~(alignment - 1);
+
+    // Only 24-bit rows can need this, and at most two extra steps
+    while (bytesPerPixel > 1 && pitch % bytesPerPixel != 0) {
+        pitch += alignment;
+    }
+    return pitch;
+}
+
+SurfaceMemory SurfaceAllocator::Allocate(size_t size) {
+    SurfaceMemory memory;
+    if (size == 0) {
+        return memory;
+    }
+
+    if (m_pageThreshold != 0 && size >= m_pageThreshold && AllocatePages(memory, size)) {
+        return memory;
+    }
+
+    uint32_t sizeClass = SizeClassOf(size);
+    size_t blockSize = SizeOfClass(sizeClass);
+    uint8_t* block = nullptr;
+    bool zeroed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_freeLists.find(sizeClass);
+        if (it != m_freeLists.end() && !it->second.empty()) {
+            block = it->second.back();
+            it->second.pop_back();
+            ++m_stats.poolHits;
+            if (blockSize > kArenaMaxBlock) {
+                m_stats.bytesCached -= blockSize;
+            }
+        } else if (blockSize <= kArenaMaxBlock) {
+            block = CarveFromArena(blockSize);
+            zeroed = (block != nullptr);
+        }
+
+        if (block) {
+            ++m_stats.allocations;
+            m_stats.bytesInUse += blockSize;
+            m_stats.peakBytesInUse = std::max(m_stats.peakBytesInUse, m_stats.bytesInUse);
+        }
+    }
+
+    if (!block) {
+        block = static_cast<uint8_t*>(_aligned_malloc(blockSize, m_alignment));
+        if (!block) {
+            DebugLog("SurfaceAllocator: out of memory allocating %zu bytes", blockSize);
+            return memory;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.allocations;
+        m_stats.bytesInUse += blockSize;
+        m_stats.peakBytesInUse = std::max(m_stats.peakBytesInUse, m_stats.bytesInUse);
+    }
+
+    // Fresh arena memory comes zeroed from the OS
+    if (!zeroed) {
+        memset(block, 0, size);
+    }
+
+    memory.m_data = block;
+    memory.m_size = size;
+    memory.m_sizeClass = sizeClass;
+    return memory;
+}
+
+void SurfaceAllocator::Free(SurfaceMemory& memory) {
+    if (memory.m_pinned) {
+        Unpin(memory);
+    }
+
+    // Only the last owner of a shared block frees it
+    if (memory.m_refs) {
+        if (memory.m_refs->fetch_sub(1, std::memory_order_acq_rel) > 1) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.bytesShared -= BlockBytes(memory);
+            return;
+        }
+        delete memory.m_refs;
+        memory.m_refs = nullptr;
+    }
+    if (memory.m_kind == SurfaceMemory::Kind::Dib) {
+        FreeDib(memory);
+        return;
+    }
+    if (memory.IsPageBacked()) {
+        FreePages(memory);
+        return;
+    }
+
+    size_t blockSize = SizeOfClass(memory.m_sizeClass);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.frees;
+    m_stats.bytesInUse -= blockSize;
+
+    // Arena blocks always go back on their list; large blocks only while
+    // the cache stays within budget
+    if (blockSize <= kArenaMaxBlock) {
+        m_freeLists[memory.m_sizeClass].push_back(memory.m_data);
+    } else if (m_stats.bytesCached + blockSize <= kMaxCachedBytes) {
+        m_freeLists[memory.m_sizeClass].push_back(memory.m_data);
+        m_stats.bytesCached += blockSize;
+    } else {
+        _aligned_free(memory.m_data);
+    }
+}
+
+uint8_t* SurfaceAllocator::CarveFromArena(size_t blockSize) {
+    // Caller holds m_mutex
+    size_t offset = (m_arenaOffset + m_alignment - 1) & ~static_cast<size_t>(m_alignment - 1);
+
+    if (offset + blockSize > kArenaChunkSize) {
+        void* chunk = VirtualAlloc(nullptr, kArenaChunkSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!chunk) {
+            return nullptr;
+        }
+        m_arenaChunks.push_back(static_cast<uint8_t*>(chunk));
+        m_stats.arenaBytes += kArenaChunkSize;
+        offset = 0;
+    }
+
+    m_arenaOffset = offset + blockSize;
+    ++m_stats.arenaAllocations;
+    return m_arenaChunks.back() + offset;
+}
+
+bool SurfaceAllocator::AllocatePages(SurfaceMemory& memory, size_t size) {
+    uint8_t* base = nullptr;
+    size_t bytes = 0;
+    SurfaceMemory::Kind kind = SurfaceMemory::Kind::Pages;
+
+    // Large pages are physically contiguous and often unavailable once
+    // memory fragments, so failure quietly falls back to normal pages
+    if (m_largePages && m_largePageSize && size >= m_largePageSize) {
+        bytes = (size + m_largePageSize - 1) / m_largePageSize * m_largePageSize;
+        base = static_cast<uint8_t*>(
+            VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+        kind = SurfaceMemory::Kind::LargePages;
+    }
+
+    if (!base) {
+        bytes = (size + kReservationGranularity - 1) / kReservationGranularity * kReservationGranularity;
+        kind = SurfaceMemory::Kind::Pages;
+
+        bool reused = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_reservations.find(bytes);
+            if (it != m_reservations.end() && !it->second.empty()) {
+                base = it->second.back();
+                it->second.pop_back();
+                m_reservedCached -= bytes;
+                ++m_stats.reservationsReused;
+                reused = true;
+            }
+        }
+
+        if (!base) {
+            base = static_cast<uint8_t*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS));
+            if (!base) {
+                return false;
+            }
+        }
+
+        // Committing only charges the page file; each page is backed by
+        // a zero page from the OS the first time it is touched
+        if (!VirtualAlloc(base, bytes, MEM_COMMIT, PAGE_READWRITE)) {
+            VirtualFree(base, 0, MEM_RELEASE);
+            if (reused) {
+                DebugLog("SurfaceAllocator: could not recommit %zu bytes", bytes);
+            }
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.allocations;
+        if (kind == SurfaceMemory::Kind::LargePages) {
+            ++m_stats.largePageAllocations;
+        } else {
+            ++m_stats.pageAllocations;
+        }
+        m_stats.bytesInUse += bytes;
+        m_stats.peakBytesInUse = std::max(m_stats.peakBytesInUse, m_stats.bytesInUse);
+    }
+
+    memory.m_data = base;
+    memory.m_size = size;
+    memory.m_kind = kind;
+    memory.m_reserved = bytes;
+    return true;
+}
+
+void SurfaceAllocator::FreePages(SurfaceMemory& memory) {
+    size_t bytes = memory.m_reserved;
+
+    if (memory.m_kind == SurfaceMemory::Kind::Pages) {
+        // Decommitting drops the contents, so a reused reservation is
+        // zeroed by the OS again when it is recommitted
+        VirtualFree(memory.m_data, bytes, MEM_DECOMMIT);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.frees;
+        m_stats.bytesInUse -= bytes;
+        if (m_reservedCached + bytes <= kMaxCachedReservation) {
+            m_reservations[bytes].push_back(memory.m_data);
+            m_reservedCached += bytes;
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.frees;
+        m_stats.bytesInUse -= bytes;
+    }
+
+    VirtualFree(memory.m_data, 0, MEM_RELEASE);
+}
+
+bool SurfaceAllocator::ConvertToDib(SurfaceMemory& memory, DWORD pitch, DWORD height,
+                                    const DDPIXELFORMAT& pixelFormat) {
+    if (memory.m_kind == SurfaceMemory::Kind::Dib) {
+        return true;
+    }
+
+    DWORD bpp = pixelFormat.dwRGBBitCount;
+
+    struct {
+        BITMAPINFOHEADER header;
+        RGBQUAD colors[256];
+    } info{};
+
+    // The DIB is as wide as the pitch, so its rows line up with ours and
+    // GDI draws straight into the surface layout
+    info.header.biSize = sizeof(BITMAPINFOHEADER);
+    info.header.biWidth = static_cast<LONG>(pitch * 8 / bpp);
+    info.header.biHeight = -static_cast<LONG>(height);
+    info.header.biPlanes = 1;
+    info.header.biBitCount = static_cast<WORD>(bpp);
+    info.header.biCompression = BI_RGB;
+
+    if (bpp == 16 || bpp == 32) {
+        DWORD masks[3] = { pixelFormat.dwRBitMask, pixelFormat.dwGBitMask, pixelFormat.dwBBitMask };
+        info.header.biCompression = BI_BITFIELDS;
+        memcpy(info.colors, masks, sizeof(masks));
+    } else if (bpp == 8) {
+        info.header.biClrUsed = 256;
+    }
+
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(nullptr, reinterpret_cast<BITMAPINFO*>(&info),
+                                      DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap || !bits) {
+        DebugLog("SurfaceAllocator: CreateDIBSection failed for %ux%u %ubpp",
+                 static_cast<unsigned>(info.header.biWidth), height, bpp);
+        if (bitmap) {
+            DeleteObject(bitmap);
+        }
+        return false;
+    }
+
+    HDC dc = CreateCompatibleDC(nullptr);
+    if (!dc) {
+        DeleteObject(bitmap);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(pitch) * height;
+    if (memory.m_data) {
+        memcpy(bits, memory.m_data, std::min(size, memory.m_size));
+    }
+
+    SurfaceMemory dib;
+    dib.m_data = static_cast<uint8_t*>(bits);
+    dib.m_size = size;
+    dib.m_kind = SurfaceMemory::Kind::Dib;
+    dib.m_reserved = (size + 4095) & ~static_cast<size_t>(4095);
+    dib.m_bitmap = bitmap;
+    dib.m_dc = dc;
+    dib.m_oldBitmap = SelectObject(dc, bitmap);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.allocations;
+        ++m_stats.dibConversions;
+        m_stats.bytesInUse += dib.m_reserved;
+        m_stats.peakBytesInUse = std::max(m_stats.peakBytesInUse, m_stats.bytesInUse);
+    }
+
+    // A PageLock taken before the conversion still applies
+    bool pinned = memory.m_pinned;
+    memory = std::move(dib);
+    if (pinned) {
+        Pin(memory);
+    }
+    return true;
+}
+
+void SurfaceAllocator::FreeDib(SurfaceMemory& memory) {
+    SelectObject(memory.m_dc, memory.m_oldBitmap);
+    DeleteDC(memory.m_dc);
+    DeleteObject(memory.m_bitmap);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.frees;
+    m_stats.bytesInUse -= memory.m_reserved;
+}
+
+size_t SurfaceAllocator::BlockBytes(const SurfaceMemory& memory) {
+    return memory.m_kind == SurfaceMemory::Kind::Pooled ? SizeOfClass(memory.m_sizeClass)
+                                                        : memory.m_reserved;
+}
+
+SurfaceMemory SurfaceAllocator::Share(SurfaceMemory& memory) {
+    SurfaceMemory copy;
+    if (!memory.m_data) {
+        return copy;
+    }
+
+    if (!memory.m_refs) {
+        memory.m_refs = new std::atomic<uint32_t>(1);
+    }
+    memory.m_refs->fetch_add(1, std::memory_order_acq_rel);
+
+    // Pinning stays with the owner that asked for it
+    copy.m_data = memory.m_data;
+    copy.m_size = memory.m_size;
+    copy.m_sizeClass = memory.m_sizeClass;
+    copy.m_kind = memory.m_kind;
+    copy.m_reserved = memory.m_reserved;
+    copy.m_bitmap = memory.m_bitmap;
+    copy.m_dc = memory.m_dc;
+    copy.m_oldBitmap = memory.m_oldBitmap;
+    copy.m_refs = memory.m_refs;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.bytesShared += BlockBytes(memory);
+    return copy;
+}
+
+bool SurfaceAllocator::MakeUnique(SurfaceMemory& memory) {
+    if (!memory.IsShared()) {
+        return true;
+    }
+
+    SurfaceMemory copy = Allocate(memory.m_size);
+    if (!copy.m_data) {
+        return false;
+    }
+    memcpy(copy.m_data, memory.m_data, memory.m_size);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.copiesOnWrite;
+    }
+
+    bool pinned = memory.m_pinned;
+    memory = std::move(copy);
+    if (pinned) {
+        Pin(memory);
+    }
+    return true;
+}
+
+bool SurfaceAllocator::Pin(SurfaceMemory& memory) {
+    if (!memory.IsPageBacked()) {
+        return false;
+    }
+    if (memory.m_pinned) {
+        return true;
+    }
+
+    // Large pages can never be paged out
+    if (memory.m_kind != SurfaceMemory::Kind::LargePages &&
+        !VirtualLock(memory.m_data, memory.m_reserved)) {
+        if (GetLastError() != ERROR_WORKING_SET_QUOTA) {
+            return false;
+        }
+
+        // Locked pages count against the minimum working set; grow it
+        SIZE_T minimum = 0;
+        SIZE_T maximum = 0;
+        HANDLE process = GetCurrentProcess();
+        if (!GetProcessWorkingSetSize(process, &minimum, &maximum) ||
+            !SetProcessWorkingSetSize(process, minimum + memory.m_reserved,
+                                      std::max(maximum, minimum + memory.m_reserved)) ||
+            !VirtualLock(memory.m_data, memory.m_reserved)) {
+            DebugLog("SurfaceAllocator: could not pin %zu bytes", memory.m_reserved);
+            return false;
+        }
+    }
+
+    memory.m_pinned = true;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.bytesPinned += memory.m_reserved;
+    return true;
+}
+
+void SurfaceAllocator::Unpin(SurfaceMemory& memory) {
+    if (!memory.m_pinned) {
+        return;
+    }
+
+    if (memory.m_kind != SurfaceMemory::Kind::LargePages) {
+        VirtualUnlock(memory.m_data, memory.m_reserved);
+    }
+    memory.m_pinned = false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.bytesPinned -= memory.m_reserved;
+}
+
+void SurfaceAllocator::Trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ReleaseCached();
+
+    for (auto& entry : m_reservations) {
+        for (uint8_t* base : entry.second) {
+            VirtualFree(base, 0, MEM_RELEASE);
+        }
+    }
+    m_reservations.clear();
+    m_reservedCached = 0;
+}
+
+void SurfaceAllocator::ReleaseCached() {
+    // Caller holds m_mutex; arena blocks stay with their chunk
+    for (auto it = m_freeLists.begin(); it != m_freeLists.end();) {
+        if (SizeOfClass(it->first) > kArenaMaxBlock) {
+            for (uint8_t* block : it->second) {
+                _aligned_free(block);
+            }
+            it = m_freeLists.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_stats.bytesCached = 0;
+}
+
+SurfaceAllocatorStats SurfaceAllocator::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SurfaceAllocator::LogStats() const {
+    SurfaceAllocatorStats stats = GetStats();
+    DebugLog("SurfaceAllocator: %llu allocations (%llu pooled, %llu arena, %llu paged, "
+             "%llu large-page), %llu frees, %llu bytes in use (peak %llu), %llu cached, "
+             "%llu arena, %llu pinned, %llu DIB sections, %llu saved by sharing "
+             "(%llu copied on write)",
+             static_cast<unsigned long long>(stats.allocations),
+             static_cast<unsigned long long>(stats.poolHits),
+             static_cast<unsigned long long>(stats.arenaAllocations),
+             static_cast<unsigned long long>(stats.pageAllocations),
+             static_cast<unsigned long long>(stats.largePageAllocations),
+             static_cast<unsigned long long>(stats.frees),
+             static_cast<unsigned long long>(stats.bytesInUse),
+             static_cast<unsigned long long>(stats.peakBytesInUse),
+             static_cast<unsigned long long>(stats.bytesCached),
+             static_cast<unsigned long long>(stats.arenaBytes),
+             static_cast<unsigned long long>(stats.bytesPinned),
+             static_cast<unsigned long long>(stats.dibConversions),
+             static_cast<unsigned long long>(stats.bytesShared),
+             static_cast<unsigned long long>(stats.copiesOnWrite));
+}
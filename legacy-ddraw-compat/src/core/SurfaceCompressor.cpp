@@ -0,0 +1,316 @@
+/**
+ * @file SurfaceCompressor.cpp
+ * @brief Idle surface compression implementation
+ */
+
+#include "core/SurfaceCompressor.h"
+#include "core/SurfaceAllocator.h"
+#include <chrono>
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// Pixel Codec
+// ============================================================================
+//
+// The stream is a series of sequences, each a token byte followed by
+// literals and a back reference:
+//
+//   token        high nibble = literal count, low nibble = match length - 4
+//   [count...]   255-valued bytes extending a nibble that reads 15
+//   literals
+//   offset       16-bit little-endian distance back into the output
+//   [count...]   extension of the match length
+//
+// The last sequence carries literals only and ends the stream.
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+constexpr uint32_t kHashBits = 14;
+
+// Matches never start this close to the end, so they can be extended
+// with unchecked 8-byte loads
+constexpr size_t kTailLiterals = 12;
+
+inline uint32_t Load32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void EmitCount(std::vector<uint8_t>& packed, size_t count) {
+    while (count >= 255) {
+        packed.push_back(255);
+        count -= 255;
+    }
+    packed.push_back(static_cast<uint8_t>(count));
+}
+
+void EmitSequence(std::vector<uint8_t>& packed, const uint8_t* literals, size_t literalCount,
+                  size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) |
+                                         std::min<size_t>(matchCode, 15));
+    packed.push_back(token);
+    if (literalCount >= 15) {
+        EmitCount(packed, literalCount - 15);
+    }
+    packed.insert(packed.end(), literals, literals + literalCount);
+
+    if (matchLength) {
+        packed.push_back(static_cast<uint8_t>(offset));
+        packed.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= 15) {
+            EmitCount(packed, matchCode - 15);
+        }
+    }
+}
+
+bool ReadCount(const uint8_t*& in, const uint8_t* end, size_t& count) {
+    uint8_t b;
+    do {
+        if (in == end) {
+            return false;
+        }
+        b = *in++;
+        count += b;
+    } while (b == 255);
+    return true;
+}
+
+} // namespace
+
+bool ldc::core::CompressPixels(const uint8_t* data, size_t size, std::vector<uint8_t>& packed) {
+    packed.clear();
+
+    // Anything that saves less than an eighth is not worth the unpack stall
+    size_t maxPacked = size - size / 8;
+    if (size < kTailLiterals * 2 || size > UINT32_MAX) {
+        return false;
+    }
+    packed.reserve(size / 4);
+
+    std::vector<uint32_t> table(size_t(1) << kHashBits, UINT32_MAX);
+    size_t anchor = 0;
+    size_t pos = 0;
+    size_t limit = size - kTailLiterals;
+
+    while (pos < limit) {
+        uint32_t sequence = Load32(data + pos);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(pos);
+
+        if (candidate == UINT32_MAX || pos - candidate > kMaxOffset ||
+            Load32(data + candidate) != sequence) {
+            // Step faster through data that keeps failing to match
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+
+        size_t length = kMinMatch;
+        while (pos + length + 8 <= size) {
+            uint64_t diff = Load64(data + pos + length) ^ Load64(data + candidate + length);
+            if (diff) {
+                break;
+            }
+            length += 8;
+        }
+        while (pos + length < size && data[pos + length] == data[candidate + length]) {
+            ++length;
+        }
+
+        EmitSequence(packed, data + anchor, pos - anchor, pos - candidate, length);
+        if (packed.size() >= maxPacked) {
+            return false;
+        }
+        pos += length;
+        anchor = pos;
+    }
+
+    EmitSequence(packed, data + anchor, size - anchor, 0, 0);
+    if (packed.size() >= maxPacked) {
+        return false;
+    }
+    packed.shrink_to_fit();
+    return true;
+}
+
+bool ldc::core::DecompressPixels(const uint8_t* packed, size_t packedSize, uint8_t* data, size_t size) {
+    const uint8_t* in = packed;
+    const uint8_t* end = packed + packedSize;
+    size_t out = 0;
+
+    while (in < end) {
+        uint8_t token = *in++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !ReadCount(in, end, literalCount)) {
+            return false;
+        }
+        if (literalCount > static_cast<size_t>(end - in) || literalCount > size - out) {
+            return false;
+        }
+        memcpy(data + out, in, literalCount);
+        in += literalCount;
+        out += literalCount;
+
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+
+        size_t length = token & 15;
+        if (length == 15 && !ReadCount(in, end, length)) {
+            return false;
+        }
+        length += kMinMatch;
+
+        if (offset == 0 || offset > out || length > size - out) {
+            return false;
+        }
+
+        // Overlapping matches repeat the last offset bytes, which is how
+        // runs are encoded; the repeated span doubles with each copy
+        uint8_t* to = data + out;
+        size_t span = offset;
+        size_t remaining = length;
+        while (remaining > 0) {
+            size_t chunk = std::min(span, remaining);
+            memcpy(to, to - span, chunk);
+            to += chunk;
+            remaining -= chunk;
+            span += chunk;
+        }
+        out += length;
+    }
+
+    return out == size;
+}
+
+// ============================================================================
+// SurfaceCompressor Implementation
+// ============================================================================
+
+SurfaceCompressor::SurfaceCompressor(uint32_t idleMs, uint64_t budgetBytes, ScanFn scan)
+    : m_idleMs(idleMs)
+    , m_budgetBytes(budgetBytes)
+    , m_scan(std::move(scan))
+{
+    m_worker = std::thread(&SurfaceCompressor::WorkerProc, this);
+
+    DebugLog("SurfaceCompressor started: idle %u ms, budget %llu bytes",
+             m_idleMs, static_cast<unsigned long long>(m_budgetBytes));
+}
+
+SurfaceCompressor::~SurfaceCompressor() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_stopCv.notify_all();
+    m_worker.join();
+
+    LogStats();
+}
+
+bool SurfaceCompressor::IsOverBudget() const {
+    return SurfaceAllocator::Instance().GetStats().bytesInUse > m_budgetBytes;
+}
+
+void SurfaceCompressor::RecordCompression(size_t original, size_t packed) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.compressions;
+    m_stats.bytesUnpacked += original;
+    m_stats.bytesPacked += packed;
+}
+
+void SurfaceCompressor::RecordIncompressible() {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.incompressible;
+}
+
+void SurfaceCompressor::RecordDecompression(size_t original, size_t packed, uint64_t micros) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.decompressions;
+    m_stats.bytesUnpacked -= original;
+    m_stats.bytesPacked -= packed;
+    m_stats.totalStallMicros += micros;
+    m_stats.maxStallMicros = std::max(m_stats.maxStallMicros, micros);
+    ++m_stats.stallHistogram[StallBucketOf(micros)];
+}
+
+void SurfaceCompressor::RecordRelease(size_t original, size_t packed) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.bytesUnpacked -= original;
+    m_stats.bytesPacked -= packed;
+}
+
+SurfaceCompressorStats SurfaceCompressor::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void SurfaceCompressor::LogStats() const {
+    SurfaceCompressorStats stats = GetStats();
+    DebugLog("SurfaceCompressor: %llu compressed (%llu incompressible), %llu unpacked on access "
+             "(%llu us total, %llu us max), %llu bytes held in %llu",
+             static_cast<unsigned long long>(stats.compressions),
+             static_cast<unsigned long long>(stats.incompressible),
+             static_cast<unsigned long long>(stats.decompressions),
+             static_cast<unsigned long long>(stats.totalStallMicros),
+             static_cast<unsigned long long>(stats.maxStallMicros),
+             static_cast<unsigned long long>(stats.bytesUnpacked),
+             static_cast<unsigned long long>(stats.bytesPacked));
+
+    for (uint32_t i = 0; i < kStallBuckets; ++i) {
+        if (stats.stallHistogram[i] == 0) {
+            continue;
+        }
+        unsigned long long low = i == 0 ? 0 : 1ull << (i + 5);
+        if (i + 1 == kStallBuckets) {
+            DebugLog("  unpack stalls >= %llu us: %llu", low,
+                     static_cast<unsigned long long>(stats.stallHistogram[i]));
+        } else {
+            DebugLog("  unpack stalls %llu-%llu us: %llu", low, 1ull << (i + 6),
+                     static_cast<unsigned long long>(stats.stallHistogram[i]));
+        }
+    }
+}
+
+uint32_t SurfaceCompressor::StallBucketOf(uint64_t micros) {
+    uint32_t bucket = 0;
+    for (uint64_t bound = 64; micros >= bound && bucket + 1 < kStallBuckets; bound <<= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+void SurfaceCompressor::WorkerProc() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        if (m_stopCv.wait_for(lock, std::chrono::milliseconds(kScanIntervalMs),
+                              [&] { return m_stopping; })) {
+            break;
+        }
+
+        lock.unlock();
+        m_scan(*this);
+        lock.lock();
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file TileExecutor.cpp
+ * @brief Row-band parallel execution implementation
+ */
+
+#include "core/TileExecutor.h"
+#include <chrono>
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// TileExecutor Implementation
+// ============================================================================
+
+TileExecutor::TileExecutor(uint32_t workerCount, int thresholdPixels) {
+    if (workerCount == 0) {
+        // The calling thread takes bands too, so one fewer worker than
+        // cores keeps every core busy without oversubscribing
+        uint32_t cpus = std::thread::hardware_concurrency();
+        workerCount = std::clamp<uint32_t>(cpus > 1 ? cpus - 1 : 0, 0, 7);
+    }
+
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&TileExecutor::WorkerProc, this);
+    }
+
+    if (m_workers.empty()) {
+        m_threshold = 0;
+    } else if (thresholdPixels < 0) {
+        // The sweep takes long enough to stall a game's first frame, so it
+        // runs beside the game with a fixed threshold in the meantime
+        m_threshold = kDefaultThreshold;
+        m_calibrator = std::thread([this] {
+            m_threshold = MeasureCrossover();
+            DebugLog("TileExecutor measured split threshold %llu pixels",
+                     static_cast<unsigned long long>(m_threshold.load()));
+        });
+    } else {
+        m_threshold = static_cast<uint64_t>(thresholdPixels);
+    }
+
+    DebugLog("TileExecutor started with %u workers, split threshold %llu pixels",
+             workerCount, static_cast<unsigned long long>(m_threshold.load()));
+}
+
+TileExecutor::~TileExecutor() {
+    // The measurement is stopped first, with the pool it borrowed threads for
+    m_stopCalibration = true;
+    if (m_calibrator.joinable()) {
+        m_calibrator.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+
+    DebugLog("TileExecutor stopped: %llu inline, %llu split into %llu bands",
+             static_cast<unsigned long long>(m_inlineRuns.load()),
+             static_cast<unsigned long long>(m_parallelRuns.load()),
+             static_cast<unsigned long long>(m_bands.load()));
+}
+
+void TileExecutor::Run(uint32_t rows, uint64_t pixels, const BandFn& band) {
+    if (rows < 2 || !ShouldSplit(pixels)) {
+        ++m_inlineRuns;
+        band(0, rows);
+        return;
+    }
+
+    ++m_parallelRuns;
+    RunParallel(rows, band);
+}
+
+TileExecutorStats TileExecutor::GetStats() const {
+    TileExecutorStats stats;
+    stats.inlineRuns = m_inlineRuns.load();
+    stats.parallelRuns = m_parallelRuns.load();
+    stats.bands = m_bands.load();
+    return stats;
+}
+
+void TileExecutor::RunParallel(uint32_t rows, const BandFn& band, bool countBands) {
+    // Two bands per thread evens out cores that start late
+    uint32_t threads = GetWorkerCount() + 1;
+    uint32_t bandCount = std::min(rows, threads * 2);
+
+    Job job;
+    job.band = &band;
+    job.rows = rows;
+    job.bandRows = (rows + bandCount - 1) / bandCount;
+    job.bandCount = (rows + job.bandRows - 1) / job.bandRows;
+    if (countBands) {
+        m_bands += job.bandCount;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobs.push_back(&job);
+    m_workCv.notify_all();
+
+    // Work on our own bands, then wait for those taken by workers
+    while (RunOneBand(lock, job)) {
+    }
+    m_doneCv.wait(lock, [&] { return job.finished == job.bandCount; });
+}
+
+bool TileExecutor::RunOneBand(std::unique_lock<std::mutex>& lock, Job& job) {
+    // Caller holds m_mutex
+    if (job.next == job.bandCount) {
+        return false;
+    }
+
+    uint32_t index = job.next++;
+    if (job.next == job.bandCount) {
+        m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+    }
+    lock.unlock();
+
+    uint32_t begin = index * job.bandRows;
+    uint32_t end = std::min(job.rows, begin + job.bandRows);
+    (*job.band)(begin, end);
+
+    lock.lock();
+    if (++job.finished == job.bandCount) {
+        m_doneCv.notify_all();
+    }
+    return true;
+}
+
+void TileExecutor::WorkerProc() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        m_workCv.wait(lock, [&] { return m_stopping || !m_jobs.empty(); });
+        if (m_jobs.empty()) {
+            break;
+        }
+        RunOneBand(lock, *m_jobs.front());
+    }
+}
+
+uint64_t TileExecutor::MeasureCrossover() {
+    using Clock = std::chrono::steady_clock;
+
+    const uint32_t width = 1024;
+    const uint32_t maxRows = 2048;
+    std::vector<uint32_t> buffer(static_cast<size_t>(width) * maxRows, 0);
+
+    BandFn fill = [&](uint32_t begin, uint32_t end) {
+        uint32_t* row = buffer.data() + static_cast<size_t>(begin) * width;
+        std::fill(row, row + static_cast<size_t>(end - begin) * width, 0xFF00FF00u);
+    };
+
+    // Split fills run on a pool of their own with as many workers: on
+    // ours, live blits would slow them down and could make splitting look
+    // like it never pays off
+    TileExecutor crew(GetWorkerCount(), 0);
+
+    auto bestOf = [&](uint32_t rows, bool split) {
+        Clock::duration best = Clock::duration::max();
+        for (int i = 0; i < 3; ++i) {
+            Clock::time_point start = Clock::now();
+            if (split) {
+                crew.RunParallel(rows, fill, false);
+            } else {
+                fill(0, rows);
+            }
+            best = std::min(best, Clock::now() - start);
+        }
+        return best;
+    };
+
+    // Fault the pages in before timing anything
+    fill(0, maxRows);
+
+    for (uint32_t rows = 16; rows <= maxRows; rows *= 2) {
+        if (m_stopCalibration) {
+            return m_threshold;
+        }
+
+        Clock::duration inlineTime = bestOf(rows, false);
+        Clock::duration splitTime = bestOf(rows, true);
+
+        // Require a clear win so noise does not pick a tiny threshold
+        if (splitTime * 5 < inlineTime * 4) {
+            return static_cast<uint64_t>(rows) * width;
+        }
+    }
+
+    // Splitting never paid off on this machine
+    return 0;
+}
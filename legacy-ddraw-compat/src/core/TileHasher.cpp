@@ -0,0 +1,183 @@
+/**
+ * @file TileHasher.cpp
+ * @brief Detection of the parts of a frame that changed since the last present
+ */
+
+#include "core/TileHasher.h"
+#include "core/Hash.h"
+
+#ifdef LDC_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace ldc;
+using namespace ldc::core;
+
+namespace {
+
+const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+
+#ifdef LDC_HAVE_SSE2
+
+// One 16-byte block into the accumulator, multiplying 32-bit halves as
+// SSE2 allows. The key moves on after every block, so equal blocks in
+// different places of a tile do not cancel out.
+inline __m128i Accumulate(__m128i acc, __m128i data, __m128i key) {
+    __m128i dataKey = _mm_xor_si128(data, key);
+    __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+    acc = _mm_add_epi64(acc, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_add_epi64(acc, product);
+}
+
+uint64_t HashTile(const uint8_t* pixels, uint32_t pitch, uint32_t rowBytes, uint32_t rows) {
+    const __m128i keyStep = _mm_set_epi32(0x27D4EB2F, 0x165667B1, 0x85EBCA77, 0x61C88647);
+    __m128i key = _mm_set_epi32(0x9E3779B9, 0x7F4A7C15, 0xC2B2AE3D, 0x94D049BB);
+    __m128i acc = _mm_set_epi64x(static_cast<long long>(rowBytes), static_cast<long long>(rows));
+
+    for (uint32_t y = 0; y < rows; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * pitch;
+        uint32_t x = 0;
+        for (; x + 16 <= rowBytes; x += 16) {
+            acc = Accumulate(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), key);
+            key = _mm_add_epi32(key, keyStep);
+        }
+        if (x < rowBytes) {
+            alignas(16) uint8_t tail[16] = {};
+            memcpy(tail, row + x, rowBytes - x);
+            acc = Accumulate(acc, _mm_load_si128(reinterpret_cast<const __m128i*>(tail)), key);
+            key = _mm_add_epi32(key, keyStep);
+        }
+    }
+
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+
+    // Final avalanche, as HashBytes does
+    uint64_t h = lanes[0] ^ ((lanes[1] << 31) | (lanes[1] >> 33));
+    h ^= h >> 32;
+    h *= kMul;
+    h ^= h >> 29;
+    return h;
+}
+
+#else
+
+uint64_t HashTile(const uint8_t* pixels, uint32_t pitch, uint32_t rowBytes, uint32_t rows) {
+    uint64_t h = rows * kMul;
+    for (uint32_t y = 0; y < rows; ++y) {
+        h = HashBytes(pixels + static_cast<size_t>(y) * pitch, rowBytes, h);
+    }
+    return h;
+}
+
+#endif
+
+} // namespace
+
+// ============================================================================
+// TileHasher Implementation
+// ============================================================================
+
+void TileHasher::Reset() {
+    std::fill(m_valid.begin(), m_valid.end(), static_cast<uint8_t>(0));
+}
+
+void TileHasher::Invalidate(const RECT* rects, uint32_t count) {
+    RECT bounds = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+    for (uint32_t i = 0; i < count; ++i) {
+        RECT area;
+        if (!RectIntersect(area, rects[i], bounds)) {
+            continue;
+        }
+
+        uint32_t tx1 = (area.right + kTileWidth - 1) / kTileWidth;
+        uint32_t ty1 = (area.bottom + kTileHeight - 1) / kTileHeight;
+        for (uint32_t ty = area.top / kTileHeight; ty < ty1; ++ty) {
+            for (uint32_t tx = area.left / kTileWidth; tx < tx1; ++tx) {
+                m_valid[ty * m_tilesX + tx] = 0;
+            }
+        }
+    }
+}
+
+uint32_t TileHasher::Compare(const uint8_t* pixels, uint32_t pitch, uint32_t width, uint32_t height,
+                             uint32_t bpp, RECT* changed, uint32_t maxRects) {
+    if (!pixels || width == 0 || height == 0) {
+        return 0;
+    }
+
+    if (width != m_width || height != m_height || bpp != m_bpp) {
+        m_width = width;
+        m_height = height;
+        m_bpp = bpp;
+        m_tilesX = (width + kTileWidth - 1) / kTileWidth;
+        m_tilesY = (height + kTileHeight - 1) / kTileHeight;
+        m_hashes.assign(static_cast<size_t>(m_tilesX) * m_tilesY, 0);
+        m_valid.assign(m_hashes.size(), 0);
+    }
+
+    uint32_t bytesPerPixel = (bpp + 7) / 8;
+    m_runs.clear();
+
+    // Runs of changed tiles along each tile row; a run spanning the same
+    // columns as one ending on the row above extends that one down
+    for (uint32_t ty = 0; ty < m_tilesY; ++ty) {
+        uint32_t y0 = ty * kTileHeight;
+        uint32_t rows = (std::min)(kTileHeight, height - y0);
+        size_t rowStart = m_runs.size();
+
+        uint32_t runStart = UINT32_MAX;
+        for (uint32_t tx = 0; tx <= m_tilesX; ++tx) {
+            bool tileChanged = false;
+            if (tx < m_tilesX) {
+                uint32_t x0 = tx * kTileWidth;
+                uint32_t columns = (std::min)(kTileWidth, width - x0);
+                uint64_t hash = HashTile(pixels + static_cast<size_t>(y0) * pitch + x0 * bytesPerPixel,
+                                         pitch, columns * bytesPerPixel, rows);
+
+                size_t index = static_cast<size_t>(ty) * m_tilesX + tx;
+                tileChanged = !m_valid[index] || m_hashes[index] != hash;
+                m_hashes[index] = hash;
+                m_valid[index] = 1;
+            }
+
+            if (tileChanged && runStart == UINT32_MAX) {
+                runStart = tx;
+            } else if (!tileChanged && runStart != UINT32_MAX) {
+                RECT run = {
+                    static_cast<LONG>(runStart * kTileWidth), static_cast<LONG>(y0),
+                    static_cast<LONG>((std::min)(tx * kTileWidth, width)), static_cast<LONG>(y0 + rows)
+                };
+
+                bool extended = false;
+                for (size_t i = 0; i < rowStart; ++i) {
+                    RECT& above = m_runs[i];
+                    if (above.left == run.left && above.right == run.right && above.bottom == run.top) {
+                        above.bottom = run.bottom;
+                        extended = true;
+                        break;
+                    }
+                }
+                if (!extended) {
+                    m_runs.push_back(run);
+                }
+                runStart = UINT32_MAX;
+            }
+        }
+    }
+
+    if (m_runs.size() <= maxRects) {
+        std::copy(m_runs.begin(), m_runs.end(), changed);
+        return static_cast<uint32_t>(m_runs.size());
+    }
+
+    RECT bounds = m_runs[0];
+    for (const RECT& run : m_runs) {
+        bounds.left = (std::min)(bounds.left, run.left);
+        bounds.top = (std::min)(bounds.top, run.top);
+        bounds.right = (std::max)(bounds.right, run.right);
+        bounds.bottom = (std::max)(bounds.bottom, run.bottom);
+    }
+    changed[0] = bounds;
+    return 1;
+}
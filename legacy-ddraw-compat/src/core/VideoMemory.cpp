@@ -0,0 +1,101 @@
+/**
+ * @file VideoMemory.cpp
+ * @brief Emulated video memory accounting implementation
+ */
+
+#include "core/VideoMemory.h"
+
+using namespace ldc;
+using namespace ldc::core;
+
+// ============================================================================
+// VideoMemoryTracker Implementation
+// ============================================================================
+
+VideoMemoryTracker::VideoMemoryTracker(uint64_t budgetBytes)
+    : m_budget(budgetBytes)
+    , m_used(0)
+{
+    m_stats.budget = budgetBytes;
+}
+
+bool VideoMemoryTracker::Reserve(SurfaceClass surfaceClass, uint64_t bytes) {
+    size_t index = static_cast<size_t>(surfaceClass);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (surfaceClass != SurfaceClass::SystemMemory) {
+        if (bytes > m_budget - m_used) {
+            ++m_stats.failedAllocations;
+            return false;
+        }
+        m_used += bytes;
+    }
+
+    m_stats.bytes[index] += bytes;
+    m_stats.peakBytes[index] = std::max(m_stats.peakBytes[index], m_stats.bytes[index]);
+    ++m_stats.surfaces[index];
+    return true;
+}
+
+void VideoMemoryTracker::Release(SurfaceClass surfaceClass, uint64_t bytes) {
+    size_t index = static_cast<size_t>(surfaceClass);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (surfaceClass != SurfaceClass::SystemMemory) {
+        m_used -= bytes;
+    }
+    m_stats.bytes[index] -= bytes;
+    --m_stats.surfaces[index];
+}
+
+uint64_t VideoMemoryTracker::GetFree() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget - m_used;
+}
+
+VideoMemoryStats VideoMemoryTracker::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void VideoMemoryTracker::LogStats() const {
+    VideoMemoryStats stats = GetStats();
+    DebugLog("VideoMemory: budget %llu bytes, %llu allocations refused",
+             static_cast<unsigned long long>(stats.budget),
+             static_cast<unsigned long long>(stats.failedAllocations));
+
+    for (size_t i = 0; i < kSurfaceClassCount; ++i) {
+        DebugLog("  %-12s %llu surfaces, %llu bytes (peak %llu)",
+                 NameOf(static_cast<SurfaceClass>(i)),
+                 static_cast<unsigned long long>(stats.surfaces[i]),
+                 static_cast<unsigned long long>(stats.bytes[i]),
+                 static_cast<unsigned long long>(stats.peakBytes[i]));
+    }
+}
+
+SurfaceClass VideoMemoryTracker::ClassOf(const DDSCAPS2& caps) {
+    if (caps.dwCaps & DDSCAPS_PRIMARYSURFACE) {
+        return SurfaceClass::Primary;
+    }
+    if (caps.dwCaps & DDSCAPS_SYSTEMMEMORY) {
+        return SurfaceClass::SystemMemory;
+    }
+    if (caps.dwCaps & DDSCAPS_OVERLAY) {
+        return SurfaceClass::Overlay;
+    }
+    if (caps.dwCaps & (DDSCAPS_BACKBUFFER | DDSCAPS_FLIP)) {
+        return SurfaceClass::BackBuffer;
+    }
+    return SurfaceClass::Offscreen;
+}
+
+const char* VideoMemoryTracker::NameOf(SurfaceClass surfaceClass) {
+    switch (surfaceClass) {
+        case SurfaceClass::Primary:      return "primary";
+        case SurfaceClass::BackBuffer:   return "back buffer";
+        case SurfaceClass::Offscreen:    return "offscreen";
+        case SurfaceClass::Overlay:      return "overlay";
+        case SurfaceClass::SystemMemory: return "system";
+        default:                         return "unknown";
+    }
+}
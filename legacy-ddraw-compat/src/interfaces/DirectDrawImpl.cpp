@@ -4,8 +4,17 @@
  */
 
 #include "interfaces/DirectDrawImpl.h"
+#include "interfaces/PaletteImpl.h"
 #include "interfaces/SurfaceImpl.h"
 #include "core/Common.h"
+#include "core/BlitQueue.h"
+#include "core/DeviceContext.h"
+#include "core/DeviceLock.h"
+#include "core/SurfaceAllocator.h"
+#include "core/SurfaceCompressor.h"
+#include "core/TileExecutor.h"
+#include "core/VideoMemory.h"
+#include "config/Config.h"
 
 using namespace ldc;
 using namespace ldc::interfaces;
@@ -26,13 +35,200 @@ DirectDrawImpl::DirectDrawImpl()
     , m_displayRefresh(0)
     , m_displayModeChanged(false)
     , m_primarySurface(nullptr)
+    , m_device(std::make_shared<DeviceContext>())
 {
     DebugLog("DirectDrawImpl created");
+
+    // Settings are read once, by the first DirectDraw object
+    if (!config::ConfigManager::Instance().IsLoaded()) {
+        config::ConfigManager::Instance().LoadFromExecutableDirectory();
+    }
+    core::SurfaceAllocator::Instance().SetAlignment(
+        static_cast<uint32_t>(config::GetConfig().surfaceAlignment));
+    core::SurfaceAllocator::Instance().SetPageBacking(
+        static_cast<size_t>(config::GetConfig().pagedSurfaceKb) * 1024,
+        config::GetConfig().largePages);
+
+    m_videoMemory = std::make_unique<core::VideoMemoryTracker>(
+        static_cast<uint64_t>(config::GetConfig().videoMemoryMb) * 1024 * 1024);
+
+    // Deduplication passes hash and compare whole surfaces, so they run
+    // on the compressor thread too rather than in the game's presents
+    bool compress = config::GetConfig().compressIdleSeconds > 0;
+    if (compress || config::GetConfig().dedupSurfaces) {
+        m_surfaceCompressor = std::make_unique<core::SurfaceCompressor>(
+            static_cast<uint32_t>(config::GetConfig().compressIdleSeconds) * 1000,
+            static_cast<uint64_t>(config::GetConfig().compressBudgetMb) * 1024 * 1024,
+            [this, compress](core::SurfaceCompressor& compressor) {
+                MaybeDeduplicateSurfaces();
+                if (compress) {
+                    CompressIdleSurfaces(compressor);
+                }
+            });
+    }
 }
 
 DirectDrawImpl::~DirectDrawImpl() {
     DebugLog("DirectDrawImpl destroyed");
     m_primarySurface = nullptr;
+
+    // Stops the scan thread before the surface list goes away
+    m_surfaceCompressor.reset();
+
+    // Surfaces the game leaked must not call back into us
+    {
+        std::lock_guard<std::mutex> lock(m_surfacesMutex);
+        for (SurfaceImpl* surface : m_surfaces) {
+            surface->DetachParent();
+        }
+        m_surfaces.clear();
+    }
+
+    // Joins the workers once every recorded blit has run
+    m_blitQueue.reset();
+    m_tileExecutor.reset();
+
+    m_videoMemory->LogStats();
+    core::SurfaceAllocator::Instance().LogStats();
+}
+
+core::BlitQueue& DirectDrawImpl::GetBlitQueue() {
+    std::call_once(m_blitQueueOnce, [this] {
+        m_blitQueue = std::make_unique<core::BlitQueue>(
+            static_cast<uint32_t>(config::GetConfig().blitThreads));
+    });
+    return *m_blitQueue;
+}
+
+void DirectDrawImpl::RegisterSurface(SurfaceImpl* surface) {
+    std::lock_guard<std::mutex> lock(m_surfacesMutex);
+    m_surfaces.push_back(surface);
+    ++m_surfacesCreatedSinceDedup;
+}
+
+void DirectDrawImpl::UnregisterSurface(SurfaceImpl* surface) {
+    std::lock_guard<std::mutex> lock(m_surfacesMutex);
+    auto it = std::find(m_surfaces.begin(), m_surfaces.end(), surface);
+    if (it != m_surfaces.end()) {
+        *it = m_surfaces.back();
+        m_surfaces.pop_back();
+    }
+}
+
+void DirectDrawImpl::MaybeDeduplicateSurfaces() {
+    // Passes only follow surface creation, at most every few seconds.
+    // Called on the compressor thread, the only one touching m_lastDedupTick.
+    const ULONGLONG kDedupIntervalMs = 5000;
+
+    if (!config::GetConfig().dedupSurfaces || m_surfacesCreatedSinceDedup == 0) {
+        return;
+    }
+    ULONGLONG now = GetTickCount64();
+    if (now - m_lastDedupTick < kDedupIntervalMs) {
+        return;
+    }
+    m_lastDedupTick = now;
+    DeduplicateSurfaces();
+}
+
+size_t DirectDrawImpl::DeduplicateSurfaces() {
+    // Contents untouched this long are treated as loaded assets
+    const ULONGLONG kIdleMs = 2000;
+
+    std::lock_guard<std::mutex> lock(m_surfacesMutex);
+
+    ULONGLONG now = GetTickCount64();
+    bool unsettled = false;
+    size_t merged = 0;
+    uint64_t bytesMerged = 0;
+
+    std::unordered_map<uint64_t, std::vector<SurfaceImpl*>> byHash;
+    for (SurfaceImpl* surface : m_surfaces) {
+        if (!surface->IsDedupCandidate(now, 0)) {
+            continue;
+        }
+        if (!surface->IsDedupCandidate(now, kIdleMs)) {
+            unsettled = true;
+            continue;
+        }
+
+        // Equal hashes are confirmed byte for byte before sharing
+        std::vector<SurfaceImpl*>& group = byHash[surface->GetContentHash()];
+        auto match = std::find_if(group.begin(), group.end(), [&](SurfaceImpl* other) {
+            return other->SharesStorageWith(*surface) || other->HasSameContents(*surface);
+        });
+
+        if (match == group.end()) {
+            group.push_back(surface);
+        } else if (!(*match)->SharesStorageWith(*surface)) {
+            // A write that raced the comparison leaves both as they are
+            if (surface->ShareStorageWith(**match)) {
+                bytesMerged += static_cast<uint64_t>(surface->GetPitch()) * surface->GetHeight();
+                ++merged;
+            } else {
+                unsettled = true;
+            }
+        }
+    }
+
+    // Surfaces still being written get another look on a later pass
+    if (!unsettled) {
+        m_surfacesCreatedSinceDedup = 0;
+    }
+
+    if (merged > 0) {
+        DebugLog("Deduplicated %zu surfaces, %llu bytes now shared", merged,
+                 static_cast<unsigned long long>(bytesMerged));
+    }
+    return merged;
+}
+
+size_t DirectDrawImpl::CompressIdleSurfaces(core::SurfaceCompressor& compressor) {
+    if (!compressor.IsOverBudget()) {
+        return 0;
+    }
+
+    ULONGLONG now = GetTickCount64();
+    std::vector<std::pair<ULONGLONG, SurfaceImpl*>> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_surfacesMutex);
+        for (SurfaceImpl* surface : m_surfaces) {
+            ULONGLONG lastAccess = surface->GetLastAccessTick();
+            if (now - lastAccess >= compressor.GetIdleMs()) {
+                idle.emplace_back(lastAccess, surface);
+            }
+        }
+    }
+    std::sort(idle.begin(), idle.end());
+
+    size_t compressed = 0;
+    for (const auto& entry : idle) {
+        if (!compressor.IsOverBudget()) {
+            break;
+        }
+
+        // The list is re-checked per surface so creation and release are
+        // only held up for one surface at a time
+        std::lock_guard<std::mutex> lock(m_surfacesMutex);
+        if (std::find(m_surfaces.begin(), m_surfaces.end(), entry.second) == m_surfaces.end()) {
+            continue;
+        }
+        if (entry.second->CompressIfIdle(compressor, now)) {
+            ++compressed;
+        }
+    }
+
+    if (compressed > 0) {
+        DebugLog("Compressed %zu idle surfaces", compressed);
+    }
+    return compressed;
+}
+
+core::TileExecutor& DirectDrawImpl::GetTileExecutor() {
+    std::call_once(m_tileExecutorOnce, [this] {
+        m_tileExecutor = std::make_unique<core::TileExecutor>(0, config::GetConfig().tileThreshold);
+    });
+    return *m_tileExecutor;
 }
 
 // ============================================================================
@@ -115,6 +311,8 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::CreatePalette(
 {
     DebugLog("CreatePalette: flags=0x%08X", dwFlags);
 
+    core::DeviceLockGuard deviceLock(IsMultithreaded());
+
     if (!lplpDDPalette) {
         return DDERR_INVALIDPARAMS;
     }
@@ -123,24 +321,12 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::CreatePalette(
         return CLASS_E_NOAGGREGATION;
     }
 
-    // Update global palette for 8-bit mode
-    if (lpDDColorArray) {
-        for (int i = 0; i < 256; i++) {
-            g_state.palette[i].rgbRed = lpDDColorArray[i].peRed;
-            g_state.palette[i].rgbGreen = lpDDColorArray[i].peGreen;
-            g_state.palette[i].rgbBlue = lpDDColorArray[i].peBlue;
-            g_state.palette[i].rgbReserved = 0;
-            g_state.palette32[i] = 0xFF000000 |
-                (lpDDColorArray[i].peRed << 16) |
-                (lpDDColorArray[i].peGreen << 8) |
-                lpDDColorArray[i].peBlue;
-        }
-        g_state.paletteChanged = true;
+    if (PaletteImpl::GetEntryCountForCaps(dwFlags) == 0 || !lpDDColorArray) {
+        return DDERR_INVALIDPARAMS;
     }
 
-    // Palette not fully implemented as separate object
-    *lplpDDPalette = nullptr;
-    return DDERR_UNSUPPORTED;
+    *lplpDDPalette = new PaletteImpl(m_device, dwFlags, lpDDColorArray);
+    return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE DirectDrawImpl::CreateSurface(
@@ -150,6 +336,8 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::CreateSurface(
 {
     DebugLog("CreateSurface called");
 
+    core::DeviceLockGuard deviceLock(IsMultithreaded());
+
     if (!lpDDSurfaceDesc || !lplpDDSurface) {
         return DDERR_INVALIDPARAMS;
     }
@@ -168,6 +356,10 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::CreateSurface(
     // Create the surface
     try {
         auto* surface = new SurfaceImpl(this, *lpDDSurfaceDesc);
+        if (!surface->FitsInVideoMemory()) {
+            surface->Release();
+            return DDERR_OUTOFVIDEOMEMORY;
+        }
 
         // Check if this is a primary surface
         if (surface->IsPrimary()) {
@@ -176,7 +368,13 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::CreateSurface(
                      surface->GetWidth(), surface->GetHeight(), surface->GetBpp());
 
             // Initialize render target
-            CreateRenderTarget(surface->GetWidth(), surface->GetHeight(), surface->GetBpp());
+            CreateRenderTarget(*m_device, surface->GetWidth(), surface->GetHeight(), surface->GetBpp(),
+                               config::GetConfig().GetRendererType());
+            SetFrameSkipping(*m_device, config::GetConfig().skipUnchanged);
+            if (config::GetConfig().frameExport) {
+                EnableFrameExport(*m_device, config::GetConfig().frameExportName,
+                                  static_cast<DWORD>(config::GetConfig().frameExportSlots));
+            }
         } else {
             DebugLog("Created surface %ux%u %ubpp",
                       surface->GetWidth(), surface->GetHeight(), surface->GetBpp());
@@ -201,12 +399,42 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::DuplicateSurface(
 {
     DebugLog("DuplicateSurface called");
 
+    core::DeviceLockGuard deviceLock(IsMultithreaded());
+
     if (!lpDDSurface || !lplpDupDDSurface) {
         return DDERR_INVALIDPARAMS;
     }
 
     *lplpDupDDSurface = nullptr;
-    return DDERR_UNSUPPORTED;
+
+    // Storage of the primary, flip chains and overlays is tied to the display
+    SurfaceImpl* source = static_cast<SurfaceImpl*>(lpDDSurface);
+    if (source->IsPrimary() || source->IsOverlay() || source->GetNextInFlipChain()) {
+        return DDERR_CANTDUPLICATE;
+    }
+
+    DDSURFACEDESC2 desc{};
+    source->GetSurfaceDesc(&desc);
+
+    // The duplicate shares the source's pixels until either side is written
+    HRESULT hr = source->PrepareAccess();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    try {
+        auto* duplicate = new SurfaceImpl(this, desc, source);
+        if (!duplicate->FitsInVideoMemory()) {
+            duplicate->Release();
+            return DDERR_OUTOFVIDEOMEMORY;
+        }
+        *lplpDupDDSurface = duplicate;
+        return DD_OK;
+    }
+    catch (const std::bad_alloc&) {
+        DebugLog("DuplicateSurface: out of memory");
+        return DDERR_OUTOFMEMORY;
+    }
 }
 
 HRESULT STDMETHODCALLTYPE DirectDrawImpl::EnumDisplayModes(
@@ -433,6 +661,8 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::Initialize(GUID* lpGUID) {
 
 HRESULT STDMETHODCALLTYPE DirectDrawImpl::RestoreDisplayMode() {
     DebugLog("RestoreDisplayMode called");
+    core::DeviceLockGuard deviceLock(IsMultithreaded());
+
     m_displayModeChanged = false;
     return DD_OK;
 }
@@ -440,14 +670,22 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::RestoreDisplayMode() {
 HRESULT STDMETHODCALLTYPE DirectDrawImpl::SetCooperativeLevel(HWND hWnd, DWORD dwFlags) {
     DebugLog("SetCooperativeLevel: hWnd=%p flags=0x%08X", hWnd, dwFlags);
 
+    // Only games that ask for it pay for serialising their calls
+    bool multithreaded = (dwFlags & DDSCL_MULTITHREADED) != 0;
+    core::DeviceLockGuard deviceLock(multithreaded || IsMultithreaded());
+    if (multithreaded != IsMultithreaded()) {
+        DebugLog("SetCooperativeLevel: multithreaded mode %s", multithreaded ? "on" : "off");
+        m_multithreaded.store(multithreaded, std::memory_order_relaxed);
+    }
+
     m_hWnd = hWnd;
     m_coopFlags = dwFlags;
-    g_state.hWnd = hWnd;
-    g_state.coopLevel = dwFlags;
+    m_device->window.hWnd = hWnd;
+    m_device->window.coopLevel = dwFlags;
 
     // Subclass window for mouse coordinate transformation
     if (hWnd) {
-        SubclassWindow(hWnd);
+        SubclassWindow(*m_device, hWnd);
     }
 
     return DD_OK;
@@ -463,6 +701,8 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::SetDisplayMode(
     DebugLog("SetDisplayMode: %ux%u %ubpp %uHz flags=0x%08X",
              dwWidth, dwHeight, dwBPP, dwRefreshRate, dwFlags);
 
+    core::DeviceLockGuard deviceLock(IsMultithreaded());
+
     if (dwWidth == 0 || dwHeight == 0 || dwBPP == 0) {
         return DDERR_INVALIDMODE;
     }
@@ -473,11 +713,11 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::SetDisplayMode(
     m_displayRefresh = dwRefreshRate;
     m_displayModeChanged = true;
 
-    g_state.gameWidth = dwWidth;
-    g_state.gameHeight = dwHeight;
-    g_state.gameBpp = dwBPP;
-    g_state.gameRefresh = dwRefreshRate;
-    g_state.displayModeSet = true;
+    m_device->game.width = dwWidth;
+    m_device->game.height = dwHeight;
+    m_device->game.bpp = dwBPP;
+    m_device->game.refresh = dwRefreshRate;
+    m_device->game.displayModeSet = true;
 
     // Resize window to match game resolution
     if (m_hWnd) {
@@ -487,7 +727,7 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::SetDisplayMode(
                      windowRect.right - windowRect.left,
                      windowRect.bottom - windowRect.top,
                      SWP_NOMOVE | SWP_NOZORDER);
-        UpdateScaling();
+        UpdateScaling(*m_device);
     }
 
     return DD_OK;
@@ -497,6 +737,9 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::WaitForVerticalBlank(DWORD dwFlags, HA
     LDC_UNUSED(dwFlags);
     LDC_UNUSED(hEvent);
     Sleep(1);
+
+    // Palette fades wait here between steps; show what they queued
+    FlushPaletteChanges(*m_device, true);
     return DD_OK;
 }
 
@@ -506,9 +749,12 @@ HRESULT STDMETHODCALLTYPE DirectDrawImpl::GetAvailableVidMem(
     LPDWORD lpdwTotal,
     LPDWORD lpdwFree)
 {
-    LDC_UNUSED(lpDDSCaps);
-    if (lpdwTotal) *lpdwTotal = 64 * 1024 * 1024;
-    if (lpdwFree) *lpdwFree = 64 * 1024 * 1024;
+    // Everything the game can place in video memory shares one budget
+    if (lpDDSCaps && (lpDDSCaps->dwCaps & DDSCAPS_SYSTEMMEMORY)) {
+        return DDERR_INVALIDCAPS;
+    }
+    if (lpdwTotal) *lpdwTotal = static_cast<DWORD>(m_videoMemory->GetTotal());
+    if (lpdwFree) *lpdwFree = static_cast<DWORD>(m_videoMemory->GetFree());
     return DD_OK;
 }
 
@@ -563,12 +809,21 @@ void DirectDrawImpl::FillCaps(LPDDCAPS pCaps) {
     pCaps->dwSize = sizeof(DDCAPS);
     pCaps->dwCaps = DDCAPS_BLT | DDCAPS_BLTCOLORFILL |
                     DDCAPS_BLTSTRETCH | DDCAPS_COLORKEY |
-                    DDCAPS_PALETTE;
+                    DDCAPS_PALETTE | DDCAPS_OVERLAY |
+                    DDCAPS_OVERLAYSTRETCH | DDCAPS_BLTQUEUE;
     pCaps->dwCaps2 = DDCAPS2_PRIMARYGAMMA;
-    pCaps->dwVidMemTotal = 64 * 1024 * 1024;
-    pCaps->dwVidMemFree = 64 * 1024 * 1024;
+    pCaps->dwCKeyCaps = DDCKEYCAPS_SRCBLT | DDCKEYCAPS_DESTBLT |
+                        DDCKEYCAPS_SRCOVERLAY | DDCKEYCAPS_DESTOVERLAY;
+
+    // Overlays are composited in software, so any count and stretch works
+    pCaps->dwMaxVisibleOverlays = 16;
+    pCaps->dwCurrVisibleOverlays = m_primarySurface ? m_primarySurface->GetVisibleOverlayCount() : 0;
+    pCaps->dwMinOverlayStretch = 1;
+    pCaps->dwMaxOverlayStretch = 32000;
+    pCaps->dwVidMemTotal = static_cast<DWORD>(m_videoMemory->GetTotal());
+    pCaps->dwVidMemFree = static_cast<DWORD>(m_videoMemory->GetFree());
     pCaps->ddsCaps.dwCaps = DDSCAPS_BACKBUFFER | DDSCAPS_FLIP |
-                            DDSCAPS_OFFSCREENPLAIN | DDSCAPS_PALETTE |
+                            DDSCAPS_OFFSCREENPLAIN | DDSCAPS_OVERLAY | DDSCAPS_PALETTE |
                             DDSCAPS_PRIMARYSURFACE | DDSCAPS_SYSTEMMEMORY |
                             DDSCAPS_VIDEOMEMORY;
 }
@@ -0,0 +1,64 @@
+/**
+ * @file GammaControlImpl.cpp
+ * @brief IDirectDrawGammaControl interface implementation
+ */
+
+#include "interfaces/GammaControlImpl.h"
+#include "core/Common.h"
+#include "core/DeviceContext.h"
+
+using namespace ldc;
+using namespace ldc::interfaces;
+
+// ============================================================================
+// GammaControlImpl Implementation
+// ============================================================================
+
+GammaControlImpl::GammaControlImpl(IUnknown& owner, std::shared_ptr<DeviceContext> device)
+    : m_owner(owner)
+    , m_device(std::move(device))
+{
+}
+
+// ============================================================================
+// IUnknown Methods
+// ============================================================================
+
+HRESULT STDMETHODCALLTYPE GammaControlImpl::QueryInterface(REFIID riid, void** ppvObj) {
+    return m_owner.QueryInterface(riid, ppvObj);
+}
+
+ULONG STDMETHODCALLTYPE GammaControlImpl::AddRef() {
+    return m_owner.AddRef();
+}
+
+ULONG STDMETHODCALLTYPE GammaControlImpl::Release() {
+    return m_owner.Release();
+}
+
+// ============================================================================
+// IDirectDrawGammaControl Methods
+// ============================================================================
+
+HRESULT STDMETHODCALLTYPE GammaControlImpl::GetGammaRamp(DWORD dwFlags, LPDDGAMMARAMP lpRampData) {
+    LDC_UNUSED(dwFlags);
+
+    if (!lpRampData) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    ldc::GetGammaRamp(*m_device, *lpRampData);
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE GammaControlImpl::SetGammaRamp(DWORD dwFlags, LPDDGAMMARAMP lpRampData) {
+    // There is no calibrator to run the ramp through
+    LDC_UNUSED(dwFlags);
+
+    if (!lpRampData) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    ldc::SetGammaRamp(*m_device, *lpRampData);
+    return DD_OK;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file PaletteImpl.cpp
+ * @brief IDirectDrawPalette interface implementation
+ */
+
+#include "interfaces/PaletteImpl.h"
+#include "core/Common.h"
+#include "core/DeviceContext.h"
+
+using namespace ldc;
+using namespace ldc::interfaces;
+
+// ============================================================================
+// PaletteImpl Implementation
+// ============================================================================
+
+PaletteImpl::PaletteImpl(std::shared_ptr<DeviceContext> device, DWORD caps, const PALETTEENTRY* entries)
+    : m_refCount(1)
+    , m_device(std::move(device))
+    , m_caps(caps)
+    , m_entryCount(GetEntryCountForCaps(caps))
+    , m_version(0)
+{
+    DebugLog("PaletteImpl created: caps=0x%08X, %u entries", caps, m_entryCount);
+
+    if (entries) {
+        memcpy(m_entries, entries, m_entryCount * sizeof(PALETTEENTRY));
+    }
+    for (DWORD i = 0; i < m_entryCount; ++i) {
+        UpdateSlot(i);
+    }
+}
+
+PaletteImpl::~PaletteImpl() {
+    DebugLog("PaletteImpl destroyed");
+}
+
+DWORD PaletteImpl::GetEntryCountForCaps(DWORD caps) {
+    switch (caps & (DDPCAPS_1BIT | DDPCAPS_2BIT | DDPCAPS_4BIT | DDPCAPS_8BIT)) {
+        case DDPCAPS_1BIT: return 2;
+        case DDPCAPS_2BIT: return 4;
+        case DDPCAPS_4BIT: return 16;
+        case DDPCAPS_8BIT: return 256;
+        default:           return 0;
+    }
+}
+
+void PaletteImpl::UpdateSlot(DWORD index) {
+    const PALETTEENTRY& entry = m_entries[index];
+    m_lut[index] = 0xFF000000 | (entry.peRed << 16) | (entry.peGreen << 8) | entry.peBlue;
+    m_colorTable[index].rgbRed = entry.peRed;
+    m_colorTable[index].rgbGreen = entry.peGreen;
+    m_colorTable[index].rgbBlue = entry.peBlue;
+    m_colorTable[index].rgbReserved = 0;
+}
+
+// ============================================================================
+// IUnknown Methods
+// ============================================================================
+
+HRESULT STDMETHODCALLTYPE PaletteImpl::QueryInterface(REFIID riid, void** ppvObj) {
+    if (!ppvObj) {
+        return E_POINTER;
+    }
+
+    *ppvObj = nullptr;
+
+    if (riid == IID_IUnknown || riid == IID_IDirectDrawPalette) {
+        AddRef();
+        *ppvObj = static_cast<IDirectDrawPalette*>(this);
+        return S_OK;
+    }
+
+    return E_NOINTERFACE;
+}
+
+ULONG STDMETHODCALLTYPE PaletteImpl::AddRef() {
+    return ++m_refCount;
+}
+
+ULONG STDMETHODCALLTYPE PaletteImpl::Release() {
+    ULONG count = --m_refCount;
+    if (count == 0) {
+        delete this;
+    }
+    return count;
+}
+
+// ============================================================================
+// IDirectDrawPalette Methods
+// ============================================================================
+
+HRESULT STDMETHODCALLTYPE PaletteImpl::GetCaps(LPDWORD lpdwCaps) {
+    if (!lpdwCaps) {
+        return DDERR_INVALIDPARAMS;
+    }
+    *lpdwCaps = m_caps;
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE PaletteImpl::GetEntries(
+    DWORD dwFlags,
+    DWORD dwBase,
+    DWORD dwNumEntries,
+    LPPALETTEENTRY lpEntries)
+{
+    LDC_UNUSED(dwFlags);
+
+    if (!lpEntries || dwBase >= m_entryCount || dwNumEntries > m_entryCount - dwBase) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+    memcpy(lpEntries, m_entries + dwBase, dwNumEntries * sizeof(PALETTEENTRY));
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE PaletteImpl::Initialize(
+    LPDIRECTDRAW lpDD,
+    DWORD dwFlags,
+    LPPALETTEENTRY lpDDColorTable)
+{
+    LDC_UNUSED(lpDD);
+    LDC_UNUSED(dwFlags);
+    LDC_UNUSED(lpDDColorTable);
+    return DDERR_ALREADYINITIALIZED;
+}
+
+HRESULT STDMETHODCALLTYPE PaletteImpl::SetEntries(
+    DWORD dwFlags,
+    DWORD dwStartingEntry,
+    DWORD dwCount,
+    LPPALETTEENTRY lpEntries)
+{
+    LDC_UNUSED(dwFlags);
+
+    if (!lpEntries || dwStartingEntry >= m_entryCount || dwCount > m_entryCount - dwStartingEntry) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+
+    // Palette animation rewrites whole ranges where only a few colours move;
+    // derive tables only for the entries that differ
+    bool changed = false;
+    for (DWORD i = 0; i < dwCount; ++i) {
+        DWORD index = dwStartingEntry + i;
+        const PALETTEENTRY& entry = lpEntries[i];
+        PALETTEENTRY& current = m_entries[index];
+        if (current.peRed == entry.peRed && current.peGreen == entry.peGreen &&
+            current.peBlue == entry.peBlue && current.peFlags == entry.peFlags) {
+            continue;
+        }
+        current = entry;
+        UpdateSlot(index);
+        changed = true;
+    }
+
+    if (!changed) {
+        return DD_OK;
+    }
+    m_version.fetch_add(1, std::memory_order_release);
+
+    // Changes on the primary show at the next vertical blank, as on hardware
+    if (m_device->present.paletteLut == m_lut) {
+        m_device->game.paletteChanges.fetch_add(1);
+        m_device->game.paletteChanged = true;
+        FlushPaletteChanges(*m_device, false);
+    }
+
+    return DD_OK;
+}
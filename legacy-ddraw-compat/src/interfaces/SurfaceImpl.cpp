@@ -5,18 +5,91 @@
 
 #include "interfaces/SurfaceImpl.h"
 #include "interfaces/DirectDrawImpl.h"
+#include "interfaces/GammaControlImpl.h"
+#include "interfaces/PaletteImpl.h"
 #include "core/Common.h"
+#include "core/OverlayCompositor.h"
+#include "core/Presenter.h"
+#include "core/BlitQueue.h"
+#include "core/DeviceContext.h"
+#include "core/DeviceLock.h"
+#include "core/TileExecutor.h"
+#include "core/Hash.h"
+#include "core/SurfaceCompressor.h"
+#include "config/Config.h"
 
 using namespace ldc;
 using namespace ldc::interfaces;
 
+namespace {
+
+// Locks a destination exclusively and a source shared, in address order
+// so two threads blitting between the same pair of surfaces cannot deadlock
+class PairLockGuard {
+public:
+    PairLockGuard(core::RWLock& dst, core::RWLock* src) : m_dst(dst), m_src(src) {
+        if (m_src && m_src < &m_dst) {
+            m_src->LockShared();
+            m_dst.Lock();
+        } else {
+            m_dst.Lock();
+            if (m_src) {
+                m_src->LockShared();
+            }
+        }
+    }
+
+    ~PairLockGuard() {
+        m_dst.Unlock();
+        if (m_src) {
+            m_src->UnlockShared();
+        }
+    }
+
+    PairLockGuard(const PairLockGuard&) = delete;
+    PairLockGuard& operator=(const PairLockGuard&) = delete;
+
+private:
+    core::RWLock& m_dst;
+    core::RWLock* m_src;
+};
+
+// Marks a blit as started on its destination and source until it has been
+// queued or executed, so a racing Lock can wait for it
+class BltStartGuard {
+public:
+    BltStartGuard(std::atomic<uint32_t>& dst, std::atomic<uint32_t>* src) : m_dst(dst), m_src(src) {
+        m_dst.fetch_add(1);
+        if (m_src) {
+            m_src->fetch_add(1);
+        }
+    }
+
+    ~BltStartGuard() {
+        m_dst.fetch_sub(1, std::memory_order_release);
+        if (m_src) {
+            m_src->fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    BltStartGuard(const BltStartGuard&) = delete;
+    BltStartGuard& operator=(const BltStartGuard&) = delete;
+
+private:
+    std::atomic<uint32_t>& m_dst;
+    std::atomic<uint32_t>* m_src;
+};
+
+} // namespace
+
 // ============================================================================
 // SurfaceImpl Implementation
 // ============================================================================
 
-SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc)
+SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc, SurfaceImpl* shareFrom)
     : m_refCount(1)
     , m_parent(parent)
+    , m_device(parent->GetDeviceContext())
     , m_width(0)
     , m_height(0)
     , m_bpp(0)
@@ -25,20 +98,37 @@ SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc)
     , m_pixelFormat{}
     , m_flags(0)
     , m_backBuffer(nullptr)
+    , m_flipFront(nullptr)
     , m_palette(nullptr)
     , m_clipper(nullptr)
-    , m_locked(false)
+    , m_lockState(kUnlocked)
     , m_lockedRect{}
     , m_srcColorKey{}
     , m_destColorKey{}
     , m_hasSrcColorKey(false)
     , m_hasDestColorKey(false)
+    , m_srcOverlayKey{}
+    , m_destOverlayKey{}
+    , m_hasSrcOverlayKey(false)
+    , m_hasDestOverlayKey(false)
+    , m_overlayDest(nullptr)
+    , m_overlaySrcRect{}
+    , m_overlayDestRect{}
+    , m_overlayVisible(false)
     , m_hDC(nullptr)
-    , m_hBitmap(nullptr)
-    , m_hBitmapOld(nullptr)
     , m_uniquenessValue(0)
     , m_priority(0)
     , m_lod(0)
+    , m_pageLockCount(0)
+    , m_writeCount(0)
+    , m_lastWriteTick(GetTickCount64())
+    , m_contentHash(0)
+    , m_hashedWriteCount(UINT64_MAX)
+    , m_lastAccessTick(GetTickCount64())
+    , m_unpackedSize(0)
+    , m_memoryClass(core::SurfaceClass::Offscreen)
+    , m_memoryCharge(0)
+    , m_memoryCharged(false)
 {
     DebugLog("SurfaceImpl creating surface");
 
@@ -52,13 +142,13 @@ SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc)
     if (desc.dwFlags & DDSD_WIDTH) {
         m_width = desc.dwWidth;
     } else if (IsPrimary()) {
-        m_width = g_state.gameWidth;
+        m_width = m_device->game.width;
     }
 
     if (desc.dwFlags & DDSD_HEIGHT) {
         m_height = desc.dwHeight;
     } else if (IsPrimary()) {
-        m_height = g_state.gameHeight;
+        m_height = m_device->game.height;
     }
 
     // Determine pixel format
@@ -66,7 +156,17 @@ SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc)
         m_pixelFormat = desc.ddpfPixelFormat;
         m_bpp = desc.ddpfPixelFormat.dwRGBBitCount;
     } else if (IsPrimary()) {
-        m_bpp = g_state.gameBpp;
+        m_bpp = m_device->game.bpp;
+    }
+
+    // Overlay color keys supplied at creation
+    if (desc.dwFlags & DDSD_CKSRCOVERLAY) {
+        m_srcOverlayKey = desc.ddckCKSrcOverlay;
+        m_hasSrcOverlayKey = true;
+    }
+    if (desc.dwFlags & DDSD_CKDESTOVERLAY) {
+        m_destOverlayKey = desc.ddckCKDestOverlay;
+        m_hasDestOverlayKey = true;
     }
 
     // Ensure we have valid dimensions and bpp
@@ -74,24 +174,39 @@ SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc)
     if (m_height == 0) m_height = 480;
     if (m_bpp == 0) m_bpp = 8;
 
-    // Calculate pitch (align to 4 bytes)
-    m_pitch = ((m_width * (m_bpp / 8) + 3) / 4) * 4;
+    // Calculate pitch (cache-line aligned for all but the narrowest sprites)
+    m_pitch = core::SurfaceAllocator::Instance().AlignPitch(m_width * (m_bpp / 8), m_bpp / 8);
 
     // Initialize pixel format if not set
     InitializePixelFormat();
 
-    // Allocate pixel data
-    AllocatePixelData();
+    if (!ChargeVideoMemory()) {
+        DebugLog("SurfaceImpl: %ux%u %ubpp surface exceeds the video memory budget",
+                 m_width, m_height, m_bpp);
+        return;
+    }
+
+    // Allocate pixel data, or share the duplicated surface's
+    if (shareFrom) {
+        shareFrom->m_bltFence.WaitIdle();
+        std::lock_guard<std::mutex> storageLock(shareFrom->m_storageMutex);
+        core::SharedLockGuard pixelLock(shareFrom->m_pixelLock);
+        m_pixels = core::SurfaceAllocator::Instance().Share(shareFrom->m_pixels);
+        m_srcColorKey = shareFrom->m_srcColorKey;
+        m_destColorKey = shareFrom->m_destColorKey;
+        m_hasSrcColorKey = shareFrom->m_hasSrcColorKey;
+        m_hasDestColorKey = shareFrom->m_hasDestColorKey;
+    } else {
+        AllocatePixelData();
+    }
+
+    if (m_parent) {
+        m_parent->RegisterSurface(this);
+    }
 
     // Handle back buffer creation for flip chains
     if ((desc.dwFlags & DDSD_BACKBUFFERCOUNT) && desc.dwBackBufferCount > 0) {
-        DDSURFACEDESC2 backDesc = desc;
-        backDesc.ddsCaps.dwCaps = (backDesc.ddsCaps.dwCaps & ~DDSCAPS_PRIMARYSURFACE) | DDSCAPS_BACKBUFFER;
-        backDesc.dwFlags &= ~DDSD_BACKBUFFERCOUNT;
-        backDesc.dwBackBufferCount = 0;
-
-        m_backBuffer = new SurfaceImpl(parent, backDesc);
-        DebugLog("Created back buffer for flip chain");
+        CreateFlipChain(desc);
     }
 
     DebugLog("SurfaceImpl created: %ux%u %ubpp pitch=%u caps=0x%08X",
@@ -101,19 +216,73 @@ SurfaceImpl::SurfaceImpl(DirectDrawImpl* parent, const DDSURFACEDESC2& desc)
 SurfaceImpl::~SurfaceImpl() {
     DebugLog("SurfaceImpl destroyed");
 
-    // Clean up GDI resources
-    if (m_hDC) {
-        if (m_hBitmapOld) {
-            ::SelectObject(m_hDC, m_hBitmapOld);
+    // Queued blits may still read or write our pixels
+    m_bltFence.WaitIdle();
+
+    if (m_parent) {
+        m_parent->UnregisterSurface(this);
+
+        // GetCaps and GetGDISurface must not reach a released primary
+        if (m_parent->GetPrimarySurface() == this) {
+            m_parent->SetPrimarySurface(nullptr);
+        }
+
+        core::SurfaceCompressor* compressor = m_parent->GetSurfaceCompressor();
+        if (compressor && !m_packedPixels.empty()) {
+            compressor->RecordRelease(m_unpackedSize, m_packedPixels.size());
+        }
+
+        if (m_memoryCharged) {
+            m_parent->GetVideoMemory().Release(m_memoryClass, m_memoryCharge);
         }
-        ::DeleteDC(m_hDC);
-        m_hDC = nullptr;
     }
-    if (m_hBitmap) {
-        ::DeleteObject(m_hBitmap);
-        m_hBitmap = nullptr;
+
+    // The presenter may still be reading this chain's storage
+    if (IsPrimary()) {
+        m_device->presenter.Stop();
+
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        m_device->present.presentPixels = nullptr;
+        m_device->present.paletteLut = nullptr;
+    }
+
+    if (m_palette) {
+        m_palette->Release();
+        m_palette = nullptr;
+    }
+
+    core::FenceStats flipStats = m_flipFence.GetStats();
+    core::FenceStats bltStats = m_bltFence.GetStats();
+    if (flipStats.waitCount || bltStats.waitCount) {
+        DebugLog("Surface fence waits: flip %llu (%llu us total, %llu us max), "
+                 "blt %llu (%llu us total, %llu us max)",
+                 static_cast<unsigned long long>(flipStats.waitCount),
+                 static_cast<unsigned long long>(flipStats.totalWaitMicros),
+                 static_cast<unsigned long long>(flipStats.maxWaitMicros),
+                 static_cast<unsigned long long>(bltStats.waitCount),
+                 static_cast<unsigned long long>(bltStats.totalWaitMicros),
+                 static_cast<unsigned long long>(bltStats.maxWaitMicros));
+    }
+
+    // Back buffers the game still holds must not point back at us
+    for (SurfaceImpl* back = m_backBuffer; back; back = back->m_backBuffer) {
+        back->m_flipFront = nullptr;
+    }
+
+    // Take this overlay off its destination, or orphan overlays shown on us
+    DetachOverlay();
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        for (SurfaceImpl* overlay : m_overlays) {
+            overlay->m_overlayDest = nullptr;
+            overlay->m_overlayVisible = false;
+        }
+        m_overlays.clear();
     }
 
+    // The DIB section and its DC, if any, are freed with the storage
+    m_hDC = nullptr;
+
     // Release back buffer
     if (m_backBuffer) {
         m_backBuffer->Release();
@@ -147,32 +316,294 @@ void SurfaceImpl::InitializePixelFormat() {
     }
 }
 
+bool SurfaceImpl::ChargeVideoMemory() {
+    if (!m_parent) {
+        return true;
+    }
+
+    core::VideoMemoryTracker& videoMemory = m_parent->GetVideoMemory();
+    uint64_t bytes = static_cast<uint64_t>(m_pitch) * m_height;
+    m_memoryClass = core::VideoMemoryTracker::ClassOf(m_caps);
+
+    if (!videoMemory.Reserve(m_memoryClass, bytes)) {
+        // Plain offscreen surfaces that did not insist on video memory
+        // are placed in system memory instead of failing
+        if (m_memoryClass != core::SurfaceClass::Offscreen || (m_caps.dwCaps & DDSCAPS_VIDEOMEMORY)) {
+            return false;
+        }
+        m_memoryClass = core::SurfaceClass::SystemMemory;
+        videoMemory.Reserve(m_memoryClass, bytes);
+    }
+
+    m_memoryCharge = bytes;
+    m_memoryCharged = true;
+
+    // Report where the surface ended up, as GetCaps does on real hardware
+    if (m_memoryClass == core::SurfaceClass::SystemMemory) {
+        m_caps.dwCaps |= DDSCAPS_SYSTEMMEMORY;
+    } else {
+        m_caps.dwCaps |= DDSCAPS_VIDEOMEMORY | DDSCAPS_LOCALVIDMEM;
+    }
+    return true;
+}
+
+bool SurfaceImpl::FitsInVideoMemory() const {
+    for (const SurfaceImpl* member = this; member; member = member->m_backBuffer) {
+        if (member->m_parent && !member->m_memoryCharged) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void SurfaceImpl::AllocatePixelData() {
     size_t size = static_cast<size_t>(m_pitch) * m_height;
-    m_pixels.resize(size, 0);
+    m_pixels = core::SurfaceAllocator::Instance().Allocate(size);
     DebugLog("Allocated %zu bytes for surface pixels", size);
 }
 
-void SurfaceImpl::NotifyContentChanged() {
-    // If this is the primary surface, copy to global state and present
+// ============================================================================
+// Flip Chain
+// ============================================================================
+
+void SurfaceImpl::CreateFlipChain(const DDSURFACEDESC2& desc) {
+    // Every buffer must match the front exactly so storage can rotate
+    DDSURFACEDESC2 backDesc = desc;
+    backDesc.dwFlags = (desc.dwFlags & ~DDSD_BACKBUFFERCOUNT) |
+                       DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PIXELFORMAT;
+    backDesc.dwBackBufferCount = 0;
+    backDesc.dwWidth = m_width;
+    backDesc.dwHeight = m_height;
+    backDesc.ddpfPixelFormat = m_pixelFormat;
+
+    DWORD chainCaps = (desc.ddsCaps.dwCaps &
+                       ~(DDSCAPS_PRIMARYSURFACE | DDSCAPS_FRONTBUFFER | DDSCAPS_BACKBUFFER)) |
+                      DDSCAPS_FLIP | DDSCAPS_COMPLEX;
+    m_caps.dwCaps |= DDSCAPS_FRONTBUFFER | DDSCAPS_FLIP | DDSCAPS_COMPLEX;
+
+    // Only the first back buffer carries DDSCAPS_BACKBUFFER
+    SurfaceImpl* prev = this;
+    for (DWORD i = 0; i < desc.dwBackBufferCount; ++i) {
+        backDesc.ddsCaps.dwCaps = chainCaps | (i == 0 ? DDSCAPS_BACKBUFFER : 0);
+
+        SurfaceImpl* back = new SurfaceImpl(m_parent, backDesc);
+        back->m_flipFront = this;
+        prev->m_backBuffer = back;
+        prev = back;
+
+        // The creator releases the whole chain if a buffer did not fit
+        if (!back->m_memoryCharged && m_parent) {
+            break;
+        }
+    }
+
+    DebugLog("Created flip chain with %u back buffers", desc.dwBackBufferCount);
+}
+
+const uint8_t* SurfaceImpl::GetFlipHandBack(SurfaceImpl* pTarget) const {
+    // Storage that becomes the first back buffer's after the flip
+    if (pTarget || !m_backBuffer || !m_backBuffer->m_backBuffer) {
+        return m_pixels.data();
+    }
+    return m_backBuffer->m_backBuffer->m_pixels.data();
+}
+
+bool SurfaceImpl::UsesDeviceLock() const {
+    return m_parent && m_parent->IsMultithreaded();
+}
+
+void SurfaceImpl::WaitForStartingBlts() const {
+    // Only ever a blit on its way into the queue or through ExecuteBlt
+    while (m_bltsStarting.load(std::memory_order_acquire) != 0) {
+        SwitchToThread();
+    }
+}
+
+HRESULT SurfaceImpl::WaitForBlts(bool doNotWait) {
+    if (m_bltFence.IsIdle()) {
+        return DD_OK;
+    }
+    if (doNotWait) {
+        return DDERR_WASSTILLDRAWING;
+    }
+    m_bltFence.WaitIdle();
+    return DD_OK;
+}
+
+void SurfaceImpl::RotateFlipChain(SurfaceImpl* pTarget) {
+    // An explicit target just trades places with the front
+    if (pTarget) {
+        std::swap(m_pixels, pTarget->m_pixels);
+        return;
+    }
+
+    // Storage moves one step towards the front; only pointers change hands
+    core::SurfaceMemory oldFront = std::move(m_pixels);
+    SurfaceImpl* prev = this;
+    for (SurfaceImpl* back = m_backBuffer; back; back = back->m_backBuffer) {
+        prev->m_pixels = std::move(back->m_pixels);
+        prev = back;
+    }
+    prev->m_pixels = std::move(oldFront);
+}
+
+void SurfaceImpl::NotifyContentChanged(const RECT* pRect) {
+    // If this is the primary surface, present it
     if (IsPrimary()) {
-        std::lock_guard<std::recursive_mutex> lock(g_state.renderMutex);
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+
+        // Presenting now supersedes any frame the presenter thread holds;
+        // if one never reached the window, only the whole image catches up
+        bool windowBehind = m_device->presenter.Discard();
+        bool partial = pRect && !windowBehind &&
+                       m_device->present.presentPixels == m_pixels.data();
+
+        if (GetVisibleOverlayCount() > 0) {
+            // Overlays are layered over a copy, never into the primary itself
+            if (m_device->present.primaryPixels.size() == m_pixels.size()) {
+                memcpy(m_device->present.primaryPixels.data(), m_pixels.data(), m_pixels.size());
+            } else {
+                m_device->present.primaryPixels.assign(m_pixels.data(), m_pixels.data() + m_pixels.size());
+            }
 
-        // Copy pixel data to global state
-        if (g_state.primaryPixels.size() == m_pixels.size()) {
-            memcpy(g_state.primaryPixels.data(), m_pixels.data(), m_pixels.size());
+            RECT full = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+            ComposeOverlays(full);
+            m_device->present.presentPixels = m_device->present.primaryPixels.data();
+            partial = false;
         } else {
-            g_state.primaryPixels = m_pixels;
-            g_state.primaryPitch = m_pitch;
+            // Nothing to compose: present straight from the front buffer
+            m_device->present.presentPixels = m_pixels.data();
         }
-
-        // Present to screen
-        PresentPrimaryToScreen();
+        m_device->present.primaryPitch = m_pitch;
+
+        // Present to screen; a change to part of the front buffer only
+        // needs that part shown
+        PresentPrimaryToScreen(*m_device, partial ? pRect : nullptr);
+    } else if (IsOverlay() && m_overlayVisible && m_overlayDest) {
+        // Only the destination area under the change needs recomposing
+        m_overlayDest->RefreshOverlayRegion(GetOverlayDestRegion(pRect));
     }
 
     m_uniquenessValue++;
 }
 
+// ============================================================================
+// Overlay Composition
+// ============================================================================
+
+DWORD SurfaceImpl::GetVisibleOverlayCount() const {
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+
+    DWORD count = 0;
+    for (const SurfaceImpl* overlay : m_overlays) {
+        if (overlay->m_overlayVisible) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void SurfaceImpl::DetachOverlay() {
+    SurfaceImpl* dest = nullptr;
+    RECT oldRegion{};
+    bool wasVisible = false;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        if (!m_overlayDest) {
+            return;
+        }
+
+        dest = m_overlayDest;
+        oldRegion = m_overlayDestRect;
+        wasVisible = m_overlayVisible;
+
+        auto& overlays = dest->m_overlays;
+        overlays.erase(std::remove(overlays.begin(), overlays.end(), this), overlays.end());
+        m_overlayDest = nullptr;
+        m_overlayVisible = false;
+    }
+
+    if (wasVisible) {
+        dest->RefreshOverlayRegion(oldRegion);
+    }
+}
+
+RECT SurfaceImpl::GetOverlayDestRegion(const RECT* pSrcRect) const {
+    if (!pSrcRect) {
+        return m_overlayDestRect;
+    }
+    return core::MapOverlayRect(*pSrcRect, m_overlaySrcRect, m_overlayDestRect);
+}
+
+void SurfaceImpl::RefreshOverlayRegion(const RECT& region) {
+    if (!IsPrimary()) {
+        return;
+    }
+
+    RECT bounds = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+    RECT dirty;
+    if (!RectIntersect(dirty, region, bounds)) {
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+    bool windowBehind = m_device->presenter.Discard();
+
+    // Nothing layered any more - present straight from the primary
+    if (GetVisibleOverlayCount() == 0) {
+        m_device->present.presentPixels = m_pixels.data();
+        m_device->present.primaryPitch = m_pitch;
+        PresentPrimaryToScreen(*m_device, windowBehind ? nullptr : &dirty);
+        return;
+    }
+
+    // No composed image yet - build it with a full update instead
+    if (m_device->present.presentPixels != m_device->present.primaryPixels.data() ||
+        m_device->present.primaryPixels.size() != m_pixels.size()) {
+        NotifyContentChanged();
+        return;
+    }
+
+    // Restore the primary's own pixels under the region, then layer overlays
+    DWORD bytesPerPixel = m_bpp / 8;
+    size_t rowBytes = static_cast<size_t>(dirty.right - dirty.left) * bytesPerPixel;
+    for (LONG y = dirty.top; y < dirty.bottom; ++y) {
+        size_t offset = static_cast<size_t>(y) * m_pitch + dirty.left * bytesPerPixel;
+        memcpy(m_device->present.primaryPixels.data() + offset, m_pixels.data() + offset, rowBytes);
+    }
+
+    ComposeOverlays(dirty);
+    PresentPrimaryToScreen(*m_device, windowBehind ? nullptr : &dirty);
+}
+
+void SurfaceImpl::ComposeOverlays(const RECT& region) {
+    // Caller holds the device renderMutex; draw back to front
+    for (auto it = m_overlays.rbegin(); it != m_overlays.rend(); ++it) {
+        const SurfaceImpl* overlay = *it;
+        if (!overlay->m_overlayVisible) {
+            continue;
+        }
+
+        core::OverlayBlendParams params;
+        params.srcPixels = overlay->m_pixels.data();
+        params.srcPitch = overlay->m_pitch;
+        params.srcRect = overlay->m_overlaySrcRect;
+        params.dstPixels = m_device->present.primaryPixels.data();
+        params.dstPitch = m_pitch;
+        params.dstRect = overlay->m_overlayDestRect;
+        params.keyPixels = m_pixels.data();  // Destination key tests the primary itself
+        params.keyPitch = m_pitch;
+        params.bytesPerPixel = m_bpp / 8;
+        params.useSrcKey = overlay->m_overlayUseSrcKey;
+        params.srcKey = overlay->m_overlaySrcKey;
+        params.useDestKey = overlay->m_overlayUseDestKey;
+        params.destKey = overlay->m_overlayDestKey;
+
+        core::CompositeOverlay(params, region);
+    }
+}
+
 // ============================================================================
 // IUnknown Implementation
 // ============================================================================
@@ -196,6 +627,18 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::QueryInterface(REFIID riid, void** ppvObj
         return S_OK;
     }
 
+    // Gamma applies to what is displayed, so only the primary has it
+    if (riid == IID_IDirectDrawGammaControl && IsPrimary()) {
+        core::DeviceLockGuard deviceLock(UsesDeviceLock());
+        if (!m_gammaControl) {
+            m_gammaControl = std::make_unique<GammaControlImpl>(
+                *static_cast<IDirectDrawSurface7*>(this), m_device);
+        }
+        AddRef();
+        *ppvObj = static_cast<IDirectDrawGammaControl*>(m_gammaControl.get());
+        return S_OK;
+    }
+
     return E_NOINTERFACE;
 }
 
@@ -221,19 +664,42 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Lock(
     DWORD dwFlags,
     HANDLE hEvent)
 {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     LDC_UNUSED(hEvent);
-    LDC_UNUSED(dwFlags);
 
     if (!lpDDSurfaceDesc) {
         return DDERR_INVALIDPARAMS;
     }
 
-    std::lock_guard<std::mutex> lock(m_lockMutex);
-
-    if (m_locked) {
+    // Claimed first, so a second Lock cannot unshare or decompress the
+    // storage under the first one; from here on new blits are refused
+    uint32_t expected = kUnlocked;
+    if (!m_lockState.compare_exchange_strong(expected, kLocking)) {
         return DDERR_SURFACEBUSY;
     }
 
+    // Pixels must be final before the game reads them, including blits
+    // that started before the claim
+    bool readOnly = (dwFlags & DDLOCK_READONLY) != 0;
+    WaitForStartingBlts();
+    HRESULT hr = WaitForBlts((dwFlags & DDLOCK_DONOTWAIT) != 0);
+    if (SUCCEEDED(hr)) {
+        hr = readOnly ? PrepareAccess() : PrepareWrite();
+    }
+    if (FAILED(hr)) {
+        m_lockState.store(kUnlocked, std::memory_order_release);
+        return hr;
+    }
+
+    // A blit still running on another thread finishes before the game
+    // gets the pointer
+    if (readOnly) {
+        core::SharedLockGuard pixelLock(m_pixelLock);
+    } else {
+        core::ExclusiveLockGuard pixelLock(m_pixelLock);
+    }
+
     // Fill in surface description
     ZeroMemory(lpDDSurfaceDesc, sizeof(DDSURFACEDESC2));
     lpDDSurfaceDesc->dwSize = sizeof(DDSURFACEDESC2);
@@ -257,23 +723,31 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Lock(
         m_lockedRect = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
     }
 
-    m_locked = true;
+    m_lockState.store(readOnly ? kLockedRead : kLockedWrite, std::memory_order_release);
 
     return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::Unlock(LPRECT lpRect) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     LDC_UNUSED(lpRect);
 
-    std::lock_guard<std::mutex> lock(m_lockMutex);
+    uint32_t state = m_lockState.load(std::memory_order_acquire);
+    do {
+        if (state != kLockedRead && state != kLockedWrite) {
+            return DDERR_NOTLOCKED;
+        }
+    } while (!m_lockState.compare_exchange_weak(state, kUnlocking, std::memory_order_acquire));
+
+    RECT lockedRect = m_lockedRect;
+    m_lockState.store(kUnlocked, std::memory_order_release);
 
-    if (!m_locked) {
-        return DDERR_NOTLOCKED;
+    // Nothing changed under a read-only lock
+    if (state == kLockedWrite) {
+        NotifyContentChanged(&lockedRect);
     }
 
-    m_locked = false;
-    NotifyContentChanged();
-
     return DD_OK;
 }
 
@@ -284,45 +758,41 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Blt(
     DWORD dwFlags,
     LPDDBLTFX lpDDBltFx)
 {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     SurfaceImpl* pSrc = static_cast<SurfaceImpl*>(lpDDSrcSurface);
+    RECT bounds = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+
+    // The game owns a locked surface's pixels until Unlock. Announcing the
+    // blit before checking means a racing Lock either sees it and waits,
+    // or has claimed the surface and fails the check.
+    BltStartGuard bltStart(m_bltsStarting, pSrc && pSrc != this ? &pSrc->m_bltsStarting : nullptr);
+    if (IsLocked() || (pSrc && pSrc->IsLocked())) {
+        return DDERR_SURFACEBUSY;
+    }
 
     // Determine destination rectangle
     RECT dstRect;
     if (lpDestRect) {
         dstRect = *lpDestRect;
     } else {
-        dstRect = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+        dstRect = bounds;
     }
 
-    // Color fill operation
+    BltOp op;
+
     if (dwFlags & DDBLT_COLORFILL) {
+        // Color fill operation
         if (!lpDDBltFx) {
             return DDERR_INVALIDPARAMS;
         }
-
-        DWORD color = lpDDBltFx->dwFillColor;
-        DWORD bytesPerPixel = m_bpp / 8;
-
-        for (LONG y = dstRect.top; y < dstRect.bottom && y < static_cast<LONG>(m_height); ++y) {
-            uint8_t* row = m_pixels.data() + y * m_pitch + dstRect.left * bytesPerPixel;
-            for (LONG x = dstRect.left; x < dstRect.right && x < static_cast<LONG>(m_width); ++x) {
-                if (bytesPerPixel == 1) {
-                    *row = static_cast<uint8_t>(color);
-                } else if (bytesPerPixel == 2) {
-                    *reinterpret_cast<uint16_t*>(row) = static_cast<uint16_t>(color);
-                } else if (bytesPerPixel == 4) {
-                    *reinterpret_cast<uint32_t*>(row) = color;
-                }
-                row += bytesPerPixel;
-            }
+        if (!RectIntersect(op.dstRect, dstRect, bounds)) {
+            return DD_OK;
         }
-
-        NotifyContentChanged();
-        return DD_OK;
-    }
-
-    // Source blit operation
-    if (pSrc) {
+        op.colorFill = true;
+        op.fillColor = lpDDBltFx->dwFillColor;
+    } else if (pSrc) {
+        // Source blit operation
         RECT srcRect;
         if (lpSrcRect) {
             srcRect = *lpSrcRect;
@@ -330,7 +800,6 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Blt(
             srcRect = { 0, 0, static_cast<LONG>(pSrc->m_width), static_cast<LONG>(pSrc->m_height) };
         }
 
-        DWORD bytesPerPixel = m_bpp / 8;
         LONG srcWidth = srcRect.right - srcRect.left;
         LONG srcHeight = srcRect.bottom - srcRect.top;
         LONG dstWidth = dstRect.right - dstRect.left;
@@ -357,50 +826,193 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Blt(
             return DD_OK;
         }
 
-        // Perform the copy
-        bool useColorKey = (dwFlags & DDBLT_KEYSRC) && pSrc->m_hasSrcColorKey;
-        DWORD colorKey = pSrc->m_srcColorKey.dwColorSpaceLowValue;
+        op.src = pSrc;
+        op.dstRect = { dstRect.left, dstRect.top,
+                       dstRect.left + copyWidth, dstRect.top + copyHeight };
+        op.srcOrigin = { srcRect.left, srcRect.top };
 
-        for (LONG y = 0; y < copyHeight; ++y) {
-            uint8_t* dstRow = m_pixels.data() +
-                              (dstRect.top + y) * m_pitch +
-                              dstRect.left * bytesPerPixel;
-            const uint8_t* srcRow = pSrc->m_pixels.data() +
-                                    (srcRect.top + y) * pSrc->m_pitch +
-                                    srcRect.left * bytesPerPixel;
+        // The key is resolved now so later SetColorKey calls cannot affect
+        // a blit that is still queued
+        op.useColorKey = (dwFlags & DDBLT_KEYSRC) && pSrc->m_hasSrcColorKey;
+        op.colorKey = pSrc->m_srcColorKey.dwColorSpaceLowValue;
+    } else {
+        return DD_OK;
+    }
 
-            if (!useColorKey) {
-                memcpy(dstRow, srcRow, copyWidth * bytesPerPixel);
-            } else {
-                // Color key blit
-                for (LONG x = 0; x < copyWidth; ++x) {
-                    DWORD pixel = 0;
+    HRESULT hr = PrepareWrite();
+    if (SUCCEEDED(hr) && pSrc && pSrc != this) {
+        hr = pSrc->PrepareAccess();
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    if (ShouldDeferBlt(dwFlags)) {
+        QueueBlt(op);
+        return DD_OK;
+    }
+
+    // Earlier deferred work on either surface must land first
+    bool doNotWait = (dwFlags & DDBLT_DONOTWAIT) != 0;
+    hr = WaitForBlts(doNotWait);
+    if (SUCCEEDED(hr) && pSrc && pSrc != this) {
+        hr = pSrc->WaitForBlts(doNotWait);
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    ExecuteBlt(op);
+    NotifyContentChanged(&op.dstRect);
+    return DD_OK;
+}
+
+HRESULT SurfaceImpl::PrepareWrite() {
+    HRESULT hr = PrepareAccess();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    m_writeCount.fetch_add(1);
+    m_lastWriteTick.store(GetTickCount64(), std::memory_order_relaxed);
+
+    // The deduplication pass may be swapping in shared storage right now;
+    // it gives up on seeing the count above, or finishes before this read
+    bool shared;
+    {
+        core::SharedLockGuard pixelLock(m_pixelLock);
+        shared = m_pixels.IsShared();
+    }
+    if (!shared) {
+        return DD_OK;
+    }
+
+    // Queued blits may still be reading the shared storage through us
+    m_bltFence.WaitIdle();
+    core::ExclusiveLockGuard pixelLock(m_pixelLock);
+    if (!core::SurfaceAllocator::Instance().MakeUnique(m_pixels)) {
+        return DDERR_OUTOFMEMORY;
+    }
+    return DD_OK;
+}
+
+bool SurfaceImpl::ShouldDeferBlt(DWORD dwFlags) const {
+    // Visible results must reach the screen immediately, so blits to the
+    // primary and to overlays always run on the calling thread
+    if (!m_parent || IsPrimary() || IsOverlay()) {
+        return false;
+    }
+    return (dwFlags & DDBLT_ASYNC) || config::GetConfig().deferredBlits;
+}
+
+void SurfaceImpl::QueueBlt(const BltOp& op) {
+    core::BlitAccess accesses[2];
+    size_t count = 0;
+
+    accesses[count].resource = this;
+    accesses[count].fence = &m_bltFence;
+    accesses[count].rect = op.dstRect;
+    accesses[count].write = true;
+    ++count;
+
+    if (op.src) {
+        LONG width = op.dstRect.right - op.dstRect.left;
+        LONG height = op.dstRect.bottom - op.dstRect.top;
+
+        accesses[count].resource = op.src;
+        accesses[count].fence = &op.src->m_bltFence;
+        accesses[count].rect = { op.srcOrigin.x, op.srcOrigin.y,
+                                 op.srcOrigin.x + width, op.srcOrigin.y + height };
+        accesses[count].write = false;
+        ++count;
+    }
+
+    m_parent->GetBlitQueue().Submit([this, op] { ExecuteBlt(op); }, accesses, count);
+    m_uniquenessValue++;
+}
+
+void SurfaceImpl::ExecuteBlt(const BltOp& op) {
+    LONG width = op.dstRect.right - op.dstRect.left;
+    LONG height = op.dstRect.bottom - op.dstRect.top;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    // Held across all bands; the executor's workers run under our locks
+    PairLockGuard pixelLock(m_pixelLock, op.src && op.src != this ? &op.src->m_pixelLock : nullptr);
+
+    auto band = [&](uint32_t begin, uint32_t end) { ExecuteBltRows(op, begin, end); };
+
+    // Overlapping rows of a blit within one surface depend on each other
+    if (!m_parent || op.src == this) {
+        band(0, static_cast<uint32_t>(height));
+        return;
+    }
+
+    m_parent->GetTileExecutor().Run(static_cast<uint32_t>(height),
+                                    static_cast<uint64_t>(width) * height, band);
+}
+
+void SurfaceImpl::ExecuteBltRows(const BltOp& op, uint32_t rowBegin, uint32_t rowEnd) {
+    DWORD bytesPerPixel = m_bpp / 8;
+
+    if (op.colorFill) {
+        DWORD color = op.fillColor;
+
+        for (LONG y = op.dstRect.top + rowBegin; y < op.dstRect.top + static_cast<LONG>(rowEnd); ++y) {
+            uint8_t* row = m_pixels.data() + y * m_pitch + op.dstRect.left * bytesPerPixel;
+            for (LONG x = op.dstRect.left; x < op.dstRect.right; ++x) {
+                if (bytesPerPixel == 1) {
+                    *row = static_cast<uint8_t>(color);
+                } else if (bytesPerPixel == 2) {
+                    *reinterpret_cast<uint16_t*>(row) = static_cast<uint16_t>(color);
+                } else if (bytesPerPixel == 4) {
+                    *reinterpret_cast<uint32_t*>(row) = color;
+                }
+                row += bytesPerPixel;
+            }
+        }
+        return;
+    }
+
+    SurfaceImpl* pSrc = op.src;
+    LONG copyWidth = op.dstRect.right - op.dstRect.left;
+
+    // Perform the copy
+    for (LONG y = static_cast<LONG>(rowBegin); y < static_cast<LONG>(rowEnd); ++y) {
+        uint8_t* dstRow = m_pixels.data() +
+                          (op.dstRect.top + y) * m_pitch +
+                          op.dstRect.left * bytesPerPixel;
+        const uint8_t* srcRow = pSrc->m_pixels.data() +
+                                (op.srcOrigin.y + y) * pSrc->m_pitch +
+                                op.srcOrigin.x * bytesPerPixel;
+
+        if (!op.useColorKey) {
+            memmove(dstRow, srcRow, copyWidth * bytesPerPixel);
+        } else {
+            // Color key blit
+            for (LONG x = 0; x < copyWidth; ++x) {
+                DWORD pixel = 0;
+                if (bytesPerPixel == 1) {
+                    pixel = srcRow[x];
+                } else if (bytesPerPixel == 2) {
+                    pixel = reinterpret_cast<const uint16_t*>(srcRow)[x];
+                } else if (bytesPerPixel == 4) {
+                    pixel = reinterpret_cast<const uint32_t*>(srcRow)[x];
+                }
+
+                if (pixel != op.colorKey) {
                     if (bytesPerPixel == 1) {
-                        pixel = srcRow[x];
+                        dstRow[x] = static_cast<uint8_t>(pixel);
                     } else if (bytesPerPixel == 2) {
-                        pixel = reinterpret_cast<const uint16_t*>(srcRow)[x];
+                        reinterpret_cast<uint16_t*>(dstRow)[x] = static_cast<uint16_t>(pixel);
                     } else if (bytesPerPixel == 4) {
-                        pixel = reinterpret_cast<const uint32_t*>(srcRow)[x];
-                    }
-
-                    if (pixel != colorKey) {
-                        if (bytesPerPixel == 1) {
-                            dstRow[x] = static_cast<uint8_t>(pixel);
-                        } else if (bytesPerPixel == 2) {
-                            reinterpret_cast<uint16_t*>(dstRow)[x] = static_cast<uint16_t>(pixel);
-                        } else if (bytesPerPixel == 4) {
-                            reinterpret_cast<uint32_t*>(dstRow)[x] = pixel;
-                        }
+                        reinterpret_cast<uint32_t*>(dstRow)[x] = pixel;
                     }
                 }
             }
         }
-
-        NotifyContentChanged();
-        return DD_OK;
     }
-
-    return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::BltFast(
@@ -435,6 +1047,9 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::BltFast(
     if (dwTrans & DDBLTFAST_DESTCOLORKEY) {
         flags |= DDBLT_KEYDEST;
     }
+    if (dwTrans & DDBLTFAST_DONOTWAIT) {
+        flags |= DDBLT_DONOTWAIT;
+    }
 
     return Blt(&dstRect, lpDDSrcSurface, &srcRect, flags, nullptr);
 }
@@ -443,21 +1058,86 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Flip(
     LPDIRECTDRAWSURFACE7 lpDDSurfaceTargetOverride,
     DWORD dwFlags)
 {
-    LDC_UNUSED(lpDDSurfaceTargetOverride);
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
 
-    // If we have a back buffer, swap content
-    if (m_backBuffer) {
-        std::swap(m_pixels, m_backBuffer->m_pixels);
-    }
+    // A lone surface has nothing to exchange; just present it
+    if (!m_backBuffer) {
+        NotifyContentChanged();
+    } else {
+        SurfaceImpl* pTarget = static_cast<SurfaceImpl*>(lpDDSurfaceTargetOverride);
 
-    // Present to screen
-    NotifyContentChanged();
+        std::vector<SurfaceImpl*> chain;
+        for (SurfaceImpl* back = m_backBuffer; back; back = back->m_backBuffer) {
+            chain.push_back(back);
+        }
+        if (pTarget && std::find(chain.begin(), chain.end(), pTarget) == chain.end()) {
+            return DDERR_INVALIDPARAMS;
+        }
 
-    // VSync wait if requested
-    if (!(dwFlags & DDFLIP_NOVSYNC)) {
-        Sleep(1);
+        // Storage may not move while the game holds a pointer into it
+        if (IsLocked() || m_hDC) {
+            return DDERR_SURFACEBUSY;
+        }
+        for (SurfaceImpl* back : chain) {
+            if (back->IsLocked() || back->m_hDC) {
+                return DDERR_SURFACEBUSY;
+            }
+        }
+
+        // Nor while deferred blits still read or write it
+        bool doNotWait = (dwFlags & DDFLIP_DONOTWAIT) != 0;
+        HRESULT hr = WaitForBlts(doNotWait);
+        for (size_t i = 0; SUCCEEDED(hr) && i < chain.size(); ++i) {
+            hr = chain[i]->WaitForBlts(doNotWait);
+        }
+        if (FAILED(hr)) {
+            return hr;
+        }
+
+        // The storage handed back for drawing must be off its way to the
+        // screen. With two or more back buffers that is never the frame being
+        // presented, so triple-buffered games do not wait here.
+        if (IsPrimary()) {
+            core::Presenter& presenter = m_device->presenter;
+            const uint8_t* handBack = GetFlipHandBack(pTarget);
+
+            if (presenter.IsPresenting(handBack)) {
+                if (doNotWait) {
+                    return DDERR_WASSTILLDRAWING;
+                }
+                core::Fence::Clock::time_point start = core::Fence::Clock::now();
+                presenter.Release(handBack);
+                m_flipFence.RecordWait(start);
+            } else {
+                presenter.Release(handBack);
+            }
+        }
+
+        // Blits on other threads must not see the storage mid-rotation;
+        // members are locked in address order, like blits lock their pair
+        std::vector<SurfaceImpl*> members = chain;
+        members.push_back(this);
+        std::sort(members.begin(), members.end());
+        for (SurfaceImpl* member : members) {
+            member->m_pixelLock.Lock();
+        }
+        RotateFlipChain(pTarget);
+        for (SurfaceImpl* member : members) {
+            member->m_pixelLock.Unlock();
+        }
+
+        if (IsPrimary() && GetVisibleOverlayCount() == 0) {
+            // Present from the new front buffer's storage on the presenter thread
+            m_device->presenter.Submit(m_pixels.data(), m_pitch,
+                                               &m_flipFence, m_flipFence.Enqueue());
+            m_uniquenessValue++;
+        } else {
+            NotifyContentChanged();
+        }
     }
 
+    // No vblank wait here: the presenter paces frames, and a sleep per
+    // Flip only cost triple-buffered games their frame rate
     return DD_OK;
 }
 
@@ -479,6 +1159,15 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetSurfaceDesc(LPDDSURFACEDESC2 lpDDSurfa
     lpDDSurfaceDesc->ddpfPixelFormat = m_pixelFormat;
     lpDDSurfaceDesc->ddsCaps = m_caps;
 
+    if (m_backBuffer) {
+        DWORD count = 0;
+        for (SurfaceImpl* back = m_backBuffer; back; back = back->m_backBuffer) {
+            ++count;
+        }
+        lpDDSurfaceDesc->dwFlags |= DDSD_BACKBUFFERCOUNT;
+        lpDDSurfaceDesc->dwBackBufferCount = count;
+    }
+
     return DD_OK;
 }
 
@@ -513,6 +1202,12 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetColorKey(DWORD dwFlags, LPDDCOLORKEY l
     } else if (dwFlags & DDCKEY_DESTBLT) {
         if (!m_hasDestColorKey) return DDERR_NOCOLORKEY;
         *lpDDColorKey = m_destColorKey;
+    } else if (dwFlags & DDCKEY_SRCOVERLAY) {
+        if (!m_hasSrcOverlayKey) return DDERR_NOCOLORKEY;
+        *lpDDColorKey = m_srcOverlayKey;
+    } else if (dwFlags & DDCKEY_DESTOVERLAY) {
+        if (!m_hasDestOverlayKey) return DDERR_NOCOLORKEY;
+        *lpDDColorKey = m_destOverlayKey;
     } else {
         return DDERR_INVALIDPARAMS;
     }
@@ -521,6 +1216,8 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetColorKey(DWORD dwFlags, LPDDCOLORKEY l
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::SetColorKey(DWORD dwFlags, LPDDCOLORKEY lpDDColorKey) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     if (dwFlags & DDCKEY_SRCBLT) {
         if (lpDDColorKey) {
             m_srcColorKey = *lpDDColorKey;
@@ -535,6 +1232,20 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::SetColorKey(DWORD dwFlags, LPDDCOLORKEY l
         } else {
             m_hasDestColorKey = false;
         }
+    } else if (dwFlags & DDCKEY_SRCOVERLAY) {
+        if (lpDDColorKey) {
+            m_srcOverlayKey = *lpDDColorKey;
+            m_hasSrcOverlayKey = true;
+        } else {
+            m_hasSrcOverlayKey = false;
+        }
+    } else if (dwFlags & DDCKEY_DESTOVERLAY) {
+        if (lpDDColorKey) {
+            m_destOverlayKey = *lpDDColorKey;
+            m_hasDestOverlayKey = true;
+        } else {
+            m_hasDestOverlayKey = false;
+        }
     } else {
         return DDERR_INVALIDPARAMS;
     }
@@ -546,7 +1257,30 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::SetColorKey(DWORD dwFlags, LPDDCOLORKEY l
 // GDI Interop
 // ============================================================================
 
+bool SurfaceImpl::EnsureDibStorage() {
+    if (m_pixels.GetDC()) {
+        return true;
+    }
+
+    core::ExclusiveLockGuard pixelLock(m_pixelLock);
+
+    // The presenter may still be reading the storage being replaced
+    const uint8_t* oldPixels = m_pixels.data();
+    m_device->presenter.Release(oldPixels);
+
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+    if (!core::SurfaceAllocator::Instance().ConvertToDib(m_pixels, m_pitch, m_height, m_pixelFormat)) {
+        return false;
+    }
+    if (m_device->present.presentPixels == oldPixels) {
+        m_device->present.presentPixels = m_pixels.data();
+    }
+    return true;
+}
+
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetDC(HDC* lphDC) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     if (!lphDC) {
         return DDERR_INVALIDPARAMS;
     }
@@ -555,56 +1289,69 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetDC(HDC* lphDC) {
         return DDERR_DCALREADYCREATED;
     }
 
-    // Use :: prefix to call Windows API functions (not our class methods)
-    HDC hScreenDC = ::GetDC(nullptr);
-    m_hDC = ::CreateCompatibleDC(hScreenDC);
+    // Claimed like Lock claims it: the storage may move into a DIB
+    // section below, which must not happen under a pointer from Lock
+    uint32_t expected = kUnlocked;
+    if (!m_lockState.compare_exchange_strong(expected, kLocking)) {
+        return DDERR_SURFACEBUSY;
+    }
 
-    BITMAPINFO bmi{};
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = m_width;
-    bmi.bmiHeader.biHeight = -static_cast<LONG>(m_height);
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = static_cast<WORD>(m_bpp);
-    bmi.bmiHeader.biCompression = BI_RGB;
+    WaitForStartingBlts();
+    WaitForBlts(false);
 
-    void* pBits = nullptr;
-    m_hBitmap = ::CreateDIBSection(m_hDC, &bmi, DIB_RGB_COLORS, &pBits, nullptr, 0);
+    // GDI draws straight into the surface once its storage is a DIB section
+    HRESULT hr = PrepareWrite();
+    if (SUCCEEDED(hr) && !EnsureDibStorage()) {
+        hr = DDERR_GENERIC;
+    }
+    if (FAILED(hr)) {
+        m_lockState.store(kUnlocked, std::memory_order_release);
+        return hr;
+    }
+    m_hDC = m_pixels.GetDC();
 
-    if (!m_hBitmap || !pBits) {
-        ::DeleteDC(m_hDC);
-        m_hDC = nullptr;
-        ::ReleaseDC(nullptr, hScreenDC);
-        return DDERR_GENERIC;
+    if (m_bpp == 8) {
+        if (m_palette) {
+            ::SetDIBColorTable(m_hDC, 0, m_palette->GetEntryCount(), m_palette->GetColorTable());
+        } else {
+            ::SetDIBColorTable(m_hDC, 0, 256, m_device->game.palette);
+        }
     }
 
-    memcpy(pBits, m_pixels.data(), m_pixels.size());
-    m_hBitmapOld = static_cast<HBITMAP>(::SelectObject(m_hDC, m_hBitmap));
-    ::ReleaseDC(nullptr, hScreenDC);
+    // The DC outlives this call; undo whatever the game selects into it
+    // and collect the bounds of what it draws
+    ::SaveDC(m_hDC);
+    ::SetBoundsRect(m_hDC, nullptr, DCB_RESET | DCB_ENABLE);
 
+    m_lockState.store(kLockedDC, std::memory_order_release);
     *lphDC = m_hDC;
     return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::ReleaseDC(HDC hDC) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     if (hDC != m_hDC || !m_hDC) {
         return DDERR_INVALIDPARAMS;
     }
 
-    BITMAP bm;
-    ::GetObject(m_hBitmap, sizeof(bm), &bm);
-    if (bm.bmBits) {
-        memcpy(m_pixels.data(), bm.bmBits, m_pixels.size());
-    }
-
-    ::SelectObject(m_hDC, m_hBitmapOld);
-    ::DeleteObject(m_hBitmap);
-    ::DeleteDC(m_hDC);
+    RECT bounds{};
+    UINT boundsState = ::GetBoundsRect(m_hDC, &bounds, DCB_RESET);
+    ::SetBoundsRect(m_hDC, nullptr, DCB_DISABLE);
+    ::RestoreDC(m_hDC, -1);
 
+    // GDI batches drawing; make it land before the pixels are read
+    ::GdiFlush();
     m_hDC = nullptr;
-    m_hBitmap = nullptr;
-    m_hBitmapOld = nullptr;
+    m_lockState.store(kUnlocked, std::memory_order_release);
 
-    NotifyContentChanged();
+    if ((boundsState & DCB_SET) == DCB_SET) {
+        RECT surfaceRect = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+        RECT damage;
+        if (RectIntersect(damage, bounds, surfaceRect)) {
+            NotifyContentChanged(&damage);
+        }
+    }
 
     return DD_OK;
 }
@@ -614,13 +1361,52 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::ReleaseDC(HDC hDC) {
 // ============================================================================
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetPalette(LPDIRECTDRAWPALETTE* lplpDDPalette) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     if (!lplpDDPalette) return DDERR_INVALIDPARAMS;
-    *lplpDDPalette = nullptr;
-    return DDERR_NOPALETTEATTACHED;
+
+    if (!m_palette) {
+        *lplpDDPalette = nullptr;
+        return DDERR_NOPALETTEATTACHED;
+    }
+
+    m_palette->AddRef();
+    *lplpDDPalette = m_palette;
+    return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::SetPalette(LPDIRECTDRAWPALETTE lpDDPalette) {
-    LDC_UNUSED(lpDDPalette);
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
+    // Only palettes we created can be attached; their tables are read directly
+    PaletteImpl* palette = static_cast<PaletteImpl*>(lpDDPalette);
+
+    if (palette && (m_bpp > 8 || palette->GetEntryCount() > (1u << m_bpp))) {
+        return DDERR_INVALIDPIXELFORMAT;
+    }
+
+    if (palette == m_palette) {
+        return DD_OK;
+    }
+
+    if (palette) {
+        palette->AddRef();
+    }
+    PaletteImpl* previous = m_palette;
+    m_palette = palette;
+
+    // The primary converts through the attached palette's LUT from now on
+    if (IsPrimary()) {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        m_device->present.paletteLut = palette ? palette->GetLut() : nullptr;
+        m_device->game.paletteChanges.fetch_add(1);
+        m_device->game.paletteChanged = true;
+        FlushPaletteChanges(*m_device, false);
+    }
+
+    if (previous) {
+        previous->Release();
+    }
     return DD_OK;
 }
 
@@ -635,6 +1421,351 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::SetClipper(LPDIRECTDRAWCLIPPER lpDDClippe
     return DD_OK;
 }
 
+// ============================================================================
+// Overlay Methods
+// ============================================================================
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::UpdateOverlay(
+    LPRECT lpSrcRect,
+    LPDIRECTDRAWSURFACE7 lpDDDestSurface,
+    LPRECT lpDestRect,
+    DWORD dwFlags,
+    LPDDOVERLAYFX lpDDOverlayFx)
+{
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
+    if (!IsOverlay()) {
+        return DDERR_NOTAOVERLAYSURFACE;
+    }
+
+    // Hiding only needs the area the overlay covered to be restored
+    if (dwFlags & DDOVER_HIDE) {
+        SurfaceImpl* dest = nullptr;
+        RECT oldRegion{};
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+            if (m_overlayVisible && m_overlayDest) {
+                dest = m_overlayDest;
+                oldRegion = m_overlayDestRect;
+            }
+            m_overlayVisible = false;
+        }
+        if (dest) {
+            dest->RefreshOverlayRegion(oldRegion);
+        }
+        return DD_OK;
+    }
+
+    SurfaceImpl* pDest = static_cast<SurfaceImpl*>(lpDDDestSurface);
+    if (!pDest) {
+        return DDERR_INVALIDPARAMS;
+    }
+    if (!pDest->IsPrimary()) {
+        return DDERR_INVALIDSURFACETYPE;
+    }
+    if (pDest->m_bpp != m_bpp) {
+        return DDERR_INVALIDPIXELFORMAT;
+    }
+
+    RECT srcBounds = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+    RECT srcRect = lpSrcRect ? *lpSrcRect : srcBounds;
+    RECT dstRect = lpDestRect ? *lpDestRect
+                              : RECT{ 0, 0, static_cast<LONG>(pDest->m_width), static_cast<LONG>(pDest->m_height) };
+
+    RECT clipped;
+    if (RectIsEmpty(dstRect) || !RectIntersect(clipped, srcRect, srcBounds) ||
+        memcmp(&clipped, &srcRect, sizeof(RECT)) != 0) {
+        return DDERR_INVALIDRECT;
+    }
+
+    // Resolve colour keys now so composition never re-reads the flags
+    bool useSrcKey = false;
+    bool useDestKey = false;
+    DWORD srcKey = 0;
+    DWORD destKey = 0;
+
+    if (dwFlags & DDOVER_KEYSRCOVERRIDE) {
+        if (!lpDDOverlayFx) return DDERR_INVALIDPARAMS;
+        useSrcKey = true;
+        srcKey = lpDDOverlayFx->dckSrcColorkey.dwColorSpaceLowValue;
+    } else if (dwFlags & DDOVER_KEYSRC) {
+        if (!m_hasSrcOverlayKey) return DDERR_NOCOLORKEY;
+        useSrcKey = true;
+        srcKey = m_srcOverlayKey.dwColorSpaceLowValue;
+    }
+
+    if (dwFlags & DDOVER_KEYDESTOVERRIDE) {
+        if (!lpDDOverlayFx) return DDERR_INVALIDPARAMS;
+        useDestKey = true;
+        destKey = lpDDOverlayFx->dckDestColorkey.dwColorSpaceLowValue;
+    } else if (dwFlags & DDOVER_KEYDEST) {
+        if (!pDest->m_hasDestOverlayKey) return DDERR_NOCOLORKEY;
+        useDestKey = true;
+        destKey = pDest->m_destOverlayKey.dwColorSpaceLowValue;
+    }
+
+    // Moving to a different destination restores the old one first
+    if (m_overlayDest && m_overlayDest != pDest) {
+        DetachOverlay();
+    }
+
+    RECT oldRegion{};
+    bool wasVisible = false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+
+        wasVisible = m_overlayVisible;
+        oldRegion = m_overlayDestRect;
+
+        m_overlaySrcRect = srcRect;
+        m_overlayDestRect = dstRect;
+        m_overlayUseSrcKey = useSrcKey;
+        m_overlaySrcKey = srcKey;
+        m_overlayUseDestKey = useDestKey;
+        m_overlayDestKey = destKey;
+        m_overlayDirtyRects.clear();
+
+        // Newly attached overlays start at the front of the z-order
+        if (!m_overlayDest) {
+            pDest->m_overlays.insert(pDest->m_overlays.begin(), this);
+            m_overlayDest = pDest;
+        }
+
+        if (dwFlags & DDOVER_SHOW) {
+            m_overlayVisible = true;
+        }
+    }
+
+    if (m_overlayVisible || wasVisible) {
+        RECT region = wasVisible ? RectUnion(oldRegion, dstRect) : dstRect;
+        pDest->RefreshOverlayRegion(region);
+    }
+
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::UpdateOverlayDisplay(DWORD dwFlags) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
+    if (!IsOverlay()) {
+        return DDERR_NOTAOVERLAYSURFACE;
+    }
+
+    std::vector<RECT> dirtyRects;
+    SurfaceImpl* dest = nullptr;
+    RECT region{};
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        dirtyRects.swap(m_overlayDirtyRects);
+        if (!m_overlayVisible || !m_overlayDest) {
+            return DD_OK;
+        }
+        dest = m_overlayDest;
+
+        if (dwFlags & DDOVER_REFRESHALL) {
+            region = m_overlayDestRect;
+        } else {
+            for (const RECT& rect : dirtyRects) {
+                region = RectUnion(region, GetOverlayDestRegion(&rect));
+            }
+        }
+    }
+
+    dest->RefreshOverlayRegion(region);
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::AddOverlayDirtyRect(LPRECT lpRect) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
+    if (!IsOverlay()) {
+        return DDERR_NOTAOVERLAYSURFACE;
+    }
+    if (!lpRect) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    RECT bounds = { 0, 0, static_cast<LONG>(m_width), static_cast<LONG>(m_height) };
+    RECT dirty;
+    if (!RectIntersect(dirty, *lpRect, bounds)) {
+        return DD_OK;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+
+    // Collapse long lists so apps that never refresh cannot grow it unbounded
+    static const size_t MAX_DIRTY_RECTS = 32;
+    if (m_overlayDirtyRects.size() >= MAX_DIRTY_RECTS) {
+        RECT merged = dirty;
+        for (const RECT& rect : m_overlayDirtyRects) {
+            merged = RectUnion(merged, rect);
+        }
+        m_overlayDirtyRects.assign(1, merged);
+    } else {
+        m_overlayDirtyRects.push_back(dirty);
+    }
+
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::SetOverlayPosition(LONG lX, LONG lY) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
+    if (!IsOverlay()) {
+        return DDERR_NOTAOVERLAYSURFACE;
+    }
+
+    SurfaceImpl* dest = nullptr;
+    RECT region{};
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        if (!m_overlayDest) {
+            return DDERR_NOOVERLAYDEST;
+        }
+        if (!m_overlayVisible) {
+            return DDERR_OVERLAYNOTVISIBLE;
+        }
+
+        RECT oldRect = m_overlayDestRect;
+        m_overlayDestRect = { lX, lY,
+                              lX + (oldRect.right - oldRect.left),
+                              lY + (oldRect.bottom - oldRect.top) };
+        region = RectUnion(oldRect, m_overlayDestRect);
+        dest = m_overlayDest;
+    }
+
+    dest->RefreshOverlayRegion(region);
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::GetOverlayPosition(LPLONG lplX, LPLONG lplY) {
+    if (!lplX || !lplY) {
+        return DDERR_INVALIDPARAMS;
+    }
+    if (!IsOverlay()) {
+        return DDERR_NOTAOVERLAYSURFACE;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+    if (!m_overlayDest) {
+        return DDERR_NOOVERLAYDEST;
+    }
+    if (!m_overlayVisible) {
+        return DDERR_OVERLAYNOTVISIBLE;
+    }
+
+    *lplX = m_overlayDestRect.left;
+    *lplY = m_overlayDestRect.top;
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::UpdateOverlayZOrder(DWORD dwFlags, LPDIRECTDRAWSURFACE7 lpDDSReference) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
+    if (!IsOverlay()) {
+        return DDERR_NOTAOVERLAYSURFACE;
+    }
+
+    SurfaceImpl* pRef = static_cast<SurfaceImpl*>(lpDDSReference);
+    SurfaceImpl* dest = nullptr;
+    RECT region{};
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        if (!m_overlayDest) {
+            return DDERR_NOOVERLAYDEST;
+        }
+
+        // Front of the list is the top of the z-order
+        auto& overlays = m_overlayDest->m_overlays;
+        auto self = std::find(overlays.begin(), overlays.end(), this);
+        if (self == overlays.end()) {
+            return DDERR_NOTFOUND;
+        }
+
+        switch (dwFlags) {
+            case DDOVERZ_SENDTOFRONT:
+                overlays.erase(self);
+                overlays.insert(overlays.begin(), this);
+                break;
+
+            case DDOVERZ_SENDTOBACK:
+                overlays.erase(self);
+                overlays.push_back(this);
+                break;
+
+            case DDOVERZ_MOVEFORWARD:
+                if (self != overlays.begin()) {
+                    std::iter_swap(self, self - 1);
+                }
+                break;
+
+            case DDOVERZ_MOVEBACKWARD:
+                if (self + 1 != overlays.end()) {
+                    std::iter_swap(self, self + 1);
+                }
+                break;
+
+            case DDOVERZ_INSERTINFRONTOF:
+            case DDOVERZ_INSERTINBACKOF:
+            {
+                if (!pRef || pRef == this) {
+                    return DDERR_INVALIDPARAMS;
+                }
+                if (std::find(overlays.begin(), overlays.end(), pRef) == overlays.end()) {
+                    return DDERR_NOTFOUND;
+                }
+                overlays.erase(self);
+                auto ref = std::find(overlays.begin(), overlays.end(), pRef);
+                if (dwFlags == DDOVERZ_INSERTINBACKOF) {
+                    ++ref;
+                }
+                overlays.insert(ref, this);
+                break;
+            }
+
+            default:
+                return DDERR_INVALIDPARAMS;
+        }
+
+        if (m_overlayVisible) {
+            dest = m_overlayDest;
+            region = m_overlayDestRect;
+        }
+    }
+
+    if (dest) {
+        dest->RefreshOverlayRegion(region);
+    }
+    return DD_OK;
+}
+
+HRESULT STDMETHODCALLTYPE SurfaceImpl::EnumOverlayZOrders(DWORD dwFlags, LPVOID lpContext, LPDDENUMSURFACESCALLBACK7 lpfnCallback) {
+    if (!lpfnCallback) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    std::vector<SurfaceImpl*> order;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_device->renderMutex);
+        order = m_overlays;
+    }
+
+    if (!(dwFlags & DDENUMOVERLAYZ_FRONTTOBACK)) {
+        std::reverse(order.begin(), order.end());
+    }
+
+    for (SurfaceImpl* overlay : order) {
+        DDSURFACEDESC2 desc{};
+        desc.dwSize = sizeof(DDSURFACEDESC2);
+        overlay->GetSurfaceDesc(&desc);
+        if (lpfnCallback(overlay, &desc, lpContext) == DDENUMRET_CANCEL) {
+            break;
+        }
+    }
+
+    return DD_OK;
+}
+
 // ============================================================================
 // Stub/Simple Methods
 // ============================================================================
@@ -644,10 +1775,6 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::AddAttachedSurface(LPDIRECTDRAWSURFACE7 l
     return DD_OK;
 }
 
-HRESULT STDMETHODCALLTYPE SurfaceImpl::AddOverlayDirtyRect(LPRECT lpRect) {
-    LDC_UNUSED(lpRect);
-    return DDERR_UNSUPPORTED;
-}
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::BltBatch(LPDDBLTBATCH lpDDBltBatch, DWORD dwCount, DWORD dwFlags) {
     LDC_UNUSED(lpDDBltBatch);
@@ -663,28 +1790,43 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::DeleteAttachedSurface(DWORD dwFlags, LPDI
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::EnumAttachedSurfaces(LPVOID lpContext, LPDDENUMSURFACESCALLBACK7 lpEnumSurfacesCallback) {
-    if (m_backBuffer && lpEnumSurfacesCallback) {
+    if (!lpEnumSurfacesCallback) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    // Each chain member has the next one attached; the last wraps to the front
+    std::vector<SurfaceImpl*> attached;
+    if (SurfaceImpl* next = GetNextInFlipChain()) {
+        attached.push_back(next);
+    }
+
+    // The callback owns a reference to each surface it is given, as with
+    // DirectDraw, and releases it when done
+    for (SurfaceImpl* surface : attached) {
         DDSURFACEDESC2 desc{};
         desc.dwSize = sizeof(DDSURFACEDESC2);
-        m_backBuffer->GetSurfaceDesc(&desc);
-        lpEnumSurfacesCallback(m_backBuffer, &desc, lpContext);
+        surface->GetSurfaceDesc(&desc);
+        surface->AddRef();
+        if (lpEnumSurfacesCallback(surface, &desc, lpContext) == DDENUMRET_CANCEL) {
+            break;
+        }
     }
     return DD_OK;
 }
 
-HRESULT STDMETHODCALLTYPE SurfaceImpl::EnumOverlayZOrders(DWORD dwFlags, LPVOID lpContext, LPDDENUMSURFACESCALLBACK7 lpfnCallback) {
-    LDC_UNUSED(dwFlags);
-    LDC_UNUSED(lpContext);
-    LDC_UNUSED(lpfnCallback);
-    return DDERR_UNSUPPORTED;
-}
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetAttachedSurface(LPDDSCAPS2 lpDDSCaps, LPDIRECTDRAWSURFACE7* lplpDDAttachedSurface) {
-    if (!lplpDDAttachedSurface) return DDERR_INVALIDPARAMS;
+    if (!lplpDDAttachedSurface || !lpDDSCaps) return DDERR_INVALIDPARAMS;
 
-    if (m_backBuffer && (lpDDSCaps->dwCaps & DDSCAPS_BACKBUFFER)) {
-        m_backBuffer->AddRef();
-        *lplpDDAttachedSurface = m_backBuffer;
+    // Match on flip chain caps only; memory placement caps are not tracked
+    const DWORD chainCaps = DDSCAPS_BACKBUFFER | DDSCAPS_FLIP |
+                            DDSCAPS_FRONTBUFFER | DDSCAPS_PRIMARYSURFACE;
+    DWORD wanted = lpDDSCaps->dwCaps & chainCaps;
+
+    SurfaceImpl* next = GetNextInFlipChain();
+    if (next && wanted && (next->m_caps.dwCaps & wanted) == wanted) {
+        next->AddRef();
+        *lplpDDAttachedSurface = next;
         return DD_OK;
     }
 
@@ -693,20 +1835,45 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetAttachedSurface(LPDDSCAPS2 lpDDSCaps,
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetBltStatus(DWORD dwFlags) {
-    LDC_UNUSED(dwFlags);
+    if (dwFlags != DDGBS_CANBLT && dwFlags != DDGBS_ISBLTDONE) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    if (!m_bltFence.IsIdle()) {
+        return DDERR_WASSTILLDRAWING;
+    }
+
+    // A surface being read by the presenter cannot be written without tearing
+    if (dwFlags == DDGBS_CANBLT && m_device->presenter.IsPresenting(m_pixels.data())) {
+        return DDERR_WASSTILLDRAWING;
+    }
+
     return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetFlipStatus(DWORD dwFlags) {
-    LDC_UNUSED(dwFlags);
+    if (dwFlags != DDGFS_CANFLIP && dwFlags != DDGFS_ISFLIPDONE) {
+        return DDERR_INVALIDPARAMS;
+    }
+
+    // Back buffers answer for the chain they belong to
+    SurfaceImpl* front = m_flipFront ? m_flipFront : this;
+    if (!front->m_backBuffer || !front->IsPrimary()) {
+        return DD_OK;
+    }
+
+    if (dwFlags == DDGFS_ISFLIPDONE) {
+        return front->m_flipFence.IsIdle() ? DD_OK : DDERR_WASSTILLDRAWING;
+    }
+
+    // A flip can go ahead without waiting unless it would hand back the
+    // buffer the presenter is reading
+    if (m_device->presenter.IsPresenting(front->GetFlipHandBack(nullptr))) {
+        return DDERR_WASSTILLDRAWING;
+    }
     return DD_OK;
 }
 
-HRESULT STDMETHODCALLTYPE SurfaceImpl::GetOverlayPosition(LPLONG lplX, LPLONG lplY) {
-    LDC_UNUSED(lplX);
-    LDC_UNUSED(lplY);
-    return DDERR_UNSUPPORTED;
-}
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::Initialize(LPDIRECTDRAW lpDD, LPDDSURFACEDESC2 lpDDSurfaceDesc) {
     LDC_UNUSED(lpDD);
@@ -722,31 +1889,6 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::Restore() {
     return DD_OK;
 }
 
-HRESULT STDMETHODCALLTYPE SurfaceImpl::SetOverlayPosition(LONG lX, LONG lY) {
-    LDC_UNUSED(lX);
-    LDC_UNUSED(lY);
-    return DDERR_UNSUPPORTED;
-}
-
-HRESULT STDMETHODCALLTYPE SurfaceImpl::UpdateOverlay(LPRECT lpSrcRect, LPDIRECTDRAWSURFACE7 lpDDDestSurface, LPRECT lpDestRect, DWORD dwFlags, LPDDOVERLAYFX lpDDOverlayFx) {
-    LDC_UNUSED(lpSrcRect);
-    LDC_UNUSED(lpDDDestSurface);
-    LDC_UNUSED(lpDestRect);
-    LDC_UNUSED(dwFlags);
-    LDC_UNUSED(lpDDOverlayFx);
-    return DDERR_UNSUPPORTED;
-}
-
-HRESULT STDMETHODCALLTYPE SurfaceImpl::UpdateOverlayDisplay(DWORD dwFlags) {
-    LDC_UNUSED(dwFlags);
-    return DDERR_UNSUPPORTED;
-}
-
-HRESULT STDMETHODCALLTYPE SurfaceImpl::UpdateOverlayZOrder(DWORD dwFlags, LPDIRECTDRAWSURFACE7 lpDDSReference) {
-    LDC_UNUSED(dwFlags);
-    LDC_UNUSED(lpDDSReference);
-    return DDERR_UNSUPPORTED;
-}
 
 // IDirectDrawSurface2+ Methods
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetDDInterface(LPVOID* lplpDD) {
@@ -760,15 +1902,181 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetDDInterface(LPVOID* lplpDD) {
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::PageLock(DWORD dwFlags) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     LDC_UNUSED(dwFlags);
+
+    // Flips move storage between chain members, so the whole chain is
+    // pinned; pooled surfaces are small and stay resident through use
+    SurfaceImpl* front = m_flipFront ? m_flipFront : this;
+    if (front->m_pageLockCount++ > 0) {
+        return DD_OK;
+    }
+
+    core::SurfaceAllocator& allocator = core::SurfaceAllocator::Instance();
+    for (SurfaceImpl* member = front; member; member = member->m_backBuffer) {
+        if (FAILED(member->PrepareAccess()) ||
+            (member->m_pixels.IsPageBacked() && !allocator.Pin(member->m_pixels))) {
+            for (SurfaceImpl* pinned = front; pinned != member; pinned = pinned->m_backBuffer) {
+                allocator.Unpin(pinned->m_pixels);
+            }
+            front->m_pageLockCount = 0;
+            return DDERR_CANTPAGELOCK;
+        }
+    }
     return DD_OK;
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::PageUnlock(DWORD dwFlags) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     LDC_UNUSED(dwFlags);
+
+    SurfaceImpl* front = m_flipFront ? m_flipFront : this;
+    if (front->m_pageLockCount == 0) {
+        return DDERR_NOTPAGELOCKED;
+    }
+
+    if (--front->m_pageLockCount == 0) {
+        for (SurfaceImpl* member = front; member; member = member->m_backBuffer) {
+            core::SurfaceAllocator::Instance().Unpin(member->m_pixels);
+        }
+    }
+    return DD_OK;
+}
+
+// ============================================================================
+// Storage Sharing
+// ============================================================================
+
+bool SurfaceImpl::IsDedupCandidate(ULONGLONG now, ULONGLONG idleMs) const {
+    if (IsPrimary() || IsOverlay() || m_backBuffer || m_flipFront) {
+        return false;
+    }
+    if (IsLocked() || m_hDC || m_pageLockCount > 0 || !m_bltFence.IsIdle()) {
+        return false;
+    }
+    return m_pixels.data() &&
+           now - m_lastWriteTick.load(std::memory_order_relaxed) >= idleMs;
+}
+
+uint64_t SurfaceImpl::GetContentHash() {
+    // The count is taken first: a write racing the hash makes the cached
+    // value stale, never the other way round
+    uint64_t writeCount = m_writeCount.load();
+    if (m_hashedWriteCount != writeCount) {
+        core::SharedLockGuard pixelLock(m_pixelLock);
+        m_contentHash = core::HashBytes(m_pixels.data(), m_pixels.size());
+        m_hashedWriteCount = writeCount;
+    }
+    return m_contentHash;
+}
+
+bool SurfaceImpl::HasSameContents(SurfaceImpl& other) {
+    if (m_width != other.m_width || m_height != other.m_height || m_pitch != other.m_pitch ||
+        memcmp(&m_pixelFormat, &other.m_pixelFormat, sizeof(m_pixelFormat)) != 0) {
+        return false;
+    }
+
+    // Both shared, in address order like PairLockGuard
+    core::RWLock* first = &m_pixelLock < &other.m_pixelLock ? &m_pixelLock : &other.m_pixelLock;
+    core::RWLock* second = first == &m_pixelLock ? &other.m_pixelLock : &m_pixelLock;
+    core::SharedLockGuard firstLock(*first);
+    core::SharedLockGuard secondLock(*second);
+    return m_pixels.data() && other.m_pixels.data() &&
+           m_pixels.size() == other.m_pixels.size() &&
+           memcmp(m_pixels.data(), other.m_pixels.data(), m_pixels.size()) == 0;
+}
+
+bool SurfaceImpl::ShareStorageWith(SurfaceImpl& source) {
+    PairLockGuard pixelLock(m_pixelLock, &source.m_pixelLock);
+
+    // A Lock or GetDC claims the lock state before its write is counted,
+    // and a blit counts its write before taking the pixel lock, so either
+    // shows here or the write finds the storage shared and copies it
+    if (IsLocked() || source.IsLocked() ||
+        m_writeCount.load() != m_hashedWriteCount ||
+        source.m_writeCount.load() != source.m_hashedWriteCount) {
+        return false;
+    }
+    m_pixels = core::SurfaceAllocator::Instance().Share(source.m_pixels);
+    return true;
+}
+
+// ============================================================================
+// Idle Compression
+// ============================================================================
+
+HRESULT SurfaceImpl::PrepareAccess() {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
+    m_lastAccessTick.store(GetTickCount64(), std::memory_order_relaxed);
+
+    if (m_packedPixels.empty()) {
+        return DD_OK;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    core::SurfaceMemory pixels = core::SurfaceAllocator::Instance().Allocate(m_unpackedSize);
+    if (pixels.empty()) {
+        return DDERR_OUTOFMEMORY;
+    }
+    if (!core::DecompressPixels(m_packedPixels.data(), m_packedPixels.size(),
+                                pixels.data(), pixels.size())) {
+        // Cannot happen for streams we wrote; keep the surface usable
+        DebugLog("SurfaceImpl: compressed storage is corrupt, surface cleared");
+    }
+
+    uint64_t micros = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    if (m_parent && m_parent->GetSurfaceCompressor()) {
+        m_parent->GetSurfaceCompressor()->RecordDecompression(m_unpackedSize, m_packedPixels.size(), micros);
+    }
+
+    core::ExclusiveLockGuard pixelLock(m_pixelLock);
+    m_pixels = std::move(pixels);
+    std::vector<uint8_t>().swap(m_packedPixels);
+    m_unpackedSize = 0;
     return DD_OK;
 }
 
+bool SurfaceImpl::CompressIfIdle(core::SurfaceCompressor& compressor, ULONGLONG now) {
+    if (IsPrimary() || IsOverlay() || m_backBuffer || m_flipFront) {
+        return false;
+    }
+
+    // Holding the storage lock makes a racing Lock or Blt wait for the
+    // result instead of reading memory that is being released
+    std::lock_guard<std::mutex> lock(m_storageMutex);
+    if (m_pixels.empty() || m_pixels.IsShared() || m_pixels.IsPinned() || m_pageLockCount > 0) {
+        return false;
+    }
+    if (now - m_lastAccessTick.load(std::memory_order_relaxed) < compressor.GetIdleMs()) {
+        return false;
+    }
+    if (m_hDC || IsLocked() || !m_bltFence.IsIdle() || !m_pixelLock.TryLock()) {
+        return false;
+    }
+
+    std::vector<uint8_t> packed;
+    bool compressed = core::CompressPixels(m_pixels.data(), m_pixels.size(), packed);
+    if (compressed) {
+        compressor.RecordCompression(m_pixels.size(), packed.size());
+        m_unpackedSize = m_pixels.size();
+        m_packedPixels = std::move(packed);
+        m_pixels.Reset();
+    } else {
+        compressor.RecordIncompressible();
+
+        // Wait another idle period before trying this surface again
+        m_lastAccessTick.store(now, std::memory_order_relaxed);
+    }
+
+    m_pixelLock.Unlock();
+    return compressed;
+}
+
 // IDirectDrawSurface3+ Methods
 HRESULT STDMETHODCALLTYPE SurfaceImpl::SetSurfaceDesc(LPDDSURFACEDESC2 lpDDSD, DWORD dwFlags) {
     LDC_UNUSED(lpDDSD);
@@ -778,6 +2086,8 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::SetSurfaceDesc(LPDDSURFACEDESC2 lpDDSD, D
 
 // IDirectDrawSurface4+ Methods
 HRESULT STDMETHODCALLTYPE SurfaceImpl::SetPrivateData(REFGUID guidTag, LPVOID lpData, DWORD cbSize, DWORD dwFlags) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     LDC_UNUSED(dwFlags);
     if (!lpData || cbSize == 0) {
         m_privateData.erase(guidTag);
@@ -790,6 +2100,8 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::SetPrivateData(REFGUID guidTag, LPVOID lp
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::GetPrivateData(REFGUID guidTag, LPVOID lpBuffer, LPDWORD lpcbBufferSize) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     auto it = m_privateData.find(guidTag);
     if (it == m_privateData.end()) return DDERR_NOTFOUND;
     if (!lpcbBufferSize) return DDERR_INVALIDPARAMS;
@@ -803,6 +2115,8 @@ HRESULT STDMETHODCALLTYPE SurfaceImpl::GetPrivateData(REFGUID guidTag, LPVOID lp
 }
 
 HRESULT STDMETHODCALLTYPE SurfaceImpl::FreePrivateData(REFGUID guidTag) {
+    core::DeviceLockGuard deviceLock(UsesDeviceLock());
+
     m_privateData.erase(guidTag);
     return DD_OK;
 }
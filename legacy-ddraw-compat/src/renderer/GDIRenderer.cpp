@@ -5,32 +5,72 @@
  * The GDI renderer provides maximum compatibility by using only
  * standard Windows GDI functions. It works on any Windows system
  * but does not support shaders or hardware acceleration.
+ *
+ * 8-bit, RGB565 and XRGB primaries are handed to GDI as they are,
+ * described by a DIB header over the game's own pixels, so GDI converts
+ * while it copies to the window; the presented areas are also copied
+ * aside, unconverted, for repaints. Other frames are converted into a
+ * 32-bit DIB section first.
+ *
+ * Which GDI call is fastest depends on the driver and on whether DWM
+ * composes the window, so the present method is configurable, and by
+ * default each one is timed the first time a window is presented to at
+ * a given depth.
  */
 
 #include "renderer/IRenderer.h"
+#include "renderer/PixelConvert.h"
 #include "core/Common.h"
+#include <chrono>
+#include <map>
+#include <vector>
 
 using namespace ldc;
 using namespace ldc::renderer;
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t MicrosBetween(Clock::time_point start, Clock::time_point end) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+// Source formats GDI reads directly
+const uint32_t kGDINativeFormats = kSourcePalette8 | kSourceRGB565 | kSourceXRGB8888;
+
+// Frames each present method is timed over, after one to warm up
+const uint32_t kMethodBenchmarkFrames = 5;
+
+// BITMAPINFO with room for a full colour table, or the three BI_BITFIELDS masks
+struct SourceBitmapInfo {
+    BITMAPINFOHEADER header;
+    uint32_t colors[256];
+};
+
+} // namespace
+
 // ============================================================================
 // GDIRenderer Class
 // ============================================================================
 
 class GDIRenderer : public IRenderer {
 public:
-    GDIRenderer();
+    explicit GDIRenderer(GDIPresentMethod method);
     ~GDIRenderer() override;
 
     bool Initialize(HWND hWnd, uint32_t width, uint32_t height, uint32_t bpp) override;
     void Shutdown() override;
     bool IsInitialized() const override { return m_initialized; }
-    void Present(const void* pixels, uint32_t pitch, uint32_t width, uint32_t height, uint32_t bpp) override;
-    void SetPalette(const uint32_t* palette256) override;
+    void Present(const PresentFrame& frame) override;
+    void PresentPartial(const PresentFrame& frame, const RECT* rects, uint32_t count) override;
+    bool Repaint() override;
     void SetVSync(bool enabled) override;
     RendererType GetType() const override { return RendererType::GDI; }
     RendererCaps GetCaps() const override;
     bool IsAvailable() const override { return true; }
+    RendererTimings GetTimings() const override { return m_timings; }
     void OnResize(uint32_t width, uint32_t height) override;
 
 private:
@@ -47,24 +87,53 @@ private:
     uint32_t m_windowWidth = 0;
     uint32_t m_windowHeight = 0;
 
+    // Method from the configuration, and the one in use; until Initialize
+    // resolves Auto, the DIB calls are assumed
+    GDIPresentMethod m_configuredMethod;
+    GDIPresentMethod m_method;
+
     BITMAPINFO m_bitmapInfo{};
-    std::array<uint32_t, 256> m_palette{};
+
+    // Header over the game's pixels for frames GDI takes natively; the
+    // colour table is the uploaded palette
+    SourceBitmapInfo m_sourceInfo{};
+    uint32_t m_sourceBpp = 0;
+
+    // The DIB section holds the last frame, converted; false before the
+    // first frame and once native frames have bypassed it
+    bool m_imageValid = false;
+
+    // Copy of the last native frame in its own format, drawn with
+    // m_sourceInfo (whose palette is that frame's) on repaints; valid
+    // while native frames follow each other
+    std::vector<uint8_t> m_nativeImage;
+    uint32_t m_nativePitch = 0;
+    bool m_nativeValid = false;
 
     bool m_initialized = false;
 
+    RendererTimings m_timings;
+
     bool CreateRenderDIB();
     void DestroyRenderDIB();
+    bool CanPresentNative(const PresentFrame& frame) const;
+    void PrepareSourceInfo(const PresentFrame& frame);
+    void PresentAreas(const PresentFrame& frame, const RECT* rects, uint32_t count);
+    void RetainNativeAreas(const PresentFrame& frame, const RECT* areas, uint32_t count);
+
+    // Copy areas to the window with the present method, from the game's
+    // pixels for a native frame, else from the DIB section
+    void DrawAreas(const PresentFrame* nativeFrame, const RECT* areas, uint32_t count);
+    GDIPresentMethod TimePresentMethods();
 };
 
 // ============================================================================
 // GDIRenderer Implementation
 // ============================================================================
 
-GDIRenderer::GDIRenderer() {
-    // Initialize palette to grayscale
-    for (int i = 0; i < 256; ++i) {
-        m_palette[i] = (i << 16) | (i << 8) | i | 0xFF000000;
-    }
+GDIRenderer::GDIRenderer(GDIPresentMethod method)
+    : m_configuredMethod(method)
+    , m_method(method == GDIPresentMethod::Auto ? GDIPresentMethod::SetDIBits : method) {
 }
 
 GDIRenderer::~GDIRenderer() {
@@ -82,6 +151,10 @@ bool GDIRenderer::Initialize(HWND hWnd, uint32_t width, uint32_t height, uint32_
     m_gameWidth = width;
     m_gameHeight = height;
     m_gameBpp = bpp;
+    m_timings = RendererTimings{};
+    m_sourceBpp = 0;
+    m_imageValid = false;
+    m_nativeValid = false;
 
     // Get window dimensions
     RECT rect;
@@ -116,13 +189,29 @@ bool GDIRenderer::Initialize(HWND hWnd, uint32_t width, uint32_t height, uint32_
     }
 
     m_initialized = true;
-    DebugLog("GDIRenderer initialized successfully");
+
+    if (m_configuredMethod == GDIPresentMethod::Auto) {
+        m_method = SelectGDIPresentMethod(m_hWnd, m_gameBpp, [this] { return TimePresentMethods(); });
+    } else {
+        m_method = m_configuredMethod;
+    }
+
+    DebugLog("GDIRenderer initialized successfully (present method %s)", GDIPresentMethodToString(m_method));
     return true;
 }
 
 void GDIRenderer::Shutdown() {
     DebugLog("GDIRenderer::Shutdown");
 
+    if (m_timings.frames > 0) {
+        double frames = static_cast<double>(m_timings.frames);
+        DebugLog("GDIRenderer: %llu frames (%s), per frame: convert %.3f ms, scale %.3f ms, present %.3f ms",
+                 static_cast<unsigned long long>(m_timings.frames), GDIPresentMethodToString(m_method),
+                 m_timings.convertMicros / frames / 1000.0,
+                 m_timings.scaleMicros / frames / 1000.0,
+                 m_timings.presentMicros / frames / 1000.0);
+    }
+
     DestroyRenderDIB();
 
     if (m_hdcMem) {
@@ -183,107 +272,269 @@ void GDIRenderer::DestroyRenderDIB() {
     m_bitmapBits = nullptr;
 }
 
-void GDIRenderer::Present(
-    const void* pixels,
-    uint32_t pitch,
-    uint32_t width,
-    uint32_t height,
-    uint32_t bpp)
-{
-    if (!m_initialized || !m_bitmapBits || !pixels) {
-        return;
+void GDIRenderer::Present(const PresentFrame& frame) {
+    PresentAreas(frame, nullptr, 0);
+}
+
+void GDIRenderer::PresentPartial(const PresentFrame& frame, const RECT* rects, uint32_t count) {
+    if (count > 0) {
+        PresentAreas(frame, rects, count);
     }
+}
 
-    // Convert source pixels to 32-bit BGRA in our DIB
-    uint32_t* dest = static_cast<uint32_t*>(m_bitmapBits);
-    const uint8_t* src = static_cast<const uint8_t*>(pixels);
+bool GDIRenderer::CanPresentNative(const PresentFrame& frame) const {
+    // BitBlt only copies from the DIB section, which holds converted pixels
+    if (m_method == GDIPresentMethod::BitBlt || !(kGDINativeFormats & SourceFormatForBpp(frame.bpp))) {
+        return false;
+    }
 
-    // Handle size mismatch by using minimum
-    uint32_t copyWidth = (width < m_gameWidth) ? width : m_gameWidth;
-    uint32_t copyHeight = (height < m_gameHeight) ? height : m_gameHeight;
+    // The header describes pitch / bytes-per-pixel wide rows, which GDI
+    // expects to start on DWORD boundaries
+    uint32_t bytesPerPixel = frame.bpp / 8;
+    if (frame.pitch % 4 != 0 || frame.pitch % bytesPerPixel != 0) {
+        return false;
+    }
 
-    if (bpp == 8) {
-        // 8-bit palettized to 32-bit
-        for (uint32_t y = 0; y < copyHeight; ++y) {
-            const uint8_t* srcRow = src + y * pitch;
-            uint32_t* destRow = dest + y * m_gameWidth;
+    // GDI only widens 565 and passes XRGB through; a gamma ramp needs the
+    // tables, which the 8-bit palette already carries
+    return frame.bpp == 8 ? frame.palette != nullptr : frame.gammaRed == nullptr;
+}
 
-            for (uint32_t x = 0; x < copyWidth; ++x) {
-                destRow[x] = m_palette[srcRow[x]];
-            }
+void GDIRenderer::PrepareSourceInfo(const PresentFrame& frame) {
+    BITMAPINFOHEADER& header = m_sourceInfo.header;
+    if (m_sourceBpp != frame.bpp) {
+        ZeroMemory(&m_sourceInfo, sizeof(m_sourceInfo));
+        header.biSize = sizeof(BITMAPINFOHEADER);
+        header.biPlanes = 1;
+        header.biBitCount = static_cast<WORD>(frame.bpp);
+        header.biCompression = BI_RGB;
+
+        if (frame.bpp == 16) {
+            header.biCompression = BI_BITFIELDS;
+            m_sourceInfo.colors[0] = 0xF800;
+            m_sourceInfo.colors[1] = 0x07E0;
+            m_sourceInfo.colors[2] = 0x001F;
         }
     }
-    else if (bpp == 16) {
-        // 16-bit RGB565 to 32-bit
-        for (uint32_t y = 0; y < copyHeight; ++y) {
-            const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(src + y * pitch);
-            uint32_t* destRow = dest + y * m_gameWidth;
-
-            for (uint32_t x = 0; x < copyWidth; ++x) {
-                uint16_t pixel = srcRow[x];
-                uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-                uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-                uint8_t b = (pixel & 0x1F) << 3;
-                destRow[x] = (r << 16) | (g << 8) | b | 0xFF000000;
-            }
+
+    // The palette is uploaded once per change, not per frame
+    if (frame.bpp == 8 && (frame.paletteChanged || m_sourceBpp != 8)) {
+        header.biClrUsed = 256;
+        for (int i = 0; i < 256; ++i) {
+            m_sourceInfo.colors[i] = frame.palette[i] & 0x00FFFFFF;
         }
     }
-    else if (bpp == 24) {
-        // 24-bit RGB to 32-bit
-        for (uint32_t y = 0; y < copyHeight; ++y) {
-            const uint8_t* srcRow = src + y * pitch;
-            uint32_t* destRow = dest + y * m_gameWidth;
-
-            for (uint32_t x = 0; x < copyWidth; ++x) {
-                uint8_t b = srcRow[x * 3 + 0];
-                uint8_t g = srcRow[x * 3 + 1];
-                uint8_t r = srcRow[x * 3 + 2];
-                destRow[x] = (r << 16) | (g << 8) | b | 0xFF000000;
-            }
+
+    header.biWidth = static_cast<LONG>(frame.pitch / (frame.bpp / 8));
+    m_sourceBpp = frame.bpp;
+}
+
+void GDIRenderer::PresentAreas(const PresentFrame& frame, const RECT* rects, uint32_t count) {
+    if (!m_initialized || !m_bitmapBits || !frame.pixels) {
+        return;
+    }
+
+    // Handle size mismatch by using minimum
+    RECT bounds = {
+        0, 0,
+        static_cast<LONG>((std::min)(frame.width, m_gameWidth)),
+        static_cast<LONG>((std::min)(frame.height, m_gameHeight))
+    };
+    if (RectIsEmpty(bounds)) {
+        return;
+    }
+
+    // New colours reach every pixel, and a converted image that native
+    // frames bypassed must be rebuilt whole
+    bool native = CanPresentNative(frame);
+    RECT areas[kMaxDamageRects];
+    uint32_t areaCount = 1;
+    areas[0] = bounds;
+    if (rects && !frame.paletteChanged && (native || m_imageValid)) {
+        areaCount = ClipDamageRects(bounds, rects, count, kMaxDamageRects, areas);
+        if (areaCount == 0) {
+            return;
         }
     }
-    else if (bpp == 32) {
-        // 32-bit direct copy
-        for (uint32_t y = 0; y < copyHeight; ++y) {
-            const uint32_t* srcRow = reinterpret_cast<const uint32_t*>(src + y * pitch);
-            uint32_t* destRow = dest + y * m_gameWidth;
-            memcpy(destRow, srcRow, copyWidth * sizeof(uint32_t));
+
+    // Native frames only need their header (and palette) set up;
+    // others are converted to 32-bit BGRA in our DIB
+    Clock::time_point convertStart = Clock::now();
+    if (native) {
+        PrepareSourceInfo(frame);
+        RetainNativeAreas(frame, areas, areaCount);
+        m_imageValid = false;
+    } else {
+        for (uint32_t i = 0; i < areaCount; ++i) {
+            ConvertFrame(frame, areas[i], static_cast<uint32_t*>(m_bitmapBits), m_gameWidth);
         }
+        m_imageValid = true;
+        m_nativeValid = false;
     }
+    Clock::time_point convertEnd = Clock::now();
+    m_timings.convertMicros += MicrosBetween(convertStart, convertEnd);
+
+    DrawAreas(native ? &frame : nullptr, areas, areaCount);
 
-    // Blit to window
-    if (m_gameWidth == m_windowWidth && m_gameHeight == m_windowHeight) {
-        // Direct blit (no scaling)
-        ::BitBlt(
-            m_hdcWindow,
-            0, 0,
-            m_gameWidth, m_gameHeight,
-            m_hdcMem,
-            0, 0,
-            SRCCOPY
-        );
+    Clock::time_point blitEnd = Clock::now();
+    bool scaled = m_gameWidth != m_windowWidth || m_gameHeight != m_windowHeight;
+    if (scaled) {
+        m_timings.scaleMicros += MicrosBetween(convertEnd, blitEnd);
     }
-    else {
-        // Scaled blit
-        ::SetStretchBltMode(m_hdcWindow, HALFTONE);
-        ::SetBrushOrgEx(m_hdcWindow, 0, 0, nullptr);
 
-        ::StretchBlt(
-            m_hdcWindow,
-            0, 0,
-            m_windowWidth, m_windowHeight,
-            m_hdcMem,
-            0, 0,
-            m_gameWidth, m_gameHeight,
-            SRCCOPY
-        );
+    ::GdiFlush();
+    m_timings.presentMicros += MicrosBetween(scaled ? blitEnd : convertEnd, Clock::now());
+    m_timings.frames++;
+}
+
+void GDIRenderer::RetainNativeAreas(const PresentFrame& frame, const RECT* areas, uint32_t count) {
+    // Only the damage changes while native frames of one layout follow
+    // each other; anything else starts the copy over
+    size_t size = static_cast<size_t>(frame.pitch) * m_gameHeight;
+    if (!m_nativeValid || m_nativePitch != frame.pitch || m_nativeImage.size() != size) {
+        m_nativeImage.assign(size, 0);
+        m_nativePitch = frame.pitch;
+        memcpy(m_nativeImage.data(), frame.pixels,
+               static_cast<size_t>(frame.pitch) * (std::min)(frame.height, m_gameHeight));
+        m_nativeValid = true;
+        return;
+    }
+
+    uint32_t bytesPerPixel = frame.bpp / 8;
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t offset = static_cast<size_t>(areas[i].left) * bytesPerPixel;
+        size_t bytes = static_cast<size_t>(areas[i].right - areas[i].left) * bytesPerPixel;
+        for (LONG y = areas[i].top; y < areas[i].bottom; ++y) {
+            size_t row = static_cast<size_t>(y) * frame.pitch + offset;
+            memcpy(m_nativeImage.data() + row, frame.pixels + row, bytes);
+        }
+    }
+}
+
+GDIPresentMethod GDIRenderer::TimePresentMethods() {
+    // A black frame in the game's format takes the same path, native or
+    // converted, that the game's frames will take with each method
+    static const uint32_t kBlack[256] = {};
+    uint32_t pitch = (m_gameWidth * ((m_gameBpp + 7) / 8) + 3) & ~3u;
+    std::vector<uint8_t> pixels(static_cast<size_t>(pitch) * m_gameHeight);
+
+    PresentFrame frame;
+    frame.pixels = pixels.data();
+    frame.pitch = pitch;
+    frame.width = m_gameWidth;
+    frame.height = m_gameHeight;
+    frame.bpp = m_gameBpp;
+    frame.palette = kBlack;
+    frame.expandRed565 = kBlack;
+    frame.expandGreen565 = kBlack;
+    frame.expandBlue565 = kBlack;
+
+    GDIPresentMethod best = GDIPresentMethod::BitBlt;
+    uint64_t bestMicros = UINT64_MAX;
+    for (GDIPresentMethod method : { GDIPresentMethod::BitBlt, GDIPresentMethod::SetDIBits,
+                                     GDIPresentMethod::StretchDIBits }) {
+        m_method = method;
+        m_sourceBpp = 0;
+        PresentAreas(frame, nullptr, 0);
+
+        // The quickest frame is the one least disturbed by the rest of the system
+        uint64_t micros = UINT64_MAX;
+        for (uint32_t i = 0; i < kMethodBenchmarkFrames; ++i) {
+            Clock::time_point start = Clock::now();
+            PresentAreas(frame, nullptr, 0);
+            micros = (std::min)(micros, MicrosBetween(start, Clock::now()));
+        }
+
+        DebugLog("GDIRenderer: %s takes %llu us per frame", GDIPresentMethodToString(method),
+                 static_cast<unsigned long long>(micros));
+        if (micros < bestMicros) {
+            best = method;
+            bestMicros = micros;
+        }
+    }
+
+    // The game's first frame starts from a clean slate
+    m_timings = RendererTimings{};
+    m_sourceBpp = 0;
+    m_imageValid = false;
+    m_nativeValid = false;
+    return best;
+}
+
+bool GDIRenderer::Repaint() {
+    if (!m_initialized || (!m_imageValid && !m_nativeValid)) {
+        return false;
+    }
+
+    // The DIB section holds a converted frame at game size; a native one
+    // is drawn from its copy with the header and palette it was shown with
+    RECT full = { 0, 0, static_cast<LONG>(m_gameWidth), static_cast<LONG>(m_gameHeight) };
+    if (m_nativeValid) {
+        PresentFrame retained;
+        retained.pixels = m_nativeImage.data();
+        retained.pitch = m_nativePitch;
+        retained.width = m_gameWidth;
+        retained.height = m_gameHeight;
+        retained.bpp = m_sourceBpp;
+        DrawAreas(&retained, &full, 1);
+    } else {
+        DrawAreas(nullptr, &full, 1);
     }
+    ::GdiFlush();
+    return true;
 }
 
-void GDIRenderer::SetPalette(const uint32_t* palette256) {
-    if (palette256) {
-        memcpy(m_palette.data(), palette256, 256 * sizeof(uint32_t));
-        DebugLog("GDIRenderer: Palette updated");
+void GDIRenderer::DrawAreas(const PresentFrame* nativeFrame, const RECT* areas, uint32_t count) {
+    // The DIB calls read native frames from the game's pixels and others
+    // from the DIB section. Rects are drawn from a header starting at
+    // their top row, which keeps GDI's top-down scan numbering out of the way
+    bool native = nativeFrame != nullptr;
+    BITMAPINFO convertedInfo = m_bitmapInfo;
+    BITMAPINFOHEADER& dibHeader = native ? m_sourceInfo.header : convertedInfo.bmiHeader;
+    const BITMAPINFO* dibInfo = native ? reinterpret_cast<const BITMAPINFO*>(&m_sourceInfo) : &convertedInfo;
+    const uint8_t* dibBits = native ? nativeFrame->pixels : static_cast<const uint8_t*>(m_bitmapBits);
+    size_t dibPitch = native ? nativeFrame->pitch : m_gameWidth * sizeof(uint32_t);
+
+    bool scaled = m_gameWidth != m_windowWidth || m_gameHeight != m_windowHeight;
+    if (scaled) {
+        ::SetStretchBltMode(m_hdcWindow, HALFTONE);
+        ::SetBrushOrgEx(m_hdcWindow, 0, 0, nullptr);
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const RECT& area = areas[i];
+        int areaWidth = area.right - area.left;
+        int areaHeight = area.bottom - area.top;
+        const uint8_t* rows = dibBits + static_cast<size_t>(area.top) * dibPitch;
+        dibHeader.biHeight = -areaHeight;
+
+        // Scaled blits round the target outwards so no seams remain
+        RECT target = area;
+        if (scaled) {
+            target.left = static_cast<LONG>(static_cast<int64_t>(area.left) * m_windowWidth / m_gameWidth);
+            target.top = static_cast<LONG>(static_cast<int64_t>(area.top) * m_windowHeight / m_gameHeight);
+            target.right = static_cast<LONG>((static_cast<int64_t>(area.right) * m_windowWidth + m_gameWidth - 1) / m_gameWidth);
+            target.bottom = static_cast<LONG>((static_cast<int64_t>(area.bottom) * m_windowHeight + m_gameHeight - 1) / m_gameHeight);
+        }
+        int targetWidth = target.right - target.left;
+        int targetHeight = target.bottom - target.top;
+
+        if (m_method == GDIPresentMethod::BitBlt) {
+            if (!scaled) {
+                ::BitBlt(m_hdcWindow, area.left, area.top, areaWidth, areaHeight,
+                         m_hdcMem, area.left, area.top, SRCCOPY);
+            } else {
+                ::StretchBlt(m_hdcWindow, target.left, target.top, targetWidth, targetHeight,
+                             m_hdcMem, area.left, area.top, areaWidth, areaHeight, SRCCOPY);
+            }
+        } else if (!scaled && m_method == GDIPresentMethod::SetDIBits) {
+            ::SetDIBitsToDevice(m_hdcWindow, area.left, area.top, areaWidth, areaHeight,
+                                area.left, 0, 0, areaHeight, rows, dibInfo, DIB_RGB_COLORS);
+        } else {
+            ::StretchDIBits(m_hdcWindow, target.left, target.top, targetWidth, targetHeight,
+                            area.left, 0, areaWidth, areaHeight, rows, dibInfo,
+                            DIB_RGB_COLORS, SRCCOPY);
+        }
     }
 }
 
@@ -301,6 +552,9 @@ RendererCaps GDIRenderer::GetCaps() const {
     caps.maxTextureHeight = 8192;
     caps.name = "GDI";
     caps.version = "1.0";
+    caps.nativeFormats = m_method == GDIPresentMethod::BitBlt ? 0 : kGDINativeFormats;
+    caps.supportsPaletteUpload = true;
+    caps.maxDamageRects = kMaxDamageRects;
     return caps;
 }
 
@@ -317,8 +571,26 @@ void GDIRenderer::OnResize(uint32_t width, uint32_t height) {
 
 namespace ldc::renderer {
 
-std::unique_ptr<IRenderer> CreateGDIRenderer() {
-    return std::make_unique<GDIRenderer>();
+std::unique_ptr<IRenderer> CreateGDIRenderer(GDIPresentMethod method) {
+    return std::make_unique<GDIRenderer>(method);
+}
+
+GDIPresentMethod SelectGDIPresentMethod(HWND hWnd, uint32_t bpp,
+                                        const std::function<GDIPresentMethod()>& measure) {
+    // Held while timing, so two devices starting together time only once
+    static std::mutex mutex;
+    static std::map<std::pair<HWND, uint32_t>, GDIPresentMethod> selected;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_pair(hWnd, bpp);
+    auto it = selected.find(key);
+    if (it != selected.end()) {
+        return it->second;
+    }
+
+    GDIPresentMethod method = measure();
+    selected.emplace(key, method);
+    return method;
 }
 
 } // namespace ldc::renderer
@@ -0,0 +1,166 @@
+/**
+ * @file NullRenderer.cpp
+ * @brief Headless rendering backend
+ */
+
+#include "renderer/NullRenderer.h"
+#include "renderer/PixelConvert.h"
+#include "core/Common.h"
+#include "core/Hash.h"
+#include <chrono>
+
+using namespace ldc;
+using namespace ldc::renderer;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t MicrosBetween(Clock::time_point start, Clock::time_point end) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+} // namespace
+
+// ============================================================================
+// NullRenderer Implementation
+// ============================================================================
+
+NullRenderer::NullRenderer(NullCapture capture)
+    : m_capture(capture)
+{
+}
+
+NullRenderer::~NullRenderer() {
+    Shutdown();
+}
+
+bool NullRenderer::Initialize(HWND hWnd, uint32_t width, uint32_t height, uint32_t bpp) {
+    LDC_UNUSED(hWnd);
+    DebugLog("NullRenderer::Initialize: %ux%u %ubpp", width, height, bpp);
+
+    if (m_initialized) {
+        Shutdown();
+    }
+
+    m_width = width;
+    m_height = height;
+    m_image.assign(static_cast<size_t>(width) * height, 0);
+    m_frameHash = 0;
+    m_sequenceHash = 0;
+    m_timings = RendererTimings{};
+
+    m_initialized = true;
+    return true;
+}
+
+void NullRenderer::Shutdown() {
+    if (!m_initialized) {
+        return;
+    }
+
+    if (m_timings.frames > 0) {
+        double frames = static_cast<double>(m_timings.frames);
+        DebugLog("NullRenderer: %llu frames, per frame: convert %.3f ms, capture %.3f ms",
+                 static_cast<unsigned long long>(m_timings.frames),
+                 m_timings.convertMicros / frames / 1000.0,
+                 m_timings.presentMicros / frames / 1000.0);
+    }
+
+    m_image.clear();
+    m_image.shrink_to_fit();
+    m_initialized = false;
+}
+
+void NullRenderer::Present(const PresentFrame& frame) {
+    RECT area = {
+        0, 0,
+        static_cast<LONG>((std::min)(frame.width, m_width)),
+        static_cast<LONG>((std::min)(frame.height, m_height))
+    };
+    if (!RectIsEmpty(area)) {
+        PresentAreas(frame, &area, 1);
+    }
+}
+
+void NullRenderer::PresentPartial(const PresentFrame& frame, const RECT* rects, uint32_t count) {
+    // New colours reach every pixel, and this backend converts them all
+    if (frame.paletteChanged) {
+        Present(frame);
+        return;
+    }
+
+    RECT bounds = {
+        0, 0,
+        static_cast<LONG>((std::min)(frame.width, m_width)),
+        static_cast<LONG>((std::min)(frame.height, m_height))
+    };
+    RECT areas[kMaxDamageRects];
+    uint32_t areaCount = ClipDamageRects(bounds, rects, count, kMaxDamageRects, areas);
+    if (areaCount > 0) {
+        PresentAreas(frame, areas, areaCount);
+    }
+}
+
+void NullRenderer::PresentAreas(const PresentFrame& frame, const RECT* areas, uint32_t count) {
+    if (!m_initialized || m_image.empty() || !frame.pixels) {
+        return;
+    }
+
+    Clock::time_point convertStart = Clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        ConvertFrame(frame, areas[i], m_image.data(), m_width);
+    }
+    Clock::time_point convertEnd = Clock::now();
+    m_timings.convertMicros += MicrosBetween(convertStart, convertEnd);
+
+    // The whole image is hashed, so a partial present still yields the
+    // hash of what a window would now show
+    if (m_capture == NullCapture::Hash) {
+        m_frameHash = core::HashBytes(m_image.data(), m_image.size() * sizeof(uint32_t));
+        m_sequenceHash = core::HashBytes(&m_frameHash, sizeof(m_frameHash), m_sequenceHash);
+        m_timings.presentMicros += MicrosBetween(convertEnd, Clock::now());
+    }
+
+    m_timings.frames++;
+}
+
+bool NullRenderer::Repaint() {
+    // The image already is what a window would show again
+    return m_initialized && m_timings.frames > 0;
+}
+
+const uint32_t* NullRenderer::GetFrame() const {
+    if (m_capture != NullCapture::Store || m_image.empty()) {
+        return nullptr;
+    }
+    return m_image.data();
+}
+
+void NullRenderer::SetVSync(bool enabled) {
+    // Never throttled; there is no display to wait for
+    LDC_UNUSED(enabled);
+}
+
+RendererCaps NullRenderer::GetCaps() const {
+    RendererCaps caps{};
+    caps.supportsShaders = false;
+    caps.supportsVSync = false;
+    caps.maxTextureWidth = 16384;
+    caps.maxTextureHeight = 16384;
+    caps.name = "Null";
+    caps.version = "1.0";
+
+    // Converts every format itself, as the CPU fallback does
+    caps.nativeFormats = 0;
+    caps.supportsPaletteUpload = false;
+    caps.maxDamageRects = kMaxDamageRects;
+    return caps;
+}
+
+void NullRenderer::OnResize(uint32_t width, uint32_t height) {
+    // The image stays at game size; there is no window to scale to
+    LDC_UNUSED(width);
+    LDC_UNUSED(height);
+}
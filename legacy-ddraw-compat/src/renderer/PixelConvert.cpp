@@ -0,0 +1,130 @@
+/**
+ * @file PixelConvert.cpp
+ * @brief Conversion of presented frames to 32-bit XRGB
+ */
+
+#include "renderer/PixelConvert.h"
+
+using namespace ldc;
+using namespace ldc::renderer;
+
+// ============================================================================
+// Conversion Kernels
+// ============================================================================
+
+void ldc::renderer::ConvertFrame(const PresentFrame& frame, const RECT& area, uint32_t* dst, uint32_t dstStride) {
+    const uint8_t* srcPixels = frame.pixels;
+    uint32_t pitch = frame.pitch;
+    uint32_t x0 = static_cast<uint32_t>(area.left);
+    uint32_t x1 = static_cast<uint32_t>(area.right);
+    uint32_t y0 = static_cast<uint32_t>(area.top);
+    uint32_t y1 = static_cast<uint32_t>(area.bottom);
+
+    if (frame.bpp == 8) {
+        // 8-bit palettized; the palette carries the gamma ramp
+        const uint32_t* lut = frame.palette;
+        for (uint32_t y = y0; y < y1; ++y) {
+            const uint8_t* srcRow = srcPixels + y * pitch;
+            uint32_t* dstRow = dst + y * dstStride;
+            for (uint32_t x = x0; x < x1; ++x) {
+                dstRow[x] = lut[srcRow[x]];
+            }
+        }
+    }
+    else if (frame.bpp == 16) {
+        // 16-bit RGB565, expanded through tables that carry the gamma ramp
+        const uint32_t* expandRed = frame.expandRed565;
+        const uint32_t* expandGreen = frame.expandGreen565;
+        const uint32_t* expandBlue = frame.expandBlue565;
+        for (uint32_t y = y0; y < y1; ++y) {
+            const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(srcPixels + y * pitch);
+            uint32_t* dstRow = dst + y * dstStride;
+            for (uint32_t x = x0; x < x1; ++x) {
+                uint16_t pixel = srcRow[x];
+                dstRow[x] = 0xFF000000 | expandRed[(pixel >> 11) & 0x1F] |
+                            expandGreen[(pixel >> 5) & 0x3F] | expandBlue[pixel & 0x1F];
+            }
+        }
+    }
+    else if (frame.bpp == 24 && frame.gammaRed) {
+        // 24-bit RGB through the gamma tables
+        const uint8_t* gammaRed = frame.gammaRed;
+        const uint8_t* gammaGreen = frame.gammaGreen;
+        const uint8_t* gammaBlue = frame.gammaBlue;
+        for (uint32_t y = y0; y < y1; ++y) {
+            const uint8_t* srcRow = srcPixels + y * pitch;
+            uint32_t* dstRow = dst + y * dstStride;
+            for (uint32_t x = x0; x < x1; ++x) {
+                uint8_t b = gammaBlue[srcRow[x * 3 + 0]];
+                uint8_t g = gammaGreen[srcRow[x * 3 + 1]];
+                uint8_t r = gammaRed[srcRow[x * 3 + 2]];
+                dstRow[x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+    else if (frame.bpp == 24) {
+        // 24-bit RGB
+        for (uint32_t y = y0; y < y1; ++y) {
+            const uint8_t* srcRow = srcPixels + y * pitch;
+            uint32_t* dstRow = dst + y * dstStride;
+            for (uint32_t x = x0; x < x1; ++x) {
+                uint8_t b = srcRow[x * 3 + 0];
+                uint8_t g = srcRow[x * 3 + 1];
+                uint8_t r = srcRow[x * 3 + 2];
+                dstRow[x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+    else if (frame.bpp == 32 && frame.gammaRed) {
+        // 32-bit through the gamma tables
+        const uint8_t* gammaRed = frame.gammaRed;
+        const uint8_t* gammaGreen = frame.gammaGreen;
+        const uint8_t* gammaBlue = frame.gammaBlue;
+        for (uint32_t y = y0; y < y1; ++y) {
+            const uint32_t* srcRow = reinterpret_cast<const uint32_t*>(srcPixels + y * pitch);
+            uint32_t* dstRow = dst + y * dstStride;
+            for (uint32_t x = x0; x < x1; ++x) {
+                uint32_t pixel = srcRow[x];
+                dstRow[x] = (pixel & 0xFF000000) |
+                            (gammaRed[(pixel >> 16) & 0xFF] << 16) |
+                            (gammaGreen[(pixel >> 8) & 0xFF] << 8) |
+                            gammaBlue[pixel & 0xFF];
+            }
+        }
+    }
+    else if (frame.bpp == 32) {
+        // 32-bit - direct copy
+        for (uint32_t y = y0; y < y1; ++y) {
+            const uint32_t* srcRow = reinterpret_cast<const uint32_t*>(srcPixels + y * pitch);
+            uint32_t* dstRow = dst + y * dstStride;
+            memcpy(dstRow + x0, srcRow + x0, (x1 - x0) * sizeof(uint32_t));
+        }
+    }
+}
+
+// ============================================================================
+// Damage
+// ============================================================================
+
+uint32_t ldc::renderer::ClipDamageRects(const RECT& bounds, const RECT* rects, uint32_t count,
+                                        uint32_t maxRects, RECT* out) {
+    uint32_t written = 0;
+    RECT merged = {};
+    for (uint32_t i = 0; i < count; ++i) {
+        RECT clipped;
+        if (!RectIntersect(clipped, rects[i], bounds)) {
+            continue;
+        }
+        merged = RectUnion(merged, clipped);
+        if (written < maxRects) {
+            out[written] = clipped;
+        }
+        written++;
+    }
+
+    if (written > maxRects) {
+        out[0] = merged;
+        return 1;
+    }
+    return written;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file RendererFactory.cpp
+ * @brief Renderer backend selection
+ */
+
+#include "renderer/IRenderer.h"
+#include "renderer/NullRenderer.h"
+#include "config/Config.h"
+#include "core/Common.h"
+
+using namespace ldc;
+using namespace ldc::renderer;
+
+// ============================================================================
+// RendererFactory Implementation
+// ============================================================================
+
+std::unique_ptr<IRenderer> RendererFactory::Create(RendererType type) {
+    if (type == RendererType::Auto) {
+        return CreateBestAvailable();
+    }
+
+    std::unique_ptr<IRenderer> renderer = TryCreate(type);
+    if (!renderer) {
+        DebugLog("RendererFactory: %s renderer is not available", RendererTypeToString(type));
+    }
+    return renderer;
+}
+
+std::unique_ptr<IRenderer> RendererFactory::CreateBestAvailable() {
+    for (RendererType type : { RendererType::D3D9, RendererType::OpenGL, RendererType::GDI }) {
+        std::unique_ptr<IRenderer> renderer = TryCreate(type);
+        if (renderer) {
+            DebugLog("RendererFactory: using %s renderer", RendererTypeToString(type));
+            return renderer;
+        }
+    }
+    return nullptr;
+}
+
+bool RendererFactory::IsD3D9Available() {
+    // No Direct3D 9 backend is built yet
+    return false;
+}
+
+bool RendererFactory::IsOpenGLAvailable() {
+    // No OpenGL backend is built yet
+    return false;
+}
+
+std::unique_ptr<IRenderer> RendererFactory::TryCreate(RendererType type) {
+    std::unique_ptr<IRenderer> renderer;
+    switch (type) {
+        case RendererType::GDI:
+            renderer = CreateGDIRenderer(config::GetConfig().GetGDIPresentMethod());
+            break;
+        case RendererType::Null:
+            renderer = std::make_unique<NullRenderer>(config::GetConfig().GetNullCapture());
+            break;
+        case RendererType::D3D9:
+        case RendererType::OpenGL:
+        case RendererType::Auto:
+            break;
+    }
+
+    if (renderer && !renderer->IsAvailable()) {
+        renderer.reset();
+    }
+    return renderer;
+}
@@ -4,10 +4,30 @@
  */
 
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <string>
 
+#include "config/Config.h"
+#include "core/BlitQueue.h"
+#include "core/DeviceContext.h"
+#include "core/DeviceLock.h"
+#include "core/Fence.h"
+#include "core/FrameExporter.h"
+#include "core/Hash.h"
+#include "core/RWLock.h"
+#include "core/SurfaceAllocator.h"
+#include "core/SurfaceCompressor.h"
+#include "core/TileExecutor.h"
+#include "core/TileHasher.h"
+#include "core/VideoMemory.h"
+#include "core/OverlayCompositor.h"
+#include "interfaces/DirectDrawImpl.h"
+#include "interfaces/PaletteImpl.h"
+#include "renderer/NullRenderer.h"
+#include "renderer/PixelConvert.h"
+
 // Simple test framework macros
 #define TEST_ASSERT(condition) \
     do { \
@@ -327,7 +347,7 @@ bool test_rgb565_conversion() {
     TEST_ASSERT_EQ(0xFF0000F8u, rgb565ToRgb888(0x001F));
 
     // White
-    TEST_ASSERT_EQ(0xFFFFFCF8u, rgb565ToRgb888(0xFFFF));
+    TEST_ASSERT_EQ(0xFFF8FCF8u, rgb565ToRgb888(0xFFFF));
 
     // Black
     TEST_ASSERT_EQ(0xFF000000u, rgb565ToRgb888(0x0000));
@@ -335,6 +355,1632 @@ bool test_rgb565_conversion() {
     return true;
 }
 
+// ============================================================================
+// Overlay Tests
+// ============================================================================
+
+/**
+ * @brief Test overlay composition with source and destination keys
+ */
+bool test_overlay_colorkeys() {
+    const uint32_t srcKey = 0xFF00FF00;   // Green overlay pixels are transparent
+    const uint32_t destKey = 0xFF000000;  // Overlay only shows over black
+
+    // 20 pixels wide so both the vector body and the scalar tail are used
+    uint32_t overlay[20];
+    uint32_t primary[20];
+    uint32_t composed[20];
+    for (int i = 0; i < 20; ++i) {
+        overlay[i] = (i % 3 == 0) ? srcKey : 0xFF100000u + i;
+        primary[i] = (i % 2 == 0) ? destKey : 0xFFFFFFFFu;
+        composed[i] = primary[i];
+    }
+
+    ldc::core::OverlayBlendParams params;
+    params.srcPixels = reinterpret_cast<const uint8_t*>(overlay);
+    params.srcPitch = sizeof(overlay);
+    params.srcRect = { 0, 0, 20, 1 };
+    params.dstPixels = reinterpret_cast<uint8_t*>(composed);
+    params.dstPitch = sizeof(composed);
+    params.dstRect = { 0, 0, 20, 1 };
+    params.bytesPerPixel = 4;
+    params.useSrcKey = true;
+    params.srcKey = srcKey;
+    params.useDestKey = true;
+    params.destKey = destKey;
+
+    ldc::core::CompositeOverlay(params, params.dstRect);
+
+    for (int i = 0; i < 20; ++i) {
+        bool shown = (i % 3 != 0) && (i % 2 == 0);
+        TEST_ASSERT_EQ(shown ? overlay[i] : primary[i], composed[i]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Test overlay stretching and dirty-rect mapping
+ */
+bool test_overlay_stretch() {
+    uint16_t overlay[2] = { 0x1111, 0x2222 };
+    uint16_t primary[8] = { 0 };
+
+    ldc::core::OverlayBlendParams params;
+    params.srcPixels = reinterpret_cast<const uint8_t*>(overlay);
+    params.srcPitch = sizeof(overlay);
+    params.srcRect = { 0, 0, 2, 1 };
+    params.dstPixels = reinterpret_cast<uint8_t*>(primary);
+    params.dstPitch = sizeof(primary);
+    params.dstRect = { 2, 0, 6, 1 };
+    params.bytesPerPixel = 2;
+
+    // Only the clipped part of the destination is written
+    RECT clip = { 0, 0, 5, 1 };
+    ldc::core::CompositeOverlay(params, clip);
+
+    const uint16_t expected[8] = { 0, 0, 0x1111, 0x1111, 0x2222, 0, 0, 0 };
+    for (int i = 0; i < 8; ++i) {
+        TEST_ASSERT_EQ(expected[i], primary[i]);
+    }
+
+    // A change to the second overlay pixel covers destination x = 4..6
+    RECT changed = { 1, 0, 2, 1 };
+    RECT mapped = ldc::core::MapOverlayRect(changed, params.srcRect, params.dstRect);
+    TEST_ASSERT_EQ(4, mapped.left);
+    TEST_ASSERT_EQ(6, mapped.right);
+
+    return true;
+}
+
+// ============================================================================
+// Fence Tests
+// ============================================================================
+
+/**
+ * @brief Test fence completion ordering
+ */
+bool test_fence_completion() {
+    ldc::core::Fence fence;
+    TEST_ASSERT(fence.IsIdle());
+
+    uint64_t first = fence.Enqueue();
+    uint64_t second = fence.Enqueue();
+    TEST_ASSERT(!fence.IsComplete(first));
+    TEST_ASSERT(!fence.IsIdle());
+
+    // Signalling a later value completes everything before it
+    fence.Signal(second);
+    TEST_ASSERT(fence.IsComplete(first));
+    TEST_ASSERT(fence.IsIdle());
+
+    // A stale signal never moves the fence backwards
+    uint64_t third = fence.Enqueue();
+    fence.Signal(first);
+    TEST_ASSERT(!fence.IsComplete(third));
+
+    // Waiting on completed work is not counted
+    fence.Wait(second);
+    TEST_ASSERT_EQ(0, static_cast<int>(fence.GetStats().waitCount));
+
+    return true;
+}
+
+/**
+ * @brief Test deferred blit ordering and fence flushing
+ */
+bool test_blit_queue_ordering() {
+    uint32_t surfaceA[64] = { 0 };
+    uint32_t surfaceB[64] = { 0 };
+    ldc::core::Fence fenceA;
+    ldc::core::Fence fenceB;
+
+    {
+        ldc::core::BlitQueue queue(2);
+
+        ldc::core::BlitAccess fillA;
+        fillA.resource = surfaceA;
+        fillA.fence = &fenceA;
+        fillA.rect = { 0, 0, 8, 8 };
+        fillA.write = true;
+
+        // Fill A, then copy A into B: the copy must see the fill
+        queue.Submit([&] {
+            for (uint32_t& pixel : surfaceA) pixel = 0x11223344;
+        }, &fillA, 1);
+
+        ldc::core::BlitAccess copy[2] = { fillA, fillA };
+        copy[0].write = false;
+        copy[1].resource = surfaceB;
+        copy[1].fence = &fenceB;
+        queue.Submit([&] {
+            memcpy(surfaceB, surfaceA, sizeof(surfaceB));
+        }, copy, 2);
+
+        // Waiting on B's fence flushes the chain of work it depends on
+        fenceB.WaitIdle();
+        TEST_ASSERT_EQ(0x11223344u, surfaceB[63]);
+        TEST_ASSERT(fenceA.IsIdle());
+
+        queue.Drain();
+        TEST_ASSERT_EQ(2, static_cast<int>(queue.GetStats().executed));
+    }
+
+    return true;
+}
+
+/**
+ * @brief Test row-band splitting covers every row exactly once
+ */
+bool test_tile_executor_bands() {
+    ldc::core::TileExecutor executor(3, 1000);
+    TEST_ASSERT_EQ(1000, static_cast<int>(executor.GetThreshold()));
+
+    std::vector<int> hits(480, 0);
+    auto band = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            ++hits[y];
+        }
+    };
+
+    // Small operations stay on the calling thread
+    executor.Run(4, 999, band);
+    TEST_ASSERT_EQ(1, static_cast<int>(executor.GetStats().inlineRuns));
+
+    executor.Run(480, 640 * 480, band);
+    TEST_ASSERT_EQ(1, static_cast<int>(executor.GetStats().parallelRuns));
+    TEST_ASSERT(executor.GetStats().bands > 1);
+
+    for (int y = 0; y < 480; ++y) {
+        TEST_ASSERT_EQ(y < 4 ? 2 : 1, hits[y]);
+    }
+
+    // Measuring the crossover does not hold up construction or blits, and
+    // its own bands are not counted
+    ldc::core::TileExecutor measuring(3, -1);
+    std::fill(hits.begin(), hits.end(), 0);
+    measuring.Run(480, ldc::core::TileExecutor::kDefaultThreshold, band);
+    for (int y = 0; y < 480; ++y) {
+        TEST_ASSERT_EQ(1, hits[y]);
+    }
+    TEST_ASSERT(measuring.GetStats().bands <= 8);
+
+    return true;
+}
+
+/**
+ * @brief Test surface allocator alignment, size classes and recycling
+ */
+bool test_surface_allocator() {
+    using ldc::core::SurfaceAllocator;
+    SurfaceAllocator& allocator = SurfaceAllocator::Instance();
+
+    // Every class holds its requests and wastes less than a quarter
+    for (size_t size = 1; size < (1u << 22); size = size * 3 / 2 + 1) {
+        size_t classSize = SurfaceAllocator::SizeOfClass(SurfaceAllocator::SizeClassOf(size));
+        TEST_ASSERT(classSize >= size);
+        TEST_ASSERT(size <= 64 || classSize * 4 < size * 5 + 4);
+    }
+
+    // Rows are padded to cache lines; narrow sprite rows only to DWORDs
+    TEST_ASSERT_EQ(64, static_cast<int>(allocator.GetAlignment()));
+    TEST_ASSERT_EQ(192, static_cast<int>(allocator.AlignPitch(40 * 4)));
+    TEST_ASSERT_EQ(12, static_cast<int>(allocator.AlignPitch(10)));
+
+    // 24-bit pitches stay whole pixels so a DIB section can share them
+    TEST_ASSERT_EQ(384, static_cast<int>(allocator.AlignPitch(100 * 3, 3)));
+
+    uint64_t hitsBefore = allocator.GetStats().poolHits;
+    const uint8_t* firstSprite = nullptr;
+    {
+        ldc::core::SurfaceMemory sprite = allocator.Allocate(32 * 32);
+        ldc::core::SurfaceMemory screen = allocator.Allocate(640 * 480 * 2);
+        TEST_ASSERT_EQ(0, static_cast<int>(reinterpret_cast<uintptr_t>(sprite.data()) % 64));
+        TEST_ASSERT_EQ(0, static_cast<int>(reinterpret_cast<uintptr_t>(screen.data()) % 64));
+        TEST_ASSERT_EQ(0, static_cast<int>(screen.data()[640 * 480 * 2 - 1]));
+
+        sprite.data()[0] = 0xAB;
+        firstSprite = sprite.data();
+    }
+
+    // Freed blocks come back zeroed for the next surface of the same class
+    ldc::core::SurfaceMemory again = allocator.Allocate(32 * 32);
+    TEST_ASSERT(again.data() == firstSprite);
+    TEST_ASSERT_EQ(0, static_cast<int>(again.data()[0]));
+    TEST_ASSERT_EQ(1, static_cast<int>(allocator.GetStats().poolHits - hitsBefore));
+
+    return true;
+}
+
+/**
+ * @brief Test page-backed surface storage and pinning
+ */
+bool test_surface_page_backing() {
+    using ldc::core::SurfaceAllocator;
+    SurfaceAllocator& allocator = SurfaceAllocator::Instance();
+    allocator.SetPageBacking(256 * 1024, false);
+
+    const size_t size = 640 * 480 * 4;
+    {
+        ldc::core::SurfaceMemory backBuffer = allocator.Allocate(size);
+        TEST_ASSERT(backBuffer.IsPageBacked());
+        TEST_ASSERT_EQ(0, static_cast<int>(backBuffer.data()[size - 1]));
+        backBuffer.data()[size - 1] = 0x5A;
+
+        TEST_ASSERT(allocator.Pin(backBuffer));
+        TEST_ASSERT(backBuffer.IsPinned());
+        TEST_ASSERT(allocator.GetStats().bytesPinned >= size);
+        allocator.Unpin(backBuffer);
+        TEST_ASSERT_EQ(0, static_cast<int>(allocator.GetStats().bytesPinned));
+    }
+
+    // The reservation is reused and recommitted as fresh zero pages
+    uint64_t reusedBefore = allocator.GetStats().reservationsReused;
+    ldc::core::SurfaceMemory again = allocator.Allocate(size);
+    TEST_ASSERT_EQ(1, static_cast<int>(allocator.GetStats().reservationsReused - reusedBefore));
+    TEST_ASSERT_EQ(0, static_cast<int>(again.data()[size - 1]));
+
+    // Small surfaces stay pooled and cannot be pinned
+    ldc::core::SurfaceMemory sprite = allocator.Allocate(64 * 64);
+    TEST_ASSERT(!sprite.IsPageBacked());
+    TEST_ASSERT(!allocator.Pin(sprite));
+
+    allocator.SetPageBacking(0, false);
+    return true;
+}
+
+/**
+ * @brief Test copy-on-write sharing of surface storage
+ */
+bool test_surface_copy_on_write() {
+    using ldc::core::SurfaceAllocator;
+    SurfaceAllocator& allocator = SurfaceAllocator::Instance();
+
+    ldc::core::SurfaceMemory sheet = allocator.Allocate(128 * 128);
+    memset(sheet.data(), 0x42, sheet.size());
+    uint64_t hash = ldc::core::HashBytes(sheet.data(), sheet.size());
+
+    uint64_t sharedBefore = allocator.GetStats().bytesShared;
+    ldc::core::SurfaceMemory duplicate = allocator.Share(sheet);
+    TEST_ASSERT(duplicate.data() == sheet.data());
+    TEST_ASSERT(sheet.IsShared() && duplicate.IsShared());
+    TEST_ASSERT(allocator.GetStats().bytesShared > sharedBefore);
+
+    // The first write gives the writer a private copy of the same pixels
+    TEST_ASSERT(allocator.MakeUnique(duplicate));
+    TEST_ASSERT(duplicate.data() != sheet.data());
+    TEST_ASSERT(!sheet.IsShared() && !duplicate.IsShared());
+    TEST_ASSERT_EQ(sharedBefore, allocator.GetStats().bytesShared);
+    TEST_ASSERT_EQ(hash, ldc::core::HashBytes(duplicate.data(), duplicate.size()));
+
+    duplicate.data()[7] = 0x43;
+    TEST_ASSERT_EQ(0x42, static_cast<int>(sheet.data()[7]));
+    TEST_ASSERT(hash != ldc::core::HashBytes(duplicate.data(), duplicate.size()));
+
+    return true;
+}
+
+/**
+ * @brief Test the idle surface codec round trip and stall histogram
+ */
+bool test_surface_compression() {
+    using namespace ldc::core;
+
+    // A 16-bit sprite sheet: solid background with noisy sprites
+    const size_t size = 256 * 256 * 2;
+    std::vector<uint8_t> pixels(size, 0);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = ((i / 512) % 4 == 0) ? static_cast<uint8_t>(seed >> 16) : 0xF8;
+    }
+
+    std::vector<uint8_t> packed;
+    TEST_ASSERT(CompressPixels(pixels.data(), size, packed));
+    TEST_ASSERT(packed.size() < size / 2);
+
+    std::vector<uint8_t> unpacked(size, 0xCC);
+    TEST_ASSERT(DecompressPixels(packed.data(), packed.size(), unpacked.data(), size));
+    TEST_ASSERT(unpacked == pixels);
+
+    // A truncated stream is rejected instead of overrunning
+    TEST_ASSERT(!DecompressPixels(packed.data(), packed.size() / 2, unpacked.data(), size));
+
+    // Noise is left alone
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = static_cast<uint8_t>(seed >> 16);
+    }
+    TEST_ASSERT(!CompressPixels(pixels.data(), size, packed));
+
+    TEST_ASSERT_EQ(0u, SurfaceCompressor::StallBucketOf(10));
+    TEST_ASSERT_EQ(1u, SurfaceCompressor::StallBucketOf(64));
+    TEST_ASSERT_EQ(5u, SurfaceCompressor::StallBucketOf(1500));
+    TEST_ASSERT_EQ(kStallBuckets - 1, SurfaceCompressor::StallBucketOf(10000000));
+
+    return true;
+}
+
+/**
+ * @brief Test per-class video memory accounting against a budget
+ */
+bool test_video_memory_budget() {
+    using namespace ldc::core;
+    const uint64_t MB = 1024 * 1024;
+    VideoMemoryTracker videoMemory(8 * MB);
+
+    TEST_ASSERT(videoMemory.Reserve(SurfaceClass::Primary, 3 * MB));
+    TEST_ASSERT(videoMemory.Reserve(SurfaceClass::BackBuffer, 3 * MB));
+    TEST_ASSERT_EQ(2 * MB, videoMemory.GetFree());
+
+    // Over budget is refused, but system memory is only counted
+    TEST_ASSERT(!videoMemory.Reserve(SurfaceClass::Offscreen, 3 * MB));
+    TEST_ASSERT(videoMemory.Reserve(SurfaceClass::SystemMemory, 3 * MB));
+    TEST_ASSERT_EQ(2 * MB, videoMemory.GetFree());
+
+    videoMemory.Release(SurfaceClass::BackBuffer, 3 * MB);
+    TEST_ASSERT(videoMemory.Reserve(SurfaceClass::Offscreen, 3 * MB));
+
+    VideoMemoryStats stats = videoMemory.GetStats();
+    TEST_ASSERT_EQ(1u, stats.failedAllocations);
+    TEST_ASSERT_EQ(0u, stats.bytes[static_cast<size_t>(SurfaceClass::BackBuffer)]);
+    TEST_ASSERT_EQ(3 * MB, stats.peakBytes[static_cast<size_t>(SurfaceClass::BackBuffer)]);
+    TEST_ASSERT_EQ(3 * MB, stats.bytes[static_cast<size_t>(SurfaceClass::SystemMemory)]);
+
+    DDSCAPS2 caps{};
+    caps.dwCaps = DDSCAPS_OFFSCREENPLAIN;
+    TEST_ASSERT(VideoMemoryTracker::ClassOf(caps) == SurfaceClass::Offscreen);
+    caps.dwCaps = DDSCAPS_PRIMARYSURFACE | DDSCAPS_FLIP;
+    TEST_ASSERT(VideoMemoryTracker::ClassOf(caps) == SurfaceClass::Primary);
+    caps.dwCaps = DDSCAPS_FLIP | DDSCAPS_SYSTEMMEMORY;
+    TEST_ASSERT(VideoMemoryTracker::ClassOf(caps) == SurfaceClass::SystemMemory);
+
+    return true;
+}
+
+/**
+ * @brief Test reader/writer exclusion of the surface pixel lock
+ */
+bool test_rw_lock_exclusion() {
+    ldc::core::RWLock lock;
+
+    // Readers share, writers exclude everyone
+    TEST_ASSERT(lock.TryLockShared());
+    TEST_ASSERT(lock.TryLockShared());
+    TEST_ASSERT(!lock.TryLock());
+    lock.UnlockShared();
+    lock.UnlockShared();
+    TEST_ASSERT(lock.TryLock());
+    TEST_ASSERT(!lock.TryLockShared());
+    lock.Unlock();
+
+    // Writers bump both halves of a pair that readers check stays equal
+    uint64_t pair[2] = { 0, 0 };
+    std::atomic<int> torn{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 20000; ++i) {
+                if (t == 0 || i % 8 == 0) {
+                    ldc::core::ExclusiveLockGuard guard(lock);
+                    ++pair[0];
+                    ++pair[1];
+                } else {
+                    ldc::core::SharedLockGuard guard(lock);
+                    if (pair[0] != pair[1]) {
+                        ++torn;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    TEST_ASSERT_EQ(0, torn.load());
+    TEST_ASSERT_EQ(20000u + 3 * 2500u, pair[0]);
+    TEST_ASSERT(lock.TryLock());
+    lock.Unlock();
+
+    return true;
+}
+
+/**
+ * @brief Test recursion and exclusion of the device thread lock
+ */
+bool test_device_lock() {
+    ldc::core::DeviceLock lock;
+
+    // The owner may nest; other threads are shut out until the last unlock
+    lock.Lock();
+    TEST_ASSERT(lock.TryLock());
+    TEST_ASSERT(lock.IsHeldByCurrentThread());
+    bool otherGotIt = true;
+    std::thread([&] { otherGotIt = lock.TryLock(); }).join();
+    TEST_ASSERT(!otherGotIt);
+    lock.Unlock();
+    std::thread([&] { otherGotIt = lock.TryLock(); }).join();
+    TEST_ASSERT(!otherGotIt);
+    lock.Unlock();
+    TEST_ASSERT(!lock.IsHeldByCurrentThread());
+
+    // Contended increments are never lost, whether waiters spin or sleep
+    uint64_t counter = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20000; ++i) {
+                lock.Lock();
+                lock.Lock();
+                ++counter;
+                lock.Unlock();
+                lock.Unlock();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    TEST_ASSERT_EQ(80000u, counter);
+    ldc::core::DeviceLockStats stats = lock.GetStats();
+    TEST_ASSERT_EQ(stats.contended, stats.spinAcquired + stats.blocked);
+    TEST_ASSERT(stats.spinLimit >= ldc::core::DeviceLock::kMinSpin);
+    TEST_ASSERT(stats.spinLimit <= ldc::core::DeviceLock::kMaxSpin);
+
+    // A disabled guard never touches the lock
+    {
+        ldc::core::DeviceLockGuard guard(false);
+        TEST_ASSERT(!ldc::core::DeviceLock::Instance().IsHeldByCurrentThread());
+    }
+
+    return true;
+}
+
+/**
+ * @brief Test the game/presenter/window split of DeviceContext
+ *
+ * Checks that the blocks written by different threads sit on different
+ * cache lines, and that the window procedure never reads a torn input
+ * mapping. ldc_bench --contention times the layout against the old one.
+ */
+bool test_device_context_false_sharing() {
+    auto state = std::make_unique<ldc::DeviceContext>();
+    auto lineOf = [&](const void* p) {
+        return (reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(state.get())) /
+               ldc::kCacheLineSize;
+    };
+
+    // Every block starts its own line and no two threads' hot fields share one
+    TEST_ASSERT(reinterpret_cast<uintptr_t>(state.get()) % ldc::kCacheLineSize == 0);
+    TEST_ASSERT(lineOf(&state->game.paletteChanged) != lineOf(&state->present.frameCount));
+    TEST_ASSERT(lineOf(&state->game.paletteChanged) != lineOf(&state->input));
+    TEST_ASSERT(lineOf(&state->present.frameCount) != lineOf(&state->input));
+    TEST_ASSERT(lineOf(&state->present.presentPixels) != lineOf(&state->renderMutex));
+    TEST_ASSERT(lineOf(&state->window.hWnd) != lineOf(&state->game.width));
+    TEST_ASSERT(lineOf(&state->game.palette32[255]) < lineOf(&state->present));
+
+    // The window republishes the mapping as WM_SIZE would while another
+    // thread maps the mouse through it
+    constexpr int kIterations = 200000;
+    std::atomic<bool> done{false};
+    std::thread window([&] {
+        for (int i = 0; !done.load(std::memory_order_relaxed); ++i) {
+            ldc::InputMapping mapping;
+            mapping.gameWidth = 640 + (i & 0xFF);
+            mapping.scaleX = static_cast<float>(mapping.gameWidth) / mapping.renderWidth;
+            state->input.Store(mapping);
+            std::this_thread::yield();
+        }
+    });
+    int torn = 0;
+    for (int i = 0; i < kIterations; ++i) {
+        ldc::InputMapping mapping = state->input.Load();
+        if (mapping.scaleX != static_cast<float>(mapping.gameWidth) / mapping.renderWidth) {
+            ++torn;
+        }
+    }
+    done = true;
+    window.join();
+    TEST_ASSERT_EQ(0, torn);
+
+    return true;
+}
+
+/**
+ * @brief Test that devices created in parallel keep their own render state
+ */
+bool test_device_context_isolation() {
+    constexpr int kDevices = 4;
+    std::vector<std::unique_ptr<ldc::DeviceContext>> devices;
+    for (int i = 0; i < kDevices; ++i) {
+        devices.push_back(std::make_unique<ldc::DeviceContext>());
+    }
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kDevices; ++i) {
+        threads.emplace_back([&, i] {
+            ldc::DeviceContext& device = *devices[i];
+            DWORD width = 320 * (i + 1);
+            DWORD height = 200 * (i + 1);
+            for (int round = 0; round < 200; ++round) {
+                if (!ldc::CreateRenderTarget(device, width, height, 8)) {
+                    ++mismatches;
+                }
+                device.game.palette32[1] = 0xFF000000u | static_cast<uint32_t>(i);
+                ldc::InputMapping mapping = device.input.Load();
+                if (device.present.bitmapWidth != width || device.present.bitmapHeight != height ||
+                    device.present.primaryPixels.size() != static_cast<size_t>(width) * height ||
+                    mapping.gameWidth != width || mapping.gameHeight != height ||
+                    device.game.palette32[1] != (0xFF000000u | static_cast<uint32_t>(i))) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    TEST_ASSERT_EQ(0, mismatches.load());
+
+    // Without a window the mapping is the identity at the game's size
+    POINT pt = { 5000, 7 };
+    POINT mapped = ldc::TransformMouseToGame(*devices[0], pt);
+    TEST_ASSERT_EQ(319, mapped.x);
+    TEST_ASSERT_EQ(7, mapped.y);
+
+    return true;
+}
+
+/**
+ * @brief Test SetEntries rebuilds only the LUT slots whose colour changed
+ */
+bool test_palette_incremental_update() {
+    auto device = std::make_shared<ldc::DeviceContext>();
+
+    PALETTEENTRY entries[256];
+    for (int i = 0; i < 256; ++i) {
+        entries[i] = { static_cast<BYTE>(i), 0, 0, 0 };
+    }
+    auto* palette = new ldc::interfaces::PaletteImpl(device, DDPCAPS_8BIT, entries);
+    TEST_ASSERT_EQ(256u, palette->GetEntryCount());
+    TEST_ASSERT_EQ(0xFF800000u, palette->GetLut()[0x80]);
+
+    // Rewriting a range where only one colour moves changes only that slot
+    uint32_t lutBefore[256];
+    memcpy(lutBefore, palette->GetLut(), sizeof(lutBefore));
+    PALETTEENTRY range[16];
+    memcpy(range, entries + 16, sizeof(range));
+    range[3] = { 0, 0xFF, 0, 0 };
+    TEST_ASSERT(palette->SetEntries(0, 16, 16, range) == DD_OK);
+    TEST_ASSERT_EQ(1u, palette->GetVersion());
+    for (int i = 0; i < 256; ++i) {
+        uint32_t expected = (i == 19) ? 0xFF00FF00u : lutBefore[i];
+        TEST_ASSERT_EQ(expected, palette->GetLut()[i]);
+    }
+    TEST_ASSERT_EQ(0xFF, palette->GetColorTable()[19].rgbGreen);
+
+    // Identical entries leave the version alone
+    TEST_ASSERT(palette->SetEntries(0, 16, 16, range) == DD_OK);
+    TEST_ASSERT_EQ(1u, palette->GetVersion());
+
+    PALETTEENTRY readBack[2];
+    TEST_ASSERT(palette->GetEntries(0, 18, 2, readBack) == DD_OK);
+    TEST_ASSERT_EQ(0xFF, readBack[1].peGreen);
+    TEST_ASSERT(palette->SetEntries(0, 250, 10, range) == DDERR_INVALIDPARAMS);
+
+    // A 4-bit palette only has 16 entries
+    auto* small = new ldc::interfaces::PaletteImpl(device, DDPCAPS_4BIT, entries);
+    TEST_ASSERT_EQ(16u, small->GetEntryCount());
+    TEST_ASSERT(small->GetEntries(0, 15, 2, readBack) == DDERR_INVALIDPARAMS);
+    TEST_ASSERT_EQ(0u, ldc::interfaces::PaletteImpl::GetEntryCountForCaps(DDPCAPS_4BIT | DDPCAPS_8BIT));
+
+    TEST_ASSERT_EQ(0u, small->Release());
+    TEST_ASSERT_EQ(0u, palette->Release());
+    return true;
+}
+
+// Renderer converting into a caller-owned buffer instead of a window
+class CaptureRenderer : public ldc::renderer::IRenderer {
+public:
+    CaptureRenderer(uint32_t* pixels, uint32_t width) : m_pixels(pixels), m_width(width) {}
+
+    bool Initialize(HWND, uint32_t, uint32_t, uint32_t) override { return true; }
+    void Shutdown() override {}
+    bool IsInitialized() const override { return true; }
+    void Present(const ldc::renderer::PresentFrame& frame) override {
+        RECT area = { 0, 0, static_cast<LONG>(frame.width), static_cast<LONG>(frame.height) };
+        ldc::renderer::ConvertFrame(frame, area, m_pixels, m_width);
+        m_paletteChanged = frame.paletteChanged;
+        m_timings.frames++;
+    }
+    void PresentPartial(const ldc::renderer::PresentFrame& frame, const RECT* rects, uint32_t count) override {
+        RECT bounds = { 0, 0, static_cast<LONG>(frame.width), static_cast<LONG>(frame.height) };
+        for (uint32_t i = 0; i < count; ++i) {
+            RECT area;
+            if (ldc::RectIntersect(area, rects[i], bounds)) {
+                ldc::renderer::ConvertFrame(frame, area, m_pixels, m_width);
+            }
+        }
+        m_paletteChanged = frame.paletteChanged;
+        m_partialFrames++;
+        m_timings.frames++;
+    }
+    void SetVSync(bool) override {}
+    void OnResize(uint32_t width, uint32_t height) override {
+        m_windowWidth = width;
+        m_windowHeight = height;
+    }
+    ldc::RendererType GetType() const override { return ldc::RendererType::GDI; }
+    ldc::renderer::RendererCaps GetCaps() const override { return {}; }
+    bool IsAvailable() const override { return true; }
+    ldc::renderer::RendererTimings GetTimings() const override { return m_timings; }
+
+    uint32_t GetPartialFrames() const { return m_partialFrames; }
+    bool GetPaletteChanged() const { return m_paletteChanged; }
+    uint32_t GetWindowWidth() const { return m_windowWidth; }
+    uint32_t GetWindowHeight() const { return m_windowHeight; }
+
+private:
+    uint32_t* m_pixels;
+    uint32_t m_width;
+    uint32_t m_windowWidth = 0;
+    uint32_t m_windowHeight = 0;
+    uint32_t m_partialFrames = 0;
+    bool m_paletteChanged = false;
+    ldc::renderer::RendererTimings m_timings;
+};
+
+/**
+ * @brief Test palette changes within a refresh period are presented once
+ */
+bool test_palette_changes_coalesced() {
+    auto device = std::make_shared<ldc::DeviceContext>();
+
+    PALETTEENTRY entries[256] = {};
+    auto* palette = new ldc::interfaces::PaletteImpl(device, DDPCAPS_8BIT, entries);
+
+    // A 4x1 primary presented into a caller-owned buffer
+    uint8_t pixels[4] = { 0, 1, 2, 3 };
+    uint32_t converted[4] = {};
+    device->present.renderer = std::make_unique<CaptureRenderer>(converted, 4);
+    device->present.bitmapWidth = 4;
+    device->present.bitmapHeight = 1;
+    device->present.presentPixels = pixels;
+    device->present.primaryPitch = 4;
+    device->present.primaryBpp = 8;
+    device->present.paletteLut = palette->GetLut();
+    device->present.lastPresentTime = GetTickCount();
+
+    // A fade step per call, all within one refresh period
+    for (int step = 1; step <= 50; ++step) {
+        PALETTEENTRY entry = { static_cast<BYTE>(step), 0, 0, 0 };
+        TEST_ASSERT(palette->SetEntries(0, 2, 1, &entry) == DD_OK);
+    }
+    TEST_ASSERT_EQ(50u, device->game.paletteChanges.load());
+    TEST_ASSERT_EQ(0u, device->present.paletteFrames);
+
+    // The vertical blank applies the latest state once
+    ldc::FlushPaletteChanges(*device, true);
+    TEST_ASSERT_EQ(0u, device->game.paletteChanges.load());
+    TEST_ASSERT_EQ(1u, device->present.paletteFrames);
+    TEST_ASSERT_EQ(50u, device->present.paletteChangesApplied);
+    TEST_ASSERT_EQ(50u, device->present.paletteChangesLastFrame.load());
+    TEST_ASSERT_EQ(0xFF320000u, converted[2]);
+    auto* renderer = static_cast<CaptureRenderer*>(device->present.renderer.get());
+    TEST_ASSERT(renderer->GetPaletteChanged());
+
+    // Nothing queued: a further vertical blank converts nothing
+    converted[2] = 0;
+    ldc::FlushPaletteChanges(*device, true);
+    TEST_ASSERT_EQ(0u, converted[2]);
+
+    // A later partial present keeps the palette; the renderer is told so
+    RECT dirty = { 0, 0, 1, 1 };
+    ldc::PresentPrimaryToScreen(*device, &dirty);
+    TEST_ASSERT(!renderer->GetPaletteChanged());
+    TEST_ASSERT_EQ(1u, renderer->GetPartialFrames());
+
+    device->present.paletteLut = nullptr;
+    device->present.presentPixels = nullptr;
+    palette->Release();
+    return true;
+}
+
+/**
+ * @brief Test a palette change made between presents is shown without another present
+ */
+bool test_palette_deferred_flush() {
+    auto device = std::make_shared<ldc::DeviceContext>();
+
+    PALETTEENTRY entries[256] = {};
+    auto* palette = new ldc::interfaces::PaletteImpl(device, DDPCAPS_8BIT, entries);
+
+    uint8_t pixels[4] = { 0, 1, 2, 3 };
+    uint32_t converted[4] = {};
+    device->present.renderer = std::make_unique<CaptureRenderer>(converted, 4);
+    device->present.bitmapWidth = 4;
+    device->present.bitmapHeight = 1;
+    device->present.presentPixels = pixels;
+    device->present.primaryPitch = 4;
+    device->present.primaryBpp = 8;
+    device->present.paletteLut = palette->GetLut();
+    device->present.lastPresentTime = GetTickCount();
+
+    // The last change of a fade, with no present, Flip or vertical blank wait after it
+    PALETTEENTRY entry = { 0x40, 0, 0, 0 };
+    TEST_ASSERT(palette->SetEntries(0, 2, 1, &entry) == DD_OK);
+
+    // The presenter thread shows it once the refresh period is over
+    uint64_t frames = 0;
+    for (int waited = 0; waited < 1000 && frames == 0; ++waited) {
+        Sleep(1);
+        std::lock_guard<std::recursive_mutex> lock(device->renderMutex);
+        frames = device->present.paletteFrames;
+    }
+    device->presenter.Stop();
+    TEST_ASSERT_EQ(1u, frames);
+    TEST_ASSERT_EQ(0u, device->game.paletteChanges.load());
+    TEST_ASSERT_EQ(0xFF400000u, converted[2]);
+
+    device->present.paletteLut = nullptr;
+    device->present.presentPixels = nullptr;
+    palette->Release();
+    return true;
+}
+
+/**
+ * @brief Test gamma ramps are applied inside pixel conversion for every depth
+ */
+bool test_gamma_fused_conversion() {
+    ldc::DeviceContext device;
+
+    uint32_t converted[2] = {};
+    device.present.renderer = std::make_unique<CaptureRenderer>(converted, 2);
+    device.present.bitmapWidth = 2;
+    device.present.bitmapHeight = 1;
+    TEST_ASSERT(!device.present.gammaActive);
+
+    // Inverting ramp
+    DDGAMMARAMP ramp;
+    for (int i = 0; i < 256; ++i) {
+        WORD level = static_cast<WORD>((255 - i) * 257);
+        ramp.red[i] = level;
+        ramp.green[i] = level;
+        ramp.blue[i] = level;
+    }
+    ldc::SetGammaRamp(device, ramp);
+    TEST_ASSERT(device.present.gammaActive);
+    TEST_ASSERT(device.game.gammaChanged.load());
+
+    uint32_t pixels32[2] = { 0xFF102030u, 0xFF000000u };
+    device.present.presentPixels = reinterpret_cast<const uint8_t*>(pixels32);
+    device.present.primaryPitch = sizeof(pixels32);
+    device.present.primaryBpp = 32;
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT(!device.game.gammaChanged.load());
+    TEST_ASSERT_EQ(0xFFEFDFCFu, converted[0]);
+    TEST_ASSERT_EQ(0xFFFFFFFFu, converted[1]);
+
+    // RGB565 white expands to 0xF8/0xFC before the ramp
+    uint16_t pixels16[2] = { 0xFFFF, 0x0000 };
+    device.present.presentPixels = reinterpret_cast<const uint8_t*>(pixels16);
+    device.present.primaryPitch = sizeof(pixels16);
+    device.present.primaryBpp = 16;
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(0xFF070307u, converted[0]);
+    TEST_ASSERT_EQ(0xFFFFFFFFu, converted[1]);
+
+    // A grey palette with the ramp folded in
+    for (uint32_t i = 0; i < 256; ++i) {
+        device.game.palette32[i] = 0xFF000000u | (i << 16) | (i << 8) | i;
+    }
+    device.game.paletteChanges = 1;
+    uint8_t pixels8[2] = { 0x40, 0xFF };
+    device.present.presentPixels = pixels8;
+    device.present.primaryPitch = sizeof(pixels8);
+    device.present.primaryBpp = 8;
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(0xFFBFBFBFu, converted[0]);
+    TEST_ASSERT_EQ(0xFF000000u, converted[1]);
+
+    // Restoring the identity ramp turns the tables off again
+    DDGAMMARAMP identity;
+    for (int i = 0; i < 256; ++i) {
+        identity.red[i] = identity.green[i] = identity.blue[i] = static_cast<WORD>(i * 257);
+    }
+    ldc::SetGammaRamp(device, identity);
+    TEST_ASSERT(!device.present.gammaActive);
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(0xFF404040u, converted[0]);
+
+    device.present.presentPixels = nullptr;
+    return true;
+}
+
+/**
+ * @brief Test presents reach the device's renderer with their damage rects
+ */
+bool test_renderer_routing() {
+    using ldc::renderer::RendererFactory;
+
+    std::unique_ptr<ldc::renderer::IRenderer> gdi = RendererFactory::Create(ldc::RendererType::GDI);
+    TEST_ASSERT(gdi != nullptr);
+    TEST_ASSERT(gdi->GetType() == ldc::RendererType::GDI);
+    TEST_ASSERT(!gdi->IsInitialized());
+    TEST_ASSERT_EQ(0u, gdi->GetTimings().frames);
+
+    std::unique_ptr<ldc::renderer::IRenderer> best = RendererFactory::Create(ldc::RendererType::Auto);
+    TEST_ASSERT(best != nullptr);
+    TEST_ASSERT(RendererFactory::Create(ldc::RendererType::D3D9) == nullptr ||
+                RendererFactory::IsD3D9Available());
+
+    // Presents reach the device's renderer with the dirty area
+    ldc::DeviceContext device;
+    uint32_t converted[4] = {};
+    uint32_t pixels[4] = { 0xFF000001u, 0xFF000002u, 0xFF000003u, 0xFF000004u };
+    auto capture = std::make_unique<CaptureRenderer>(converted, 4);
+    CaptureRenderer* renderer = capture.get();
+    device.present.renderer = std::move(capture);
+    device.present.bitmapWidth = 4;
+    device.present.bitmapHeight = 1;
+    device.present.presentPixels = reinterpret_cast<const uint8_t*>(pixels);
+    device.present.primaryPitch = sizeof(pixels);
+    device.present.primaryBpp = 32;
+
+    RECT dirty = { 1, 0, 3, 1 };
+    ldc::PresentPrimaryToScreen(device, &dirty);
+    TEST_ASSERT_EQ(1u, renderer->GetTimings().frames);
+    TEST_ASSERT_EQ(1u, renderer->GetPartialFrames());
+    TEST_ASSERT_EQ(0u, converted[0]);
+    TEST_ASSERT_EQ(0xFF000002u, converted[1]);
+    TEST_ASSERT_EQ(0xFF000003u, converted[2]);
+    TEST_ASSERT_EQ(0u, converted[3]);
+
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(2u, renderer->GetTimings().frames);
+    TEST_ASSERT_EQ(1u, renderer->GetPartialFrames());
+    TEST_ASSERT_EQ(0xFF000004u, converted[3]);
+
+    // Several damage rects arrive in one partial present
+    std::memset(converted, 0, sizeof(converted));
+    RECT damage[2] = { { 0, 0, 1, 1 }, { 3, 0, 4, 1 } };
+    ldc::PresentPrimaryToScreen(device, damage, 2);
+    TEST_ASSERT_EQ(2u, renderer->GetPartialFrames());
+    TEST_ASSERT_EQ(0xFF000001u, converted[0]);
+    TEST_ASSERT_EQ(0u, converted[1]);
+    TEST_ASSERT_EQ(0xFF000004u, converted[3]);
+    TEST_ASSERT(!renderer->GetPaletteChanged());
+
+    device.present.presentPixels = nullptr;
+    return true;
+}
+
+/**
+ * @brief Test the null renderer converts, keeps and captures frames
+ *
+ * Frames are converted like a display backend would, the previous image
+ * is kept outside the dirty area, and the result is hashed or stored.
+ */
+bool test_null_renderer_capture() {
+    using ldc::renderer::NullRenderer;
+
+    // 4x2 XRGB source; the renderer needs no window
+    uint32_t pixels[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    ldc::renderer::PresentFrame frame;
+    frame.pixels = reinterpret_cast<const uint8_t*>(pixels);
+    frame.pitch = 16;
+    frame.width = 4;
+    frame.height = 2;
+    frame.bpp = 32;
+
+    NullRenderer store(ldc::NullCapture::Store);
+    TEST_ASSERT(store.Initialize(nullptr, 4, 2, 32));
+    TEST_ASSERT(store.GetType() == ldc::RendererType::Null);
+    store.Present(frame);
+    TEST_ASSERT(store.GetFrame() != nullptr);
+    TEST_ASSERT_EQ(1u, store.GetFrame()[0]);
+    TEST_ASSERT_EQ(8u, store.GetFrame()[7]);
+
+    // Only the dirty pixels are converted again
+    pixels[0] = 9;
+    pixels[5] = 10;
+    pixels[7] = 11;
+    RECT dirty[2] = { { 1, 1, 2, 2 }, { 3, 1, 4, 2 } };
+    store.PresentPartial(frame, dirty, 2);
+    TEST_ASSERT_EQ(1u, store.GetFrame()[0]);
+    TEST_ASSERT_EQ(10u, store.GetFrame()[5]);
+    TEST_ASSERT_EQ(7u, store.GetFrame()[6]);
+    TEST_ASSERT_EQ(11u, store.GetFrame()[7]);
+    TEST_ASSERT_EQ(2u, store.GetTimings().frames);
+
+    // It converts every format itself
+    TEST_ASSERT(!store.GetCaps().AcceptsNative(32));
+    TEST_ASSERT_EQ(ldc::renderer::kMaxDamageRects, store.GetCaps().maxDamageRects);
+
+    // Hash mode hashes the whole image, here a straight copy of the source
+    NullRenderer hash(ldc::NullCapture::Hash);
+    TEST_ASSERT(hash.Initialize(nullptr, 4, 2, 32));
+    hash.Present(frame);
+    TEST_ASSERT(hash.GetFrame() == nullptr);
+    TEST_ASSERT_EQ(ldc::core::HashBytes(pixels, sizeof(pixels)), hash.GetFrameHash());
+
+    uint64_t firstSequence = hash.GetSequenceHash();
+    hash.Present(frame);
+    TEST_ASSERT(hash.GetSequenceHash() != firstSequence);
+
+    // Requested explicitly, never picked automatically
+    auto created = ldc::renderer::RendererFactory::Create(ldc::RendererType::Null);
+    TEST_ASSERT(created && created->GetType() == ldc::RendererType::Null);
+    auto best = ldc::renderer::RendererFactory::CreateBestAvailable();
+    TEST_ASSERT(!best || best->GetType() != ldc::RendererType::Null);
+    TEST_ASSERT(ldc::StringToRendererType("null") == ldc::RendererType::Null);
+
+    return true;
+}
+
+/**
+ * @brief Test presented frames are published to the shared-memory ring
+ */
+bool test_frame_export_ring() {
+    using namespace ldc::core;
+
+    uint32_t pixels[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    ldc::renderer::PresentFrame frame;
+    frame.pixels = reinterpret_cast<const uint8_t*>(pixels);
+    frame.pitch = 16;
+    frame.width = 4;
+    frame.height = 2;
+    frame.bpp = 32;
+
+    FrameExporter exporter;
+    TEST_ASSERT(exporter.Open("ldc_test_frame_ring", 3, 4, 2));
+
+    // One writer per ring
+    FrameExporter second;
+    TEST_ASSERT(!second.Open("ldc_test_frame_ring", 3, 4, 2));
+
+    // Map it the way an external consumer does
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, "Local\\ldc_test_frame_ring");
+    TEST_ASSERT(mapping != nullptr);
+    const auto* view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    TEST_ASSERT(view != nullptr);
+    const auto* header = reinterpret_cast<const FrameRingHeader*>(view);
+    const FrameRingSlot* slots = GetFrameRingSlots(header);
+    TEST_ASSERT(header->magic == kFrameRingMagic);
+    TEST_ASSERT_EQ(3u, header->slotCount);
+    TEST_ASSERT_EQ(0u, header->latestSequence.load());
+
+    exporter.Publish(frame);
+    TEST_ASSERT_EQ(1u, header->latestSequence.load());
+    TEST_ASSERT_EQ(1u, slots[0].sequence.load());
+    TEST_ASSERT_EQ(4u, slots[0].width);
+    TEST_ASSERT_EQ(16u, slots[0].pitch);
+    TEST_ASSERT_EQ(1u, slots[0].damageCount);
+    TEST_ASSERT_EQ(4, slots[0].damage[0].right);
+    TEST_ASSERT(slots[0].publishTime >= slots[0].captureTime);
+    const auto* image = reinterpret_cast<const uint32_t*>(view + slots[0].pixelOffset);
+    TEST_ASSERT(std::memcmp(image, pixels, sizeof(pixels)) == 0);
+
+    // A partial frame carries the rest over from the previous one
+    pixels[0] = 9;
+    pixels[5] = 10;
+    RECT dirty = { 1, 1, 2, 2 };
+    exporter.Publish(frame, &dirty, 1);
+    TEST_ASSERT_EQ(2u, header->latestSequence.load());
+    image = reinterpret_cast<const uint32_t*>(view + slots[1].pixelOffset);
+    TEST_ASSERT_EQ(1u, image[0]);
+    TEST_ASSERT_EQ(10u, image[5]);
+    TEST_ASSERT_EQ(8u, image[7]);
+    TEST_ASSERT_EQ(1, slots[1].damage[0].left);
+    TEST_ASSERT_EQ(2, slots[1].damage[0].bottom);
+
+    // The writer laps the ring without waiting; a reader still holding
+    // frame 1 sees its slot's sequence change
+    exporter.Publish(frame);
+    exporter.Publish(frame);
+    TEST_ASSERT_EQ(4u, header->latestSequence.load());
+    TEST_ASSERT_EQ(4u, slots[0].sequence.load());
+    image = reinterpret_cast<const uint32_t*>(view + slots[0].pixelOffset);
+    TEST_ASSERT_EQ(9u, image[0]);
+
+    // Frames larger than a slot are skipped
+    frame.width = 8;
+    frame.height = 1;
+    frame.pitch = 32;
+    exporter.Publish(frame);
+    TEST_ASSERT_EQ(4u, header->latestSequence.load());
+    TEST_ASSERT_EQ(1u, exporter.GetSkippedCount());
+    TEST_ASSERT_EQ(4u, exporter.GetPublishedCount());
+
+    // Closing removes the name; the consumer's view stays readable
+    exporter.Close();
+    TEST_ASSERT(OpenFileMappingA(FILE_MAP_READ, FALSE, "Local\\ldc_test_frame_ring") == nullptr);
+    TEST_ASSERT(header->magic == kFrameRingMagic);
+
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    return true;
+}
+
+/**
+ * @brief Test damage clipping and native-format negotiation
+ *
+ * Damage rects are clipped to the image and merged once there are more
+ * than a backend takes; backends declare the formats they take as-is.
+ */
+bool test_present_damage_contract() {
+    using namespace ldc::renderer;
+
+    RECT bounds = { 0, 0, 100, 50 };
+    RECT rects[3] = { { -10, -10, 10, 10 }, { 200, 0, 300, 10 }, { 90, 40, 120, 60 } };
+    RECT out[3];
+    TEST_ASSERT_EQ(2u, ClipDamageRects(bounds, rects, 3, 3, out));
+    TEST_ASSERT_EQ(0, out[0].left);
+    TEST_ASSERT_EQ(10, out[0].right);
+    TEST_ASSERT_EQ(100, out[1].right);
+    TEST_ASSERT_EQ(50, out[1].bottom);
+
+    // Too many for the backend: one rect covering them all
+    TEST_ASSERT_EQ(1u, ClipDamageRects(bounds, rects, 3, 1, out));
+    TEST_ASSERT_EQ(0, out[0].top);
+    TEST_ASSERT_EQ(100, out[0].right);
+    TEST_ASSERT_EQ(50, out[0].bottom);
+    TEST_ASSERT_EQ(0u, ClipDamageRects(bounds, &rects[1], 1, 3, out));
+
+    TEST_ASSERT_EQ(kSourcePalette8, SourceFormatForBpp(8));
+    TEST_ASSERT_EQ(kSourceRGB565, SourceFormatForBpp(16));
+    TEST_ASSERT_EQ(0u, SourceFormatForBpp(15));
+
+    // GDI takes 8-bit with its palette, 565 and XRGB without converting
+    std::unique_ptr<IRenderer> gdi = RendererFactory::Create(ldc::RendererType::GDI);
+    TEST_ASSERT(gdi != nullptr);
+    RendererCaps caps = gdi->GetCaps();
+    TEST_ASSERT(caps.AcceptsNative(8));
+    TEST_ASSERT(caps.AcceptsNative(16));
+    TEST_ASSERT(!caps.AcceptsNative(24));
+    TEST_ASSERT(caps.AcceptsNative(32));
+    TEST_ASSERT(caps.supportsPaletteUpload);
+    TEST_ASSERT(caps.maxDamageRects > 1);
+
+    return true;
+}
+
+/**
+ * @brief Test window repaints from the renderer's retained image
+ *
+ * A renderer without one gets the primary presented again. A repaint or
+ * resize never waits for a present on another thread; the next present
+ * picks up the window size.
+ */
+bool test_window_repaint() {
+    uint32_t pixels[4] = { 1, 2, 3, 4 };
+
+    ldc::DeviceContext device;
+    device.present.bitmapWidth = 4;
+    device.present.bitmapHeight = 1;
+    device.present.presentPixels = reinterpret_cast<const uint8_t*>(pixels);
+    device.present.primaryPitch = sizeof(pixels);
+    device.present.primaryBpp = 32;
+
+    uint32_t converted[4] = {};
+    auto capture = std::make_unique<CaptureRenderer>(converted, 4);
+    CaptureRenderer* captureRenderer = capture.get();
+    device.present.renderer = std::move(capture);
+    ldc::RepaintWindow(device);
+    TEST_ASSERT_EQ(1u, captureRenderer->GetTimings().frames);
+    TEST_ASSERT_EQ(0u, device.present.repaints);
+
+    // Nothing retained before the first frame, so that one is presented
+    auto store = std::make_unique<ldc::renderer::NullRenderer>(ldc::NullCapture::Store);
+    ldc::renderer::NullRenderer* null = store.get();
+    TEST_ASSERT(null->Initialize(nullptr, 4, 1, 32));
+    device.present.renderer = std::move(store);
+    ldc::RepaintWindow(device);
+    TEST_ASSERT_EQ(1u, null->GetTimings().frames);
+
+    // Later repaints show the presented frame, not what the game drew since
+    pixels[0] = 9;
+    TEST_ASSERT(ldc::RepaintWindow(device));
+    TEST_ASSERT(ldc::RepaintWindow(device));
+    TEST_ASSERT_EQ(1u, null->GetTimings().frames);
+    TEST_ASSERT_EQ(2u, device.present.repaints);
+    TEST_ASSERT_EQ(1u, null->GetFrame()[0]);
+
+    // A present in progress on another thread is not waited for; the
+    // window procedure is told nothing was redrawn
+    bool repainted = true;
+    {
+        std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+        std::thread window([&] { repainted = ldc::RepaintWindow(device); });
+        window.join();
+    }
+    TEST_ASSERT(!repainted);
+    TEST_ASSERT(device.window.repaintPending.load());
+    TEST_ASSERT_EQ(2u, device.present.repaints);
+
+    // A resize only publishes the size; the renderer gets it when it next
+    // draws, whichever thread that is
+    device.present.renderer = std::make_unique<CaptureRenderer>(converted, 4);
+    captureRenderer = static_cast<CaptureRenderer*>(device.present.renderer.get());
+    ldc::InputMapping mapping = device.input.Load();
+    mapping.renderWidth = 800;
+    mapping.renderHeight = 600;
+    {
+        std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+        std::thread window([&] {
+            device.input.Store(mapping);
+            repainted = ldc::RepaintWindow(device);
+        });
+        window.join();
+    }
+    TEST_ASSERT(!repainted);
+    TEST_ASSERT_EQ(0u, captureRenderer->GetWindowWidth());
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(800u, captureRenderer->GetWindowWidth());
+    TEST_ASSERT_EQ(600u, captureRenderer->GetWindowHeight());
+    TEST_ASSERT(!device.window.repaintPending.load());
+
+    device.present.presentPixels = nullptr;
+    return true;
+}
+
+/**
+ * @brief Test unchanged frames and tiles are not presented
+ *
+ * Full presents compare the primary tile by tile with the last one: an
+ * unchanged frame is skipped, a changed one presents only its tiles.
+ */
+bool test_unchanged_frame_skipping() {
+    using ldc::core::TileHasher;
+
+    // 160x64 at 32bpp: three tile columns (the last one narrow), two tile rows
+    std::vector<uint32_t> pixels(160 * 64, 0xFF102030u);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pixels.data());
+    RECT changed[ldc::renderer::kMaxDamageRects];
+
+    TileHasher tiles;
+    TEST_ASSERT_EQ(1u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 16));
+    TEST_ASSERT_EQ(160, changed[0].right);
+    TEST_ASSERT_EQ(64, changed[0].bottom);
+    TEST_ASSERT_EQ(0u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 16));
+
+    // Swapping two equal-sized blocks inside a tile is still a change
+    pixels[0] = 1;
+    pixels[4] = 2;
+    TEST_ASSERT_EQ(1u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 16));
+    pixels[0] = 2;
+    pixels[4] = 1;
+    TEST_ASSERT_EQ(1u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 16));
+    TEST_ASSERT_EQ(0, changed[0].left);
+    TEST_ASSERT_EQ(64, changed[0].right);
+    TEST_ASSERT_EQ(32, changed[0].bottom);
+
+    // The same column changing in both tile rows is one rect; too many
+    // rects for the caller become their bounds
+    pixels[150] = 3;
+    pixels[40 * 160 + 150] = 3;
+    pixels[40 * 160 + 10] = 3;
+    TEST_ASSERT_EQ(2u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 16));
+    TEST_ASSERT_EQ(128, changed[0].left);
+    TEST_ASSERT_EQ(0, changed[0].top);
+    TEST_ASSERT_EQ(64, changed[0].bottom);
+    TEST_ASSERT_EQ(0, changed[1].left);
+    TEST_ASSERT_EQ(32, changed[1].top);
+    pixels[150] = 4;
+    pixels[40 * 160 + 10] = 4;
+    TEST_ASSERT_EQ(1u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 1));
+    TEST_ASSERT_EQ(0, changed[0].left);
+    TEST_ASSERT_EQ(160, changed[0].right);
+
+    RECT shown = { 70, 10, 80, 20 };
+    tiles.Invalidate(&shown, 1);
+    TEST_ASSERT_EQ(1u, tiles.Compare(bytes, 640, 160, 64, 32, changed, 16));
+    TEST_ASSERT_EQ(64, changed[0].left);
+    TEST_ASSERT_EQ(128, changed[0].right);
+
+    // Through the device: unchanged frames never reach the renderer
+    ldc::DeviceContext device;
+    device.present.bitmapWidth = 160;
+    device.present.bitmapHeight = 64;
+    device.present.presentPixels = bytes;
+    device.present.primaryPitch = 640;
+    device.present.primaryBpp = 32;
+    auto store = std::make_unique<ldc::renderer::NullRenderer>(ldc::NullCapture::Store);
+    ldc::renderer::NullRenderer* null = store.get();
+    TEST_ASSERT(null->Initialize(nullptr, 160, 64, 32));
+    device.present.renderer = std::move(store);
+    ldc::SetFrameSkipping(device, true);
+
+    ldc::PresentPrimaryToScreen(device);
+    ldc::PresentPrimaryToScreen(device);
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(1u, null->GetTimings().frames);
+    TEST_ASSERT_EQ(2u, device.present.framesSkipped);
+
+    pixels[159] = 5;
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(2u, null->GetTimings().frames);
+    TEST_ASSERT_EQ(5u, null->GetFrame()[159]);
+    TEST_ASSERT(ldc::GetFrameSkipRatio(device) > 0.49 && ldc::GetFrameSkipRatio(device) < 0.51);
+
+    // A new ramp recolours everything, even with the same pixels
+    DDGAMMARAMP dark;
+    for (int i = 0; i < 256; ++i) {
+        dark.red[i] = dark.green[i] = dark.blue[i] = static_cast<WORD>(i * 128);
+    }
+    ldc::SetGammaRamp(device, dark);
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(3u, null->GetTimings().frames);
+
+    // A window that could not be repainted while another thread presented
+    // gets the whole frame next, though nothing changed
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(3u, null->GetTimings().frames);
+    {
+        std::lock_guard<std::recursive_mutex> lock(device.renderMutex);
+        std::thread window([&] { ldc::RepaintWindow(device); });
+        window.join();
+    }
+    TEST_ASSERT(device.window.repaintPending.load());
+    uint64_t skipped = device.present.framesSkipped;
+    ldc::PresentPrimaryToScreen(device);
+    TEST_ASSERT_EQ(4u, null->GetTimings().frames);
+    TEST_ASSERT_EQ(skipped, device.present.framesSkipped);
+    TEST_ASSERT(!device.window.repaintPending.load());
+
+    device.present.presentPixels = nullptr;
+    return true;
+}
+
+/**
+ * @brief Test GDI present method parsing, cached selection and native format caps
+ */
+bool test_gdi_present_method() {
+    using ldc::GDIPresentMethod;
+    using ldc::renderer::CreateGDIRenderer;
+
+    TEST_ASSERT(ldc::StringToGDIPresentMethod("bitblt") == GDIPresentMethod::BitBlt);
+    TEST_ASSERT(ldc::StringToGDIPresentMethod("setdibits") == GDIPresentMethod::SetDIBits);
+    TEST_ASSERT(ldc::StringToGDIPresentMethod("StretchDIBits") == GDIPresentMethod::StretchDIBits);
+    TEST_ASSERT(ldc::StringToGDIPresentMethod("fastest") == GDIPresentMethod::Auto);
+    TEST_ASSERT_STR_EQ("setdibits", ldc::GDIPresentMethodToString(GDIPresentMethod::SetDIBits));
+
+    ldc::config::Config defaults;
+    TEST_ASSERT(defaults.GetGDIPresentMethod() == GDIPresentMethod::Auto);
+
+    // BitBlt copies from the converted DIB section, so nothing goes natively
+    TEST_ASSERT_EQ(0u, CreateGDIRenderer(GDIPresentMethod::BitBlt)->GetCaps().nativeFormats);
+    TEST_ASSERT(CreateGDIRenderer(GDIPresentMethod::SetDIBits)->GetCaps().AcceptsNative(16));
+    TEST_ASSERT(CreateGDIRenderer(GDIPresentMethod::StretchDIBits)->GetCaps().AcceptsNative(8));
+    TEST_ASSERT(CreateGDIRenderer()->GetCaps().AcceptsNative(32));
+
+    // Auto times the methods once per window and depth; later primaries
+    // reuse the result
+    HWND window = reinterpret_cast<HWND>(static_cast<uintptr_t>(0x5A1EC7));
+    int timings = 0;
+    auto measure = [&] {
+        ++timings;
+        return timings == 1 ? GDIPresentMethod::StretchDIBits : GDIPresentMethod::BitBlt;
+    };
+    TEST_ASSERT(ldc::renderer::SelectGDIPresentMethod(window, 16, measure) == GDIPresentMethod::StretchDIBits);
+    TEST_ASSERT(ldc::renderer::SelectGDIPresentMethod(window, 16, measure) == GDIPresentMethod::StretchDIBits);
+    TEST_ASSERT_EQ(1, timings);
+    TEST_ASSERT(ldc::renderer::SelectGDIPresentMethod(window, 8, measure) == GDIPresentMethod::BitBlt);
+    TEST_ASSERT_EQ(2, timings);
+
+    return true;
+}
+
+/**
+ * @brief Test that releasing the primary leaves no dangling pointer
+ *
+ * Games release the primary around mode switches and query caps in
+ * between; the DirectDraw object must not reach the freed surface.
+ */
+bool test_primary_release_caps() {
+    auto* dd = new ldc::interfaces::DirectDrawImpl();
+    dd->SetCooperativeLevel(nullptr, DDSCL_NORMAL);
+    TEST_ASSERT(SUCCEEDED(dd->SetDisplayMode(64, 32, 32, 0, 0)));
+
+    DDSURFACEDESC2 desc = {};
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DDSD_CAPS;
+    desc.ddsCaps.dwCaps = DDSCAPS_PRIMARYSURFACE;
+    LPDIRECTDRAWSURFACE7 primary = nullptr;
+    TEST_ASSERT(SUCCEEDED(dd->CreateSurface(&desc, &primary, nullptr)));
+    TEST_ASSERT(dd->GetPrimarySurface() != nullptr);
+    primary->Release();
+    TEST_ASSERT(dd->GetPrimarySurface() == nullptr);
+
+    DDCAPS caps = {};
+    caps.dwSize = sizeof(caps);
+    TEST_ASSERT(SUCCEEDED(dd->GetCaps(&caps, nullptr)));
+    TEST_ASSERT_EQ(0u, caps.dwCurrVisibleOverlays);
+
+    LPDIRECTDRAWSURFACE7 gdi = nullptr;
+    TEST_ASSERT(dd->GetGDISurface(&gdi) == DDERR_NOTFOUND);
+
+    dd->Release();
+    return true;
+}
+
+/**
+ * @brief Test triple-buffered flip chain rotation and attachment queries
+ */
+bool test_triple_buffer_flip() {
+    auto* dd = new ldc::interfaces::DirectDrawImpl();
+    dd->SetCooperativeLevel(nullptr, DDSCL_NORMAL);
+    TEST_ASSERT(SUCCEEDED(dd->SetDisplayMode(64, 32, 32, 0, 0)));
+
+    DDSURFACEDESC2 desc = {};
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DDSD_CAPS | DDSD_BACKBUFFERCOUNT;
+    desc.ddsCaps.dwCaps = DDSCAPS_PRIMARYSURFACE | DDSCAPS_FLIP | DDSCAPS_COMPLEX;
+    desc.dwBackBufferCount = 2;
+    LPDIRECTDRAWSURFACE7 front = nullptr;
+    TEST_ASSERT(SUCCEEDED(dd->CreateSurface(&desc, &front, nullptr)));
+
+    DDSURFACEDESC2 frontDesc = {};
+    frontDesc.dwSize = sizeof(frontDesc);
+    TEST_ASSERT(SUCCEEDED(front->GetSurfaceDesc(&frontDesc)));
+    TEST_ASSERT_EQ(2u, frontDesc.dwBackBufferCount);
+
+    // Front -> first back -> second back -> front
+    DDSCAPS2 caps = {};
+    caps.dwCaps = DDSCAPS_BACKBUFFER;
+    LPDIRECTDRAWSURFACE7 back1 = nullptr;
+    TEST_ASSERT(SUCCEEDED(front->GetAttachedSurface(&caps, &back1)));
+    caps.dwCaps = DDSCAPS_FLIP;
+    LPDIRECTDRAWSURFACE7 back2 = nullptr;
+    TEST_ASSERT(SUCCEEDED(back1->GetAttachedSurface(&caps, &back2)));
+    TEST_ASSERT(back2 != front && back2 != back1);
+    caps.dwCaps = DDSCAPS_FRONTBUFFER;
+    LPDIRECTDRAWSURFACE7 wrapped = nullptr;
+    TEST_ASSERT(SUCCEEDED(back2->GetAttachedSurface(&caps, &wrapped)));
+    TEST_ASSERT(wrapped == front);
+    wrapped->Release();
+
+    // Each member enumerates the next one, handing over a reference
+    struct Enumerated {
+        LPDIRECTDRAWSURFACE7 surface;
+        int calls;
+    } enumerated = { nullptr, 0 };
+    auto record = [](LPDIRECTDRAWSURFACE7 surface, LPDDSURFACEDESC2, LPVOID context) -> HRESULT {
+        auto* seen = static_cast<Enumerated*>(context);
+        seen->surface = surface;
+        seen->calls++;
+        surface->Release();
+        return DDENUMRET_CANCEL;
+    };
+    TEST_ASSERT(SUCCEEDED(front->EnumAttachedSurfaces(&enumerated, record)));
+    TEST_ASSERT_EQ(1, enumerated.calls);
+    TEST_ASSERT(enumerated.surface == back1);
+    TEST_ASSERT(SUCCEEDED(back2->EnumAttachedSurfaces(&enumerated, record)));
+    TEST_ASSERT_EQ(2, enumerated.calls);
+    TEST_ASSERT(enumerated.surface == front);
+    TEST_ASSERT(front->EnumAttachedSurfaces(nullptr, nullptr) == DDERR_INVALIDPARAMS);
+
+    // Mark each buffer with its own value
+    LPDIRECTDRAWSURFACE7 chain[3] = { front, back1, back2 };
+    for (uint32_t i = 0; i < 3; ++i) {
+        DDSURFACEDESC2 lockDesc = {};
+        lockDesc.dwSize = sizeof(lockDesc);
+        TEST_ASSERT(SUCCEEDED(chain[i]->Lock(nullptr, &lockDesc, DDLOCK_WAIT, nullptr)));
+        static_cast<uint32_t*>(lockDesc.lpSurface)[0] = i + 1;
+        TEST_ASSERT(SUCCEEDED(chain[i]->Unlock(nullptr)));
+    }
+
+    // Each flip moves every buffer's image one step towards the front
+    for (uint32_t flip = 1; flip <= 3; ++flip) {
+        TEST_ASSERT(SUCCEEDED(front->Flip(nullptr, DDFLIP_WAIT)));
+        for (uint32_t i = 0; i < 3; ++i) {
+            DDSURFACEDESC2 lockDesc = {};
+            lockDesc.dwSize = sizeof(lockDesc);
+            TEST_ASSERT(SUCCEEDED(chain[i]->Lock(nullptr, &lockDesc, DDLOCK_WAIT | DDLOCK_READONLY, nullptr)));
+            uint32_t value = static_cast<uint32_t*>(lockDesc.lpSurface)[0];
+            TEST_ASSERT(SUCCEEDED(chain[i]->Unlock(nullptr)));
+            TEST_ASSERT_EQ((i + flip) % 3 + 1, value);
+        }
+    }
+
+    back2->Release();
+    back1->Release();
+    front->Release();
+    dd->Release();
+    return true;
+}
+
+/**
+ * @brief Test blits to or from a locked surface are refused until Unlock
+ */
+bool test_blt_locked_surface() {
+    auto* dd = new ldc::interfaces::DirectDrawImpl();
+    dd->SetCooperativeLevel(nullptr, DDSCL_NORMAL);
+    TEST_ASSERT(SUCCEEDED(dd->SetDisplayMode(64, 32, 32, 0, 0)));
+
+    DDSURFACEDESC2 desc = {};
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT;
+    desc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN;
+    desc.dwWidth = 16;
+    desc.dwHeight = 16;
+    LPDIRECTDRAWSURFACE7 a = nullptr;
+    LPDIRECTDRAWSURFACE7 b = nullptr;
+    TEST_ASSERT(SUCCEEDED(dd->CreateSurface(&desc, &a, nullptr)));
+    TEST_ASSERT(SUCCEEDED(dd->CreateSurface(&desc, &b, nullptr)));
+
+    DDSURFACEDESC2 lockDesc = {};
+    lockDesc.dwSize = sizeof(lockDesc);
+    TEST_ASSERT(SUCCEEDED(a->Lock(nullptr, &lockDesc, DDLOCK_WAIT, nullptr)));
+    TEST_ASSERT(a->Lock(nullptr, &lockDesc, DDLOCK_WAIT, nullptr) == DDERR_SURFACEBUSY);
+    static_cast<uint32_t*>(lockDesc.lpSurface)[0] = 0x12345678u;
+
+    // Neither as destination nor as source, including fills and BltFast
+    DDBLTFX fx = {};
+    fx.dwSize = sizeof(fx);
+    fx.dwFillColor = 0xFFu;
+    TEST_ASSERT(a->Blt(nullptr, nullptr, nullptr, DDBLT_COLORFILL | DDBLT_WAIT, &fx) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(a->Blt(nullptr, b, nullptr, DDBLT_WAIT, nullptr) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(b->Blt(nullptr, a, nullptr, DDBLT_WAIT, nullptr) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(b->BltFast(0, 0, a, nullptr, DDBLTFAST_WAIT) == DDERR_SURFACEBUSY);
+    TEST_ASSERT_EQ(0x12345678u, static_cast<uint32_t*>(lockDesc.lpSurface)[0]);
+    TEST_ASSERT(SUCCEEDED(a->Unlock(nullptr)));
+
+    TEST_ASSERT(SUCCEEDED(b->BltFast(0, 0, a, nullptr, DDBLTFAST_WAIT)));
+    TEST_ASSERT(SUCCEEDED(b->Lock(nullptr, &lockDesc, DDLOCK_WAIT | DDLOCK_READONLY, nullptr)));
+    TEST_ASSERT_EQ(0x12345678u, static_cast<uint32_t*>(lockDesc.lpSurface)[0]);
+    TEST_ASSERT(SUCCEEDED(b->Unlock(nullptr)));
+
+    b->Release();
+    a->Release();
+    dd->Release();
+    return true;
+}
+
+/**
+ * @brief Test GDI drawing through GetDC and the damage ReleaseDC reports
+ *
+ * The DC draws straight into the surface, which stays locked until
+ * ReleaseDC; only the bounds drawn into are presented, and a DC that
+ * drew nothing presents nothing.
+ */
+bool test_surface_get_dc() {
+    auto* dd = new ldc::interfaces::DirectDrawImpl();
+    dd->SetCooperativeLevel(nullptr, DDSCL_NORMAL);
+    TEST_ASSERT(SUCCEEDED(dd->SetDisplayMode(64, 32, 32, 0, 0)));
+
+    DDSURFACEDESC2 desc = {};
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PIXELFORMAT;
+    desc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN;
+    desc.dwWidth = 16;
+    desc.dwHeight = 16;
+    desc.ddpfPixelFormat.dwSize = sizeof(DDPIXELFORMAT);
+    desc.ddpfPixelFormat.dwFlags = DDPF_RGB;
+    desc.ddpfPixelFormat.dwRGBBitCount = 32;
+    desc.ddpfPixelFormat.dwRBitMask = 0x00FF0000;
+    desc.ddpfPixelFormat.dwGBitMask = 0x0000FF00;
+    desc.ddpfPixelFormat.dwBBitMask = 0x000000FF;
+    LPDIRECTDRAWSURFACE7 surface = nullptr;
+    TEST_ASSERT(SUCCEEDED(dd->CreateSurface(&desc, &surface, nullptr)));
+
+    DDSURFACEDESC2 lockDesc = {};
+    lockDesc.dwSize = sizeof(lockDesc);
+    TEST_ASSERT(SUCCEEDED(surface->Lock(nullptr, &lockDesc, DDLOCK_WAIT, nullptr)));
+    static_cast<uint32_t*>(lockDesc.lpSurface)[0] = 0x00ABCDEFu;
+    HDC dc = nullptr;
+    TEST_ASSERT(surface->GetDC(&dc) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(SUCCEEDED(surface->Unlock(nullptr)));
+
+    // The storage moves into a DIB section, keeping the pixels
+    DWORD uniqueness = 0;
+    TEST_ASSERT(SUCCEEDED(surface->GetUniquenessValue(&uniqueness)));
+    TEST_ASSERT(SUCCEEDED(surface->GetDC(&dc)));
+    TEST_ASSERT(dc != nullptr);
+    HDC second = nullptr;
+    TEST_ASSERT(surface->GetDC(&second) == DDERR_DCALREADYCREATED);
+    ::SetPixel(dc, 3, 2, RGB(0x12, 0x34, 0x56));
+
+    // Nothing else reaches the pixels while the DC is out
+    DDBLTFX fx = {};
+    fx.dwSize = sizeof(fx);
+    TEST_ASSERT(surface->Lock(nullptr, &lockDesc, DDLOCK_WAIT, nullptr) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(surface->Blt(nullptr, nullptr, nullptr, DDBLT_COLORFILL | DDBLT_WAIT, &fx) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(surface->Unlock(nullptr) == DDERR_NOTLOCKED);
+    TEST_ASSERT(surface->ReleaseDC(dc) == DD_OK);
+    TEST_ASSERT(surface->ReleaseDC(dc) == DDERR_INVALIDPARAMS);
+
+    DWORD changed = 0;
+    TEST_ASSERT(SUCCEEDED(surface->GetUniquenessValue(&changed)));
+    TEST_ASSERT_EQ(uniqueness + 1, changed);
+    TEST_ASSERT(SUCCEEDED(surface->Lock(nullptr, &lockDesc, DDLOCK_WAIT | DDLOCK_READONLY, nullptr)));
+    const uint32_t* pixels = static_cast<const uint32_t*>(lockDesc.lpSurface);
+    const uint32_t stride = lockDesc.lPitch / sizeof(uint32_t);
+    TEST_ASSERT_EQ(0x00ABCDEFu, pixels[0]);
+    TEST_ASSERT_EQ(0x00123456u, pixels[2 * stride + 3]);
+    TEST_ASSERT(SUCCEEDED(surface->Unlock(nullptr)));
+
+    // A DC that draws nothing changes nothing
+    TEST_ASSERT(SUCCEEDED(surface->GetDC(&dc)));
+    TEST_ASSERT(SUCCEEDED(surface->ReleaseDC(dc)));
+    TEST_ASSERT(SUCCEEDED(surface->GetUniquenessValue(&uniqueness)));
+    TEST_ASSERT_EQ(changed, uniqueness);
+    surface->Release();
+
+    // On the primary, only the drawn bounds are presented
+    desc.dwFlags = DDSD_CAPS | DDSD_BACKBUFFERCOUNT;
+    desc.ddsCaps.dwCaps = DDSCAPS_PRIMARYSURFACE | DDSCAPS_FLIP | DDSCAPS_COMPLEX;
+    desc.dwBackBufferCount = 1;
+    LPDIRECTDRAWSURFACE7 front = nullptr;
+    TEST_ASSERT(SUCCEEDED(dd->CreateSurface(&desc, &front, nullptr)));
+    DDSCAPS2 caps = {};
+    caps.dwCaps = DDSCAPS_BACKBUFFER;
+    LPDIRECTDRAWSURFACE7 back = nullptr;
+    TEST_ASSERT(SUCCEEDED(front->GetAttachedSurface(&caps, &back)));
+
+    const auto& device = dd->GetDeviceContext();
+    std::vector<uint32_t> converted(64 * 32, 0u);
+    CaptureRenderer* renderer = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(device->renderMutex);
+        auto capture = std::make_unique<CaptureRenderer>(converted.data(), 64);
+        renderer = capture.get();
+        device->present.renderer = std::move(capture);
+    }
+
+    // The first present shows the whole image
+    TEST_ASSERT(SUCCEEDED(front->GetDC(&dc)));
+    ::SetPixel(dc, 5, 4, RGB(0x00, 0xFF, 0x00));
+    TEST_ASSERT(SUCCEEDED(front->ReleaseDC(dc)));
+    {
+        std::lock_guard<std::recursive_mutex> lock(device->renderMutex);
+        TEST_ASSERT_EQ(1u, renderer->GetTimings().frames);
+        TEST_ASSERT_EQ(0u, renderer->GetPartialFrames());
+    }
+    TEST_ASSERT_EQ(0x0000FF00u, converted[4 * 64 + 5] & 0x00FFFFFFu);
+
+    converted[0] = 0xDEADBEEFu;
+    TEST_ASSERT(SUCCEEDED(front->GetDC(&dc)));
+    ::SetPixel(dc, 40, 20, RGB(0xFF, 0x00, 0x00));
+    TEST_ASSERT(SUCCEEDED(front->ReleaseDC(dc)));
+    {
+        std::lock_guard<std::recursive_mutex> lock(device->renderMutex);
+        TEST_ASSERT_EQ(2u, renderer->GetTimings().frames);
+        TEST_ASSERT_EQ(1u, renderer->GetPartialFrames());
+    }
+    TEST_ASSERT_EQ(0x00FF0000u, converted[20 * 64 + 40] & 0x00FFFFFFu);
+    TEST_ASSERT_EQ(0xDEADBEEFu, converted[0]);
+
+    TEST_ASSERT(SUCCEEDED(front->GetDC(&dc)));
+    TEST_ASSERT(SUCCEEDED(front->ReleaseDC(dc)));
+    {
+        std::lock_guard<std::recursive_mutex> lock(device->renderMutex);
+        TEST_ASSERT_EQ(2u, renderer->GetTimings().frames);
+    }
+
+    // The DC belongs to the storage, so it follows the image on a flip
+    HDC backDC = nullptr;
+    TEST_ASSERT(SUCCEEDED(back->GetDC(&backDC)));
+    TEST_ASSERT(front->Flip(nullptr, DDFLIP_WAIT) == DDERR_SURFACEBUSY);
+    TEST_ASSERT(SUCCEEDED(back->ReleaseDC(backDC)));
+    TEST_ASSERT(SUCCEEDED(front->Flip(nullptr, DDFLIP_WAIT)));
+    TEST_ASSERT(SUCCEEDED(front->GetDC(&dc)));
+    TEST_ASSERT(dc == backDC);
+    TEST_ASSERT(SUCCEEDED(front->ReleaseDC(dc)));
+    TEST_ASSERT(SUCCEEDED(back->GetDC(&dc)));
+    TEST_ASSERT(dc != backDC);
+    TEST_ASSERT(SUCCEEDED(back->ReleaseDC(dc)));
+
+    back->Release();
+    front->Release();
+    dd->Release();
+    return true;
+}
+
 // ============================================================================
 // Main Test Runner
 // ============================================================================
@@ -367,6 +2013,41 @@ int main() {
     RUN_TEST(test_palette_conversion);
     RUN_TEST(test_rgb565_conversion);
 
+    // Overlay tests
+    printf("\n--- Overlay Tests ---\n");
+    RUN_TEST(test_overlay_colorkeys);
+    RUN_TEST(test_overlay_stretch);
+
+    // Fence tests
+    printf("\n--- Fence Tests ---\n");
+    RUN_TEST(test_fence_completion);
+    RUN_TEST(test_blit_queue_ordering);
+    RUN_TEST(test_tile_executor_bands);
+    RUN_TEST(test_surface_allocator);
+    RUN_TEST(test_surface_page_backing);
+    RUN_TEST(test_surface_copy_on_write);
+    RUN_TEST(test_surface_compression);
+    RUN_TEST(test_video_memory_budget);
+    RUN_TEST(test_rw_lock_exclusion);
+    RUN_TEST(test_device_lock);
+    RUN_TEST(test_device_context_false_sharing);
+    RUN_TEST(test_device_context_isolation);
+    RUN_TEST(test_palette_incremental_update);
+    RUN_TEST(test_palette_changes_coalesced);
+    RUN_TEST(test_palette_deferred_flush);
+    RUN_TEST(test_gamma_fused_conversion);
+    RUN_TEST(test_renderer_routing);
+    RUN_TEST(test_null_renderer_capture);
+    RUN_TEST(test_frame_export_ring);
+    RUN_TEST(test_present_damage_contract);
+    RUN_TEST(test_gdi_present_method);
+    RUN_TEST(test_window_repaint);
+    RUN_TEST(test_unchanged_frame_skipping);
+    RUN_TEST(test_primary_release_caps);
+    RUN_TEST(test_triple_buffer_flip);
+    RUN_TEST(test_blt_locked_surface);
+    RUN_TEST(test_surface_get_dc);
+
     // Summary
     printf("\n===========================================\n");
     printf("Results: %d/%d passed", passed, total);
@@ -0,0 +1,239 @@
+/**
+ * @file FrameRingReader.cpp
+ * @brief Reference consumer of the shared-memory frame ring
+ *
+ * Maps the ring a game publishes with frameexport=true, follows the
+ * newest frame and reads each one in place: it checksums the pixels
+ * without copying them and validates the slot afterwards, as any
+ * consumer must (see core/FrameRing.h). Reports per-frame size, damage
+ * and latency, and how many frames it missed or lost to the writer.
+ *
+ * Usage: ldc_frame_reader [--name NAME] [--frames N] [--timeout MS] [--dump FILE.bmp]
+ */
+
+#include <windows.h>
+#include "core/FrameRing.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace ldc::core;
+
+namespace {
+
+struct ReaderOptions {
+    std::string name = "ldc_frames";
+    uint64_t frames = 0;        // 0 = until the writer goes quiet
+    DWORD timeoutMs = 5000;     // Waiting for the ring, then for new frames
+    std::string dumpPath;
+};
+
+bool ParseOptions(int argc, char** argv, ReaderOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        if (arg == "--name") {
+            options.name = value;
+        } else if (arg == "--frames") {
+            options.frames = strtoull(value, nullptr, 10);
+        } else if (arg == "--timeout") {
+            options.timeoutMs = static_cast<DWORD>(atoi(value));
+        } else if (arg == "--dump") {
+            options.dumpPath = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+uint64_t QueryTicks() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return static_cast<uint64_t>(now.QuadPart);
+}
+
+double TicksToMs(uint64_t ticks, uint64_t frequency) {
+    return ticks * 1000.0 / static_cast<double>(frequency);
+}
+
+// FNV-1a over the image, read straight from the slot
+uint32_t ChecksumPixels(const uint8_t* pixels, uint32_t pitch, uint32_t width, uint32_t height) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(pixels + static_cast<size_t>(y) * pitch);
+        for (uint32_t x = 0; x < width; ++x) {
+            hash = (hash ^ row[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+void PutLE(FILE* file, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        fputc(static_cast<int>((value >> (8 * i)) & 0xFF), file);
+    }
+}
+
+// Top-down 32-bit BMP, written from the slot without an intermediate copy
+bool WriteBitmap(const std::string& path, const uint8_t* pixels, uint32_t pitch,
+                 uint32_t width, uint32_t height) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t imageBytes = width * height * 4;
+    fputc('B', file);
+    fputc('M', file);
+    PutLE(file, 54 + imageBytes, 4);
+    PutLE(file, 0, 4);
+    PutLE(file, 54, 4);
+    PutLE(file, 40, 4);
+    PutLE(file, width, 4);
+    PutLE(file, static_cast<uint32_t>(-static_cast<int32_t>(height)), 4);
+    PutLE(file, 1, 2);
+    PutLE(file, 32, 2);
+    PutLE(file, 0, 4);
+    PutLE(file, imageBytes, 4);
+    PutLE(file, 2835, 4);
+    PutLE(file, 2835, 4);
+    PutLE(file, 0, 4);
+    PutLE(file, 0, 4);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        fwrite(pixels + static_cast<size_t>(y) * pitch, 4, width, file);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+} // namespace
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char** argv) {
+    ReaderOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    // The game may not have created the ring yet
+    std::string sectionName = "Local\\" + options.name;
+    HANDLE mapping = nullptr;
+    DWORD start = GetTickCount();
+    while (!(mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, sectionName.c_str()))) {
+        if (GetTickCount() - start >= options.timeoutMs) {
+            fprintf(stderr, "No frame ring named %s\n", sectionName.c_str());
+            return 1;
+        }
+        Sleep(10);
+    }
+
+    const auto* view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    const auto* header = reinterpret_cast<const FrameRingHeader*>(view);
+    if (!view || header->magic != kFrameRingMagic || header->version != kFrameRingVersion ||
+        header->format != kFrameRingFormatXRGB8888) {
+        fprintf(stderr, "%s is not a version %u frame ring\n", sectionName.c_str(), kFrameRingVersion);
+        if (view) {
+            UnmapViewOfFile(view);
+        }
+        CloseHandle(mapping);
+        return 1;
+    }
+
+    printf("%s: %u slots of %ux%u\n", sectionName.c_str(), header->slotCount,
+           header->maxWidth, header->maxHeight);
+
+    const FrameRingSlot* slots = GetFrameRingSlots(header);
+    uint64_t lastSeen = header->latestSequence.load(std::memory_order_acquire);
+    uint64_t received = 0;
+    uint64_t missed = 0;
+    uint64_t overwritten = 0;
+    double latencyTotal = 0.0;
+    bool dumped = options.dumpPath.empty();
+
+    DWORD lastFrameTime = GetTickCount();
+    while (options.frames == 0 || received < options.frames) {
+        uint64_t latest = header->latestSequence.load(std::memory_order_acquire);
+        if (latest == lastSeen) {
+            if (GetTickCount() - lastFrameTime >= options.timeoutMs) {
+                break;
+            }
+            Sleep(1);
+            continue;
+        }
+        lastFrameTime = GetTickCount();
+
+        // Only the newest frame is read; those in between are skipped
+        if (lastSeen > 0) {
+            missed += latest - lastSeen - 1;
+        }
+        lastSeen = latest;
+
+        const FrameRingSlot& slot = slots[GetFrameRingSlotIndex(header, latest)];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != latest) {
+            overwritten++;
+            continue;
+        }
+
+        uint32_t width = slot.width;
+        uint32_t height = slot.height;
+        uint32_t pitch = slot.pitch;
+        uint32_t damageCount = slot.damageCount;
+        FrameRingRect damage = slot.damage[0];
+        uint64_t captureTime = slot.captureTime;
+        uint64_t publishTime = slot.publishTime;
+
+        const uint8_t* pixels = view + slot.pixelOffset;
+        uint32_t checksum = ChecksumPixels(pixels, pitch, width, height);
+        bool dumping = !dumped && WriteBitmap(options.dumpPath, pixels, pitch, width, height);
+
+        // Whatever was read is only valid if the writer left the slot alone
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            overwritten++;
+            if (dumping) {
+                remove(options.dumpPath.c_str());
+            }
+            continue;
+        }
+        dumped = dumped || dumping;
+
+        double latency = TicksToMs(QueryTicks() - publishTime, header->timerFrequency);
+        latencyTotal += latency;
+        received++;
+
+        printf("frame %llu: %ux%u, %u damage (first %d,%d-%d,%d), checksum %08x, "
+               "publish %.3f ms, latency %.3f ms\n",
+               static_cast<unsigned long long>(sequence), width, height, damageCount,
+               damage.left, damage.top, damage.right, damage.bottom, checksum,
+               TicksToMs(publishTime - captureTime, header->timerFrequency), latency);
+    }
+
+    printf("%llu frames read, %llu skipped, %llu overwritten while reading",
+           static_cast<unsigned long long>(received), static_cast<unsigned long long>(missed),
+           static_cast<unsigned long long>(overwritten));
+    if (received > 0) {
+        printf(", mean latency %.3f ms", latencyTotal / received);
+    }
+    printf("\n");
+    if (!options.dumpPath.empty()) {
+        printf(dumped ? "frame written to %s\n" : "no frame written to %s\n", options.dumpPath.c_str());
+    }
+
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    return received > 0 ? 0 : 1;
+}